@@ -51,6 +51,12 @@
 
 typedef int (*Item_Cmp)(void * item, void * other_item);
 typedef uint64_t (*Hash_Func)(void * item, uint64_t table_size);
+// Returns bits of the item's hash that are independent of those used by Hash_Func
+// to pick the bucket. Used as a tag to reject mismatches without comparing items
+typedef uint16_t (*Hash_Tag_Func)(void * item);
+// Returns well-distributed bits of the item's hash, the most significant bits pick the
+// shard within a Sharded_Table (so should also be independent of Hash_Func and Hash_Tag_Func)
+typedef uint64_t (*Shard_Func)(void * item);
 
 
 
@@ -234,13 +234,24 @@
 // for multiple clients submitting to same mempool fifo
 #define MEMORY_OPS_BUFFER_MAX_REQUESTS_PER_MEMPOOL 64
 
+// How clients wait for the memory server to complete their op
+// (see Fifo_Wait_Policy within fifo.h)
+//	- used to be a pure spin, now spin for a bit then park
+#define MEMORY_OP_WAIT_POLICY FIFO_WAIT_SPIN_THEN_PARK
+#define MEMORY_OP_SPIN_ITERS 1U << 12
+
 // this is to make allocations faster for lists
 // that containing starting chunk_id's of the same range size
 
 // each list represent a fixed memory range size, so we actually
 // know the maximum capacity, but this could be an undue waste of memory
 // setting higher can accelerate list operations because no need for malloc()/frees()
-#define MEMORY_RANGE_LIST_DEFAULT_BUFFER_CAPACITY 1
+
+// The first buffer is allocated with the list (16 nodes = 384 bytes) and
+// covers the common case of a handful of free ranges per size. Lists that 
+// outgrow it double their node buffers (see fast_list.h), so popular sizes
+// only need a few more mallocs
+#define MEMORY_RANGE_LIST_DEFAULT_BUFFER_CAPACITY 16
 
 
 #define MEMORY_RANGE_LISTS_MIN_TABLE_SIZE 256
@@ -371,6 +382,15 @@
 #define SEND_CTRL_MAX_POLL_ENTRIES 1U << 10
 
 #define CTRL_RECV_DISPATCHER_BACKLOG_MESSAGES 1U << 21
+// the dispatcher checks its (lock-free) ring this many times before
+// parking until the cq handler produces more messages
+#define CTRL_RECV_DISPATCHER_SPIN_ITERS 1U << 14
+
+
+// How workers wait on their task fifos (see Fifo_Wait_Policy within fifo.h)
+//	- spinning for a bit avoids a futex wakeup per message when messages are frequent
+#define WORKER_TASKS_WAIT_POLICY FIFO_WAIT_SPIN_THEN_PARK
+#define WORKER_TASKS_SPIN_ITERS 1U << 10
 
 
 // MASTER CLASS CONFIGURATION
@@ -401,6 +421,14 @@
 // the load factor and shrink factor only matter if min_size != max_size
 #define EXCHANGE_TABLES_LOAD_FACTOR 0.5f
 #define EXCHANGE_TABLES_SHRINK_FACTOR 0.1f
+// number of consecutive slots sharing one lock
+#define EXCHANGE_TABLES_SLOT_LOCK_RATIO 16
+// TABLE_LINEAR_PROBE or TABLE_GROUP_PROBE
+//	- group probing keeps probe sequences shorter (both engines resize incrementally)
+#define EXCHANGE_TABLES_ENGINE TABLE_LINEAR_PROBE
+// each of the bids/offers/futures tables is split into 2^EXCHANGE_TABLES_SHARD_BITS independent tables
+//	- the min/max table items above are for all shards combined
+#define EXCHANGE_TABLES_SHARD_BITS 4
 
 
 
@@ -412,7 +440,9 @@
 
 // INVENTORY MESSAGE CONFIGURATION
 
-#define MAX_FINGERPRINT_MATCH_LOCATIONS 24
+// A Fingerprint_Match must fit within INVENTORY_MESSAGE_MAX_SIZE_BYTES (112):
+// 32 byte fingerprint + 4 byte num_nodes + 4 bytes per location
+#define MAX_FINGERPRINT_MATCH_LOCATIONS 19
 
 // INVENTORY STRUCT CONFIGURATION
 
@@ -420,6 +450,13 @@
 #define INVENTORY_MAX_FINGERPRINTS_TABLE_ITEMS (1ULL << 36)
 #define INVENTORY_TABLES_LOAD_FACTOR 0.5f
 #define INVENTORY_TABLES_SHRINK_FACTOR 0.5f
+// number of consecutive slots sharing one lock
+//	- (a pthread_mutex_t is 40 bytes vs. 8 bytes for the slot itself)
+#define INVENTORY_TABLES_SLOT_LOCK_RATIO 64
+// TABLE_LINEAR_PROBE or TABLE_GROUP_PROBE (see exchange tables above)
+#define INVENTORY_TABLES_ENGINE TABLE_LINEAR_PROBE
+// the object table is split into 2^INVENTORY_TABLES_SHARD_BITS independent tables
+#define INVENTORY_TABLES_SHARD_BITS 4
 
 
 // OUTSTANDING BIDS TABLE
@@ -429,6 +466,8 @@
 
 #define OUTSTANDING_BIDS_TABLE_LOAD_FACTOR 0.5f
 #define OUTSTANDING_BIDS_TABLE_SHRINK_FACTOR 0.1f
+#define OUTSTANDING_BIDS_TABLE_SLOT_LOCK_RATIO 16
+#define OUTSTANDING_BIDS_TABLE_ENGINE TABLE_LINEAR_PROBE
 
 
 #endif
@@ -71,13 +71,13 @@ int activate_cq_threads(Net_World * net_world, Work_Pool * work_pool){
 			cq_recv_thread_data[i * num_endpoint_types + j].work_pool = work_pool;
 			cq_recv_thread_data[i * num_endpoint_types + j].cq = cq_recv_collection[i][j];
 			if (endpoint_types[j] == CONTROL_ENDPOINT){
-				cq_recv_thread_data[i * num_endpoint_types + j].recv_dispatcher_fifo = init_fifo(CTRL_RECV_DISPATCHER_BACKLOG_MESSAGES, sizeof(Recv_Ctrl_Message));
-				if (cq_recv_thread_data[i * num_endpoint_types + j].recv_dispatcher_fifo == NULL){
-					fprintf(stderr, "Error: failed to initialize control receive dispatcher fifo for ib device id %d\n", i);
+				cq_recv_thread_data[i * num_endpoint_types + j].recv_dispatcher_ring = init_spsc_ring(CTRL_RECV_DISPATCHER_BACKLOG_MESSAGES, sizeof(Recv_Ctrl_Message), CTRL_RECV_DISPATCHER_SPIN_ITERS);
+				if (cq_recv_thread_data[i * num_endpoint_types + j].recv_dispatcher_ring == NULL){
+					fprintf(stderr, "Error: failed to initialize control receive dispatcher ring for ib device id %d\n", i);
 				}
 			}
 			else{
-				cq_recv_thread_data[i * num_endpoint_types + j].recv_dispatcher_fifo = NULL;
+				cq_recv_thread_data[i * num_endpoint_types + j].recv_dispatcher_ring = NULL;
 			}
 			
 		}
@@ -98,7 +98,7 @@ int activate_cq_threads(Net_World * net_world, Work_Pool * work_pool){
 			cq_send_thread_data[i * num_endpoint_types + j].net_world = net_world;
 			cq_send_thread_data[i * num_endpoint_types + j].work_pool = work_pool;
 			cq_send_thread_data[i * num_endpoint_types + j].cq = cq_send_collection[i][j];
-			cq_send_thread_data[i * num_endpoint_types + j].recv_dispatcher_fifo = NULL;
+			cq_send_thread_data[i * num_endpoint_types + j].recv_dispatcher_ring = NULL;
 		}
 	}
 
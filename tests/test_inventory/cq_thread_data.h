@@ -5,13 +5,15 @@
 #include "net.h"
 #include "exchange.h"
 #include "work_pool.h"
+#include "spsc_ring.h"
 
 typedef struct cq_thread_data{
 	EndpointType endpoint_type;
 	int ib_device_id;
 	Net_World * net_world;
 	struct ibv_cq_ex * cq;
-	Fifo * recv_dispatcher_fifo;
+	// single producer (this cq thread) and single consumer (the dispatcher thread)
+	Spsc_Ring * recv_dispatcher_ring;
 	pthread_t dispatcher_thread;
 	// The completition queue is responsible for reading the control message
 	// header which indicates the class the control message should be "routed to"
@@ -164,30 +164,71 @@ int post_send_ctrl_channel(Ctrl_Channel * channel, Ctrl_Message * ctrl_message,
 
 	int ret;
 
-	// Error check if we want
+	// 1.) Copy item into a registered memory region
+	Ctrl_Send_Reservation reservation;
+	ret = reserve_send_ctrl_channel(channel, ah, remote_qp_num, remote_qkey, &reservation);
+	if (ret != 0){
+		fprintf(stderr, "Error: post_send_ctrl_channel failed to reserve a send slot\n");
+		return -1;
+	}
 
-	// assert(channel -> channel_type == SEND_CHANNEL)
+	memcpy(reservation.ctrl_message, ctrl_message, sizeof(Ctrl_Message));
+
+	// 2.) Post it
+	return commit_send_ctrl_channel(&reservation);
+}
+
+
+// Send channels use the lock free fifo engine (see init_ctrl_channel), which supports reserve/commit
+int reserve_send_ctrl_channel(Ctrl_Channel * channel, struct ibv_ah * ah, uint32_t remote_qp_num, uint32_t remote_qkey, Ctrl_Send_Reservation * ret_reservation) {
+
+	// only send channels are lock free
+	uint64_t fifo_pos = reserve_fifo(channel -> fifo);
+	if (unlikely(fifo_pos == FIFO_RESERVE_ERROR)){
+		fprintf(stderr, "Error: reserve_send_ctrl_channel called on a channel whose fifo does not support reserve (channel type: %d)\n", channel -> channel_type);
+		return -1;
+	}
+
+	ret_reservation -> channel = channel;
+	ret_reservation -> fifo_pos = fifo_pos;
+	ret_reservation -> ctrl_message = (Ctrl_Message *) get_buffer_addr(channel -> fifo, fifo_pos % (channel -> fifo -> max_items));
+	ret_reservation -> ah = ah;
+	ret_reservation -> remote_qp_num = remote_qp_num;
+	ret_reservation -> remote_qkey = remote_qkey;
+
+	return 0;
+}
 
-	// 1.) Copy item into a registered memory region
+
+int commit_send_ctrl_channel(Ctrl_Send_Reservation * reservation) {
+
+	int ret;
+
+	Ctrl_Channel * channel = reservation -> channel;
+
+	// 1.) Mark the item as produced
+	//		- the send completion handler consumes it once the send completes
+	ret = commit_fifo(channel -> fifo, reservation -> fifo_pos);
+	if (unlikely(ret != 0)){
+		fprintf(stderr, "Error: commit_send_ctrl_channel could not commit the reserved send slot\n");
+		return -1;
+	}
+
+	// 2.) Based on it's insertion index and the channel id, determine an appropriate wr_id
 
 	// the lower 32 bits of insert_ind will be used as the wr_id
 	// we know that the buffer sizes are limited by hardware ~32k
 	// thus insert_ind can be casted down. 32 bits is plently
-	uint32_t insert_ind = (uint32_t) produce_fifo(channel -> fifo, (void *) ctrl_message);
-
-	// 2.) Now obtain the address of item within registered region
-	void * buffer_item = get_buffer_addr(channel -> fifo, insert_ind);
-
-	// 3.) Based on it's insertion index and the channel id, determine an appropriate wr_id
+	uint32_t insert_ind = (uint32_t) (reservation -> fifo_pos % (channel -> fifo -> max_items));
 
 	// now obtain the wr_id
 	uint64_t wr_id = encode_ctrl_wr_id(channel, insert_ind);
 
-	// 4.) Get other information needed for posting work requests
+	// 3.) Get other information needed for posting work requests
 	uint32_t lkey = channel -> channel_mr -> lkey;
 	uint32_t length = channel -> fifo -> item_size_bytes;
 
-	ret = post_send_work_request(channel -> qp, (uint64_t) buffer_item, length, lkey, wr_id, ah, remote_qp_num, remote_qkey);
+	ret = post_send_work_request(channel -> qp, (uint64_t) reservation -> ctrl_message, length, lkey, wr_id, reservation -> ah, reservation -> remote_qp_num, reservation -> remote_qkey);
 
 	if (ret != 0){
 		fprintf(stderr, "Error: post_channel failed\n");
@@ -308,7 +349,18 @@ Ctrl_Channel * init_ctrl_channel(CtrlChannelType channel_type, uint32_t max_item
 	}
 	
 	// 2.) Create fifo to actually hold / manage channel items
-	Fifo * fifo = init_fifo(max_items, item_size_bytes);
+	//	- many threads post sends on the same channel and the send cq handler only consumes single items,
+	//		so send channels use the lock free engine
+	//	- receive channels need the batch functions (contiguous indicies for posting receives)
+	Fifo_Engine fifo_engine;
+	if (channel_type == SEND_CTRL_CHANNEL){
+		fifo_engine = FIFO_ENGINE_LOCK_FREE;
+	}
+	else{
+		fifo_engine = FIFO_ENGINE_LOCKED;
+	}
+
+	Fifo * fifo = init_fifo_with_engine(max_items, item_size_bytes, fifo_engine);
 	if (fifo == NULL){
 		fprintf(stderr, "Error: init_channel failed because couldn't create fifo\n");
 		return NULL;
@@ -52,6 +52,21 @@ typedef struct ctrl_channel {
 } Ctrl_Channel;
 
 
+// A slot of a send channel's (registered) fifo buffer that the caller
+// builds a message in before committing it to be posted
+typedef struct ctrl_send_reservation {
+	Ctrl_Channel * channel;
+	// the position from reserve_fifo
+	uint64_t fifo_pos;
+	// points into the channel's registered buffer
+	Ctrl_Message * ctrl_message;
+	// where the message will be sent
+	struct ibv_ah * ah;
+	uint32_t remote_qp_num;
+	uint32_t remote_qkey;
+} Ctrl_Send_Reservation;
+
+
 // If channel type is SEND_CHANNEL:
 //	- then qp must be non-null an srq is ignored
 // If channel type is RECV_CHANNEL:
@@ -67,6 +82,15 @@ Ctrl_Channel * init_ctrl_channel(CtrlChannelType channel_type, uint32_t max_item
 
 int post_send_ctrl_channel(Ctrl_Channel * channel, Ctrl_Message * ctrl_message, struct ibv_ah * ah, uint32_t remote_qp_num, uint32_t remote_qkey);
 
+// Same as post_send_ctrl_channel, but the message is built in place instead of being copied in:
+//	- reserve_send_ctrl_channel populates ret_reservation, the caller fills in ret_reservation -> ctrl_message 
+//	- commit_send_ctrl_channel posts it
+// The slot is claimed until commit (the send completion handler waits on it), so commit promptly
+// Both return 0 on success, -1 on error (the channel's fifo doesn't support reserve/commit)
+// BLOCKING (reserve)!
+int reserve_send_ctrl_channel(Ctrl_Channel * channel, struct ibv_ah * ah, uint32_t remote_qp_num, uint32_t remote_qkey, Ctrl_Send_Reservation * ret_reservation);
+int commit_send_ctrl_channel(Ctrl_Send_Reservation * reservation);
+
 // populates a control message template passed in
 // only returns error if cannot replace an item on a receive channel
 int extract_ctrl_channel(Ctrl_Channel * channel, Ctrl_Message * ret_ctrl_message);
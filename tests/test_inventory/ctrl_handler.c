@@ -9,18 +9,18 @@ void * run_recv_ctrl_handler(void * _cq_thread_data) {
 
 	// 1.) Start a dispatcher thread if needed
 
-	Fifo * recv_dispatcher_fifo = cq_thread_data -> recv_dispatcher_fifo;
+	Spsc_Ring * recv_dispatcher_ring = cq_thread_data -> recv_dispatcher_ring;
 
 
 	Ctrl_Recv_Dispatcher_Thread_Data recv_dispatcher_thread_data;
 	recv_dispatcher_thread_data.ib_device_id = cq_thread_data -> ib_device_id;
-	recv_dispatcher_thread_data.dispatcher_fifo = recv_dispatcher_fifo;
+	recv_dispatcher_thread_data.dispatcher_ring = recv_dispatcher_ring;
 	recv_dispatcher_thread_data.net_world = cq_thread_data -> net_world;
 	recv_dispatcher_thread_data.work_pool = cq_thread_data -> work_pool;
 
 
 	// if we are supposed to dispatch
-	if (recv_dispatcher_fifo != NULL){
+	if (recv_dispatcher_ring != NULL){
 		ret = pthread_create(&(cq_thread_data -> dispatcher_thread), NULL, run_recv_ctrl_dispatcher, &recv_dispatcher_thread_data);
 		if (ret != 0){
 			fprintf(stderr, "Error: failed to start ctrl receive dispatcher thread within ib device id: %d\n", cq_thread_data -> ib_device_id);
@@ -123,12 +123,13 @@ void * run_recv_ctrl_handler(void * _cq_thread_data) {
 		}
 
 
-		// 4.) Add these receive messages to the sorting fifo 
+		// 4.) Add these receive messages to the sorting ring 
 		//		which will be responsible for reading the header 
 		//		and placing it on the appropriate worker's task queue
 
-
-		produce_batch_fifo(recv_dispatcher_fifo, num_comp, recv_ctrl_messages);
+		//	- this thread is the only producer and the dispatcher is the only
+		//		consumer, so the whole batch is published without any lock
+		produce_batch_spsc_ring(recv_dispatcher_ring, num_comp, recv_ctrl_messages);
 	}
 
 	return 0;
@@ -6,7 +6,7 @@ void * run_recv_ctrl_dispatcher(void * _ctrl_recv_dispatcher_thread_data) {
 	Ctrl_Recv_Dispatcher_Thread_Data * dispatcher_thread_data = (Ctrl_Recv_Dispatcher_Thread_Data *) _ctrl_recv_dispatcher_thread_data;
 
 	int ib_device_id = dispatcher_thread_data -> ib_device_id;
-	Fifo * dispatcher_fifo = dispatcher_thread_data -> dispatcher_fifo;
+	Spsc_Ring * dispatcher_ring = dispatcher_thread_data -> dispatcher_ring;
 	Work_Pool * work_pool = dispatcher_thread_data -> work_pool;
 	Net_World * net_world = dispatcher_thread_data -> net_world;
 
@@ -31,7 +31,7 @@ void * run_recv_ctrl_dispatcher(void * _ctrl_recv_dispatcher_thread_data) {
 	Work_Class ** work_classes = work_pool -> classes;
 
 
-	Recv_Ctrl_Message * recv_ctrl_messages = (Recv_Ctrl_Message *) malloc(dispatcher_fifo -> max_items * sizeof(Recv_Ctrl_Message));
+	Recv_Ctrl_Message * recv_ctrl_messages = (Recv_Ctrl_Message *) malloc(dispatcher_ring -> max_items * sizeof(Recv_Ctrl_Message));
 	if (recv_ctrl_messages == NULL){
 		fprintf(stderr, "Error: malloc failed to allocate buffer for recv control messages within dispatcher thread\n");
 		return NULL;
@@ -51,12 +51,13 @@ void * run_recv_ctrl_dispatcher(void * _ctrl_recv_dispatcher_thread_data) {
 
 	while (1){
 
-		// CONSUME THE FIFO PRODUCED BY RECV_CTRL_HANDLER
+		// CONSUME THE RING PRODUCED BY RECV_CTRL_HANDLER
 
-		num_consumed = consume_all_fifo(dispatcher_fifo, recv_ctrl_messages);
+		//	- spins for CTRL_RECV_DISPATCHER_SPIN_ITERS before parking
+		num_consumed = consume_all_spsc_ring(dispatcher_ring, recv_ctrl_messages);
 
 
-		// Consume as many as possible and store in buffer to reduce lock contention on the fifo
+		// Consume as many as possible and store in buffer so the cq handler gets the slots back at once
 
 		for (uint64_t i = 0; i < num_consumed; i++){
 
@@ -4,6 +4,7 @@
 
 #include "common.h"
 #include "fifo.h"
+#include "spsc_ring.h"
 #include "self_net.h"
 #include "net.h"
 #include "cq_thread_data.h"
@@ -15,7 +16,7 @@
 
 typedef struct ctrl_recv_dispatcher_thread_data {
 	int ib_device_id;
-	Fifo * dispatcher_fifo;
+	Spsc_Ring * dispatcher_ring;
 	Net_World * net_world;
 	Work_Pool * work_pool;
 } Ctrl_Recv_Dispatcher_Thread_Data;
@@ -0,0 +1,266 @@
+#include "epoch.h"
+
+#include <immintrin.h>
+#include <sched.h>
+
+
+// When a thread exits its remaining retired items are destroyed 
+// (after waiting for them to become safe) and its slot can be reused
+static void unregister_thread_epoch(void * _thread_epoch);
+
+Epoch_Domain * init_epoch_domain() {
+
+	int ret;
+
+	Epoch_Domain * domain = (Epoch_Domain *) malloc(sizeof(Epoch_Domain));
+	if (domain == NULL){
+		fprintf(stderr, "Error: malloc failed to allocate epoch domain\n");
+		return NULL;
+	}
+
+	domain -> global_epoch = 0;
+	domain -> num_thread_slots = 0;
+
+	ret = posix_memalign((void **) &(domain -> threads), 64, EPOCH_MAX_THREADS * sizeof(Epoch_Thread));
+	if (ret != 0){
+		fprintf(stderr, "Error: could not allocate epoch thread records\n");
+		free(domain);
+		return NULL;
+	}
+	memset(domain -> threads, 0, EPOCH_MAX_THREADS * sizeof(Epoch_Thread));
+
+	for (uint64_t i = 0; i < EPOCH_MAX_THREADS; i++){
+		(domain -> threads)[i].local_epoch = EPOCH_INACTIVE;
+	}
+
+	ret = pthread_key_create(&(domain -> thread_key), &unregister_thread_epoch);
+	if (ret != 0){
+		fprintf(stderr, "Error: could not create epoch thread key\n");
+		free(domain -> threads);
+		free(domain);
+		return NULL;
+	}
+
+	ret = pthread_mutex_init(&(domain -> register_lock), NULL);
+	if (ret != 0){
+		fprintf(stderr, "Error: could not init epoch register lock\n");
+		pthread_key_delete(domain -> thread_key);
+		free(domain -> threads);
+		free(domain);
+		return NULL;
+	}
+
+	return domain;
+}
+
+
+static void destroy_retire_list_epoch(Epoch_Retire_List * retire_list){
+	Epoch_Retired * retired = retire_list -> retired;
+	for (uint64_t i = 0; i < retire_list -> cnt; i++){
+		(retired[i].retire_func)(retired[i].item);
+	}
+	retire_list -> cnt = 0;
+}
+
+void destroy_epoch_domain(Epoch_Domain * domain) {
+
+	Epoch_Thread * thread_epoch;
+	for (uint64_t i = 0; i < domain -> num_thread_slots; i++){
+		thread_epoch = &((domain -> threads)[i]);
+		for (int j = 0; j < EPOCH_NUM_RETIRE_LISTS; j++){
+			destroy_retire_list_epoch(&(thread_epoch -> retire_lists[j]));
+			free(thread_epoch -> retire_lists[j].retired);
+		}
+	}
+
+	pthread_key_delete(domain -> thread_key);
+	pthread_mutex_destroy(&(domain -> register_lock));
+	free(domain -> threads);
+	free(domain);
+}
+
+
+static Epoch_Thread * register_thread_epoch(Epoch_Domain * domain){
+
+	Epoch_Thread * thread_epoch = NULL;
+
+	pthread_mutex_lock(&(domain -> register_lock));
+	for (uint64_t i = 0; i < EPOCH_MAX_THREADS; i++){
+		if (!((domain -> threads)[i].in_use)){
+			thread_epoch = &((domain -> threads)[i]);
+			thread_epoch -> in_use = true;
+			if (i >= domain -> num_thread_slots){
+				__atomic_store_n(&(domain -> num_thread_slots), i + 1, __ATOMIC_RELEASE);
+			}
+			break;
+		}
+	}
+	pthread_mutex_unlock(&(domain -> register_lock));
+
+	if (thread_epoch == NULL){
+		fprintf(stderr, "Error: more than %d threads are using the same epoch domain\n", EPOCH_MAX_THREADS);
+		return NULL;
+	}
+
+	thread_epoch -> local_epoch = EPOCH_INACTIVE;
+	thread_epoch -> nesting = 0;
+	thread_epoch -> num_retired_since_reclaim = 0;
+	thread_epoch -> domain = domain;
+
+	pthread_setspecific(domain -> thread_key, thread_epoch);
+
+	return thread_epoch;
+}
+
+static inline Epoch_Thread * get_thread_epoch(Epoch_Domain * domain){
+	Epoch_Thread * thread_epoch = (Epoch_Thread *) pthread_getspecific(domain -> thread_key);
+	if (unlikely(thread_epoch == NULL)){
+		thread_epoch = register_thread_epoch(domain);
+	}
+	return thread_epoch;
+}
+
+
+void enter_epoch(Epoch_Domain * domain){
+
+	Epoch_Thread * thread_epoch = get_thread_epoch(domain);
+
+	if (thread_epoch -> nesting == 0){
+		__atomic_store_n(&(thread_epoch -> local_epoch), __atomic_load_n(&(domain -> global_epoch), __ATOMIC_ACQUIRE), __ATOMIC_RELAXED);
+		// the announcement must be visible before any shared pointer is loaded
+		__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	}
+
+	thread_epoch -> nesting += 1;
+}
+
+void exit_epoch(Epoch_Domain * domain){
+
+	Epoch_Thread * thread_epoch = get_thread_epoch(domain);
+
+	thread_epoch -> nesting -= 1;
+
+	if (thread_epoch -> nesting == 0){
+		__atomic_store_n(&(thread_epoch -> local_epoch), EPOCH_INACTIVE, __ATOMIC_RELEASE);
+	}
+}
+
+
+// Advances the global epoch if every thread within a critical section has observed the current one
+// Returns the global epoch after attempting
+static uint64_t try_advance_epoch(Epoch_Domain * domain){
+
+	// pairs with the fence within enter_epoch
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+	uint64_t epoch = __atomic_load_n(&(domain -> global_epoch), __ATOMIC_ACQUIRE);
+	uint64_t num_thread_slots = __atomic_load_n(&(domain -> num_thread_slots), __ATOMIC_ACQUIRE);
+
+	uint64_t local_epoch;
+	for (uint64_t i = 0; i < num_thread_slots; i++){
+		local_epoch = __atomic_load_n(&((domain -> threads)[i].local_epoch), __ATOMIC_ACQUIRE);
+		if ((local_epoch != EPOCH_INACTIVE) && (local_epoch != epoch)){
+			return epoch;
+		}
+	}
+
+	// fine if someone else already advanced it
+	__atomic_compare_exchange_n(&(domain -> global_epoch), &epoch, epoch + 1, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+
+	return __atomic_load_n(&(domain -> global_epoch), __ATOMIC_ACQUIRE);
+}
+
+// Destroys every list whose items were retired at least 2 epochs ago
+static void reclaim_thread_epoch(Epoch_Thread * thread_epoch, uint64_t global_epoch){
+	Epoch_Retire_List * retire_list;
+	for (int i = 0; i < EPOCH_NUM_RETIRE_LISTS; i++){
+		retire_list = &(thread_epoch -> retire_lists[i]);
+		if ((retire_list -> cnt > 0) && (retire_list -> epoch + 2 <= global_epoch)){
+			destroy_retire_list_epoch(retire_list);
+		}
+	}
+}
+
+
+void retire_epoch(Epoch_Domain * domain, void * item, Retire_Func retire_func){
+
+	Epoch_Thread * thread_epoch = get_thread_epoch(domain);
+	if (unlikely(thread_epoch == NULL)){
+		// can't defer, the only safe option is to leak
+		fprintf(stderr, "Error: could not retire item, leaking it\n");
+		return;
+	}
+
+	uint64_t epoch = __atomic_load_n(&(domain -> global_epoch), __ATOMIC_ACQUIRE);
+
+	Epoch_Retire_List * retire_list = &(thread_epoch -> retire_lists[epoch % EPOCH_NUM_RETIRE_LISTS]);
+
+	// The list is from an epoch at least EPOCH_NUM_RETIRE_LISTS ago, so its items are safe
+	if (retire_list -> epoch != epoch){
+		destroy_retire_list_epoch(retire_list);
+		retire_list -> epoch = epoch;
+	}
+
+	if (retire_list -> cnt == retire_list -> capacity){
+		uint64_t new_capacity = (retire_list -> capacity == 0) ? EPOCH_RECLAIM_THRESHOLD : 2 * retire_list -> capacity;
+		Epoch_Retired * new_retired = (Epoch_Retired *) realloc(retire_list -> retired, new_capacity * sizeof(Epoch_Retired));
+		if (new_retired == NULL){
+			fprintf(stderr, "Error: could not grow retire list to %lu items, leaking item\n", new_capacity);
+			return;
+		}
+		retire_list -> retired = new_retired;
+		retire_list -> capacity = new_capacity;
+	}
+
+	(retire_list -> retired)[retire_list -> cnt].item = item;
+	(retire_list -> retired)[retire_list -> cnt].retire_func = retire_func;
+	retire_list -> cnt += 1;
+
+	thread_epoch -> num_retired_since_reclaim += 1;
+	if (thread_epoch -> num_retired_since_reclaim >= EPOCH_RECLAIM_THRESHOLD){
+		thread_epoch -> num_retired_since_reclaim = 0;
+		reclaim_thread_epoch(thread_epoch, try_advance_epoch(domain));
+	}
+}
+
+
+static void barrier_thread_epoch(Epoch_Domain * domain, Epoch_Thread * thread_epoch){
+
+	uint64_t target_epoch = __atomic_load_n(&(domain -> global_epoch), __ATOMIC_ACQUIRE) + 2;
+
+	while (try_advance_epoch(domain) < target_epoch){
+		sched_yield();
+	}
+
+	for (int i = 0; i < EPOCH_NUM_RETIRE_LISTS; i++){
+		destroy_retire_list_epoch(&(thread_epoch -> retire_lists[i]));
+	}
+	thread_epoch -> num_retired_since_reclaim = 0;
+}
+
+void barrier_epoch(Epoch_Domain * domain){
+
+	Epoch_Thread * thread_epoch = get_thread_epoch(domain);
+	if (unlikely(thread_epoch == NULL)){
+		return;
+	}
+
+	barrier_thread_epoch(domain, thread_epoch);
+}
+
+
+static void unregister_thread_epoch(void * _thread_epoch){
+
+	Epoch_Thread * thread_epoch = (Epoch_Thread *) _thread_epoch;
+
+	Epoch_Domain * domain = thread_epoch -> domain;
+
+	__atomic_store_n(&(thread_epoch -> local_epoch), EPOCH_INACTIVE, __ATOMIC_RELEASE);
+	thread_epoch -> nesting = 0;
+
+	barrier_thread_epoch(domain, thread_epoch);
+
+	pthread_mutex_lock(&(domain -> register_lock));
+	thread_epoch -> in_use = false;
+	pthread_mutex_unlock(&(domain -> register_lock));
+}
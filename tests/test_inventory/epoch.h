@@ -0,0 +1,97 @@
+#ifndef EPOCH_H
+#define EPOCH_H
+
+#include "common.h"
+
+// Epoch-based reclamation
+
+// Threads that dereference items they found within a shared structure (tables, deques, ...)
+// do so between enter_epoch and exit_epoch (a critical section). After an item is unlinked
+// from the structure, instead of being destroyed directly it is retired along with the function
+// that destroys it. The retire function is only called once every thread that was within a
+// critical section at the time of retiring has exited it, so readers never need to lock an item
+// just to keep it alive.
+
+// There is a global epoch per domain. A thread entering a critical section announces the global epoch
+// it observed. The global epoch can only advance once every thread within a critical section has
+// announced the current one, so an item retired during epoch e is safe to destroy once the
+// global epoch reaches e + 2
+
+// Threads are registered with a domain automatically the first time they use it
+
+
+// maximum number of threads that can ever use the same domain concurrently
+#define EPOCH_MAX_THREADS 256
+
+// a thread attempts to advance the epoch (and destroy its safe items) after this many retires
+#define EPOCH_RECLAIM_THRESHOLD 64
+
+// a thread's announced epoch when it is not within a critical section
+#define EPOCH_INACTIVE UINT64_MAX
+
+// retired items are bucketed by (epoch % EPOCH_NUM_RETIRE_LISTS)
+//	- only the lists of the current and previous epochs can contain unsafe items
+#define EPOCH_NUM_RETIRE_LISTS 3
+
+typedef void (*Retire_Func)(void * item);
+
+typedef struct epoch_domain Epoch_Domain;
+
+typedef struct epoch_retired {
+	void * item;
+	Retire_Func retire_func;
+} Epoch_Retired;
+
+typedef struct epoch_retire_list {
+	// the global epoch when these items were retired
+	uint64_t epoch;
+	uint64_t cnt;
+	uint64_t capacity;
+	Epoch_Retired * retired;
+} Epoch_Retire_List;
+
+// each thread's record lives on its own cache line(s) because local_epoch 
+// is written upon every critical section entry/exit
+typedef struct epoch_thread {
+	// EPOCH_INACTIVE when outside of a critical section
+	uint64_t local_epoch;
+	// critical sections can be nested, only the outermost one announces the epoch
+	uint64_t nesting;
+	uint64_t num_retired_since_reclaim;
+	// if this slot belongs to a registered thread
+	bool in_use;
+	// needed when the owning thread exits
+	Epoch_Domain * domain;
+	Epoch_Retire_List retire_lists[EPOCH_NUM_RETIRE_LISTS];
+} __attribute__((aligned(64))) Epoch_Thread;
+
+struct epoch_domain {
+	uint64_t global_epoch;
+	// every slot below this has been handed out at some point
+	//	- (advancing the epoch only needs to check these)
+	uint64_t num_thread_slots;
+	Epoch_Thread * threads;
+	// each thread's slot within threads
+	pthread_key_t thread_key;
+	// held when registering/unregistering threads
+	pthread_mutex_t register_lock;
+};
+
+
+Epoch_Domain * init_epoch_domain();
+// Assumes no thread is within a critical section and no other thread 
+// will use the domain again. Calls the retire function of every remaining item
+void destroy_epoch_domain(Epoch_Domain * domain);
+
+void enter_epoch(Epoch_Domain * domain);
+void exit_epoch(Epoch_Domain * domain);
+
+// The item must already be unreachable for threads that enter a critical section from now on.
+// Can be called within or outside of a critical section
+void retire_epoch(Epoch_Domain * domain, void * item, Retire_Func retire_func);
+
+// Waits until everything this thread retired so far is safe and destroys it
+//	- must not be called within a critical section (it would wait for itself)
+void barrier_epoch(Epoch_Domain * domain);
+
+#endif
@@ -31,6 +31,28 @@ uint64_t exchange_hash_func(void * exchange_item, uint64_t table_size) {
 	return least_sig_64bits % table_size;
 }
 
+uint16_t exchange_hash_tag_func(void * exchange_item) {
+	Exchange_Item * item_casted = (Exchange_Item *) exchange_item;
+	return fingerprint_to_most_sig16(item_casted -> fingerprint);
+}
+
+uint64_t exchange_shard_func(void * exchange_item) {
+	Exchange_Item * item_casted = (Exchange_Item *) exchange_item;
+	return fingerprint_to_shard64(item_casted -> fingerprint);
+}
+
+// Lookups, inserts and removals use their own instantiation of the table's probing paths,
+// with the functions above (and the fingerprint compare) inlined
+#define TABLE_T_FN(name) name##_exchange_table
+#define TABLE_T_SHARDED_FN(name) name##_exchange_sharded_table
+#define TABLE_T_ITEM_TYPE Exchange_Item
+#define TABLE_T_KEY_FIELD fingerprint
+#define TABLE_T_KEY_SIZE FINGERPRINT_NUM_BYTES
+#define TABLE_T_HASH(table, item, size) exchange_hash_func((item), (size))
+#define TABLE_T_TAG(table, item) exchange_hash_tag_func(item)
+#define TABLE_T_SHARD(item) exchange_shard_func(item)
+#include "table_template.h"
+
 Exchange * init_exchange() {
 
 	Exchange * exchange = (Exchange *) malloc(sizeof(Exchange));
@@ -48,15 +70,20 @@ Exchange * init_exchange() {
 	//		- the ratio of filled items before the table grows by 1 / load_factor
 	float load_factor = EXCHANGE_TABLES_LOAD_FACTOR;
 	float shrink_factor = EXCHANGE_TABLES_SHRINK_FACTOR;
+	uint64_t slot_lock_ratio = EXCHANGE_TABLES_SLOT_LOCK_RATIO;
+	Table_Engine engine = EXCHANGE_TABLES_ENGINE;
+	uint32_t shard_bits = EXCHANGE_TABLES_SHARD_BITS;
 
 
 	Hash_Func hash_func = &exchange_hash_func;
 	Item_Cmp item_cmp = &exchange_item_cmp;
+	Hash_Tag_Func tag_func = &exchange_hash_tag_func;
+	Shard_Func shard_func = &exchange_shard_func;
 
 	// init bids and offers table
-	Table * bids = init_table(EXCHANGE_MIN_BID_TABLE_ITEMS, EXCHANGE_MAX_BID_TABLE_ITEMS, load_factor, shrink_factor, hash_func, item_cmp);
-	Table * offers = init_table(EXCHANGE_MIN_OFFER_TABLE_ITEMS, EXCHANGE_MAX_OFFER_TABLE_ITEMS, load_factor, shrink_factor, hash_func, item_cmp);
-	Table * futures = init_table(EXCHANGE_MIN_FUTURE_TABLE_ITEMS, EXCHANGE_MAX_FUTURE_TABLE_ITEMS, load_factor, shrink_factor, hash_func, item_cmp);
+	Sharded_Table * bids = init_sharded_table(shard_bits, shard_func, EXCHANGE_MIN_BID_TABLE_ITEMS, EXCHANGE_MAX_BID_TABLE_ITEMS, load_factor, shrink_factor, slot_lock_ratio, hash_func, item_cmp, tag_func, engine);
+	Sharded_Table * offers = init_sharded_table(shard_bits, shard_func, EXCHANGE_MIN_OFFER_TABLE_ITEMS, EXCHANGE_MAX_OFFER_TABLE_ITEMS, load_factor, shrink_factor, slot_lock_ratio, hash_func, item_cmp, tag_func, engine);
+	Sharded_Table * futures = init_sharded_table(shard_bits, shard_func, EXCHANGE_MIN_FUTURE_TABLE_ITEMS, EXCHANGE_MAX_FUTURE_TABLE_ITEMS, load_factor, shrink_factor, slot_lock_ratio, hash_func, item_cmp, tag_func, engine);
 	if ((bids == NULL) || (offers == NULL) || (futures == NULL)){
 		fprintf(stderr, "Error: could not initialize exchange tables\n");
 		return NULL;
@@ -66,6 +93,18 @@ Exchange * init_exchange() {
 	exchange -> offers = offers;
 	exchange -> futures = futures;
 
+	Epoch_Domain * epoch_domain = init_epoch_domain();
+	if (epoch_domain == NULL){
+		fprintf(stderr, "Error: could not initialize exchange epoch domain\n");
+		return NULL;
+	}
+
+	set_epoch_domain_sharded_table(bids, epoch_domain);
+	set_epoch_domain_sharded_table(offers, epoch_domain);
+	set_epoch_domain_sharded_table(futures, epoch_domain);
+
+	exchange -> epoch_domain = epoch_domain;
+
 	int ret = pthread_mutex_init(&(exchange -> exchange_lock), NULL);
 	if (ret != 0){
 		fprintf(stderr, "Error: could not initialize exchange lock\n");
@@ -205,6 +244,18 @@ void destroy_exchange_item(Exchange_Item * exchange_item){
 	free(exchange_item);
 }
 
+// Retire function for exchange items removed from the tables
+//	- called once no worker can still be referencing the item or its participants,
+//	  so there is no lock to acquire
+void retire_exchange_item(void * _exchange_item){
+
+	Exchange_Item * exchange_item = (Exchange_Item *) _exchange_item;
+
+	destroy_deque(exchange_item -> participants, false);
+	pthread_mutex_destroy(&(exchange_item -> exch_item_lock));
+	free(exchange_item);
+}
+
 void update_item_lookup(Exchange_Item * exchange_item){
 	struct timespec time;
 	clock_gettime(CLOCK_MONOTONIC, &time);
@@ -235,7 +286,7 @@ void update_item_modify(Exchange_Item * exchange_item) {
 
 int lookup_exch_item(Exchange * exchange, uint8_t * fingerprint, ExchangeItemType item_type, Exchange_Item ** ret_item){
 
-	Table * table;
+	Sharded_Table * table;
 
 	switch (item_type){
 		case BID_ITEM:
@@ -259,7 +310,7 @@ int lookup_exch_item(Exchange * exchange, uint8_t * fingerprint, ExchangeItemTyp
 	memcpy(exchange_item.fingerprint, fingerprint, FINGERPRINT_NUM_BYTES);
 
 	// set to null if doesn't exist
-	Exchange_Item * found_item = (Exchange_Item *) find_item_table(table, &exchange_item);
+	Exchange_Item * found_item = (Exchange_Item *) find_item_exchange_sharded_table(table, &exchange_item);
 
 	*ret_item = found_item;
 
@@ -274,9 +325,36 @@ int lookup_exch_item(Exchange * exchange, uint8_t * fingerprint, ExchangeItemTyp
 }
 
 
+void prefetch_exchange_functions(Exchange * exchange, uint64_t num_messages, Ctrl_Message * ctrl_messages){
+
+	// lookup items populated with just the fingerprint (like lookup_exch_item)
+	Exchange_Item lookup_items[TABLE_BATCH_PREFETCH_ITEMS];
+	void * items[TABLE_BATCH_PREFETCH_ITEMS];
+
+	Exch_Message * exch_message;
+
+	uint64_t num_items = 0;
+	for (uint64_t i = 0; i < num_messages; i++){
+
+		exch_message = (Exch_Message *) ctrl_messages[i].contents;
+		memcpy(lookup_items[num_items].fingerprint, exch_message -> fingerprint, FINGERPRINT_NUM_BYTES);
+		items[num_items] = &(lookup_items[num_items]);
+		num_items++;
+
+		// every order type looks up the offers and bids, and posting offers/futures also the futures
+		if ((num_items == TABLE_BATCH_PREFETCH_ITEMS) || (i == num_messages - 1)){
+			prefetch_batch_exchange_sharded_table(exchange -> offers, num_items, items);
+			prefetch_batch_exchange_sharded_table(exchange -> bids, num_items, items);
+			prefetch_batch_exchange_sharded_table(exchange -> futures, num_items, items);
+			num_items = 0;
+		}
+	}
+}
+
+
 int remove_exch_item(Exchange * exchange, uint8_t * fingerprint, ExchangeItemType item_type, Exchange_Item ** ret_item){
 	
-	Table * table;
+	Sharded_Table * table;
 
 	switch (item_type){
 		case BID_ITEM:
@@ -299,7 +377,7 @@ int remove_exch_item(Exchange * exchange, uint8_t * fingerprint, ExchangeItemTyp
 	memcpy(exchange_item.fingerprint, fingerprint, FINGERPRINT_NUM_BYTES);
 
 	// set to null if doesn't exist
-	Exchange_Item * removed_item = (Exchange_Item *) remove_item_table(table, &exchange_item);
+	Exchange_Item * removed_item = (Exchange_Item *) remove_item_exchange_sharded_table(table, &exchange_item);
 
 	*ret_item = removed_item;
 
@@ -353,7 +431,7 @@ int post_bid(Exchange * exchange, uint8_t * fingerprint, uint32_t node_id, Deque
 			fprintf(stderr, "Error: could not initialize new bid exchange item\n");
 			return -1;
 		}
-		ret = insert_item_table(exchange -> bids, new_bid);
+		ret = insert_item_exchange_sharded_table(exchange -> bids, new_bid);
 		if (unlikely(ret != 0)){
 			fprintf(stderr, "Error: could not insert new bid to exchange table\n");
 			return -1;
@@ -394,7 +472,7 @@ int post_offer(Exchange * exchange, uint8_t * fingerprint, uint32_t node_id, Deq
 			fprintf(stderr, "Error: could not initialize new offer exchange item\n");
 			return -1;
 		}
-		ret = insert_item_table(exchange -> offers, new_offer);
+		ret = insert_item_exchange_sharded_table(exchange -> offers, new_offer);
 		if (unlikely(ret != 0)){
 			fprintf(stderr, "Error: could not insert new offer to exchange table\n");
 			return -1;
@@ -436,14 +514,18 @@ int post_offer(Exchange * exchange, uint8_t * fingerprint, uint32_t node_id, Deq
 		uint64_t participant_cnt = get_count_deque(future_participants);
 		// there are no more participants, so we can remove this item from table and free its memory
 		if (participant_cnt == 0){
-			Exchange_Item * removed_item = (Exchange_Item *) remove_item_table(exchange -> futures, found_future);
+			Exchange_Item * removed_item = (Exchange_Item *) remove_item_exchange_sharded_table(exchange -> futures, found_future);
 			// assert(removed_item == found_bid)
 			if (unlikely(removed_item != found_future)){
 				fprintf(stderr, "Error: issue removing exchange bid item after a offer_match confirmation from node: %u\n", node_id);
+				pthread_mutex_unlock(&(found_future -> exch_item_lock));
 				return -1;
 			}
 
-			destroy_exchange_item(found_future);
+			// other workers might have looked up this item before it was removed, 
+			// so it gets destroyed once they are done with it
+			pthread_mutex_unlock(&(found_future -> exch_item_lock));
+			retire_epoch(exchange -> epoch_domain, found_future, &retire_exchange_item);
 		}
 		else{
 			// there were more participants, so we aren't destroying but need to release lock
@@ -490,7 +572,7 @@ int post_offer_confirm_match_data(Exchange * exchange, uint8_t * fingerprint, ui
 			fprintf(stderr, "Error: could not initialize new offer exchange item\n");
 			return -1;
 		}
-		ret = insert_item_table(exchange -> offers, new_offer);
+		ret = insert_item_exchange_sharded_table(exchange -> offers, new_offer);
 		if (unlikely(ret != 0)){
 			fprintf(stderr, "Error: could not insert new offer to exchange table\n");
 			return -1;
@@ -525,14 +607,18 @@ int post_offer_confirm_match_data(Exchange * exchange, uint8_t * fingerprint, ui
 		uint64_t participant_cnt = get_count_deque(bid_participants);
 		// there are no more participants, so we can remove this item from table and free its memory
 		if (participant_cnt == 0){
-			Exchange_Item * removed_item = (Exchange_Item *) remove_item_table(exchange -> bids, found_bid);
+			Exchange_Item * removed_item = (Exchange_Item *) remove_item_exchange_sharded_table(exchange -> bids, found_bid);
 			// assert(removed_item == found_bid)
 			if (unlikely(removed_item != found_bid)){
 				fprintf(stderr, "Error: issue removing exchange bid item after a offer_match confirmation from node: %u\n", node_id);
+				pthread_mutex_unlock(&(found_bid -> exch_item_lock));
 				return -1;
 			}
 
-			destroy_exchange_item(found_bid);
+			// other workers might have looked up this item before it was removed, 
+			// so it gets destroyed once they are done with it
+			pthread_mutex_unlock(&(found_bid -> exch_item_lock));
+			retire_epoch(exchange -> epoch_domain, found_bid, &retire_exchange_item);
 		}
 		else{
 			// there were more participants, so we aren't destroying but need to release lock
@@ -575,7 +661,7 @@ int post_future(Exchange * exchange, uint8_t * fingerprint, uint32_t node_id) {
 			fprintf(stderr, "Error: could not initialize new future exchange item\n");
 			return -1;
 		}
-		ret = insert_item_table(exchange -> futures, new_future);
+		ret = insert_item_exchange_sharded_table(exchange -> futures, new_future);
 		if (ret != 0){
 			fprintf(stderr, "Error: could not insert new future to exchange table\n");
 			return -1;
@@ -586,117 +672,156 @@ int post_future(Exchange * exchange, uint8_t * fingerprint, uint32_t node_id) {
 }
 
 
-// If offer is the trigger, then matching participants will be the set of bids that the exchange needs to send with the trigger_node_id as data location
-// If bid is the trigger, then matching participants will be the set of offer locations that the exchannge needs to send back to the trigger node
-int generate_match_ctrl_messages(uint32_t self_id, uint32_t trigger_node_id, bool is_offer_trigger, uint8_t * fingerprint, Deque * matching_particpants, uint32_t * ret_num_ctrl_messages, Ctrl_Message ** ret_ctrl_messages){
+// Copies the node ids of the matching participants into the sender's scratch space while holding the 
+// list lock, so that the match messages can be sent without holding the lock (or being within the epoch)
 
+// The scratch space is only grown (outside of the lock) if there are more participants than it has ever held
 
+// returns 0 on success (setting *ret_num_participants, which may be 0), -1 on error
+static int copy_matching_participants(Deque * matching_particpants, Ctrl_Message_Sender * sender, uint32_t * ret_num_participants){
 
-	*ret_num_ctrl_messages = 0;
-	*ret_ctrl_messages = NULL;
+	*ret_num_participants = 0;
 
 	// ensure that we only generate matching participants if non-null
 	if (matching_particpants == NULL){
 		return 0;
 	}
 
+	uint32_t matching_particpants_cnt;
+	uint32_t * participant_node_ids;
 
-	// Now need to iterate over all the participants and create a message for each one
 	pthread_mutex_lock(&(matching_particpants -> list_lock));
 
-	uint32_t matching_particpants_cnt = (uint32_t) matching_particpants -> cnt;
-	if (matching_particpants_cnt == 0){
+	matching_particpants_cnt = (uint32_t) matching_particpants -> cnt;
+	while (unlikely(matching_particpants_cnt > sender -> max_participant_node_ids)){
+
 		pthread_mutex_unlock(&(matching_particpants -> list_lock));
-		return 0;
+
+		participant_node_ids = (uint32_t *) realloc(sender -> participant_node_ids, matching_particpants_cnt * sizeof(uint32_t));
+		if (participant_node_ids == NULL){
+			fprintf(stderr, "Error: realloc failed to grow participant node ids scratch space to %u\n", matching_particpants_cnt);
+			return -1;
+		}
+		sender -> participant_node_ids = participant_node_ids;
+		sender -> max_participant_node_ids = matching_particpants_cnt;
+
+		// more participants might have been added in the meantime
+		pthread_mutex_lock(&(matching_particpants -> list_lock));
+		matching_particpants_cnt = (uint32_t) matching_particpants -> cnt;
 	}
 
+	participant_node_ids = sender -> participant_node_ids;
+
+	uint32_t num_participants = 0;
+	Deque_Item * cur_deque_item = matching_particpants -> head;
+	while ((cur_deque_item != NULL) && (num_participants < matching_particpants_cnt)){
+		participant_node_ids[num_participants] = ((Participant *) cur_deque_item -> item) -> node_id;
+		num_participants++;
+		cur_deque_item = cur_deque_item -> next;
+	}
+
+	pthread_mutex_unlock(&(matching_particpants -> list_lock));
+
+	*ret_num_participants = num_participants;
+
+	return 0;
+}
+
+
+// If offer is the trigger, then matching participants will be the set of bids that the exchange needs to send with the trigger_node_id as data location
+// If bid is the trigger, then matching participants will be the set of offer locations that the exchannge needs to send back to the trigger node
+
+// Each message is reserved from the sender, populated in place and committed. Reserving may block
+// and committing a self-directed message processes it directly, so this is called without holding any 
+// locks with the participants copied by copy_matching_participants
+
+// A message that fails is reported and the rest are still sent, returns -1 if any failed
+static int generate_match_ctrl_messages(uint32_t self_id, uint32_t trigger_node_id, bool is_offer_trigger, uint8_t * fingerprint, 
+											uint32_t num_participants, uint32_t * participant_node_ids, Ctrl_Message_Sender * sender){
+
+	int ret;
+
 	uint32_t num_response_messages;
 	if (is_offer_trigger){
-		num_response_messages = matching_particpants_cnt;
+		num_response_messages = num_participants;
 	}
 	else{
 		// the ceil of number of response messages
-		num_response_messages = matching_particpants_cnt / MAX_FINGERPRINT_MATCH_LOCATIONS + ((matching_particpants_cnt % MAX_FINGERPRINT_MATCH_LOCATIONS) != 0);
-	}
-
-
-	Ctrl_Message * match_messages = (Ctrl_Message *) malloc(num_response_messages * sizeof(Ctrl_Message));
-	if (match_messages == NULL){
-		fprintf(stderr, "Error: malloc failed to allocate memory for generating match ctrl messages\n");
-		pthread_mutex_unlock(&(matching_particpants -> list_lock));
-		return -1;
+		num_response_messages = num_participants / MAX_FINGERPRINT_MATCH_LOCATIONS + ((num_participants % MAX_FINGERPRINT_MATCH_LOCATIONS) != 0);
 	}
 
 
+	Ctrl_Message * match_message;
 	Inventory_Message * inventory_message;
 	Fingerprint_Match * fingerprint_match;
-	Deque_Item * cur_deque_item = matching_particpants -> head;
+	uint32_t participant_ind = 0;
 
-	// If the offer was the trigger, we need to send a set of different control messages indicating this offer node's location to each of the bid participants
-	if (is_offer_trigger){
+	uint32_t dest_node_id;
 
-		uint32_t i = 0;
-		uint32_t bid_node_id;
-		while (cur_deque_item != NULL){
-			bid_node_id = ((Participant *) cur_deque_item -> item) -> node_id;
+	int num_failed = 0;
 
-			match_messages[i].header.source_node_id = self_id;
-			match_messages[i].header.dest_node_id = bid_node_id;
-			match_messages[i].header.message_class = INVENTORY_CLASS;
+	for (uint32_t message_ind = 0; message_ind < num_response_messages; message_ind++){
 
-			inventory_message = (Inventory_Message *) (&(match_messages[i].contents));
-			inventory_message -> message_type = FINGERPRINT_MATCH;
+		// If the offer was the trigger, we need to send a set of different control messages indicating this offer node's location to each of the bid participants
+		// If the bid was the trigger, we need to send num_participants / MAX_FINGERPRINT_MATCH_LOCATIONS messages to the node with all the locations of the offers
+		if (is_offer_trigger){
+			dest_node_id = participant_node_ids[message_ind];
+		}
+		else{
+			dest_node_id = trigger_node_id;
+		}
 
-			fingerprint_match = (Fingerprint_Match *) inventory_message -> message;
-			memcpy(fingerprint_match -> fingerprint, fingerprint, FINGERPRINT_NUM_BYTES);
-			fingerprint_match -> num_nodes = 1;
-			(fingerprint_match -> node_ids)[0] = trigger_node_id; 
+		match_message = (sender -> reserve)(sender -> sender_arg, dest_node_id);
+		if (match_message == NULL){
+			fprintf(stderr, "Error: could not reserve match ctrl message #%u (of %u) to node %u\n", message_ind, num_response_messages, dest_node_id);
+			num_failed++;
+			// these locations still need to be skipped over
+			if (!is_offer_trigger){
+				participant_ind += MAX_FINGERPRINT_MATCH_LOCATIONS;
+			}
+			continue;
+		}
+
+		match_message -> header.source_node_id = self_id;
+		match_message -> header.dest_node_id = dest_node_id;
+		match_message -> header.message_class = INVENTORY_CLASS;
 
-			cur_deque_item = cur_deque_item -> next;
-			i++;
+		inventory_message = (Inventory_Message *) (&(match_message -> contents));
+		inventory_message -> message_type = FINGERPRINT_MATCH;
+
+		fingerprint_match = (Fingerprint_Match *) inventory_message -> message;
+		memcpy(fingerprint_match -> fingerprint, fingerprint, FINGERPRINT_NUM_BYTES);
+
+		if (is_offer_trigger){
+			fingerprint_match -> num_nodes = 1;
+			(fingerprint_match -> node_ids)[0] = trigger_node_id;
 		}
-	}
-	// If the bid was the trigger, we need to send matching_particpants_cnt / MAX_FINGERPRINT_MATCH_LOCATIONS messages to the node with all the locations of the offers
-	else{
-		
-		uint32_t offer_node_id;
-		uint32_t match_node_id_ind;
-		for (int message_ind = 0; message_ind < num_response_messages; message_ind++){
-			
-			match_messages[message_ind].header.source_node_id = self_id;
-			match_messages[message_ind].header.dest_node_id = trigger_node_id;
-			match_messages[message_ind].header.message_class = INVENTORY_CLASS;
-
-			inventory_message = (Inventory_Message *) (&(match_messages[message_ind].contents));
-			inventory_message -> message_type = FINGERPRINT_MATCH;
-
-			fingerprint_match = (Fingerprint_Match *) inventory_message -> message;
-			memcpy(fingerprint_match -> fingerprint, fingerprint, FINGERPRINT_NUM_BYTES);
+		else{
 			fingerprint_match -> num_nodes = 0;
-
-			match_node_id_ind = 0;
-			while ((cur_deque_item != NULL) && (match_node_id_ind < MAX_FINGERPRINT_MATCH_LOCATIONS)){
-				offer_node_id = ((Participant *) cur_deque_item -> item) -> node_id;
+			while ((participant_ind < num_participants) && (fingerprint_match -> num_nodes < MAX_FINGERPRINT_MATCH_LOCATIONS)){
+				(fingerprint_match -> node_ids)[fingerprint_match -> num_nodes] = participant_node_ids[participant_ind];
 				fingerprint_match -> num_nodes += 1;
-				(fingerprint_match -> node_ids)[match_node_id_ind] = offer_node_id; 
-				cur_deque_item = cur_deque_item -> next;
-				match_node_id_ind++;
+				participant_ind++;
 			}
 		}
 
+		ret = (sender -> commit)(sender -> sender_arg);
+		if (ret != 0){
+			fprintf(stderr, "Error: could not send match ctrl message #%u (of %u) to node %u\n", message_ind, num_response_messages, dest_node_id);
+			num_failed++;
+		}
 	}
 
-	pthread_mutex_unlock(&(matching_particpants -> list_lock));
-
-	*ret_num_ctrl_messages = num_response_messages;
-	*ret_ctrl_messages = match_messages;
+	if (num_failed > 0){
+		return -1;
+	}
 
 	return 0;
 }
 
 
 
-int do_exchange_function(Exchange * exchange, Ctrl_Message * ctrl_message, uint32_t * ret_num_ctrl_messages, Ctrl_Message ** ret_ctrl_messages) {
+int do_exchange_function(Exchange * exchange, Ctrl_Message * ctrl_message, Ctrl_Message_Sender * sender) {
 
 	int ret;
 
@@ -709,10 +834,14 @@ int do_exchange_function(Exchange * exchange, Ctrl_Message * ctrl_message, uint3
 	
 	Deque * matching_particpants;
 
-	// Default return values
-	// generate_match_ctrl_messages may override these...
-	*ret_num_ctrl_messages = 0;
-	*ret_ctrl_messages = NULL;
+	// set when a bid/offer matched, the messages are generated
+	// after leaving the epoch
+	bool is_offer_trigger = false;
+	uint32_t num_participants = 0;
+
+	// the matching participants deques belong to items that other 
+	// workers might remove before the participants are copied
+	enter_epoch(exchange -> epoch_domain);
 
 	switch(exch_message_type){			
 			case BID_ORDER:
@@ -720,9 +849,9 @@ int do_exchange_function(Exchange * exchange, Ctrl_Message * ctrl_message, uint3
 				if (unlikely(ret != 0)){
 					fprintf(stderr, "Error: could not post bid from node_id %u\n", node_id);
 				}
-				ret = generate_match_ctrl_messages(exchange -> self_id, node_id, false, fingerprint, matching_particpants, ret_num_ctrl_messages, ret_ctrl_messages);
+				ret = copy_matching_participants(matching_particpants, sender, &num_participants);
 				if (unlikely(ret != 0)){
-					fprintf(stderr, "Error: could not generate match notification message after posting bid from node_id %u\n", node_id);
+					fprintf(stderr, "Error: could not copy matching participants after posting bid from node_id %u\n", node_id);
 				}
 				break;
 			case OFFER_ORDER:
@@ -730,9 +859,10 @@ int do_exchange_function(Exchange * exchange, Ctrl_Message * ctrl_message, uint3
 				if (unlikely(ret != 0)){
 					fprintf(stderr, "Error: could not post bid from node_id %u\n", node_id);
 				}
-				ret = generate_match_ctrl_messages(exchange -> self_id, node_id, true, fingerprint, matching_particpants, ret_num_ctrl_messages, ret_ctrl_messages);
+				is_offer_trigger = true;
+				ret = copy_matching_participants(matching_particpants, sender, &num_participants);
 				if (unlikely(ret != 0)){
-					fprintf(stderr, "Error: could not generate match notification message after posting bid from node_id %u\n", node_id);
+					fprintf(stderr, "Error: could not copy matching participants after posting offer from node_id %u\n", node_id);
 				}
 				break;
 			case OFFER_CONFIRM_MATCH_DATA_ORDER:
@@ -752,6 +882,17 @@ int do_exchange_function(Exchange * exchange, Ctrl_Message * ctrl_message, uint3
 				break;
 	}
 
+	exit_epoch(exchange -> epoch_domain);
+
+	// Sending may block and self-directed messages get processed by the sender,
+	// so this happens outside of the epoch and without the participants' list lock
+	if (num_participants > 0){
+		ret = generate_match_ctrl_messages(exchange -> self_id, node_id, is_offer_trigger, fingerprint, num_participants, sender -> participant_node_ids, sender);
+		if (unlikely(ret != 0)){
+			fprintf(stderr, "Error: could not generate all match notification messages after posting order from node_id %u\n", node_id);
+		}
+	}
+
 	return ret;
 
 }
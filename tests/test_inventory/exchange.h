@@ -4,7 +4,9 @@
 #include "common.h"
 #include "config.h"
 #include "table.h"
+#include "sharded_table.h"
 #include "deque.h"
+#include "epoch.h"
 #include "fingerprint.h"
 #include "inventory_messages.h"
 
@@ -82,9 +84,15 @@ typedef struct exchange {
 	uint64_t max_bids;
 	uint64_t max_offers;
 	uint64_t max_futures;
-	Table * bids;
-	Table * offers;
-	Table * futures;
+	Sharded_Table * bids;
+	Sharded_Table * offers;
+	Sharded_Table * futures;
+
+	// Exchange items found within the tables (and their participants deques) are only
+	// referenced within a critical section of this domain (every do_exchange_function call is one).
+	// Once an item is removed it is retired here, so a concurrent worker that
+	// already looked it up can keep using it without holding exch_item_lock
+	Epoch_Domain * epoch_domain;
 
 	// Maintain an array to reference each participant
 	// TODO: needs to dynamically increaes when notification of new node
@@ -108,14 +116,38 @@ Exchange * init_exchange();
 int update_init_exchange_with_net_info(Exchange * exchange, uint32_t self_id, uint32_t max_nodes);
 
 
+// Some exchange functions generate messages that need to be sent out (match notifications).
+// Instead of returning them in an allocated array, the exchange builds each one in place through
+// the calling worker's sender:
+//	- reserve returns the message to populate for dest_node_id (NULL on error)
+//		(i.e. a slot within a registered send buffer, so the message is never copied)
+//	- commit sends the message that was last reserved, returns 0 on success
+// Messages are reserved and committed one at a time
+
+// The sender also holds the calling worker's scratch space for the node ids of a match's
+// participants (copied under the participants' lock, then used to build the messages)
+//	- sized for max_nodes upon init, so matches never allocate
+//	- only grown if a participants list has more entries than that
+typedef struct ctrl_message_sender {
+	void * sender_arg;
+	Ctrl_Message * (*reserve)(void * sender_arg, uint32_t dest_node_id);
+	int (*commit)(void * sender_arg);
+	uint32_t max_participant_node_ids;
+	uint32_t * participant_node_ids;
+} Ctrl_Message_Sender;
+
+
 // The generic function called by exchange workers who then call the appropriate
 // order type.
 
-// Some exchange functions will generate a return message that should be sent out the exchange will populated a return control message that the calling worker then can then send
-// appropriately
+// Many functions will have no messages to send
+int do_exchange_function(Exchange * exchange, Ctrl_Message * ctrl_message, Ctrl_Message_Sender * sender);
 
-// Many functions will have no return type
-int do_exchange_function(Exchange * exchange, Ctrl_Message * ctrl_message, uint32_t * ret_num_ctrl_messages, Ctrl_Message ** ret_ctrl_messages);
+// Prefetches the table slots that do_exchange_function will look up for each of the messages, so
+// a worker that drained many messages at once overlaps their cache misses
+//	- only the prefetches are batched: each message can insert/remove the items that the following
+//	  ones look up, so the messages must still be processed one at a time, in order
+void prefetch_exchange_functions(Exchange * exchange, uint64_t num_messages, Ctrl_Message * ctrl_messages);
 
 
 
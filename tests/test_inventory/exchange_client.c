@@ -51,7 +51,11 @@ int submit_exchange_order(System * system, uint8_t * fingerprint, ExchMessageTyp
 
 		printf("\n\n[Node %d: Exchange Client -- 0] Inserting outstanding bid into table...\n", net_world -> self_node_id);
 
+		// the insert compares against bids already within the table, which inventory 
+		// workers might be removing (and retiring) concurrently
+		enter_epoch(inventory -> epoch_domain);
 		ret = insert_item_table(inventory -> outstanding_bids, new_bid);
+		exit_epoch(inventory -> epoch_domain);
 		if (ret < 0){
 			fprintf(stderr, "Error: unable to insert outstnading bid into table\n");
 			return -1;
@@ -93,8 +97,11 @@ int submit_exchange_order(System * system, uint8_t * fingerprint, ExchMessageTyp
 
 		// a.) Actually post to self exchange
 
-		uint32_t num_triggered_ctrl_messages;
-		Ctrl_Message * triggered_ctrl_messages;
+		// any triggered responses are sent out from within do_exchange_function
+		// this may block depending on size of send queue...
+		Exchange_Net_Sender net_sender;
+		Ctrl_Message_Sender sender;
+		init_exchange_net_sender(&net_sender, net_world, inventory, EXCHANGE_CLIENT, 0, &sender);
 
 		// within exchange.c
 		exch_message_type_to_str(exch_message_type_str, exch_message -> message_type);
@@ -106,44 +113,11 @@ int submit_exchange_order(System * system, uint8_t * fingerprint, ExchMessageTyp
 							net_world -> self_node_id, exch_message_type_str, fingerprint_as_hex_str);
 
 		
-		ret = do_exchange_function(self_exchange, &exch_ctrl_message, &num_triggered_ctrl_messages, &triggered_ctrl_messages);
+		ret = do_exchange_function(self_exchange, &exch_ctrl_message, &sender);
 		if (ret != 0){
 			fprintf(stderr, "Error: when submitting an exchange message to self exchange, do_exchange_function failed\n");
 			return -1;
 		}
-
-		// b.) Potentially send triggered responses
-		//		(and free the triggered_ctrl_messages array that was allocated within do_exchange_function)
-
-		// now send out all the triggered messages
-		// this may block depending on size of send queue...
-		for (uint32_t i = 0; i < num_triggered_ctrl_messages; i++){
-
-			// a.) first check if we actually need to send a message or if it is self-directed
-			
-			if (triggered_ctrl_messages[i].header.dest_node_id != net_world -> self_node_id){
-				ret = post_send_ctrl_net(net_world, &(triggered_ctrl_messages[i]));
-				if (ret != 0){
-					fprintf(stderr, "Error: post_send_ctrl_net failed when sending out triggered ctrl messages from exchange (triggered message #%u)\n", i);
-					// still free the array that was allocated within do_exchange_function
-					free(triggered_ctrl_messages);
-					return -1;
-				}
-			}
-			else {
-				// TODO: actually call function to process this self-directed message
-				if (triggered_ctrl_messages[i].header.message_class == INVENTORY_CLASS){
-					print_inventory_message(net_world -> self_node_id, EXCHANGE_CLIENT, 0, &(triggered_ctrl_messages[i]));
-
-					ret = do_inventory_function(inventory, EXCHANGE_CLIENT, 0, &(triggered_ctrl_messages[i]), NULL, NULL);
-					if (ret){
-						fprintf(stderr, "Error: unable to do inventory function from exchange worker\n");
-						return -1;
-					}
-				}
-			}
-		}
-		free(triggered_ctrl_messages);
 	}
 	else{
 
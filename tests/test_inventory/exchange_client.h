@@ -9,6 +9,7 @@
 #include "work_pool.h"
 #include "inventory.h"
 #include "sys.h"
+#include "exchange_worker.h"
 
 
 // content size only matters if bid order to be able to then allocate space upon match
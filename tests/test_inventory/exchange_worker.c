@@ -1,5 +1,77 @@
 #include "exchange_worker.h"
 
+
+static Ctrl_Message * reserve_exchange_net_sender(void * _net_sender, uint32_t dest_node_id) {
+
+	int ret;
+
+	Exchange_Net_Sender * net_sender = (Exchange_Net_Sender *) _net_sender;
+
+	// Ensure to not post to self and instead directly pass to proper function
+	if (dest_node_id == net_sender -> net_world -> self_node_id){
+		net_sender -> is_self_message = true;
+		return &(net_sender -> self_message);
+	}
+
+	net_sender -> is_self_message = false;
+
+	ret = reserve_send_ctrl_net(net_sender -> net_world, dest_node_id, &(net_sender -> reservation));
+	if (ret != 0){
+		fprintf(stderr, "Error: could not reserve send ctrl message to node %u\n", dest_node_id);
+		return NULL;
+	}
+
+	return net_sender -> reservation.ctrl_message;
+}
+
+static int commit_exchange_net_sender(void * _net_sender) {
+
+	int ret;
+
+	Exchange_Net_Sender * net_sender = (Exchange_Net_Sender *) _net_sender;
+
+	if (!net_sender -> is_self_message){
+		return commit_send_ctrl_channel(&(net_sender -> reservation));
+	}
+
+	// Messages to self are never posted, instead the message is passed directly to the proper function
+	Ctrl_Message * self_message = &(net_sender -> self_message);
+	if (self_message -> header.message_class == INVENTORY_CLASS){
+		print_inventory_message(net_sender -> net_world -> self_node_id, net_sender -> worker_type, net_sender -> thread_id, self_message);
+		ret = do_inventory_function(net_sender -> inventory, net_sender -> worker_type, net_sender -> thread_id, self_message, NULL, NULL);
+		if (ret){
+			fprintf(stderr, "Error: unable to do inventory function for self-directed message from exchange\n");
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+int init_exchange_net_sender(Exchange_Net_Sender * net_sender, Net_World * net_world, Inventory * inventory, WorkerType worker_type, int thread_id, Ctrl_Message_Sender * ret_sender) {
+
+	net_sender -> net_world = net_world;
+	net_sender -> inventory = inventory;
+	net_sender -> worker_type = worker_type;
+	net_sender -> thread_id = thread_id;
+	net_sender -> is_self_message = false;
+
+	ret_sender -> sender_arg = net_sender;
+	ret_sender -> reserve = &reserve_exchange_net_sender;
+	ret_sender -> commit = &commit_exchange_net_sender;
+
+	// every node (and the master) can be a participant
+	ret_sender -> max_participant_node_ids = net_world -> max_nodes + 1;
+	ret_sender -> participant_node_ids = (uint32_t *) malloc(ret_sender -> max_participant_node_ids * sizeof(uint32_t));
+	if (ret_sender -> participant_node_ids == NULL){
+		fprintf(stderr, "Error: malloc failed to allocate participant node ids for exchange net sender\n");
+		return -1;
+	}
+
+	return 0;
+}
+
+
 void * run_exchange_worker(void * _worker_thread_data) {
 	
 
@@ -53,10 +125,18 @@ void * run_exchange_worker(void * _worker_thread_data) {
 	Ctrl_Message_H ctrl_message_header;
 	Exch_Message * exch_message;
 
-	uint32_t num_triggered_response_ctrl_messages;
-	Ctrl_Message * triggered_response_ctrl_messages;
+	// any control messages that need be sent out in response to some trigger
+	// are built and sent by the exchange through this
+	Exchange_Net_Sender net_sender;
+	Ctrl_Message_Sender sender;
+	ret = init_exchange_net_sender(&net_sender, net_world, inventory, EXCHANGE_WORKER, worker_thread_id, &sender);
+	if (ret != 0){
+		fprintf(stderr, "Error: could not initialize exchange net sender within exchange worker\n");
+		return NULL;
+	}
 
 	uint64_t num_consumed;
+	uint64_t num_prefetch;
 
 	char message_type_str[255];
 	char fingerprint_as_hex_str[2 * FINGERPRINT_NUM_BYTES + 1];
@@ -82,6 +162,16 @@ void * run_exchange_worker(void * _worker_thread_data) {
 
 		for (uint64_t i = 0; i < num_consumed; i++){
 
+			// Start the table lookups of the next chunk of messages before processing
+			// them one by one (within exchange.c)
+			if ((i % TABLE_BATCH_PREFETCH_ITEMS) == 0){
+				num_prefetch = num_consumed - i;
+				if (num_prefetch > TABLE_BATCH_PREFETCH_ITEMS){
+					num_prefetch = TABLE_BATCH_PREFETCH_ITEMS;
+				}
+				prefetch_exchange_functions(exchange, num_prefetch, &(ctrl_messages[i]));
+			}
+
 			ctrl_message = ctrl_messages[i];
 			ctrl_message_header = ctrl_message.header;
 			
@@ -115,46 +205,14 @@ void * run_exchange_worker(void * _worker_thread_data) {
 			}
 
 			// 2.) Actually perform the task
-			ret = do_exchange_function(exchange, &ctrl_message, &num_triggered_response_ctrl_messages, &triggered_response_ctrl_messages);
+			//	- (the response messages are sent from within, see reserve/commit_exchange_net_sender)
+			ret = do_exchange_function(exchange, &ctrl_message, &sender);
 			if (ret != 0){
 				fprintf(stderr, "[Exchange Worker %d] Error: do_exchange_function failed\n", worker_thread_id);
 			}
 
 
-			// 3. If there are any control messages that need be send out in response to some trigger, do so
-			for (uint32_t i = 0; i < num_triggered_response_ctrl_messages; i++){
-
-				// Ensure to not post to self and instead directly pass to proper function
-				if (triggered_response_ctrl_messages[i].header.dest_node_id != net_world -> self_node_id){
-					ret = post_send_ctrl_net(net_world, &(triggered_response_ctrl_messages[i]));
-					if (ret != 0){
-						fprintf(stderr, "[Exchange Worker %d] Error: after do exchange function, was supposed to send %u triggered messages. But posting a send ctrl message for #%u failed\n", 
-						worker_thread_id, num_triggered_response_ctrl_messages, i);
-					}
-				}
-				else{
-
-					// TODO: actually call function to process this self-directed message
-					if (triggered_response_ctrl_messages[i].header.message_class == INVENTORY_CLASS){
-						print_inventory_message(net_world -> self_node_id, EXCHANGE_WORKER, worker_thread_id, &(triggered_response_ctrl_messages[i]));
-						ret = do_inventory_function(inventory, EXCHANGE_WORKER, worker_thread_id, &(triggered_response_ctrl_messages[i]), NULL, NULL);
-						if (ret){
-							fprintf(stderr, "Error: unable to do inventory function from exchange worker\n");
-						}
-					}
-				}
-			}
-
-
-			// 4.) Clean up memory if necesary
-			// generate_match_ctrl_messages() allocated memory if there were messages that needed to be sent, but now free
-			// because the message informatioin got copied to the send control channel
-			if (num_triggered_response_ctrl_messages > 0){
-				free(triggered_response_ctrl_messages);
-			}
-
-
-			// 5.) If we have work_bench set, do bookeeping
+			// 3.) If we have work_bench set, do bookeeping
 			//			- Indicate completed task
 
 
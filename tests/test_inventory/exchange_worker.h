@@ -18,6 +18,27 @@ typedef struct exchange_worker_data {
 } Exchange_Worker_Data;
 
 
+// The Ctrl_Message_Sender (see exchange.h) argument used by exchange workers 
+// and the exchange client when posting to the self exchange
+//	- messages to other nodes are built directly within the registered buffer of the default send channel
+//	- messages to this node are built within self_message and passed straight to the inventory on commit
+typedef struct exchange_net_sender {
+	Net_World * net_world;
+	Inventory * inventory;
+	WorkerType worker_type;
+	int thread_id;
+	// set upon reserve, based on the destination
+	bool is_self_message;
+	Ctrl_Send_Reservation reservation;
+	Ctrl_Message self_message;
+} Exchange_Net_Sender;
+
+
+// Populates net_sender and ret_sender (which references net_sender)
+// returns 0 on success, -1 if the participants scratch space could not be allocated
+int init_exchange_net_sender(Exchange_Net_Sender * net_sender, Net_World * net_world, Inventory * inventory, WorkerType worker_type, int thread_id, Ctrl_Message_Sender * ret_sender);
+
+
 void * run_exchange_worker(void * _worker_thread_data);
 
 #endif
\ No newline at end of file
@@ -3,7 +3,8 @@
 
 Fast_List * init_fast_list(uint64_t node_buffer_capacity){
 
-	Fast_List * fast_list = (Fast_List *) malloc(sizeof(Fast_List));
+	// the first buffer of nodes directly follows the list
+	Fast_List * fast_list = (Fast_List *) malloc(sizeof(Fast_List) + node_buffer_capacity * sizeof(Fast_List_Node));
 	if (!fast_list){
 		fprintf(stderr, "Error: malloc failed to allocate fast_list\n");
 		return NULL;
@@ -13,6 +14,12 @@ Fast_List * init_fast_list(uint64_t node_buffer_capacity){
 	fast_list -> head = NULL;
 	fast_list -> tail = NULL;
 
+	fast_list -> free_nodes = NULL;
+	fast_list -> unused_nodes = (Fast_List_Node *) (fast_list + 1);
+	fast_list -> num_unused_nodes = node_buffer_capacity;
+	fast_list -> num_buffer_nodes = node_buffer_capacity;
+	fast_list -> node_buffers = NULL;
+
 	return fast_list;
 }
 
@@ -20,6 +27,15 @@ Fast_List * init_fast_list(uint64_t node_buffer_capacity){
 void destroy_fast_list(Fast_List * fast_list){
 
 	// assert cnt == 0
+
+	void * node_buffer = fast_list -> node_buffers;
+	void * next_node_buffer;
+	while (node_buffer){
+		next_node_buffer = *((void **) node_buffer);
+		free(node_buffer);
+		node_buffer = next_node_buffer;
+	}
+
 	free(fast_list);
 	return;
 }
@@ -29,11 +45,38 @@ Fast_List_Node * create_fast_list_node(Fast_List * fast_list){
 
 	Fast_List_Node * new_node;
 
-	new_node = malloc(sizeof(Fast_List_Node));
-	if (!new_node){
-		fprintf(stderr, "Error: malloc failed to allocate new fast list node\n");
-		return NULL;
+	if (fast_list -> free_nodes){
+		new_node = fast_list -> free_nodes;
+		fast_list -> free_nodes = new_node -> next;
 	}
+	else{
+
+		if (fast_list -> num_unused_nodes == 0){
+
+			uint64_t num_new_nodes = fast_list -> num_buffer_nodes;
+			if (num_new_nodes == 0){
+				num_new_nodes = 1;
+			}
+
+			void * node_buffer = malloc(sizeof(void *) + num_new_nodes * sizeof(Fast_List_Node));
+			if (!node_buffer){
+				fprintf(stderr, "Error: malloc failed to allocate new fast list node buffer\n");
+				return NULL;
+			}
+
+			*((void **) node_buffer) = fast_list -> node_buffers;
+			fast_list -> node_buffers = node_buffer;
+
+			fast_list -> unused_nodes = (Fast_List_Node *) (((void **) node_buffer) + 1);
+			fast_list -> num_unused_nodes = num_new_nodes;
+			fast_list -> num_buffer_nodes += num_new_nodes;
+		}
+
+		new_node = fast_list -> unused_nodes;
+		fast_list -> unused_nodes += 1;
+		fast_list -> num_unused_nodes -= 1;
+	}
+
 	new_node -> item = 0;
 	new_node -> prev = NULL;
 	new_node -> next = NULL;
@@ -42,7 +85,8 @@ Fast_List_Node * create_fast_list_node(Fast_List * fast_list){
 }
 
 void destroy_fast_list_node(Fast_List * fast_list, Fast_List_Node * fast_list_node){
-	free(fast_list_node);
+	fast_list_node -> next = fast_list -> free_nodes;
+	fast_list -> free_nodes = fast_list_node;
 }
 
 
@@ -11,10 +11,27 @@ struct fast_list_node {
 	Fast_List_Node * next;
 };
 
+// The nodes are carved out of buffers owned by the list (so they never move and
+// their references stay valid). The first buffer holds node_buffer_capacity nodes
+// and is allocated along with the list. If it runs out, each additional buffer holds
+// as many nodes as all of the previous buffers combined.
+
+// Removed nodes are kept on a free list for reuse and the buffers are only
+// freed when the list is destroyed
 typedef struct fast_list {
 	uint64_t cnt;
 	Fast_List_Node * head;
 	Fast_List_Node * tail;
+	// linked through next
+	Fast_List_Node * free_nodes;
+	// the never used nodes at the end of the newest buffer
+	Fast_List_Node * unused_nodes;
+	uint64_t num_unused_nodes;
+	// total nodes within all the buffers
+	uint64_t num_buffer_nodes;
+	// singly linked list of the additional buffers
+	// (the next pointer is stored in the first bytes of the buffer)
+	void * node_buffers;
 } Fast_List;
 
 
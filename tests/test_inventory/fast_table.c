@@ -1,5 +1,10 @@
 #include "fast_table.h"
 
+#include <immintrin.h>
+
+// resizing re-inserts through the same placement as insert
+static int insert_item_fast_table(Fast_Table * fast_table, void * key, void * value, uint64_t * ret_max_dist);
+
 // Assumes memory has already been allocated for fast_table container
 
 Fast_Table_Config * save_fast_table_config(Hash_Func hash_func, uint64_t key_size_bytes, uint64_t value_size_bytes, 
@@ -19,72 +24,454 @@ Fast_Table_Config * save_fast_table_config(Hash_Func hash_func, uint64_t key_siz
 	config -> key_size_bytes = key_size_bytes;
 	config -> value_size_bytes = value_size_bytes;
 
+	switch (key_size_bytes){
+		case 1:
+			config -> key_type = FAST_TABLE_KEY_8;
+			break;
+		case 2:
+			config -> key_type = FAST_TABLE_KEY_16;
+			break;
+		case 4:
+			config -> key_type = FAST_TABLE_KEY_32;
+			break;
+		case 8:
+			config -> key_type = FAST_TABLE_KEY_64;
+			break;
+		default:
+			config -> key_type = FAST_TABLE_KEY_GENERIC;
+			break;
+	}
+
+	for (int i = 0; i < FAST_TABLE_SLAB_NUM_SIZE_CLASSES; i++){
+		(config -> slabs)[i] = NULL;
+		(config -> num_empty_slabs)[i] = 0;
+	}
+
+	config -> epoch_domain = NULL;
+
 	return config;
 
 }
 
-// if memory error on creating table returns -1
-// otherwise 0
-int init_fast_table(Fast_Table * fast_table, Fast_Table_Config * config) {
+void set_epoch_domain_fast_table_config(Fast_Table_Config * config, Epoch_Domain * epoch_domain){
+	config -> epoch_domain = epoch_domain;
+}
 
-	uint64_t min_size = config -> min_size;
-	fast_table -> config = config;
-	fast_table -> cnt = 0;
+void destroy_fast_table_config(Fast_Table_Config * config){
+
+	// with all tables destroyed every slab is empty and therefore on its class' list
+	struct fast_table_slab * slab;
+	struct fast_table_slab * next_slab;
+	for (int i = 0; i < FAST_TABLE_SLAB_NUM_SIZE_CLASSES; i++){
+		slab = (config -> slabs)[i];
+		while (slab){
+			next_slab = *((struct fast_table_slab **) slab);
+			free(slab);
+			slab = next_slab;
+		}
+	}
 
-	fast_table -> size = min_size;
+	free(config);
+}
 
 
+// The values array starts after the (padded) keys array
+// rounded up to 8 bytes so pointer-sized values stay aligned
+static inline uint64_t get_values_offset_fast_table(uint64_t key_size_bytes, uint64_t size){
+	return ((size * key_size_bytes + FAST_TABLE_KEY_PADDING_BYTES) + 7) & ~((uint64_t) 7);
+}
 
+static inline void * get_key_fast_table(void * items, uint64_t key_size_bytes, uint64_t ind){
+	return (void *) (((uint64_t) items) + ind * key_size_bytes);
+}
 
-	// also uses an extra byte per entry to indicate if 
-	// there is an item in that slot (otherwise wouldn't be able
-	// to distinguish the key/value should be 0's or if they are empty)
+static inline void * get_value_fast_table(void * items, uint64_t key_size_bytes, uint64_t value_size_bytes, uint64_t size, uint64_t ind){
+	return (void *) (((uint64_t) items) + get_values_offset_fast_table(key_size_bytes, size) + ind * value_size_bytes);
+}
 
-	// this will be a bit vector where each item is a uint64_t
-	// it is of size ceil(fast_table -> size / 64) == size shifted by 
+// Values that are whole words (the common case of pointers or embedded structures
+// of pointers) get written a word at a time so a concurrent find never sees a torn pointer.
+// A NULL src zeros the value
+static inline void store_value_fast_table(void * dest, void * src, uint64_t value_size_bytes){
 
-	// the index into the table is the high order bits 56 bits of the bucket index within
-	// fast_table -> items
+	if ((value_size_bytes & 0x7) != 0){
+		if (src){
+			memcpy(dest, src, value_size_bytes);
+		}
+		else{
+			memset(dest, 0, value_size_bytes);
+		}
+		return;
+	}
 
-	// and the bit position within each vector is the low order 6 bits
-	
-	int bit_vector_els = MY_CEIL(min_size, 64);
-	fast_table -> is_empty_bit_vector = (uint64_t *) malloc(bit_vector_els * sizeof(uint64_t));
-	if (unlikely(!fast_table -> is_empty_bit_vector)){
+	uint64_t * dest_words = (uint64_t *) dest;
+	uint64_t num_words = value_size_bytes >> 3;
+	uint64_t word = 0;
+	for (uint64_t i = 0; i < num_words; i++){
+		if (src){
+			memcpy(&word, ((uint8_t *) src) + (i << 3), sizeof(uint64_t));
+		}
+		__atomic_store_n(&dest_words[i], word, __ATOMIC_RELAXED);
+	}
+}
+
+// The probe distances follow the bit vector, padded so that
+// a 16 byte load at the last slot stays within the allocation
+static inline uint8_t * get_probe_dists_fast_table(uint64_t * is_empty_bit_vector, uint64_t size){
+	return (uint8_t *) (is_empty_bit_vector + MY_CEIL(size, 64));
+}
+
+// Every block starts with this header, followed by the bit vector.
+
+// The size lets a block pointer on its own describe the table, so concurrent
+// finds only need to load the bit vector pointer to get a consistent view (see
+// set_epoch_domain_fast_table_config). The owner lets a retired block be
+// released back to its slab
+typedef struct fast_table_block_header {
+	uint64_t size;
+	// the slab the block was carved from if the size is within
+	// FAST_TABLE_SLAB_MAX_SIZE_CLASS, otherwise the config
+	void * owner;
+} Fast_Table_Block_Header;
+
+// The start of every slab, followed by its blocks
+typedef struct fast_table_slab {
+	// next must stay first (see destroy_fast_table_config)
+	struct fast_table_slab * next;
+	struct fast_table_slab * prev;
+	Fast_Table_Config * config;
+	// singly linked list of the free blocks within this slab
+	// (the next pointer is stored in the first bytes of the block)
+	void * free_blocks;
+	uint64_t num_used;
+	uint64_t size_class;
+} Fast_Table_Slab;
+
+// keep the blocks 16 byte aligned
+#define FAST_TABLE_SLAB_HEADER_BYTES ((sizeof(Fast_Table_Slab) + 15) & ~((uint64_t) 15))
+
+static inline Fast_Table_Block_Header * get_block_header_fast_table(uint64_t * is_empty_bit_vector){
+	return ((Fast_Table_Block_Header *) is_empty_bit_vector) - 1;
+}
+
+// smallest size_class such that size <= 2^size_class
+static inline int get_size_class_fast_table(uint64_t size){
+	if (size <= 1){
+		return 0;
+	}
+	return 64 - __builtin_clzll(size - 1);
+}
+
+static inline Fast_Table_Config * get_block_config_fast_table(Fast_Table_Block_Header * block_header){
+	if (get_size_class_fast_table(block_header -> size) <= FAST_TABLE_SLAB_MAX_SIZE_CLASS){
+		return ((Fast_Table_Slab *) (block_header -> owner)) -> config;
+	}
+	return (Fast_Table_Config *) (block_header -> owner);
+}
+
+// The items start after the bit vector and probe distances
+// within the table's block (offset from the bit vector)
+static inline uint64_t get_items_offset_fast_table(uint64_t size){
+	return (MY_CEIL(size, 64) * sizeof(uint64_t) + size + FAST_TABLE_KEY_PADDING_BYTES + 15) & ~((uint64_t) 15);
+}
+
+static inline void * get_items_fast_table(uint64_t * is_empty_bit_vector, uint64_t size){
+	return (void *) (((uint64_t) is_empty_bit_vector) + get_items_offset_fast_table(size));
+}
+
+static inline uint64_t get_block_bytes_fast_table(Fast_Table_Config * config, uint64_t size){
+	return sizeof(Fast_Table_Block_Header) + get_items_offset_fast_table(size) + get_values_offset_fast_table(config -> key_size_bytes, size) + size * config -> value_size_bytes;
+}
+
+
+// The number of distinct keys for the widths that can use the direct layout, otherwise 0
+static inline uint64_t get_key_space_fast_table(Fast_Table_Config * config){
+	switch (config -> key_type){
+		case FAST_TABLE_KEY_8:
+			return 1UL << 8;
+		case FAST_TABLE_KEY_16:
+			return 1UL << 16;
+		default:
+			return 0;
+	}
+}
+
+static inline Fast_Table_Layout get_layout_fast_table(Fast_Table_Config * config, uint64_t size){
+	if (size == get_key_space_fast_table(config)){
+		return FAST_TABLE_LAYOUT_DIRECT;
+	}
+	if ((size <= FAST_TABLE_SORTED_MAX_SIZE) && (config -> key_type != FAST_TABLE_KEY_GENERIC)){
+		return FAST_TABLE_LAYOUT_SORTED;
+	}
+	return FAST_TABLE_LAYOUT_HASH;
+}
+
+// The number of items a table of this size can hold before it needs to grow
+static inline uint64_t get_load_cap_fast_table(Fast_Table_Config * config, uint64_t size){
+	if (get_layout_fast_table(config, size) == FAST_TABLE_LAYOUT_HASH){
+		// make sure types are correct when multiplying uint64_t by float
+		return (uint64_t) (size * config -> load_factor);
+	}
+	// sorted and direct tables can be completely full
+	return size;
+}
+
+static inline uint64_t get_grow_size_fast_table(Fast_Table_Config * config, uint64_t size){
+
+	// casting from float to uint64 is fine
+	uint64_t new_size = (uint64_t) (size * (1.0f / config -> load_factor));
+
+	// once the table would cover half of the key space
+	// go straight to the direct layout
+	uint64_t key_space = get_key_space_fast_table(config);
+	if ((key_space > 0) && (new_size >= (key_space >> 1))){
+		new_size = key_space;
+	}
+
+	if (new_size > config -> max_size){
+		new_size = config -> max_size;
+	}
+	return new_size;
+}
+
+static inline void unlink_slab_fast_table(Fast_Table_Config * config, Fast_Table_Slab * slab){
+	if (slab -> prev){
+		slab -> prev -> next = slab -> next;
+	}
+	else{
+		(config -> slabs)[slab -> size_class] = slab -> next;
+	}
+	if (slab -> next){
+		slab -> next -> prev = slab -> prev;
+	}
+}
+
+static inline void push_slab_fast_table(Fast_Table_Config * config, Fast_Table_Slab * slab){
+	slab -> prev = NULL;
+	slab -> next = (config -> slabs)[slab -> size_class];
+	if (slab -> next){
+		slab -> next -> prev = slab;
+	}
+	(config -> slabs)[slab -> size_class] = slab;
+}
+
+static void * alloc_slab_block_fast_table(Fast_Table_Config * config, int size_class, Fast_Table_Slab ** ret_slab){
+
+	// every slab on the list has a free block
+	Fast_Table_Slab * slab = (config -> slabs)[size_class];
+
+	if (!slab){
+
+		// need to carve out a new slab for this class
+
+		// keep the blocks 16 byte aligned
+		uint64_t block_bytes = (get_block_bytes_fast_table(config, 1ULL << size_class) + 15) & ~((uint64_t) 15);
+		uint64_t num_blocks = FAST_TABLE_SLAB_BYTES / block_bytes;
+		if (num_blocks == 0){
+			num_blocks = 1;
+		}
+
+		slab = malloc(FAST_TABLE_SLAB_HEADER_BYTES + num_blocks * block_bytes);
+		if (unlikely(!slab)){
+			fprintf(stderr, "Error: malloc failed when allocating fast table slab for size class %d\n", size_class);
+			return NULL;
+		}
+
+		slab -> config = config;
+		slab -> num_used = 0;
+		slab -> size_class = size_class;
+
+		void * block;
+		void * free_blocks = NULL;
+		for (uint64_t i = num_blocks; i > 0; i--){
+			block = (void *) (((uint64_t) slab) + FAST_TABLE_SLAB_HEADER_BYTES + (i - 1) * block_bytes);
+			*((void **) block) = free_blocks;
+			free_blocks = block;
+		}
+		slab -> free_blocks = free_blocks;
+
+		push_slab_fast_table(config, slab);
+		(config -> num_empty_slabs)[size_class] += 1;
+	}
+
+	void * block = slab -> free_blocks;
+	slab -> free_blocks = *((void **) block);
+
+	if (slab -> num_used == 0){
+		(config -> num_empty_slabs)[size_class] -= 1;
+	}
+	slab -> num_used += 1;
+
+	// full slabs leave the list until one of their blocks is released
+	if (!(slab -> free_blocks)){
+		unlink_slab_fast_table(config, slab);
+	}
+
+	*ret_slab = slab;
+	return block;
+}
+
+static void release_block_fast_table(void * block, uint64_t size){
+
+	int size_class = get_size_class_fast_table(size);
+	if (size_class > FAST_TABLE_SLAB_MAX_SIZE_CLASS){
+		free(block);
+		return;
+	}
+
+	// pushing onto the slab's free list overwrites the start of the header
+	Fast_Table_Slab * slab = (Fast_Table_Slab *) (((Fast_Table_Block_Header *) block) -> owner);
+	Fast_Table_Config * config = slab -> config;
+
+	if (!(slab -> free_blocks)){
+		push_slab_fast_table(config, slab);
+	}
+
+	*((void **) block) = slab -> free_blocks;
+	slab -> free_blocks = block;
+
+	slab -> num_used -= 1;
+	if (slab -> num_used > 0){
+		return;
+	}
+
+	if ((config -> num_empty_slabs)[size_class] >= FAST_TABLE_SLAB_MAX_EMPTY_PER_CLASS){
+		unlink_slab_fast_table(config, slab);
+		free(slab);
+		return;
+	}
+
+	(config -> num_empty_slabs)[size_class] += 1;
+}
+
+// Called by the epoch domain once no concurrent find can be using the block
+static void retire_block_fast_table(void * block){
+	Fast_Table_Block_Header * block_header = (Fast_Table_Block_Header *) block;
+	release_block_fast_table(block, block_header -> size);
+}
+
+static void free_block_fast_table(Fast_Table_Config * config, uint64_t * is_empty_bit_vector, uint64_t size){
+
+	Fast_Table_Block_Header * block_header = get_block_header_fast_table(is_empty_bit_vector);
+
+	if (config -> epoch_domain){
+		retire_epoch(config -> epoch_domain, block_header, &retire_block_fast_table);
+		return;
+	}
+
+	release_block_fast_table(block_header, size);
+}
+
+
+// Gets a block for a table of size slots and initializes the bit vector
+// (all empty), probe distances and items (all zero)
+
+// returns -1 on error, otherwise 0
+static int alloc_block_fast_table(Fast_Table_Config * config, uint64_t size, uint64_t ** ret_is_empty_bit_vector, void ** ret_items){
+
+	int size_class = get_size_class_fast_table(size);
+
+	void * block;
+	Fast_Table_Slab * slab;
+	void * owner;
+	if (size_class <= FAST_TABLE_SLAB_MAX_SIZE_CLASS){
+		block = alloc_slab_block_fast_table(config, size_class, &slab);
+		owner = slab;
+	}
+	else{
+		block = malloc(get_block_bytes_fast_table(config, size));
+		owner = config;
+	}
+
+	if (unlikely(!block)){
 		return -1;
 	}
 
+	Fast_Table_Block_Header * block_header = (Fast_Table_Block_Header *) block;
+	block_header -> size = size;
+	block_header -> owner = owner;
+
+	uint64_t * is_empty_bit_vector = (uint64_t *) (block_header + 1);
+
+	int bit_vector_els = MY_CEIL(size, 64);
+
 	// initialize everything to empty up to table size...
 	// we know that bit vector els is the minimum number of 
 	// elements to span the table size, but the last one might be
 	// partially full
 	for (int i = 0; i < bit_vector_els - 1; i++){
-		(fast_table -> is_empty_bit_vector)[i] = 0xFFFFFFFFFFFFFFFF;
+		is_empty_bit_vector[i] = 0xFFFFFFFFFFFFFFFF;
 	}
 
-	int last_vec_els = min_size & 0x3F;
+	int last_vec_els = size & 0x3F;
 
 	if (last_vec_els == 0){
-		(fast_table -> is_empty_bit_vector)[bit_vector_els - 1] = 0xFFFFFFFFFFFFFFFF;
+		is_empty_bit_vector[bit_vector_els - 1] = 0xFFFFFFFFFFFFFFFF;
 	}
 	else{
-		(fast_table -> is_empty_bit_vector)[bit_vector_els - 1] = (1ULL << last_vec_els) - 1;
+		is_empty_bit_vector[bit_vector_els - 1] = (1ULL << last_vec_els) - 1;
 	}
 
+	// zero out the probe distances and items
+	uint64_t bit_vector_bytes = bit_vector_els * sizeof(uint64_t);
+	memset((void *) (((uint64_t) is_empty_bit_vector) + bit_vector_bytes), 0, 
+				get_block_bytes_fast_table(config, size) - sizeof(Fast_Table_Block_Header) - bit_vector_bytes);
+
+	*ret_is_empty_bit_vector = is_empty_bit_vector;
+	*ret_items = get_items_fast_table(is_empty_bit_vector, size);
+
+	return 0;
+}
+
+// if memory error on creating table returns -1
+// otherwise 0
+int init_fast_table(Fast_Table * fast_table, Fast_Table_Config * config) {
+
+	uint64_t min_size = config -> min_size;
+	fast_table -> config = config;
+	fast_table -> cnt = 0;
+
+	fast_table -> size = min_size;
+
+
+
+
+	// also uses an extra byte per entry to indicate if 
+	// there is an item in that slot (otherwise wouldn't be able
+	// to distinguish the key/value should be 0's or if they are empty)
+
+	// this will be a bit vector where each item is a uint64_t
+	// it is of size ceil(fast_table -> size / 64) == size shifted by 
+
+	// the index into the table is the high order bits 56 bits of the bucket index within
+	// fast_table -> items
 
-	fast_table -> items = calloc(config -> min_size, config -> key_size_bytes + config -> value_size_bytes);
-	if (unlikely(!fast_table -> items)){
+	// and the bit position within each vector is the low order 6 bits
+	
+	// the bit vector and items share one block from the config's slabs
+	uint64_t * is_empty_bit_vector;
+	void * items;
+	int ret = alloc_block_fast_table(config, min_size, &is_empty_bit_vector, &items);
+	if (unlikely(ret == -1)){
+		fast_table -> is_empty_bit_vector = NULL;
+		fast_table -> items = NULL;
 		return -1;
 	}
+
+	fast_table -> items = items;
+	// publish the block last for concurrent finds
+	__atomic_store_n(&(fast_table -> is_empty_bit_vector), is_empty_bit_vector, __ATOMIC_RELEASE);
 	return 0;
 }
 
 
 void destroy_fast_table(Fast_Table * fast_table) {
-	free(fast_table -> is_empty_bit_vector);
-	free(fast_table -> items);
+	// the bit vector is within the table's block (right after its header)
+	if (fast_table -> is_empty_bit_vector){
+		free_block_fast_table(fast_table -> config, fast_table -> is_empty_bit_vector, fast_table -> size);
+	}
 	fast_table -> items = NULL;
-	fast_table -> is_empty_bit_vector = NULL;
+	__atomic_store_n(&(fast_table -> is_empty_bit_vector), NULL, __ATOMIC_RELEASE);
 }
 
 // returns size upon failure to find slot. should never happen because checked if null
@@ -175,32 +562,10 @@ int resize_fast_table(Fast_Table * fast_table, uint64_t new_size){
 	uint64_t key_size_bytes = fast_table -> config -> key_size_bytes;
 	uint64_t value_size_bytes = fast_table -> config -> value_size_bytes;
 
-	int bit_vector_els = MY_CEIL(new_size, 64);
-	uint64_t * new_is_empty_bit_vector = (uint64_t *) malloc(bit_vector_els * sizeof(uint64_t));
-	if (unlikely(!new_is_empty_bit_vector)){
-		fprintf(stderr, "Error: trying to resize fast table from %lu to %lu failed.\n", old_size, new_size);
-		return -1;
-	}
-
-	// initialize everything to empty up to table size...
-	// we know that bit vector els is the minimum number of 
-	// elements to span the table size, but the last one might be
-	// partially full
-	for (int i = 0; i < bit_vector_els - 1; i++){
-		new_is_empty_bit_vector[i] = 0xFFFFFFFFFFFFFFFF;
-	}
-
-	int last_vec_els = new_size & 0x3F;
-
-	if (last_vec_els == 0){
-		new_is_empty_bit_vector[bit_vector_els - 1] = 0xFFFFFFFFFFFFFFFF;
-	}
-	else{
-		new_is_empty_bit_vector[bit_vector_els - 1] = (1ULL << last_vec_els) - 1;
-	}
-	
-	void * new_items = (void *) calloc(new_size, key_size_bytes + value_size_bytes);
-	if (unlikely(!new_items)){
+	uint64_t * new_is_empty_bit_vector;
+	void * new_items;
+	int ret = alloc_block_fast_table(fast_table -> config, new_size, &new_is_empty_bit_vector, &new_items);
+	if (unlikely(ret == -1)){
 		fprintf(stderr, "Error: trying to resize fast table from %lu to %lu failed.\n", old_size, new_size);
 		return -1;
 	}
@@ -208,25 +573,29 @@ int resize_fast_table(Fast_Table * fast_table, uint64_t new_size){
 	void * old_items = fast_table -> items;
 	uint64_t * old_is_empty_bit_vector = fast_table -> is_empty_bit_vector;
 
+	// The items are re-inserted into a table that points to
+	// the new memory so the ordering of the new layout is maintained
+	Fast_Table new_table;
+	new_table.cnt = 0;
+	new_table.size = new_size;
+	new_table.config = fast_table -> config;
+	new_table.is_empty_bit_vector = new_is_empty_bit_vector;
+	new_table.items = new_items;
+
 	// we know how many items we need to re-insert
 
 	uint64_t seen_cnt = 0;
 
 	void * old_key;
 	void * old_value;
-	void * new_key_pos;
-	void * new_value_pos;
-
+	uint64_t max_dist;
 
-	uint64_t new_hash_ind;
-	uint64_t new_insert_ind;
 
-
-	// because we know the count we don't need to error check for next index returning the table size.
+	// because we know the count we don't need to error check for the insert index
 	// they are guaranteed to succeed
 	uint64_t cur_bit_vec;
 	uint64_t cur_pos_in_vec;
-	for (int old_ind = 0; old_ind < old_size; old_ind++){
+	for (uint64_t old_ind = 0; old_ind < old_size; old_ind++){
 		
 		cur_bit_vec = old_is_empty_bit_vector[old_ind >> 6];
 		cur_pos_in_vec = (old_ind & 0x3F);
@@ -237,37 +606,12 @@ int resize_fast_table(Fast_Table * fast_table, uint64_t new_size){
 		}
 
 		// Now we need to re-hash this item into new table
-		old_key = (void *) (((uint64_t) old_items) + (old_ind * (key_size_bytes + value_size_bytes)));
-		old_value = (void *) (((uint64_t) old_key) + key_size_bytes);
-
-		new_hash_ind = (fast_table -> config -> hash_func)(old_key, new_size);
-
-		// now we can get the insert index for the new table. now we are searching for next free slot
-		// and we will use the new bit vector
-		new_insert_ind = get_next_ind_fast_table(new_is_empty_bit_vector, new_size, new_hash_ind);
-
+		old_key = get_key_fast_table(old_items, key_size_bytes, old_ind);
+		old_value = get_value_fast_table(old_items, key_size_bytes, value_size_bytes, old_size, old_ind);
 
-		// now setting the pointer to be within new_items
-		new_key_pos = (void *) (((uint64_t) new_items) + (new_insert_ind * (key_size_bytes + value_size_bytes)));
-		new_value_pos = (void *) (((uint64_t) new_key_pos) + key_size_bytes);
-
-		// Actually copy into the new table place in table
-		memcpy(new_key_pos, old_key, key_size_bytes);
-		memcpy(new_value_pos, old_value, value_size_bytes);
-
-		// Ensure to update the new bit vector that we inserted at new_insert_ind 
-		// (because there may be collisions within re-inserting and we need the bit vector to track these)
-
-		// No point in updating old bit vector because we started from zero and are only increasing updwards 
-		// until we see all cnt elements
-
-		// clearing the entry for this insert_ind in the bit vector
-
-		// the bucket's upper bits represent index into the bit vector elements
-		// and the low order 6 bits represent offset into element. Set to 0 
-
-		// needs to be 1ULL otherwise will default to 1 byte
-		new_is_empty_bit_vector[new_insert_ind >> 6] &= ~(1ULL << (new_insert_ind & 0x3F));
+		// the keys are unique so this always succeeds
+		insert_item_fast_table(&new_table, old_key, old_value, &max_dist);
+		new_table.cnt += 1;
 		seen_cnt += 1;
 
 		if (seen_cnt == cnt){
@@ -279,329 +623,923 @@ int resize_fast_table(Fast_Table * fast_table, uint64_t new_size){
 	// now reset the table size, items, and bit vector 
 	// and free the old memory
 
-	free(old_is_empty_bit_vector);
-	free(old_items);
 
 	fast_table -> size = new_size;
-	fast_table -> is_empty_bit_vector = new_is_empty_bit_vector;
 	fast_table -> items = new_items;
+	// concurrent finds take their view of the table from the block
+	// so publishing the bit vector pointer switches them over atomically
+	__atomic_store_n(&(fast_table -> is_empty_bit_vector), new_is_empty_bit_vector, __ATOMIC_RELEASE);
+
+	// the old bit vector is within the old block (which contains the old items)
+	free_block_fast_table(fast_table -> config, old_is_empty_bit_vector, old_size);
 
 	return 0;
 }
 
 
-
-
-// returns 0 on success, -1 on error
-
-// does memcopiess of key and value into the table array
-// assumes the content of the key cannot be 0 of size key_size_bytes
-int insert_fast_table(Fast_Table * fast_table, void * key, void * value) {
+// Grows the table directly to the size that num_items inserts would
+// have grown it to, so that those inserts trigger no resizes
+int reserve_fast_table(Fast_Table * fast_table, uint64_t num_items){
 
 	uint64_t size = fast_table -> size;
-	uint64_t cnt = fast_table -> cnt;
+	uint64_t max_size = fast_table -> config -> max_size;
 
-	// should only happen when cnt = max_size
-	// otherwise we would have grown the table after the 
-	// prior triggering insertion
-	if (unlikely(cnt == size)){
-		return -1;
+	// same growth steps as insert
+	while ((size < max_size) && (num_items > get_load_cap_fast_table(fast_table -> config, size))){
+		size = get_grow_size_fast_table(fast_table -> config, size);
 	}
 
-	uint64_t ret = find_fast_table(fast_table, key, false, NULL);
-	if (ret != fast_table -> config -> max_size){
-		fprintf(stderr, "Error: key already exists in table. Cannot insert...\n");
-		return -1;
+	if (size == fast_table -> size){
+		return 0;
 	}
 
-	// 1.) Lookup where to place this item in the table
+	return resize_fast_table(fast_table, size);
+}
 
-	// acutally compute the hash index
-	uint64_t hash_ind = (fast_table -> config -> hash_func)(key, fast_table -> size);
 
-	// we already saw cnt != size so we are guaranteed for this to succeed
-	uint64_t insert_ind = get_next_ind_fast_table(fast_table -> is_empty_bit_vector, fast_table -> size, hash_ind);
-	
-	uint64_t key_size_bytes = fast_table -> config -> key_size_bytes;
-	uint64_t value_size_bytes = fast_table -> config -> value_size_bytes;
+// The smallest size that insert would have grown to for
+// the current count (starting from min_size)
+int compact_fast_table(Fast_Table * fast_table){
 
+	if (!(fast_table -> is_empty_bit_vector)){
+		return 0;
+	}
 
-	// Now we want to insert into the table by copying key and value 
-	// into the appropriate insert ind and then setting the 
-	// is_empty bit to 0 within the bit vector
+	uint64_t cnt = fast_table -> cnt;
+	uint64_t size = fast_table -> config -> min_size;
+	uint64_t max_size = fast_table -> config -> max_size;
 
+	while ((size < max_size) && (cnt > get_load_cap_fast_table(fast_table -> config, size))){
+		size = get_grow_size_fast_table(fast_table -> config, size);
+	}
 
-	// 2.) Copy the key and value into the table 
-	//		(memory has already been allocated for them within the table)
+	if (size >= fast_table -> size){
+		return 0;
+	}
 
-	void * items = fast_table -> items;
+	return resize_fast_table(fast_table, size);
+}
 
-	// setting the position for the key in the table
-	// this is based on the insert_index that was returned to us
-	void * key_pos = (void *) (((uint64_t) items) + (insert_ind * (key_size_bytes + value_size_bytes)));
-	// advance passed the key we will insert
-	void * value_pos = (void *) (((uint64_t) key_pos) + key_size_bytes);
 
-	// Actually place in table
-	memcpy(key_pos, key, key_size_bytes);
-	memcpy(value_pos, value, value_size_bytes);
+uint64_t get_bytes_fast_table(Fast_Table * fast_table){
 
+	if (!(fast_table -> is_empty_bit_vector)){
+		return 0;
+	}
 
-	// 3.) Update bookkeeping values
+	Fast_Table_Config * config = fast_table -> config;
+	uint64_t size = fast_table -> size;
 
-	cnt += 1;
-	fast_table -> cnt = cnt;
+	// slab blocks take up their entire size class
+	int size_class = get_size_class_fast_table(size);
+	if (size_class <= FAST_TABLE_SLAB_MAX_SIZE_CLASS){
+		return (get_block_bytes_fast_table(config, 1ULL << size_class) + 15) & ~((uint64_t) 15);
+	}
 
+	return get_block_bytes_fast_table(config, size);
+}
 
-	// clearing the entry for this insert_ind in the bit vector
 
-	// the bucket's upper bits represent index into the bit vector elements
-	// and the low order 6 bits represent offset into element. Set to 0 
+int next_item_fast_table(Fast_Table * fast_table, uint64_t * ind, void ** ret_key, void ** ret_value){
 
-	// needs to be 1ULL otherwise will default to 1 byte
-	(fast_table -> is_empty_bit_vector)[insert_ind >> 6] &= ~(1ULL << (insert_ind & 0x3F));
+	uint64_t * is_empty_bit_vector = fast_table -> is_empty_bit_vector;
+	uint64_t size = fast_table -> size;
+	uint64_t key_size_bytes;
 
+	uint64_t cur_ind = *ind;
+	uint64_t filled_vector;
 
-	// 4.) Potentially resize
+	if (!is_empty_bit_vector){
+		return -1;
+	}
 
-	// check if we exceed load and are below max cap
-	// if so, grow
-	float load_factor = fast_table -> config -> load_factor;
-	uint64_t max_size = fast_table -> config -> max_size;
-	// make sure types are correct when multiplying uint64_t by float
-	uint64_t load_cap = (uint64_t) (size * load_factor);
-	if ((size < max_size) && (cnt > load_cap)){
-		// casting from float to uint64 is fine
-		size = (uint64_t) (size * (1.0f / load_factor));
-		if (size > max_size){
-			size = max_size;
-		}
-		int ret = resize_fast_table(fast_table, size);
-		// check if there was an error growing table
-		// indicate that there was an error by being able to insert
+	while (cur_ind < size){
+		
+		// the bits beyond size are 0, which is handled after finding the slot
+		filled_vector = ~(is_empty_bit_vector[cur_ind >> 6]) & (0xFFFFFFFFFFFFFFFF << (cur_ind & 0x3F));
+		
+		if (filled_vector){
+			
+			cur_ind = (cur_ind & ~((uint64_t) 0x3F)) + __builtin_ctzll(filled_vector);
+			if (cur_ind >= size){
+				return -1;
+			}
 
-		// might want a different error message here because this is fatal
-		if (unlikely(ret == -1)){
-			return -1;
+			key_size_bytes = fast_table -> config -> key_size_bytes;
+			if (ret_key){
+				*ret_key = get_key_fast_table(fast_table -> items, key_size_bytes, cur_ind);
+			}
+			if (ret_value){
+				*ret_value = get_value_fast_table(fast_table -> items, key_size_bytes, fast_table -> config -> value_size_bytes, size, cur_ind);
+			}
+
+			*ind = cur_ind + 1;
+			return 0;
 		}
+
+		cur_ind = (cur_ind & ~((uint64_t) 0x3F)) + 64;
 	}
 
-	return 0;
+	return -1;
+}
+
+
 
 
+// KEY-WIDTH SPECIALIZED PROBING
+
+// The packed keys are scanned in windows of 16 bytes (16/8/4/2 slots
+// for 1/2/4/8 byte keys) with a single SIMD compare per window. Every
+// helper takes the key_type so that when probe_fast_table dispatches with a
+// constant each width gets its own loop. Generic key widths use a window of 1
+// and memcmp.
+
+static inline uint64_t get_window_slots_fast_table(Fast_Table_Key_Type key_type){
+	switch (key_type){
+		case FAST_TABLE_KEY_8:
+			return 16;
+		case FAST_TABLE_KEY_16:
+			return 8;
+		case FAST_TABLE_KEY_32:
+			return 4;
+		case FAST_TABLE_KEY_64:
+			return 2;
+		default:
+			return 1;
+	}
 }
 
+static inline __m128i broadcast_key_fast_table(Fast_Table_Key_Type key_type, void * key){
+	uint8_t key_8;
+	uint16_t key_16;
+	uint32_t key_32;
+	uint64_t key_64;
+	switch (key_type){
+		case FAST_TABLE_KEY_8:
+			memcpy(&key_8, key, sizeof(uint8_t));
+			return _mm_set1_epi8((char) key_8);
+		case FAST_TABLE_KEY_16:
+			memcpy(&key_16, key, sizeof(uint16_t));
+			return _mm_set1_epi16((short) key_16);
+		case FAST_TABLE_KEY_32:
+			memcpy(&key_32, key, sizeof(uint32_t));
+			return _mm_set1_epi32((int) key_32);
+		case FAST_TABLE_KEY_64:
+			memcpy(&key_64, key, sizeof(uint64_t));
+			return _mm_set1_epi64x((long long) key_64);
+		default:
+			return _mm_setzero_si128();
+	}
+}
 
-// Returns the index in the table and returns
-// the index at which it was found
-// Returns fast_table -> max_size if not found
+// bit i is set if the key in slot i of the window equals the broadcasted key
+static inline uint32_t match_keys_fast_table(Fast_Table_Key_Type key_type, void * window_keys, __m128i key_vec){
+	__m128i window = _mm_loadu_si128((__m128i *) window_keys);
+	__m128i cmp;
+	switch (key_type){
+		case FAST_TABLE_KEY_8:
+			return (uint32_t) _mm_movemask_epi8(_mm_cmpeq_epi8(window, key_vec));
+		case FAST_TABLE_KEY_16:
+			// narrow each 16-bit lane result to a byte so movemask gives 1 bit per slot
+			cmp = _mm_cmpeq_epi16(window, key_vec);
+			return (uint32_t) _mm_movemask_epi8(_mm_packs_epi16(cmp, _mm_setzero_si128()));
+		case FAST_TABLE_KEY_32:
+			return (uint32_t) _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(window, key_vec)));
+		case FAST_TABLE_KEY_64:
+			// no 64-bit compare in SSE2, so both 32-bit halves must match
+			cmp = _mm_cmpeq_epi32(window, key_vec);
+			cmp = _mm_and_si128(cmp, _mm_shuffle_epi32(cmp, 0xB1));
+			return (uint32_t) _mm_movemask_pd(_mm_castsi128_pd(cmp));
+		default:
+			return 0;
+	}
+}
 
-// A copy of the value assoicated with key in the table
-// Assumes that memory of value_sized_bytes as already been allocated to ret_val
-// And so a memory copy will succeed
-uint64_t find_fast_table(Fast_Table * fast_table, void * key, bool to_copy_value, void ** ret_value){
+static inline void store_key_fast_table(Fast_Table_Key_Type key_type, void * key_pos, void * key, uint64_t key_size_bytes){
+	switch (key_type){
+		case FAST_TABLE_KEY_8:
+			memcpy(key_pos, key, sizeof(uint8_t));
+			return;
+		case FAST_TABLE_KEY_16:
+			memcpy(key_pos, key, sizeof(uint16_t));
+			return;
+		case FAST_TABLE_KEY_32:
+			memcpy(key_pos, key, sizeof(uint32_t));
+			return;
+		case FAST_TABLE_KEY_64:
+			memcpy(key_pos, key, sizeof(uint64_t));
+			return;
+		default:
+			memcpy(key_pos, key, key_size_bytes);
+			return;
+	}
+}
 
-	uint64_t value_size_bytes = fast_table -> config -> value_size_bytes;
+// Bit i is set if slot start_ind + i is empty (for i < num_slots)
+// Assumes num_slots <= 16 and start_ind + num_slots <= table size, so
+// the window spans at most 2 elements of the bit vector
+static inline uint64_t get_empty_window_fast_table(uint64_t * is_empty_bit_vector, uint64_t start_ind, uint64_t num_slots){
 
-	// Assume we aren't finding the element...
-	if (ret_value){
-		if (to_copy_value){
-			memset((void *) ret_value, 0, value_size_bytes);
+	uint64_t vec_ind = start_ind >> 6;
+	uint64_t bit_ind = start_ind & 0x3F;
+
+	uint64_t empty_bits = is_empty_bit_vector[vec_ind] >> bit_ind;
+	if (bit_ind + num_slots > 64){
+		empty_bits |= is_empty_bit_vector[vec_ind + 1] << (64 - bit_ind);
+	}
+
+	return empty_bits & ((1ULL << num_slots) - 1);
+}
+
+
+// Bit i is set if the item in slot start_ind + i is closer to its home slot
+// than an item probing from probe_dist slots before start_ind would be at that slot.
+// Because clusters are kept sorted by home slot, the key cannot be at or after such a slot.
+
+// Distances are saturated at FAST_TABLE_MAX_PROBE_DIST, so a saturated expected distance
+// only stops on items that are known to be closer
+static inline uint64_t get_closer_window_fast_table(uint8_t * probe_dists, uint64_t start_ind, uint64_t num_slots, uint64_t probe_dist){
+
+	if (probe_dist > FAST_TABLE_MAX_PROBE_DIST){
+		probe_dist = FAST_TABLE_MAX_PROBE_DIST;
+	}
+
+	__m128i dists = _mm_loadu_si128((__m128i *) &(probe_dists[start_ind]));
+	__m128i expected_dists = _mm_adds_epu8(_mm_set1_epi8((char) probe_dist), 
+											_mm_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+
+	// no unsigned less-than in SSE2: dist >= expected <==> max(dist, expected) == dist
+	uint64_t not_closer = (uint64_t) _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_max_epu8(dists, expected_dists), dists));
+
+	return ~not_closer & ((1ULL << num_slots) - 1);
+}
+
+
+// Walks the cluster starting at hash_ind
+
+// Returns the index of key if it is in the table, otherwise returns
+// fast_table -> size and sets ret_insert_ind to the position the key belongs
+// in order to maintain the Robin Hood ordering (either the first empty slot or the
+// first item that is closer to its home slot), or size if the table is full
+static inline uint64_t probe_keys_fast_table(Fast_Table_Config * config, Fast_Table_Key_Type key_type, uint64_t * is_empty_bit_vector, uint64_t size, void * items, 
+													void * key, uint64_t hash_ind, uint64_t * ret_insert_ind){
+
+	uint64_t key_size_bytes = config -> key_size_bytes;
+	uint8_t * probe_dists = get_probe_dists_fast_table(is_empty_bit_vector, size);
+	void * keys = items;
+
+	uint64_t window_slots = get_window_slots_fast_table(key_type);
+	__m128i key_vec = broadcast_key_fast_table(key_type, key);
+
+	uint64_t cur_ind = hash_ind;
+	// also the probe distance of the start of the window
+	uint64_t slots_seen = 0;
+
+	uint64_t num_slots;
+	uint64_t stop_bits;
+	uint64_t matches;
+	void * window_keys;
+
+	// if the table is completely full there may be no slot to
+	// stop at so we bound by the size
+	while (slots_seen < size){
+
+		// don't let the window run past the end of the table,
+		// the next window will wrap around to index 0
+		num_slots = size - cur_ind;
+		if (num_slots > window_slots){
+			num_slots = window_slots;
+		}
+
+		stop_bits = get_empty_window_fast_table(is_empty_bit_vector, cur_ind, num_slots) 
+						| get_closer_window_fast_table(probe_dists, cur_ind, num_slots, slots_seen);
+
+		window_keys = get_key_fast_table(keys, key_size_bytes, cur_ind);
+		if (key_type == FAST_TABLE_KEY_GENERIC){
+			matches = (memcmp(key, window_keys, key_size_bytes) == 0);
 		}
 		else{
-			*ret_value = NULL;
+			matches = match_keys_fast_table(key_type, window_keys, key_vec);
+		}
+
+		// the key can only be before the first stopping slot
+		// (empty slots are zeroed, so a zero key could "match" them otherwise)
+		if (stop_bits){
+			matches &= (stop_bits & -stop_bits) - 1;
+		}
+		else{
+			matches &= (1ULL << num_slots) - 1;
+		}
+
+		if (matches){
+			return cur_ind + __builtin_ctzll(matches);
+		}
+
+		if (stop_bits){
+			*ret_insert_ind = cur_ind + __builtin_ctzll(stop_bits);
+			return size;
+		}
+
+		slots_seen += num_slots;
+		cur_ind += num_slots;
+		if (cur_ind == size){
+			cur_ind = 0;
 		}
 	}
 
-	if (fast_table -> items == NULL){
-		return fast_table -> config -> max_size;
+	*ret_insert_ind = size;
+	return size;
+}
+
+// The key width is fixed per config, so this switch is the only
+// branch on it per operation
+static uint64_t probe_fast_table(Fast_Table_Config * config, uint64_t * is_empty_bit_vector, uint64_t size, void * items, 
+									void * key, uint64_t hash_ind, uint64_t * ret_insert_ind){
+	switch (config -> key_type){
+		case FAST_TABLE_KEY_8:
+			return probe_keys_fast_table(config, FAST_TABLE_KEY_8, is_empty_bit_vector, size, items, key, hash_ind, ret_insert_ind);
+		case FAST_TABLE_KEY_16:
+			return probe_keys_fast_table(config, FAST_TABLE_KEY_16, is_empty_bit_vector, size, items, key, hash_ind, ret_insert_ind);
+		case FAST_TABLE_KEY_32:
+			return probe_keys_fast_table(config, FAST_TABLE_KEY_32, is_empty_bit_vector, size, items, key, hash_ind, ret_insert_ind);
+		case FAST_TABLE_KEY_64:
+			return probe_keys_fast_table(config, FAST_TABLE_KEY_64, is_empty_bit_vector, size, items, key, hash_ind, ret_insert_ind);
+		default:
+			return probe_keys_fast_table(config, FAST_TABLE_KEY_GENERIC, is_empty_bit_vector, size, items, key, hash_ind, ret_insert_ind);
 	}
+}
+
+
+
+
+// Places the item at insert_ind (as returned by the probe). If that slot is occupied
+// the rest of the cluster up to the next empty slot is shifted forward by one
+// slot. This ends in the same order as the chain of Robin Hood swaps, but moves each item once
+
+// Assumes there is an empty slot in the table and does not update the count
+// Returns the largest probe distance of the new item and the shifted items
+static uint64_t place_item_fast_table(Fast_Table * fast_table, uint64_t insert_ind, uint64_t hash_ind, void * key, void * value){
 
 	uint64_t size = fast_table -> size;
+	Fast_Table_Key_Type key_type = fast_table -> config -> key_type;
 	uint64_t key_size_bytes = fast_table -> config -> key_size_bytes;
-	uint64_t hash_ind = (fast_table -> config -> hash_func)(key, size);
+	uint64_t value_size_bytes = fast_table -> config -> value_size_bytes;
+	uint64_t * is_empty_bit_vector = fast_table -> is_empty_bit_vector;
+	uint8_t * probe_dists = get_probe_dists_fast_table(is_empty_bit_vector, size);
+	void * items = fast_table -> items;
 
+	uint64_t empty_ind = get_next_ind_fast_table(is_empty_bit_vector, size, insert_ind);
 
-	// get the next null value and search up to that point
-	// because we are using linear probing if we haven't found the key
-	// by this point then we can terminate and return that we didn't find anything
+	uint64_t max_dist = 0;
+	uint64_t cur_ind = empty_ind;
+	uint64_t prev_ind;
 
-	// we could just walk along and check the bit vector as we go, but this is easily
-	// (at albeit potential performance hit if table is very full and we do wasted work)
-	uint64_t * is_empty_bit_vector = fast_table -> is_empty_bit_vector;
-	
-	uint64_t next_empty = get_next_ind_fast_table(is_empty_bit_vector, size, hash_ind);
-	
-	uint64_t cur_ind = hash_ind;
+	// walk backwards from the empty slot so each item is only copied once
+	while (cur_ind != insert_ind){
+		
+		prev_ind = (cur_ind == 0) ? size - 1 : cur_ind - 1;
 
+		store_key_fast_table(key_type, get_key_fast_table(items, key_size_bytes, cur_ind), get_key_fast_table(items, key_size_bytes, prev_ind), key_size_bytes);
+		store_value_fast_table(get_value_fast_table(items, key_size_bytes, value_size_bytes, size, cur_ind), 
+				get_value_fast_table(items, key_size_bytes, value_size_bytes, size, prev_ind), value_size_bytes);
 
-	void * cur_table_key = (void *) (((uint64_t) fast_table -> items) + (cur_ind * (key_size_bytes + value_size_bytes)));
+		if (probe_dists[prev_ind] < FAST_TABLE_MAX_PROBE_DIST){
+			probe_dists[cur_ind] = probe_dists[prev_ind] + 1;
+		}
+		else{
+			probe_dists[cur_ind] = FAST_TABLE_MAX_PROBE_DIST;
+		}
+
+		if (probe_dists[cur_ind] > max_dist){
+			max_dist = probe_dists[cur_ind];
+		}
 
-	uint64_t items_to_check;
-	if (cur_ind <= next_empty){
-		items_to_check = next_empty - cur_ind;
+		cur_ind = prev_ind;
 	}
-	// the next empty slot needs to be
-	// wrapped around
-	else{
-		items_to_check = (size - cur_ind) + next_empty + 1;
+
+	// needs to be 1ULL otherwise will default to 1 byte
+	is_empty_bit_vector[empty_ind >> 6] &= ~(1ULL << (empty_ind & 0x3F));
+
+
+	uint64_t dist = (insert_ind >= hash_ind) ? (insert_ind - hash_ind) : (size - hash_ind + insert_ind);
+	if (dist > FAST_TABLE_MAX_PROBE_DIST){
+		dist = FAST_TABLE_MAX_PROBE_DIST;
 	}
 
+	if (dist > max_dist){
+		max_dist = dist;
+	}
 
-	int key_cmp;
-	uint64_t i = 0;
-	while (i < items_to_check) {
+	store_key_fast_table(key_type, get_key_fast_table(items, key_size_bytes, insert_ind), key, key_size_bytes);
+	store_value_fast_table(get_value_fast_table(items, key_size_bytes, value_size_bytes, size, insert_ind), value, value_size_bytes);
+	probe_dists[insert_ind] = (uint8_t) dist;
 
-		// compare the key
-		key_cmp = memcmp(key, cur_table_key, key_size_bytes);
-		// if we found the key
-		if (key_cmp == 0){
+	return max_dist;
+}
 
-			// if we want the key, we want the value immediately after, so we add key_size_bytes
-			// to the current key
-			void * table_value = (void *) (((uint64_t) cur_table_key) + key_size_bytes);
 
-			if (ret_value){
-				// now we want to copy the value and then can return
-				// if we are copying then we assume the return value is just
-				// directly the pointer to copy to
-				if (to_copy_value) {
-					memcpy((void *) ret_value, table_value, value_size_bytes);
-				}
-				else{
-					*ret_value = table_value;
-				}
-			}
 
-			return cur_ind;
-		}
 
-		// update the next key position which will be just 1 element higher so we can add the size of 1 item
+// ADAPTIVE LAYOUTS
+
+// The hash layout uses the probe + placement above. Sorted
+// and direct tables are only used for the fixed key widths
+
+static inline uint64_t get_key_value_fast_table(Fast_Table_Key_Type key_type, void * key){
+	uint8_t key_8;
+	uint16_t key_16;
+	uint32_t key_32;
+	uint64_t key_64;
+	switch (key_type){
+		case FAST_TABLE_KEY_8:
+			memcpy(&key_8, key, sizeof(uint8_t));
+			return key_8;
+		case FAST_TABLE_KEY_16:
+			memcpy(&key_16, key, sizeof(uint16_t));
+			return key_16;
+		case FAST_TABLE_KEY_32:
+			memcpy(&key_32, key, sizeof(uint32_t));
+			return key_32;
+		case FAST_TABLE_KEY_64:
+			memcpy(&key_64, key, sizeof(uint64_t));
+			return key_64;
+		default:
+			return 0;
+	}
+}
 
-		
+// The items of a sorted table fill slots [0, cnt), so the count can be
+// taken from the bit vector (size <= FAST_TABLE_SORTED_MAX_SIZE < 64)
+static inline uint64_t get_sorted_cnt_fast_table(uint64_t * is_empty_bit_vector, uint64_t size){
+	return __builtin_ctzll(is_empty_bit_vector[0] | (1ULL << size));
+}
 
-		// next empty might have a returned a value that wrapped around
-		// if the whole table
-		cur_ind = (cur_ind + 1) % size;
+// Scans all of the keys in windows (without hashing)
+static inline uint64_t scan_sorted_keys_fast_table(Fast_Table_Key_Type key_type, uint64_t key_size_bytes, uint64_t * is_empty_bit_vector, uint64_t size, void * items, void * key){
 
-		cur_table_key = (void *) (((uint64_t) fast_table -> items) + (cur_ind * (key_size_bytes + value_size_bytes)));
+	uint64_t cnt = get_sorted_cnt_fast_table(is_empty_bit_vector, size);
 
-		i += 1;
+	uint64_t window_slots = get_window_slots_fast_table(key_type);
+	__m128i key_vec = broadcast_key_fast_table(key_type, key);
+
+	uint64_t matches;
+	for (uint64_t start_ind = 0; start_ind < cnt; start_ind += window_slots){
+		matches = match_keys_fast_table(key_type, get_key_fast_table(items, key_size_bytes, start_ind), key_vec);
+		if (cnt - start_ind < window_slots){
+			matches &= (1ULL << (cnt - start_ind)) - 1;
+		}
+		if (matches){
+			return start_ind + __builtin_ctzll(matches);
+		}
 	}
-	
-	// We didn't find the element
-	return fast_table -> config -> max_size;
+
+	return size;
 }
 
+// Returns the index of key if it is in the table, otherwise size
+static uint64_t find_item_fast_table(Fast_Table_Config * config, uint64_t * is_empty_bit_vector, uint64_t size, void * items, void * key){
 
-// returns 0 upon successfully removing, -1 on error finding. 
+	uint64_t ind;
+	uint64_t hash_ind;
+	uint64_t empty_ind;
+
+	switch (get_layout_fast_table(config, size)){
+		case FAST_TABLE_LAYOUT_SORTED:
+			switch (config -> key_type){
+				case FAST_TABLE_KEY_8:
+					return scan_sorted_keys_fast_table(FAST_TABLE_KEY_8, sizeof(uint8_t), is_empty_bit_vector, size, items, key);
+				case FAST_TABLE_KEY_16:
+					return scan_sorted_keys_fast_table(FAST_TABLE_KEY_16, sizeof(uint16_t), is_empty_bit_vector, size, items, key);
+				case FAST_TABLE_KEY_32:
+					return scan_sorted_keys_fast_table(FAST_TABLE_KEY_32, sizeof(uint32_t), is_empty_bit_vector, size, items, key);
+				default:
+					return scan_sorted_keys_fast_table(FAST_TABLE_KEY_64, sizeof(uint64_t), is_empty_bit_vector, size, items, key);
+			}
+		case FAST_TABLE_LAYOUT_DIRECT:
+			// the key is the slot
+			ind = get_key_value_fast_table(config -> key_type, key);
+			if (is_empty_bit_vector[ind >> 6] & (1ULL << (ind & 0x3F))){
+				return size;
+			}
+			return ind;
+		default:
+			// scans the packed keys from hash_ind up to the next empty slot
+			hash_ind = (config -> hash_func)(key, size);
+			return probe_fast_table(config, is_empty_bit_vector, size, items, key, hash_ind, &empty_ind);
+	}
+}
 
-// Note: Might want to have different return value
-// from function to indicate a fatal error that could have occurred within resized (in the gap of freeing larger
-// table and allocating new, smaller one)
 
-// if copy_val is set to true then copy back the item
-int remove_fast_table(Fast_Table * fast_table, void * key, void * ret_value) {
+// Shifts the items after the key's position up by one slot
+static int insert_sorted_fast_table(Fast_Table * fast_table, void * key, void * value){
 
+	uint64_t cnt = fast_table -> cnt;
+	uint64_t size = fast_table -> size;
+	Fast_Table_Key_Type key_type = fast_table -> config -> key_type;
+	uint64_t key_size_bytes = fast_table -> config -> key_size_bytes;
+	uint64_t value_size_bytes = fast_table -> config -> value_size_bytes;
+	void * items = fast_table -> items;
 
-	// remove is equivalent to find, except we need to also:
-	//	a.) Confirm that other positions can still be found (by replacing as needed)
-	//	b.) mark the empty bit/decrease count
-	//	c.) potentially shrink
+	uint64_t key_value = get_key_value_fast_table(key_type, key);
+	uint64_t cur_key_value;
+
+	uint64_t insert_ind = 0;
+	while (insert_ind < cnt){
+		cur_key_value = get_key_value_fast_table(key_type, get_key_fast_table(items, key_size_bytes, insert_ind));
+		if (cur_key_value == key_value){
+			return -1;
+		}
+		if (cur_key_value > key_value){
+			break;
+		}
+		insert_ind++;
+	}
 
+	(fast_table -> is_empty_bit_vector)[0] &= ~(1ULL << cnt);
 
-	// 1.) Search for item!
+	for (uint64_t i = cnt; i > insert_ind; i--){
+		store_key_fast_table(key_type, get_key_fast_table(items, key_size_bytes, i), get_key_fast_table(items, key_size_bytes, i - 1), key_size_bytes);
+		store_value_fast_table(get_value_fast_table(items, key_size_bytes, value_size_bytes, size, i), 
+				get_value_fast_table(items, key_size_bytes, value_size_bytes, size, i - 1), value_size_bytes);
+	}
 
-	// if the item existed this will handle copying
-	// because we are removing from the table we need to copy the value
-	uint64_t empty_ind = find_fast_table(fast_table, key, true, (void **) ret_value);
+	store_key_fast_table(key_type, get_key_fast_table(items, key_size_bytes, insert_ind), key, key_size_bytes);
+	store_value_fast_table(get_value_fast_table(items, key_size_bytes, value_size_bytes, size, insert_ind), value, value_size_bytes);
 
-	// item didn't exist so we immediately return
-	if (empty_ind == (fast_table -> config -> max_size)){
+	return 0;
+}
+
+// Shifts the items after ind down by one slot
+static void remove_sorted_fast_table(Fast_Table * fast_table, uint64_t ind){
+
+	uint64_t cnt = fast_table -> cnt;
+	uint64_t size = fast_table -> size;
+	Fast_Table_Key_Type key_type = fast_table -> config -> key_type;
+	uint64_t key_size_bytes = fast_table -> config -> key_size_bytes;
+	uint64_t value_size_bytes = fast_table -> config -> value_size_bytes;
+	void * items = fast_table -> items;
+
+	for (uint64_t i = ind; i + 1 < cnt; i++){
+		store_key_fast_table(key_type, get_key_fast_table(items, key_size_bytes, i), get_key_fast_table(items, key_size_bytes, i + 1), key_size_bytes);
+		store_value_fast_table(get_value_fast_table(items, key_size_bytes, value_size_bytes, size, i), 
+				get_value_fast_table(items, key_size_bytes, value_size_bytes, size, i + 1), value_size_bytes);
+	}
+
+	memset(get_key_fast_table(items, key_size_bytes, cnt - 1), 0, key_size_bytes);
+	store_value_fast_table(get_value_fast_table(items, key_size_bytes, value_size_bytes, size, cnt - 1), NULL, value_size_bytes);
+
+	(fast_table -> is_empty_bit_vector)[0] |= (1ULL << (cnt - 1));
+}
+
+static int insert_direct_fast_table(Fast_Table * fast_table, void * key, void * value){
+
+	uint64_t size = fast_table -> size;
+	Fast_Table_Key_Type key_type = fast_table -> config -> key_type;
+	uint64_t key_size_bytes = fast_table -> config -> key_size_bytes;
+	uint64_t value_size_bytes = fast_table -> config -> value_size_bytes;
+	void * items = fast_table -> items;
+
+	uint64_t ind = get_key_value_fast_table(key_type, key);
+
+	if (!((fast_table -> is_empty_bit_vector)[ind >> 6] & (1ULL << (ind & 0x3F)))){
 		return -1;
 	}
 
+	// the keys are still stored so that resizing
+	// can treat every layout the same
+	store_key_fast_table(key_type, get_key_fast_table(items, key_size_bytes, ind), key, key_size_bytes);
+	store_value_fast_table(get_value_fast_table(items, key_size_bytes, value_size_bytes, size, ind), value, value_size_bytes);
+
+	(fast_table -> is_empty_bit_vector)[ind >> 6] &= ~(1ULL << (ind & 0x3F));
+
+	return 0;
+}
+
+static void remove_direct_fast_table(Fast_Table * fast_table, uint64_t ind){
 
-	// 2.) Ensure that we will still be able to find other items that have collided
-	// 		with a hash that is >= to the index we removed
 	uint64_t size = fast_table -> size;
 	uint64_t key_size_bytes = fast_table -> config -> key_size_bytes;
 	uint64_t value_size_bytes = fast_table -> config -> value_size_bytes;
-	uint64_t * is_empty_bit_vector = fast_table -> is_empty_bit_vector;
-	uint64_t next_empty = get_next_ind_fast_table(is_empty_bit_vector, size, empty_ind);
+	void * items = fast_table -> items;
+
+	memset(get_key_fast_table(items, key_size_bytes, ind), 0, key_size_bytes);
+	store_value_fast_table(get_value_fast_table(items, key_size_bytes, value_size_bytes, size, ind), NULL, value_size_bytes);
 
-	uint64_t items_to_check;
+	(fast_table -> is_empty_bit_vector)[ind >> 6] |= (1ULL << (ind & 0x3F));
+}
 
+// Inserts into the current layout without growing (assumes there is room)
+// Returns -1 if the key already exists, otherwise 0 and sets ret_max_dist to the
+// largest probe distance caused by the insert (0 for sorted and direct tables)
+static int insert_item_fast_table(Fast_Table * fast_table, void * key, void * value, uint64_t * ret_max_dist){
 
-	// Now we are only checking AFTER the "removed" index
+	*ret_max_dist = 0;
+
+	uint64_t size = fast_table -> size;
 
-	// we know next_empty != empty_ind because we already checked this item existed
-	if (empty_ind < next_empty){
-		items_to_check = next_empty - empty_ind - 1;
+	switch (get_layout_fast_table(fast_table -> config, size)){
+		case FAST_TABLE_LAYOUT_SORTED:
+			return insert_sorted_fast_table(fast_table, key, value);
+		case FAST_TABLE_LAYOUT_DIRECT:
+			return insert_direct_fast_table(fast_table, key, value);
+		default:
+			break;
 	}
-	// the next empty slot needs to be
-	// wrapped around
-	else{
-		// -1 because we start after the empty ind
-		items_to_check = (size - empty_ind - 1) + next_empty;
+
+	// acutally compute the hash index
+	uint64_t hash_ind = (fast_table -> config -> hash_func)(key, size);
+
+	// the probe both checks for the key and gives us the position
+	// it belongs in the cluster
+	uint64_t insert_ind;
+	uint64_t found_ind = probe_fast_table(fast_table -> config, fast_table -> is_empty_bit_vector, size, fast_table -> items, key, hash_ind, &insert_ind);
+	if (found_ind != size){
+		return -1;
 	}
 
-	uint64_t i = 0;
-	uint64_t hash_ind;
-	void * cur_table_key;
-	uint64_t cur_ind = (empty_ind + 1) % size;
-	void * empty_table_key = (void *) (((uint64_t) fast_table -> items) + (empty_ind * (key_size_bytes + value_size_bytes)));
-	
-	while (i < items_to_check){ 
+	//	- this shifts the items after insert_ind and
+	//		clears the is_empty bit of the slot that was filled
+	*ret_max_dist = place_item_fast_table(fast_table, insert_ind, hash_ind, key, value);
 
-		// assset (is_empty_bit_vector[cur_ind >> 6] & (cur_ind & 0x3F)) == 1
+	return 0;
+}
 
-		cur_table_key = (void *) (((uint64_t) fast_table -> items) + (cur_ind * (key_size_bytes + value_size_bytes)));
 
-		// get the hash index for the entry in the table to see if it could still be found
-		hash_ind = (fast_table -> config -> hash_func)(cur_table_key, size);
 
-		// Ref: https://stackoverflow.com/questions/9127207/hash-table-why-deletion-is-difficult-in-open-addressing-scheme
 
-		// If cur_table_key wouldn't be able to be found again we need to move it to the 
-		// empty_ind position to ensure that it could be
-		if (((cur_ind > empty_ind) && (hash_ind <= empty_ind || hash_ind > cur_ind))
-			|| ((cur_ind < empty_ind) && (hash_ind <= empty_ind && hash_ind > cur_ind))){
-			
-			// perform the replacement
-			memcpy(empty_table_key, cur_table_key, key_size_bytes + value_size_bytes);
+// returns 0 on success, -1 on error
+
+// does memcopiess of key and value into the table array
+// assumes the content of the key cannot be 0 of size key_size_bytes
+int insert_fast_table(Fast_Table * fast_table, void * key, void * value) {
+
+	Fast_Table_Config * config = fast_table -> config;
+	uint64_t size = fast_table -> size;
+	uint64_t cnt = fast_table -> cnt;
+	uint64_t max_size = config -> max_size;
+
+	int ret;
 
-			// now reset the next time we might need to replace
-			empty_ind = cur_ind;
-			empty_table_key = cur_table_key;
+	// 1.) Grow first if this item would exceed the load of the current layout
+	if ((size < max_size) && (cnt >= get_load_cap_fast_table(config, size))){
+		ret = resize_fast_table(fast_table, get_grow_size_fast_table(config, size));
+		// might want a different error message here because this is fatal
+		if (unlikely(ret == -1)){
+			return -1;
 		}
+		size = fast_table -> size;
+	}
 
-		i += 1;
+	// should only happen when cnt = max_size
+	if (unlikely(cnt == size)){
+		return -1;
+	}
 
-		// update position of cur table key and index
-		cur_ind = (cur_ind + 1) % size;
-		
 
+	// 2.) Copy the key and value into the table 
+	//		(memory has already been allocated for them within the table)
+	uint64_t max_dist;
+	ret = insert_item_fast_table(fast_table, key, value, &max_dist);
+	if (ret){
+		fprintf(stderr, "Error: key already exists in table. Cannot insert...\n");
+		return -1;
 	}
 
-	// 3.) Do proper bookkeeping. Mark the last empty slot (after re-shuffling) as empty now
 
-	// otherwise we need to update
-	fast_table -> cnt -= 1;
+	// 3.) Update bookkeeping values
+
+	fast_table -> cnt = cnt + 1;
 
-	// clearing the entry for this insert_ind in the bit vector
+
+	// 4.) A hash table also grows if some item got displaced too far
+	//		(and the load is high enough that growing would actually shorten the probes)
+
+	if ((size < max_size) && (max_dist >= FAST_TABLE_MAX_PROBE_DIST) && ((cnt + 1) > (size >> FAST_TABLE_PROBE_GROW_MIN_LOAD_SHIFT))){
+		ret = resize_fast_table(fast_table, get_grow_size_fast_table(config, size));
+		if (unlikely(ret == -1)){
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+
+// Returns the index in the table and returns
+// the index at which it was found
+// Returns fast_table -> max_size if not found
+
+// A copy of the value assoicated with key in the table
+// Assumes that memory of value_sized_bytes as already been allocated to ret_val
+// And so a memory copy will succeed
+uint64_t find_fast_table(Fast_Table * fast_table, void * key, bool to_copy_value, void ** ret_value){
+
+	// Take a single snapshot of the block so a concurrent resize
+	// cannot mix sizes and items (the block holds its own size)
+	uint64_t * is_empty_bit_vector = __atomic_load_n(&(fast_table -> is_empty_bit_vector), __ATOMIC_ACQUIRE);
+
+	// The block also records its config. A concurrent find might be within a table whose 
+	// container is being moved (or cleared) by the writer, so it only relies on the block
+	Fast_Table_Config * config = is_empty_bit_vector ? get_block_config_fast_table(get_block_header_fast_table(is_empty_bit_vector)) : fast_table -> config;
+
+	// Assume we aren't finding the element...
+	if (ret_value){
+		if (to_copy_value){
+			memset((void *) ret_value, 0, config -> value_size_bytes);
+		}
+		else{
+			*ret_value = NULL;
+		}
+	}
+
+	if (is_empty_bit_vector == NULL){
+		// the config can only be missing when racing with the writer
+		return likely(config != NULL) ? config -> max_size : UINT64_MAX;
+	}
+
+	uint64_t size = get_block_header_fast_table(is_empty_bit_vector) -> size;
+	void * items = get_items_fast_table(is_empty_bit_vector, size);
+
+	uint64_t key_size_bytes = config -> key_size_bytes;
+	uint64_t value_size_bytes = config -> value_size_bytes;
+
+	uint64_t cur_ind = find_item_fast_table(config, is_empty_bit_vector, size, items, key);
+
+	// We didn't find the element
+	if (cur_ind == size){
+		return config -> max_size;
+	}
+
+	if (ret_value){
+		void * table_value = get_value_fast_table(items, key_size_bytes, value_size_bytes, size, cur_ind);
+		// now we want to copy the value and then can return
+		// if we are copying then we assume the return value is just
+		// directly the pointer to copy to
+		if (to_copy_value) {
+			memcpy((void *) ret_value, table_value, value_size_bytes);
+		}
+		else{
+			*ret_value = table_value;
+		}
+	}
+
+	return cur_ind;
+}
+
+
+// With the Robin Hood ordering this is a backward shift: every following item
+// that is not at its home slot moves back one slot. Empty slots have a 
+// probe distance of 0 so this stops at the end of the cluster
+static void remove_hash_fast_table(Fast_Table * fast_table, uint64_t empty_ind){
+
+	uint64_t size = fast_table -> size;
+	Fast_Table_Key_Type key_type = fast_table -> config -> key_type;
+	uint64_t key_size_bytes = fast_table -> config -> key_size_bytes;
+	uint64_t value_size_bytes = fast_table -> config -> value_size_bytes;
+	uint8_t * probe_dists = get_probe_dists_fast_table(fast_table -> is_empty_bit_vector, size);
+	void * items = fast_table -> items;
+
+	uint64_t cur_ind = (empty_ind + 1) % size;
+	uint64_t hash_ind;
+	uint64_t dist;
+	void * cur_table_key;
+	void * empty_table_key = get_key_fast_table(items, key_size_bytes, empty_ind);
+
+	// bounded by size in case the table was full
+	uint64_t i = 1;
+	while ((i < size) && (probe_dists[cur_ind] > 0)){
+
+		cur_table_key = get_key_fast_table(items, key_size_bytes, cur_ind);
+
+		dist = probe_dists[cur_ind];
+		// saturated distance, need the real one from the hash
+		if (unlikely(dist == FAST_TABLE_MAX_PROBE_DIST)){
+			hash_ind = (fast_table -> config -> hash_func)(cur_table_key, size);
+			dist = (cur_ind >= hash_ind) ? (cur_ind - hash_ind) : (size - hash_ind + cur_ind);
+			if (dist > FAST_TABLE_MAX_PROBE_DIST){
+				dist = FAST_TABLE_MAX_PROBE_DIST + 1;
+			}
+		}
+
+		// perform the replacement, keys and values live in separate arrays
+		store_key_fast_table(key_type, empty_table_key, cur_table_key, key_size_bytes);
+		store_value_fast_table(get_value_fast_table(items, key_size_bytes, value_size_bytes, size, empty_ind), 
+				get_value_fast_table(items, key_size_bytes, value_size_bytes, size, cur_ind), value_size_bytes);
+		probe_dists[empty_ind] = (uint8_t) (dist - 1);
+
+		// now reset the next time we might need to replace
+		empty_ind = cur_ind;
+		empty_table_key = cur_table_key;
+
+		i += 1;
+		cur_ind = (cur_ind + 1) % size;
+	}
 
 	// remove element from table
-	memset(empty_table_key, 0, key_size_bytes + value_size_bytes);
+	memset(empty_table_key, 0, key_size_bytes);
+	store_value_fast_table(get_value_fast_table(items, key_size_bytes, value_size_bytes, size, empty_ind), NULL, value_size_bytes);
+	probe_dists[empty_ind] = 0;
 
 	// the bucket's upper bits represent index into the bit vector elements
 	// and the low order 6 bits represent offset into element. 
 
 	// Set to 1 to indicate this bucket is now free 
 	(fast_table -> is_empty_bit_vector)[empty_ind >> 6] |= (1ULL << (empty_ind & 0x3F));
+}
 
 
-	// 3.) Check if this removal triggered 
+// Issues prefetches for the slot a find for key would start at
+//	- only the container and config are dereferenced, so it doesn't matter
+//	  if the table is resized before the find actually happens
+void prefetch_fast_table(Fast_Table * fast_table, void * key){
+
+	uint64_t * is_empty_bit_vector = __atomic_load_n(&(fast_table -> is_empty_bit_vector), __ATOMIC_RELAXED);
+	Fast_Table_Config * config = fast_table -> config;
+	uint64_t size = fast_table -> size;
+	void * items = fast_table -> items;
+
+	if ((!is_empty_bit_vector) || (!config) || (!items) || (size == 0)){
+		return;
+	}
+
+	uint64_t key_size_bytes = config -> key_size_bytes;
+	uint64_t value_size_bytes = config -> value_size_bytes;
+
+	uint64_t ind;
+
+	switch (get_layout_fast_table(config, size)){
+		case FAST_TABLE_LAYOUT_SORTED:
+			// the scan goes over all of the keys
+			__builtin_prefetch(is_empty_bit_vector, 0, 3);
+			__builtin_prefetch(items, 0, 3);
+			__builtin_prefetch(get_value_fast_table(items, key_size_bytes, value_size_bytes, size, 0), 0, 3);
+			return;
+		case FAST_TABLE_LAYOUT_DIRECT:
+			ind = get_key_value_fast_table(config -> key_type, key);
+			break;
+		default:
+			ind = (config -> hash_func)(key, size);
+			__builtin_prefetch(&(get_probe_dists_fast_table(is_empty_bit_vector, size)[ind]), 0, 3);
+			break;
+	}
+
+	__builtin_prefetch(&(is_empty_bit_vector[ind >> 6]), 0, 3);
+	__builtin_prefetch(get_key_fast_table(items, key_size_bytes, ind), 0, 3);
+	__builtin_prefetch(get_value_fast_table(items, key_size_bytes, value_size_bytes, size, ind), 0, 3);
+}
+
+
+// returns 0 upon successfully removing, -1 on error finding. 
+
+// Note: Might want to have different return value
+// from function to indicate a fatal error that could have occurred within resized (in the gap of freeing larger
+// table and allocating new, smaller one)
+
+// if copy_val is set to true then copy back the item
+int remove_fast_table(Fast_Table * fast_table, void * key, void * ret_value) {
+
+
+	// remove is equivalent to find, except we need to also:
+	//	a.) Confirm that other positions can still be found (by replacing as needed)
+	//	b.) mark the empty bit/decrease count
+	//	c.) potentially shrink
+
+
+	// 1.) Search for item!
+
+	// if the item existed this will handle copying
+	// because we are removing from the table we need to copy the value
+	uint64_t empty_ind = find_fast_table(fast_table, key, true, (void **) ret_value);
+
+	// item didn't exist so we immediately return
+	if (empty_ind == (fast_table -> config -> max_size)){
+		return -1;
+	}
+
+
+	// 2.) Ensure that we will still be able to find other items that have collided
+	// 		with a hash that is <= to the index we removed (hash layout), or that the
+	//		sorted items stay contiguous. Each marks the freed slot as empty
+
+	uint64_t size = fast_table -> size;
+
+	switch (get_layout_fast_table(fast_table -> config, size)){
+		case FAST_TABLE_LAYOUT_SORTED:
+			remove_sorted_fast_table(fast_table, empty_ind);
+			break;
+		case FAST_TABLE_LAYOUT_DIRECT:
+			remove_direct_fast_table(fast_table, empty_ind);
+			break;
+		default:
+			remove_hash_fast_table(fast_table, empty_ind);
+			break;
+	}
+
+	// 3.) Do proper bookkeeping
+	fast_table -> cnt -= 1;
+
+
+	// 4.) Check if this removal triggered 
 
 
 	// check if we should shrink
@@ -629,4 +1567,4 @@ int remove_fast_table(Fast_Table * fast_table, void * key, void * ret_value) {
 
 	return 0;
 
-}
\ No newline at end of file
+}
@@ -2,6 +2,7 @@
 #define FAST_TABLE_H
 
 #include "common.h"
+#include "epoch.h"
 
 
 
@@ -27,6 +28,84 @@
 // by having trees at each level point to 
 // this struct
 
+
+// All of the tables within the system use small integer keys
+// (fast tree levels + the memory server's range tables), so
+// the probe loops are specialized for these widths. The key type
+// is determined once when saving the config based on key_size_bytes
+// and any other width falls back to memcmp
+typedef enum fast_table_key_type {
+	FAST_TABLE_KEY_GENERIC,
+	FAST_TABLE_KEY_8,
+	FAST_TABLE_KEY_16,
+	FAST_TABLE_KEY_32,
+	FAST_TABLE_KEY_64
+} Fast_Table_Key_Type;
+
+// The keys are packed at the front of fast_table -> items
+// and we scan them with 16 byte unaligned loads, so we over-allocate
+// the key array by this amount so the load at the last slot
+// stays within the allocation
+#define FAST_TABLE_KEY_PADDING_BYTES 16
+
+// Insertion uses Robin Hood ordering, so every cluster stays sorted by home slot
+// and a lookup can stop at the first slot whose item is closer to its home
+// than the key being searched would be.
+
+// The distance of each item from its home slot is stored as a uint8_t
+// in the same allocation as is_empty_bit_vector (saturating at this value).
+// If an insert causes an item to be displaced this far the table grows
+// (when below max_size) even if the load factor was not reached, which
+// bounds the probe length of the tiny fast tree tables
+#define FAST_TABLE_MAX_PROBE_DIST 255
+
+// ...but only if the table is at least 1 / 2^FAST_TABLE_PROBE_GROW_MIN_LOAD_SHIFT full.
+// Below that a long probe means the keys collide within the hash (growing wouldn't 
+// spread them out), so inserts just continue past the saturated distance
+#define FAST_TABLE_PROBE_GROW_MIN_LOAD_SHIFT 2
+
+
+// Most fast tree tables are either tiny (a handful of children) or nearly
+// full (dense key ranges), so the arrangement of the slots depends on the size:
+//	- SORTED: size <= FAST_TABLE_SORTED_MAX_SIZE (non-generic keys). The items
+//		fill slots [0, cnt) in increasing key order and a find is a SIMD
+//		scan over all of the keys without hashing
+//	- DIRECT: size equals the entire key space (8 or 16 bit keys). The key
+//		is the slot index and a find is a single bit test
+//	- HASH: everything else, Robin Hood probing as described above
+// Sorted and direct tables can be completely full. Once growing would cover
+// half of the key space the table goes directly to the full key space size.
+// The layout is derived from the config + size so the block alone determines it
+typedef enum fast_table_layout {
+	FAST_TABLE_LAYOUT_HASH,
+	FAST_TABLE_LAYOUT_SORTED,
+	FAST_TABLE_LAYOUT_DIRECT
+} Fast_Table_Layout;
+
+#define FAST_TABLE_SORTED_MAX_SIZE 16
+
+
+// The bit vector (+ probe distances) and items of a table are placed
+// in a single block. Blocks for tables of up to 2^FAST_TABLE_SLAB_MAX_SIZE_CLASS
+// slots are carved out of larger slabs owned by the config, and are
+// rounded up to the next power of two size. When a table is destroyed or resized 
+// the block goes back onto the config's free list for its size class, so 
+// the constant growing/shrinking/destroying of the tiny fast tree tables
+// reuses the same memory instead of calling malloc/free.
+
+// Larger tables use malloc/free directly
+
+// Each slab counts its blocks in use. Once all of a slab's blocks are released
+// the slab is freed, except for up to FAST_TABLE_SLAB_MAX_EMPTY_PER_CLASS empty 
+// slabs per size class which are kept around so a table bouncing between two 
+// sizes doesn't malloc/free a slab every time
+#define FAST_TABLE_SLAB_MAX_EMPTY_PER_CLASS 1
+#define FAST_TABLE_SLAB_MAX_SIZE_CLASS 8
+#define FAST_TABLE_SLAB_NUM_SIZE_CLASSES (FAST_TABLE_SLAB_MAX_SIZE_CLASS + 1)
+// the number of blocks within a slab is determined by the block size
+// (at least 1 block per slab)
+#define FAST_TABLE_SLAB_BYTES (1UL << 16)
+
 typedef struct fast_table_config {
 	uint64_t min_size;
 	uint64_t max_size;
@@ -44,6 +123,16 @@ typedef struct fast_table_config {
 	uint64_t key_size_bytes;
 	// to know how much room to allocate
 	uint64_t value_size_bytes;
+	// set from key_size_bytes, selects the probe loop
+	Fast_Table_Key_Type key_type;
+	// doubly linked lists (per size class) of the slabs that have 
+	// at least one free block. Full slabs are only referenced by their blocks
+	struct fast_table_slab * slabs[FAST_TABLE_SLAB_NUM_SIZE_CLASSES];
+	// the number of slabs on each list with no blocks in use
+	uint64_t num_empty_slabs[FAST_TABLE_SLAB_NUM_SIZE_CLASSES];
+	// NULL by default. When set, blocks released by resizes and destroys
+	// are retired to this domain instead of being reused immediately
+	Epoch_Domain * epoch_domain;
 } Fast_Table_Config;
 
 
@@ -60,13 +149,20 @@ typedef struct fast_table {
 
 	// will use __builtin_ffsll() to get bit position of least-significant
 	// 1 in order to determine the next empty slot
+
+	// The same allocation continues with a uint8_t per slot holding
+	// the item's probe distance from its home slot (0 when empty)
+
+	// The block also has a small header before the bit vector recording its size,
+	// so this pointer alone is a consistent view of the table for concurrent finds
 	uint64_t * is_empty_bit_vector;
-	// array that is sized
-	// (key_size_bytes + value_size_bytes * size
-	// the indicies are implied by the total size
-	// Assumes all items inserted have the first
-	// key_size_bytes of the entry representing
-	// the key for fast comparisons
+	// points into the same block as the bit vector and contains two arrays:
+	//	- keys: packed array of size * key_size_bytes (+ FAST_TABLE_KEY_PADDING_BYTES)
+	//	- values: packed array of size * value_size_bytes starting at the
+	//		next 8-byte aligned offset after the keys
+	// the indicies are implied by the total size.
+	// Packing the keys lets a probe compare many slots
+	// with a single SIMD compare
 	void * items;
 } Fast_Table;
 
@@ -74,14 +170,45 @@ typedef struct fast_table {
 Fast_Table_Config * save_fast_table_config(Hash_Func hash_func, uint64_t key_size_bytes, uint64_t value_size_bytes, 
 						uint64_t min_table_size, uint64_t max_table_size, float load_factor, float shrink_factor);
 
+// frees the remaining (empty) slabs and the config. Assumes all tables
+// using this config have been destroyed (and if there is an epoch
+// domain, that the blocks they retired have been reclaimed)
+void destroy_fast_table_config(Fast_Table_Config * config);
+
+// Lets find_fast_table run concurrently with a single writer. The writer
+// still must be externally serialized, and readers must be within the epoch
+// (and revalidate their result, items may be moving during a find) 
+void set_epoch_domain_fast_table_config(Fast_Table_Config * config, Epoch_Domain * epoch_domain);
+
 // Assumes memory has already been allocated for fast_table container
 int init_fast_table(Fast_Table * fast_table, Fast_Table_Config * config);
 
-// all it does is free fast_table -> items
+// all it does is release the table's block (bit vector + items)
+// back to the config
 void destroy_fast_table(Fast_Table * fast_table);
 
 
 
+// Resizes the table ahead of a known number of inserts (num_items in total),
+// used when bulk loading. returns 0 on success, -1 on error
+int reserve_fast_table(Fast_Table * fast_table, uint64_t num_items);
+
+// Shrinks the table to the size it would have grown to for its current count
+// (the shrink factor can leave tables much larger than needed after many removals)
+// returns 0 on success, -1 on error
+int compact_fast_table(Fast_Table * fast_table);
+
+// The number of bytes of the table's block (bit vector + items), 0 if not initialized
+uint64_t get_bytes_fast_table(Fast_Table * fast_table);
+
+// Iterates over the items in slot order (not key order): starting with *ind = 0,
+// sets ret_key and ret_value to point at the next item within the table and advances *ind.
+// returns 0 on success, -1 once there are no more items
+
+// Any insert or remove invalidates the iteration
+int next_item_fast_table(Fast_Table * fast_table, uint64_t * ind, void ** ret_key, void ** ret_value);
+
+
 // returns 0 on success, -1 on error
 
 // does memcopiess of key and value into the table array
@@ -100,6 +227,10 @@ int insert_fast_table(Fast_Table * fast_table, void * key, void * value);
 // If to_copy_value is set the copy back the the item. If no item exists and this flag is set, ret_value is set to NULL
 uint64_t find_fast_table(Fast_Table * fast_table, void * key, bool to_copy_value, void ** ret_value);
 
+// Prefetches the slots that a find for key would start with, so lookups
+// for many keys can have their cache misses overlap
+void prefetch_fast_table(Fast_Table * fast_table, void * key);
+
 // returns 0 upon success, -1 upon error
 // The value will copied into ret_value
 int remove_fast_table(Fast_Table * fast_table, void * key, void * ret_value);
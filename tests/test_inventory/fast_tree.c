@@ -1,5 +1,7 @@
 #include "fast_tree.h"
 
+#include <immintrin.h>
+
 #define ALL_ONES_64 0xFFFFFFFFFFFFFFFF
 #define TREE_MAX ALL_ONES_64
 
@@ -24,6 +26,15 @@
 #define LEAF_KEY_MASK 0x00000000000000FF
 
 
+// A search racing with the writer (see set_epoch_domain_fast_tree) can observe
+// states that "should never happen". It will be retried so these aren't reported
+static __thread bool is_speculative_search = false;
+
+#define SEARCH_ERROR_FAST_TREE(...) do { if (!is_speculative_search) { fprintf(stderr, __VA_ARGS__); } } while (0)
+
+static int search_nosync_fast_tree(Fast_Tree * fast_tree, uint64_t search_key, FastTreeSearchModifier search_type, Fast_Tree_Result * ret_search_result);
+
+
 uint64_t hash_func_modulus_64(void * key_ref, uint64_t table_size) {
 	uint64_t key = *((uint64_t *) key_ref);
 	return key % table_size;
@@ -68,6 +79,10 @@ int fast_tree_leaf_cmp(void * fast_tree_leaf, void * other_fast_tree_leaf){
 
 // this intializes a top level fast tree
 Fast_Tree * init_fast_tree() {
+	return init_fast_tree_with_key_bits(FAST_TREE_KEY_BITS_64);
+}
+
+Fast_Tree * init_fast_tree_with_key_bits(Fast_Tree_Key_Bits key_bits) {
 
 	Fast_Tree * fast_tree = (Fast_Tree *) malloc(sizeof(Fast_Tree));
 	if (!fast_tree){
@@ -180,25 +195,40 @@ Fast_Tree * init_fast_tree() {
 	// the current tree also initialzes the inward table of the outward root with the configuration corresponding
 	// to 1 level below the current tree's level..
 
-	int ret = init_fast_table(&(fast_tree -> inward), table_config_32);
-	if (ret != 0){
-		fprintf(stderr, "Error: failure to initialize fast tree root's inward table\n");
-		return NULL;
-	}
-
+	fast_tree -> key_bits = key_bits;
 
+	memset(&(fast_tree -> inward), 0, sizeof(Fast_Table));
 	memset(&(fast_tree -> outward_root), 0, sizeof(Fast_Tree_Outward_Root_32));
 
-	// Can initialize the root's outward root's inward tree here.
-	ret = init_fast_table(&(fast_tree -> outward_root.inward), table_config_16);
-	if (ret != 0){
-		fprintf(stderr, "Error: failure to initialize fast tree root's outward root's inward table\n");
-		return NULL;
+	// A narrow tree's top level tree initializes its tables upon the first insert
+	// (like any other tree below the root)
+	memset(&(fast_tree -> narrow_root), 0, sizeof(fast_tree -> narrow_root));
+
+	int ret;
+
+	if (key_bits == FAST_TREE_KEY_BITS_64){
+
+		ret = init_fast_table(&(fast_tree -> inward), table_config_32);
+		if (ret != 0){
+			fprintf(stderr, "Error: failure to initialize fast tree root's inward table\n");
+			return NULL;
+		}
+
+		// Can initialize the root's outward root's inward tree here.
+		ret = init_fast_table(&(fast_tree -> outward_root.inward), table_config_16);
+		if (ret != 0){
+			fprintf(stderr, "Error: failure to initialize fast tree root's outward root's inward table\n");
+			return NULL;
+		}
 	}
 
 	fast_tree -> min_leaf = NULL;
 	fast_tree -> max_leaf = NULL;
 
+	fast_tree -> epoch_domain = NULL;
+	fast_tree -> write_seq_start = 0;
+	fast_tree -> write_seq_end = 0;
+
 
 	(fast_tree -> tree_stats).num_trees_32 = 0;
 	(fast_tree -> tree_stats).num_trees_16 = 0;
@@ -358,7 +388,7 @@ void link_fast_tree_leaf(Fast_Tree * root, Fast_Tree_Leaf * fast_tree_leaf){
 
 	// we know that there are at least 2 leaves and that this is 
 	// sandwiched in the middle
-	ret = search_fast_tree(root, base, FAST_TREE_PREV, &leaf_search);
+	ret = search_nosync_fast_tree(root, base, FAST_TREE_PREV, &leaf_search);
 	
 	if (unlikely(ret)){
 		fprintf(stderr, "Error: base was greater than the minimum so there should be a previous leaf...\n");
@@ -819,10 +849,82 @@ int insert_fast_tree_outward_32(Fast_Tree * root, Fast_Tree_Outward_Root_32 * fa
 
 }
 
+// NARROW TREES
+
+// All of the keys fit within the top level tree that is stored in the root,
+// so each operation starts at that level (with base 0)
+
+static inline uint64_t get_max_key_fast_tree(Fast_Tree * fast_tree){
+	switch (fast_tree -> key_bits){
+		case FAST_TREE_KEY_BITS_32:
+			return OFF_32_MASK;
+		case FAST_TREE_KEY_BITS_16:
+			return OFF_16_MASK;
+		default:
+			return TREE_MAX;
+	}
+}
+
+static int insert_narrow_fast_tree(Fast_Tree * fast_tree, uint64_t key, void * value, bool to_overwrite, void * prev_value) {
+
+	if (unlikely(key > get_max_key_fast_tree(fast_tree))){
+		fprintf(stderr, "Error: key %lu is too large for narrow fast tree\n", key);
+		return -1;
+	}
+
+	int ret;
+
+	bool element_inserted = false;
+
+	Fast_Tree_Leaf * new_main_leaf = NULL;
+
+	uint64_t base = key & LEAF_BASE_MASK;
+
+	if (fast_tree -> key_bits == FAST_TREE_KEY_BITS_32){
+		Fast_Tree_32 * tree_32 = &(fast_tree -> narrow_root.tree_32);
+		// same as a newly created tree below the root
+		if (tree_32 -> cnt == 0){
+			tree_32 -> min = key;
+			tree_32 -> max = key;
+		}
+		ret = insert_fast_tree_32(fast_tree, tree_32, (uint32_t) key, value, to_overwrite, prev_value, base, &element_inserted, &new_main_leaf);
+	}
+	else{
+		Fast_Tree_16 * tree_16 = &(fast_tree -> narrow_root.tree_16);
+		if (tree_16 -> cnt == 0){
+			tree_16 -> min = key;
+			tree_16 -> max = key;
+		}
+		ret = insert_fast_tree_16(fast_tree, tree_16, (uint16_t) key, value, to_overwrite, prev_value, base, &element_inserted, &new_main_leaf);
+	}
+
+	if (new_main_leaf){
+		link_fast_tree_leaf(fast_tree, new_main_leaf);
+	}
+
+	if (element_inserted){
+		fast_tree -> cnt += 1;
+	}
+
+	if (key < fast_tree -> min){
+		fast_tree -> min = key;
+	}
+	if (key > fast_tree -> max){
+		fast_tree -> max = key;
+	}
+
+	return ret;
+}
+
+
 // returns 0 on success -1 on error
 // fails is key is already in the tree and overwrite set to false
 // if key was already in the tree and had a non-null value, then copies the previous value into prev_value
-int insert_fast_tree(Fast_Tree * fast_tree, uint64_t key, void * value, bool to_overwrite, void * prev_value) {
+static int insert_nosync_fast_tree(Fast_Tree * fast_tree, uint64_t key, void * value, bool to_overwrite, void * prev_value) {
+
+	if (fast_tree -> key_bits != FAST_TREE_KEY_BITS_64){
+		return insert_narrow_fast_tree(fast_tree, key, value, to_overwrite, prev_value);
+	}
 
 	int ret;
 
@@ -910,505 +1012,684 @@ int insert_fast_tree(Fast_Tree * fast_tree, uint64_t key, void * value, bool to_
 
 }
 
+int insert_fast_tree(Fast_Tree * fast_tree, uint64_t key, void * value, bool to_overwrite, void * prev_value) {
 
+	if (!(fast_tree -> epoch_domain)){
+		return insert_nosync_fast_tree(fast_tree, key, value, to_overwrite, prev_value);
+	}
 
+	// concurrent searches that overlap with this will retry
+	__atomic_fetch_add(&(fast_tree -> write_seq_start), 1, __ATOMIC_SEQ_CST);
+	int ret = insert_nosync_fast_tree(fast_tree, key, value, to_overwrite, prev_value);
+	__atomic_fetch_add(&(fast_tree -> write_seq_end), 1, __ATOMIC_RELEASE);
 
-Fast_Tree_Leaf * get_leaf(Fast_Tree * fast_tree, uint64_t key){
-
-	uint32_t ind_32 = (key & IND_32_MASK) >> 32;
-	uint32_t off_32 = (key & OFF_32_MASK);
-
-	Fast_Tree_32 * inward_tree_32_ref = NULL;
-
-	find_fast_table(&(fast_tree -> inward), &ind_32, false, (void **) &inward_tree_32_ref);
+	return ret;
+}
 
-	if (!inward_tree_32_ref){
-		return NULL;
-	}
 
-	uint16_t ind_16 = (off_32 & IND_16_MASK) >> 16;
-	uint16_t off_16 = (off_32 & OFF_16_MASK);
+// BULK LOADING
 
-	Fast_Tree_16 * inward_tree_16_ref = NULL;
+// Each level is built from the sorted keys in a single pass. Because the keys are
+// sorted every child is completed (with its final min, max and cnt) before it is copied
+// into its parent's table, which is reserved up front for the number of children
 
-	find_fast_table(&(inward_tree_32_ref -> inward), &ind_16, false, (void **) &inward_tree_16_ref);
 
-	if (!inward_tree_16_ref){
-		return NULL;
+// number of distinct (key >> shift) within sorted keys
+static uint64_t count_prefixes_fast_tree(uint64_t * keys, uint64_t n, int shift){
+	uint64_t num_prefixes = 0;
+	for (uint64_t i = 0; i < n; i++){
+		if ((i == 0) || ((keys[i] >> shift) != (keys[i - 1] >> shift))){
+			num_prefixes += 1;
+		}
 	}
+	return num_prefixes;
+}
 
-	uint8_t ind_8 = (off_16 & IND_8_MASK) >> 8;
-
-	Fast_Tree_Leaf ** fast_tree_leaf_ref = NULL;
 
-	find_fast_table(&(inward_tree_16_ref -> inward_leaves), &ind_8, false, (void **) &fast_tree_leaf_ref);
+// Builds the two levels made of outward leaves (shared by Fast_Tree_Outward_Root_16
+// and non-main Fast_Tree_16's) from sorted and unique 16-bit keys
+static int build_fast_tree_outward_leaves(Fast_Tree * root, Fast_Table * inward_leaves, Fast_Tree_Outward_Leaf * outward_leaf, uint16_t * keys, uint64_t n){
 
-	if (!fast_tree_leaf_ref){
-		return NULL;
+	int ret = init_fast_table(inward_leaves, root -> table_config_outward_leaf);
+	if (unlikely(ret != 0)){
+		fprintf(stderr, "Error: failure to init inward_leaves table when building outward leaves\n");
+		return -1;
 	}
 
-	// we already checked that the reference was non-null, so we know leaf exists
-	Fast_Tree_Leaf * fast_tree_leaf = *fast_tree_leaf_ref;
-
-	return fast_tree_leaf;
-}
+	memset(outward_leaf -> bit_vector, 0, 4 * sizeof(uint64_t));
+	outward_leaf -> min = (keys[0] & IND_8_MASK) >> 8;
+	outward_leaf -> max = (keys[n - 1] & IND_8_MASK) >> 8;
 
+	uint64_t num_leaves = 1;
+	for (uint64_t i = 1; i < n; i++){
+		if ((keys[i] >> 8) != (keys[i - 1] >> 8)){
+			num_leaves += 1;
+		}
+	}
 
-// SEARCH PREV and SEARCH NEXT RETURN <= and >= key's relative to search key respectively!
-// Rely on passing -1/+1 to achieve strict predecessor/successor
-
-uint8_t lookup_bitvector_prev(uint64_t * bit_vector, uint8_t key){
+	ret = reserve_fast_table(inward_leaves, num_leaves);
+	if (unlikely(ret != 0)){
+		fprintf(stderr, "Error: failure to reserve inward_leaves table when building outward leaves\n");
+		return -1;
+	}
 
+	Fast_Tree_Outward_Leaf new_inward_leaf;
 
-	// upper 2 bits
-	uint8_t vec_ind = (key & LEAF_VEC_IND_MASK) >> 6;
-	// lower 6 bits
-	uint8_t bit_ind = (key & LEAF_BIT_POS_MASK);
+	uint8_t ind_8;
+	uint8_t off_8;
 
-	
+	uint64_t i = 0;
+	while (i < n){
 
-	uint64_t orig_vec = bit_vector[vec_ind];
-	// need to clear the upper bits (all bits at positions > bit_ind) before looing for
-	// highest set bit
+		ind_8 = (keys[i] & IND_8_MASK) >> 8;
 
-	// set 1's for all positions between [0, bit_ind]
-	uint64_t lower_mask = (((1ULL << bit_ind) - 1) | (1ULL << bit_ind));
-	uint64_t cur_search_vec = orig_vec & lower_mask;
+		memset(&new_inward_leaf, 0, sizeof(Fast_Tree_Outward_Leaf));
+		new_inward_leaf.min = keys[i] & OFF_8_MASK;
 
-	uint8_t cur_val = 64 * vec_ind;
-	uint8_t cur_vec_ind = vec_ind;
-	
-	int found_element_pos;
-	while (cur_vec_ind >= 0){
+		while ((i < n) && (((keys[i] & IND_8_MASK) >> 8) == ind_8)){
+			off_8 = keys[i] & OFF_8_MASK;
+			set_bitvector(new_inward_leaf.bit_vector, off_8);
+			new_inward_leaf.max = off_8;
+			i++;
+		}
 
-		if (cur_search_vec == 0){
-			cur_val -= 64;
-			cur_vec_ind -= 1;
-			cur_search_vec = bit_vector[cur_vec_ind];
-			continue;
+		ret = insert_fast_table(inward_leaves, &ind_8, &new_inward_leaf);
+		if (unlikely(ret != 0)){
+			fprintf(stderr, "Error: failure to insert outward leaf into table when building outward leaves\n");
+			return -1;
 		}
 
-		// get highest order set bit position
-		found_element_pos = 63 - __builtin_clzll(cur_search_vec);
+		(root -> tree_stats).num_outward_leaves += 1;
 
-		return cur_val + found_element_pos;
+		set_bitvector(outward_leaf -> bit_vector, ind_8);
 	}
 
-	// should never get here
-	fprintf(stderr, "Error: no position found in lookup_bitvector_prev\n");
-	return 0xFF;
+	return 0;
 }
 
 
-uint8_t lookup_bitvector_next(uint64_t * bit_vector, uint8_t key){
+// The main leaf holding keys[0, n), which all share the same base
+static Fast_Tree_Leaf * build_fast_tree_leaf(Fast_Tree * root, uint64_t * keys, void ** values, uint64_t n){
 
+	Fast_Tree_Leaf * fast_tree_leaf = (Fast_Tree_Leaf *) malloc(sizeof(Fast_Tree_Leaf));
+	if (unlikely(!fast_tree_leaf)){
+		fprintf(stderr, "Error: malloc failed to allocate a fast tree leaf\n");
+		return NULL;
+	}
 
-	// upper 2 bits
-	uint8_t vec_ind = (key & LEAF_VEC_IND_MASK) >> 6;
-	// lower 6 bits
-	uint8_t bit_ind = (key & LEAF_BIT_POS_MASK);
+	fast_tree_leaf -> base = keys[0] & LEAF_BASE_MASK;
+	fast_tree_leaf -> cnt = n;
+	fast_tree_leaf -> min = keys[0] & LEAF_KEY_MASK;
+	fast_tree_leaf -> max = keys[n - 1] & LEAF_KEY_MASK;
 
-	uint64_t orig_vec = bit_vector[vec_ind];
+	memset(fast_tree_leaf -> bit_vector, 0, 4 * sizeof(uint64_t));
+	for (uint64_t i = 0; i < n; i++){
+		set_bitvector(fast_tree_leaf -> bit_vector, keys[i] & LEAF_KEY_MASK);
+	}
 
-	// need to clear the lower bits before looing for
-	// highest set bit
-	uint64_t cur_search_vec = orig_vec & (ALL_ONES_64 << bit_ind);
+	int ret = init_fast_table(&(fast_tree_leaf -> values), root -> table_config_value);
+	if (unlikely(ret != 0)){
+		fprintf(stderr, "Error: failure to init value table in leaf\n");
+		return NULL;
+	}
 
-	uint8_t cur_val = 64 * vec_ind;
-	uint8_t cur_vec_ind = vec_ind;
-	int found_element_pos;
-	while (cur_vec_ind >= 0){
+	if (!values){
+		return fast_tree_leaf;
+	}
 
-		if (cur_search_vec == 0){
-			cur_val += 64;
-			cur_vec_ind += 1;
-			cur_search_vec = bit_vector[cur_vec_ind];
-			continue;
+	uint64_t num_values = 0;
+	for (uint64_t i = 0; i < n; i++){
+		if (values[i]){
+			num_values += 1;
 		}
+	}
 
-		// get lowest order set bit position
-		found_element_pos = __builtin_ctzll(cur_search_vec);
+	ret = reserve_fast_table(&(fast_tree_leaf -> values), num_values);
+	if (unlikely(ret != 0)){
+		fprintf(stderr, "Error: failure to reserve value table in leaf\n");
+		return NULL;
+	}
 
-		return cur_val + found_element_pos;
+	uint8_t value_key;
+	for (uint64_t i = 0; i < n; i++){
+		if (values[i]){
+			value_key = keys[i] & LEAF_KEY_MASK;
+			ret = insert_fast_table(&(fast_tree_leaf -> values), &value_key, &(values[i]));
+			if (unlikely(ret != 0)){
+				fprintf(stderr, "Error: failure to insert value into the table in leaf\n");
+				return NULL;
+			}
+		}
 	}
 
-	// should never get here
-	fprintf(stderr, "Error: no position found in lookup_bitvector_next\n");
-	return 0;
+	return fast_tree_leaf;
+}
 
 
-}
+// Main Fast_Tree_16 for keys[0, n) which share the same upper 48 bits
+static int build_fast_tree_16(Fast_Tree * root, Fast_Tree_16 * fast_tree, uint64_t * keys, void ** values, uint64_t n){
 
+	memset(fast_tree, 0, sizeof(Fast_Tree_16));
 
-// Because all values in the table are pointers, we can 
-// get a reference within the table and deference it
-// to get a staic pointer value that is returned
+	fast_tree -> cnt = n;
+	fast_tree -> min = keys[0] & OFF_16_MASK;
+	fast_tree -> max = keys[n - 1] & OFF_16_MASK;
 
-// The value table might get resized so we don't want to to return a pointer
-// to something within the table!
-void * get_value_from_leaf(Fast_Tree_Leaf * fast_tree_leaf, uint8_t key){
-	// if there isn't a table for this leaf
-	if (fast_tree_leaf -> values.items == NULL){
-		return NULL;
+	int ret = init_fast_table(&(fast_tree -> inward_leaves), root -> table_config_main_leaf);
+	if (unlikely(ret != 0)){
+		fprintf(stderr, "Error: failure to init inward_leaves table from main_16\n");
+		return -1;
 	}
-	// otherwise lookup key within table
-	uint8_t value_key = key;
-	void * table_value_ptr = NULL;
 
-	
-	find_fast_table(&(fast_tree_leaf -> values), &value_key, false, (void **) &table_value_ptr);
-	if ((!table_value_ptr) || !((void **) table_value_ptr)){
-		return NULL;
+	ret = reserve_fast_table(&(fast_tree -> inward_leaves), count_prefixes_fast_tree(keys, n, 8));
+	if (unlikely(ret != 0)){
+		fprintf(stderr, "Error: failure to reserve inward_leaves table from main_16\n");
+		return -1;
 	}
 
-	void * value = *((void **) table_value_ptr);
-	return value;
-}
+	Fast_Tree_Outward_Leaf * outward_leaf_ref = &(fast_tree -> outward_leaf);
+	outward_leaf_ref -> min = (keys[0] & IND_8_MASK) >> 8;
+	outward_leaf_ref -> max = (keys[n - 1] & IND_8_MASK) >> 8;
 
+	Fast_Tree_Leaf * inward_leaf;
+	uint8_t ind_8;
 
+	uint64_t start = 0;
+	uint64_t end;
+	while (start < n){
 
+		end = start + 1;
+		while ((end < n) && ((keys[end] >> 8) == (keys[start] >> 8))){
+			end++;
+		}
 
+		inward_leaf = build_fast_tree_leaf(root, &(keys[start]), values ? &(values[start]) : NULL, end - start);
+		if (unlikely(!inward_leaf)){
+			fprintf(stderr, "Error: failure to build fast tree leaf\n");
+			return -1;
+		}
 
+		// the keys are sorted so each leaf goes at the end of the list
+		inward_leaf -> prev = root -> max_leaf;
+		inward_leaf -> next = NULL;
+		if (root -> max_leaf){
+			root -> max_leaf -> next = inward_leaf;
+		}
+		else{
+			root -> min_leaf = inward_leaf;
+		}
+		root -> max_leaf = inward_leaf;
 
+		ind_8 = (keys[start] & IND_8_MASK) >> 8;
 
-// SEARCH PREV and SEARCH NEXT RETURN <= and >= key's relative to search key respectively!
-// Rely on passing -1/+1 to achieve strict predecessor/successor
+		ret = insert_fast_table(&(fast_tree -> inward_leaves), &ind_8, &inward_leaf);
+		if (unlikely(ret != 0)){
+			fprintf(stderr, "Error: failure to insert tree into table from 16\n");
+			return -1;
+		}
 
-int search_prev_fast_tree_16(Fast_Tree_16 * fast_tree, uint16_t search_key, Fast_Tree_Result * ret_search_result){
+		(root -> tree_stats).num_leaves += 1;
 
-	uint8_t ind_8 = (search_key & IND_8_MASK) >> 8;
-	uint8_t off_8 = (search_key & OFF_8_MASK);
+		set_bitvector(outward_leaf_ref -> bit_vector, ind_8);
 
+		start = end;
+	}
 
-	Fast_Tree_Leaf ** leaf_ref = NULL;
+	return 0;
+}
 
-	Fast_Tree_Leaf * main_leaf = NULL;
 
-	find_fast_table(&(fast_tree -> inward_leaves), &ind_8, false, (void **) &leaf_ref);
+// Main Fast_Tree_32 for keys[0, n) which share the same upper 32 bits
 
-	// this index did not exist so now our search will be looking for the
-	// the successor of index and returing the minimum value from this 32_tree
-	if ((!leaf_ref) || (off_8 < (*leaf_ref) -> min)){
+// ind_16_buffer has room for all 2^16 possible indices
+static int build_fast_tree_32(Fast_Tree * root, Fast_Tree_32 * fast_tree, uint64_t * keys, void ** values, uint64_t n, uint16_t * ind_16_buffer){
 
-		uint8_t prev_leaf_ind = lookup_bitvector_prev(fast_tree -> outward_leaf.bit_vector, ind_8 - 1);
+	memset(fast_tree, 0, sizeof(Fast_Tree_32));
 
-		// now we should be guarenteed that there will be a tree with the next index
-		find_fast_table(&(fast_tree -> inward_leaves), &prev_leaf_ind, false, (void **) &leaf_ref);
+	fast_tree -> cnt = n;
+	fast_tree -> min = keys[0] & OFF_32_MASK;
+	fast_tree -> max = keys[n - 1] & OFF_32_MASK;
 
-		// this should never happen
-		if (unlikely(!leaf_ref)){
-			fprintf(stderr, "Error: expected to find ind_16 tree after outward search, but not found\n");
-			ret_search_result -> key = search_key;
-			return -1;
-		}
+	int ret = init_fast_table(&(fast_tree -> inward), root -> table_config_16);
+	if (unlikely(ret != 0)){
+		fprintf(stderr, "Error: failure to init inward_tree_16 table from main_32\n");
+		return -1;
+	}
 
-		main_leaf = *leaf_ref;
+	ret = reserve_fast_table(&(fast_tree -> inward), count_prefixes_fast_tree(keys, n, 16));
+	if (unlikely(ret != 0)){
+		fprintf(stderr, "Error: failure to reserve inward_tree_16 table from main_32\n");
+		return -1;
+	}
 
-		// set the bottom result
-		ret_search_result -> key = ((uint16_t) prev_leaf_ind << 8) + (uint16_t) main_leaf -> max;
+	Fast_Tree_16 new_inward_tree_16;
+	uint16_t ind_16;
+	uint64_t num_inds_16 = 0;
 
-		// we are in the leaf of main tree, so can accelerate by populing the values here
-		ret_search_result -> fast_tree_leaf = main_leaf;
-		ret_search_result -> value = get_value_from_leaf(main_leaf, main_leaf -> max);
-	}
-	else{
+	uint64_t start = 0;
+	uint64_t end;
+	while (start < n){
 
-		main_leaf = *leaf_ref;
+		end = start + 1;
+		while ((end < n) && ((keys[end] >> 16) == (keys[start] >> 16))){
+			end++;
+		}
 
-		// this will temporarily populate the ret_search_result with 32-bit value represent next off_32
-		uint8_t prev_leaf_off = lookup_bitvector_prev(main_leaf -> bit_vector, off_8);
+		ret = build_fast_tree_16(root, &new_inward_tree_16, &(keys[start]), values ? &(values[start]) : NULL, end - start);
+		if (unlikely(ret != 0)){
+			return -1;
+		}
 
-		// set the bottom result
-		ret_search_result -> key = ((uint16_t) ind_8 << 8) + (uint16_t) prev_leaf_off;
+		ind_16 = (keys[start] & IND_16_MASK) >> 16;
 
-		ret_search_result -> fast_tree_leaf = main_leaf;
-		ret_search_result -> value = get_value_from_leaf(main_leaf, prev_leaf_off);
+		ret = insert_fast_table(&(fast_tree -> inward), &ind_16, &new_inward_tree_16);
+		if (unlikely(ret != 0)){
+			fprintf(stderr, "Error: failure to insert tree into table from 32\n");
+			return -1;
+		}
+
+		(root -> tree_stats).num_trees_16 += 1;
+
+		ind_16_buffer[num_inds_16] = ind_16;
+		num_inds_16 += 1;
+
+		start = end;
 	}
 
-	return 0;
+	ret = build_fast_tree_outward_leaves(root, &(fast_tree -> outward_root.inward_leaves), &(fast_tree -> outward_root.outward_leaf), ind_16_buffer, num_inds_16);
+	if (unlikely(ret != 0)){
+		fprintf(stderr, "Error: failure to build outward tree from 32\n");
+		return -1;
+	}
 
+	return 0;
 }
 
-int search_prev_fast_tree_nonmain_16(Fast_Tree_16 * fast_tree, uint16_t search_key, Fast_Tree_Result * ret_search_result){
 
-	uint8_t ind_8 = (search_key & IND_8_MASK) >> 8;
-	uint8_t off_8 = (search_key & OFF_8_MASK);
+// The root's outward root is built from the distinct upper 32 bits of the keys
 
+// both buffers have room for all 2^16 possible indices
+static int build_fast_tree_outward_32(Fast_Tree * root, uint64_t * keys, uint64_t n, uint16_t * off_16_buffer, uint16_t * ind_16_buffer){
 
-	Fast_Tree_Outward_Leaf * leaf_ref = NULL;
+	Fast_Tree_Outward_Root_32 * fast_tree = &(root -> outward_root);
 
-	find_fast_table(&(fast_tree -> inward_leaves), &ind_8, false, (void **) &leaf_ref);
+	// the 32-bit key within the outward root is the upper 32 bits of the original
+	int ret = reserve_fast_table(&(fast_tree -> inward), count_prefixes_fast_tree(keys, n, 48));
+	if (unlikely(ret != 0)){
+		fprintf(stderr, "Error: failure to reserve inward table of outward_32\n");
+		return -1;
+	}
 
-	// this index did not exist so now our search will be looking for the
-	// the successor of index and returing the minimum value from this 32_tree
-	if ((!leaf_ref) || (off_8 < leaf_ref -> min)){
+	Fast_Tree_16 new_inward_tree_16;
+	uint16_t ind_16;
+	uint16_t off_16;
+	uint64_t num_offs_16;
+	uint64_t num_inds_16 = 0;
 
-		uint8_t prev_leaf_ind = lookup_bitvector_prev(fast_tree -> outward_leaf.bit_vector, ind_8 - 1);
+	uint64_t i = 0;
+	while (i < n){
 
-		// now we should be guarenteed that there will be a tree with the next index
-		find_fast_table(&(fast_tree -> inward_leaves), &prev_leaf_ind, false, (void **) &leaf_ref);
+		ind_16 = keys[i] >> 48;
 
-		// this should never happen
-		if (unlikely(!leaf_ref)){
-			fprintf(stderr, "Error: expected to find ind_16 tree after outward search, but not found\n");
-			ret_search_result -> key = search_key;
+		// the distinct lower 16 bits of (key >> 32) under this ind_16
+		num_offs_16 = 0;
+		while ((i < n) && ((keys[i] >> 48) == ind_16)){
+			off_16 = (keys[i] >> 32) & OFF_16_MASK;
+			if ((num_offs_16 == 0) || (off_16_buffer[num_offs_16 - 1] != off_16)){
+				off_16_buffer[num_offs_16] = off_16;
+				num_offs_16 += 1;
+			}
+			i++;
+		}
+
+		memset(&new_inward_tree_16, 0, sizeof(Fast_Tree_16));
+		new_inward_tree_16.cnt = num_offs_16;
+		new_inward_tree_16.min = off_16_buffer[0];
+		new_inward_tree_16.max = off_16_buffer[num_offs_16 - 1];
+
+		ret = build_fast_tree_outward_leaves(root, &(new_inward_tree_16.inward_leaves), &(new_inward_tree_16.outward_leaf), off_16_buffer, num_offs_16);
+		if (unlikely(ret != 0)){
+			fprintf(stderr, "Error: failure to build nonmain_16 tree from outward_32\n");
 			return -1;
 		}
 
-		// set the bottom result
-		ret_search_result -> key = ((uint16_t) prev_leaf_ind << 8) + (uint16_t) leaf_ref -> max;
-	}
-	else{
+		ret = insert_fast_table(&(fast_tree -> inward), &ind_16, &new_inward_tree_16);
+		if (unlikely(ret != 0)){
+			fprintf(stderr, "Error: failure to insert tree into table from outward_32\n");
+			return -1;
+		}
 
-		// this will temporarily populate the ret_search_result with 32-bit value represent next off_32
-		uint8_t prev_leaf_off = lookup_bitvector_prev(leaf_ref -> bit_vector, off_8);
+		(root -> tree_stats).num_nonmain_trees_16 += 1;
 
-		// set the bottom result
-		ret_search_result -> key = ((uint16_t) ind_8 << 8) + (uint16_t) prev_leaf_off;
+		ind_16_buffer[num_inds_16] = ind_16;
+		num_inds_16 += 1;
+	}
+
+	ret = build_fast_tree_outward_leaves(root, &(fast_tree -> outward_root.inward_leaves), &(fast_tree -> outward_root.outward_leaf), ind_16_buffer, num_inds_16);
+	if (unlikely(ret != 0)){
+		fprintf(stderr, "Error: failure to build outward tree from outward_32\n");
+		return -1;
 	}
 
 	return 0;
 }
 
-int search_prev_fast_tree_outward_16(Fast_Tree_Outward_Root_16 * fast_tree, uint16_t search_key, Fast_Tree_Result * ret_search_result){
 
-	uint8_t ind_8 = (search_key & IND_8_MASK) >> 8;
-	uint8_t off_8 = (search_key & OFF_8_MASK);
+// The root's inward trees and outward root for keys[0, n) of a 64-bit tree
 
+// both buffers have room for all 2^16 possible indices
+static int build_fast_tree_64(Fast_Tree * fast_tree, uint64_t * keys, void ** values, uint64_t n, uint16_t * off_16_buffer, uint16_t * ind_16_buffer){
 
-	Fast_Tree_Outward_Leaf * leaf_ref = NULL;
+	int ret = reserve_fast_table(&(fast_tree -> inward), count_prefixes_fast_tree(keys, n, 32));
+	if (unlikely(ret != 0)){
+		fprintf(stderr, "Error: failure to reserve fast tree root's inward table\n");
+		return -1;
+	}
 
-	find_fast_table(&(fast_tree -> inward_leaves), &ind_8, false, (void **) &leaf_ref);
+	Fast_Tree_32 new_inward_tree_32;
+	uint32_t ind_32;
 
-	// this index did not exist so now our search will be looking for the
-	// the successor of index and returing the minimum value from this 32_tree
-	if ((!leaf_ref) || (off_8 < leaf_ref -> min)){
+	uint64_t start = 0;
+	uint64_t end;
+	while (start < n){
 
-		uint8_t prev_leaf_ind = lookup_bitvector_prev(fast_tree -> outward_leaf.bit_vector, ind_8 - 1);
+		end = start + 1;
+		while ((end < n) && ((keys[end] >> 32) == (keys[start] >> 32))){
+			end++;
+		}
 
-		// now we should be guarenteed that there will be a tree with the next index
-		find_fast_table(&(fast_tree -> inward_leaves), &prev_leaf_ind, false, (void **) &leaf_ref);
+		ret = build_fast_tree_32(fast_tree, &new_inward_tree_32, &(keys[start]), values ? &(values[start]) : NULL, end - start, ind_16_buffer);
+		if (unlikely(ret != 0)){
+			fprintf(stderr, "Error: failure to build inward_tree_32\n");
+			return -1;
+		}
 
-		// this should never happen
-		if (unlikely(!leaf_ref)){
-			fprintf(stderr, "Error: expected to find ind_16 tree after outward search, but not found\n");
-			ret_search_result -> key = search_key;
+		ind_32 = (keys[start] & IND_32_MASK) >> 32;
+
+		ret = insert_fast_table(&(fast_tree -> inward), &ind_32, &new_inward_tree_32);
+		if (unlikely(ret != 0)){
+			fprintf(stderr, "Error: failure to insert tree into table\n");
 			return -1;
 		}
 
-		// set the bottom result
-		ret_search_result -> key = ((uint16_t) prev_leaf_ind << 8) + (uint16_t) leaf_ref -> max;
-	}
-	else{
+		(fast_tree -> tree_stats).num_trees_32 += 1;
 
-		// this will temporarily populate the ret_search_result with 32-bit value represent next off_32
-		uint8_t prev_leaf_off = lookup_bitvector_prev(leaf_ref -> bit_vector, off_8);
+		start = end;
+	}
 
-		// set the bottom result
-		ret_search_result -> key = ((uint16_t) ind_8 << 8) + (uint16_t) prev_leaf_off;
+	ret = build_fast_tree_outward_32(fast_tree, keys, n, off_16_buffer, ind_16_buffer);
+	if (unlikely(ret != 0)){
+		fprintf(stderr, "Error: failure to build outward tree\n");
+		return -1;
 	}
 
 	return 0;
 }
 
 
-int search_prev_fast_tree_32(Fast_Tree_32 * fast_tree, uint32_t search_key, Fast_Tree_Result * ret_search_result){
-
-	uint16_t ind_16 = (search_key & IND_16_MASK) >> 16;
-	uint16_t off_16 = (search_key & OFF_16_MASK);
-
-	Fast_Tree_16 * inward_tree_16_ref = NULL;
-
-	find_fast_table(&(fast_tree -> inward), &ind_16, false, (void **) &inward_tree_16_ref);
-
-	int ret;
+Fast_Tree * build_fast_tree_sorted(uint64_t * keys, void ** values, uint64_t n){
+	return build_fast_tree_sorted_with_key_bits(FAST_TREE_KEY_BITS_64, keys, values, n);
+}
 
-	// this index did not exist so now our search will be looking for the
-	// the successor of index and returing the minimum value from this 32_tree
-	if ((!inward_tree_16_ref) || (off_16 < inward_tree_16_ref -> min)){
+Fast_Tree * build_fast_tree_sorted_with_key_bits(Fast_Tree_Key_Bits key_bits, uint64_t * keys, void ** values, uint64_t n){
 
-		// this will temporarily populate the ret_search_result with 32-bit value represent next ind_32
-		ret = search_prev_fast_tree_outward_16(&(fast_tree -> outward_root), ind_16 - 1, ret_search_result);
-		// this should never happen
-		if (unlikely(ret)){
-			fprintf(stderr, "Error: search_next_fast_tree_outward_32 returned error\n");
-			ret_search_result -> key = search_key;
-			return -1;
+	for (uint64_t i = 1; i < n; i++){
+		if (unlikely(keys[i] <= keys[i - 1])){
+			fprintf(stderr, "Error: keys passed to build_fast_tree_sorted are not sorted and unique (index %lu)\n", i);
+			return NULL;
 		}
+	}
 
-		uint32_t prev_ind_16 = ret_search_result -> key;
+	Fast_Tree * fast_tree = init_fast_tree_with_key_bits(key_bits);
+	if (unlikely(!fast_tree)){
+		fprintf(stderr, "Error: failure to init fast tree to build from sorted keys\n");
+		return NULL;
+	}
 
-		// now we should be guarenteed that there will be a tree with the next index
-		find_fast_table(&(fast_tree -> inward), &prev_ind_16, false, (void **) &inward_tree_16_ref);
+	if (n == 0){
+		return fast_tree;
+	}
 
-		// this should never happen
-		if (unlikely(!inward_tree_16_ref)){
-			fprintf(stderr, "Error: expected to find ind_16 tree after outward search, but not found\n");
-			ret_search_result -> key = search_key;
-			return -1;
-		}
+	if (unlikely(keys[n - 1] > get_max_key_fast_tree(fast_tree))){
+		fprintf(stderr, "Error: key %lu is too large for narrow fast tree\n", keys[n - 1]);
+		return NULL;
+	}
 
-		// now reset the result to be correct
-		ret_search_result -> key = ((uint32_t) prev_ind_16 << 16) + (uint32_t) inward_tree_16_ref -> max;
+	// scratch space for the distinct 16-bit indices at the
+	// outward roots, each level only needs them temporarily
+	uint16_t * off_16_buffer = (uint16_t *) malloc((1UL << 16) * sizeof(uint16_t));
+	uint16_t * ind_16_buffer = (uint16_t *) malloc((1UL << 16) * sizeof(uint16_t));
+	if (unlikely(!off_16_buffer || !ind_16_buffer)){
+		fprintf(stderr, "Error: malloc failed to allocate buffers to build fast tree\n");
+		return NULL;
 	}
-	else{
 
-		// this will temporarily populate the ret_search_result with 32-bit value represent next off_32
-		ret = search_prev_fast_tree_16(inward_tree_16_ref, off_16, ret_search_result);
+	int ret;
 
-		// this should never happen
-		if (unlikely(ret)){
-			fprintf(stderr, "Error: search_next_fast_tree_outward_16 returned error\n");
-			ret_search_result -> key = search_key;
-			return -1;
-		}
+	// A narrow tree's top level tree is built directly
+	// (it isn't counted within the tree stats, same as when inserting)
+	switch (key_bits){
+		case FAST_TREE_KEY_BITS_32:
+			ret = build_fast_tree_32(fast_tree, &(fast_tree -> narrow_root.tree_32), keys, values, n, ind_16_buffer);
+			break;
+		case FAST_TREE_KEY_BITS_16:
+			ret = build_fast_tree_16(fast_tree, &(fast_tree -> narrow_root.tree_16), keys, values, n);
+			break;
+		default:
+			ret = build_fast_tree_64(fast_tree, keys, values, n, off_16_buffer, ind_16_buffer);
+			break;
+	}
 
-		uint16_t prev_off_16 = ret_search_result -> key;
+	free(off_16_buffer);
+	free(ind_16_buffer);
 
-		// now reset the result to be correct
-		ret_search_result -> key = ((uint32_t) ind_16 << 16) + (uint32_t) prev_off_16;
+	if (unlikely(ret != 0)){
+		fprintf(stderr, "Error: failure to build fast tree from sorted keys\n");
+		return NULL;
 	}
 
-	return 0;
-	
+	fast_tree -> cnt = n;
+	fast_tree -> min = keys[0];
+	fast_tree -> max = keys[n - 1];
+
+	return fast_tree;
 }
 
-int search_prev_fast_tree_outward_32(Fast_Tree_Outward_Root_32 * fast_tree, uint32_t search_key, Fast_Tree_Result * ret_search_result){
 
-	uint16_t ind_16 = (search_key & IND_16_MASK) >> 16;
-	uint16_t off_16 = (search_key & OFF_16_MASK);
 
 
+Fast_Tree_Leaf * get_leaf(Fast_Tree * fast_tree, uint64_t key){
+
+	Fast_Tree_32 * inward_tree_32_ref = NULL;
 	Fast_Tree_16 * inward_tree_16_ref = NULL;
 
-	find_fast_table(&(fast_tree -> inward), &ind_16, false, (void **) &inward_tree_16_ref);
+	switch (fast_tree -> key_bits){
+		case FAST_TREE_KEY_BITS_32:
+			if (key > OFF_32_MASK){
+				return NULL;
+			}
+			inward_tree_32_ref = &(fast_tree -> narrow_root.tree_32);
+			break;
+		case FAST_TREE_KEY_BITS_16:
+			if (key > OFF_16_MASK){
+				return NULL;
+			}
+			inward_tree_16_ref = &(fast_tree -> narrow_root.tree_16);
+			break;
+		default:
+			break;
+	}
 
-	int ret;
+	if (fast_tree -> key_bits == FAST_TREE_KEY_BITS_64){
 
-	// this index did not exist so now our search will be looking for the
-	// the successor of index and returing the minimum value from this 32_tree
-	if ((!inward_tree_16_ref) || (off_16 < inward_tree_16_ref -> min)){
+		uint32_t ind_32 = (key & IND_32_MASK) >> 32;
 
-		// this will temporarily populate the ret_search_result with 32-bit value represent next ind_32
-		ret = search_prev_fast_tree_outward_16(&(fast_tree -> outward_root), ind_16 - 1, ret_search_result);
-		// this should never happen
-		if (unlikely(ret)){
-			fprintf(stderr, "Error: search_next_fast_tree_outward_32 returned error\n");
-			ret_search_result -> key = search_key;
-			return -1;
+		find_fast_table(&(fast_tree -> inward), &ind_32, false, (void **) &inward_tree_32_ref);
+
+		if (!inward_tree_32_ref){
+			return NULL;
 		}
+	}
 
-		uint32_t prev_ind_16 = ret_search_result -> key;
+	uint32_t off_32 = (key & OFF_32_MASK);
+	uint16_t ind_16 = (off_32 & IND_16_MASK) >> 16;
+	uint16_t off_16 = (off_32 & OFF_16_MASK);
 
-		// now we should be guarenteed that there will be a tree with the next index
-		find_fast_table(&(fast_tree -> inward), &prev_ind_16, false, (void **) &inward_tree_16_ref);
+	if (fast_tree -> key_bits != FAST_TREE_KEY_BITS_16){
 
-		// this should never happen
-		if (unlikely(!inward_tree_16_ref)){
-			fprintf(stderr, "Error: expected to find ind_16 tree after outward search, but not found\n");
-			ret_search_result -> key = search_key;
-			return -1;
-		}
+		find_fast_table(&(inward_tree_32_ref -> inward), &ind_16, false, (void **) &inward_tree_16_ref);
 
-		// now reset the result to be correct
-		ret_search_result -> key = ((uint32_t) prev_ind_16 << 16) + (uint32_t) inward_tree_16_ref -> max;
+		if (!inward_tree_16_ref){
+			return NULL;
+		}
 	}
-	else{
 
-		// this will temporarily populate the ret_search_result with 32-bit value represent next off_32
-		ret = search_prev_fast_tree_nonmain_16(inward_tree_16_ref, off_16, ret_search_result);
+	uint8_t ind_8 = (off_16 & IND_8_MASK) >> 8;
 
-		// this should never happen
-		if (unlikely(ret)){
-			fprintf(stderr, "Error: search_next_fast_tree_outward_16 returned error\n");
-			ret_search_result -> key = search_key;
-			return -1;
-		}
+	Fast_Tree_Leaf ** fast_tree_leaf_ref = NULL;
 
-		uint16_t prev_off_16 = ret_search_result -> key;
+	find_fast_table(&(inward_tree_16_ref -> inward_leaves), &ind_8, false, (void **) &fast_tree_leaf_ref);
 
-		// now reset the result to be correct
-		ret_search_result -> key = ((uint32_t) ind_16 << 16) + (uint32_t) prev_off_16;
+	if (!fast_tree_leaf_ref){
+		return NULL;
 	}
 
-	return 0;
+	// we already checked that the reference was non-null, so we know leaf exists
+	Fast_Tree_Leaf * fast_tree_leaf = *fast_tree_leaf_ref;
 
+	return fast_tree_leaf;
 }
 
-int search_prev_fast_tree(Fast_Tree * fast_tree, uint64_t search_key, Fast_Tree_Result * ret_search_result){
 
-	// initally set search result
-	ret_search_result -> fast_tree_leaf = NULL;
-	ret_search_result -> key = search_key;
-	ret_search_result -> value = NULL;
+// SEARCH PREV and SEARCH NEXT RETURN <= and >= key's relative to search key respectively!
+// Rely on passing -1/+1 to achieve strict predecessor/successor
 
-	// Can immediately return because we know there will not be a next within the tree
-	if (search_key < fast_tree -> min){
-		return -1; 
-	}
+uint8_t lookup_bitvector_prev(uint64_t * bit_vector, uint8_t key){
 
 
-	uint32_t ind_32 = (search_key & IND_32_MASK) >> 32;
-	uint32_t off_32 = (search_key & OFF_32_MASK);
+	// upper 2 bits
+	uint8_t vec_ind = (key & LEAF_VEC_IND_MASK) >> 6;
+	// lower 6 bits
+	uint8_t bit_ind = (key & LEAF_BIT_POS_MASK);
 
+	
 
-	Fast_Tree_32 * inward_tree_32_ref = NULL;
+	uint64_t orig_vec = bit_vector[vec_ind];
+	// need to clear the upper bits (all bits at positions > bit_ind) before looing for
+	// highest set bit
 
-	find_fast_table(&(fast_tree -> inward), &ind_32, false, (void **) &inward_tree_32_ref);
-
-	int ret;
+	// set 1's for all positions between [0, bit_ind]
+	uint64_t lower_mask = (((1ULL << bit_ind) - 1) | (1ULL << bit_ind));
+	uint64_t cur_search_vec = orig_vec & lower_mask;
 
-	// this index did not exist so now our search will be looking for the
-	// the successor of index and returing the minimum value from this 32_tree
-	if ((!inward_tree_32_ref) || (off_32 < inward_tree_32_ref -> min)){
+	uint8_t cur_val = 64 * vec_ind;
+	uint8_t cur_vec_ind = vec_ind;
+	
+	int found_element_pos;
+	while (cur_vec_ind >= 0){
 
-		// this will temporarily populate the ret_search_result with 32-bit value represent next ind_32
-		ret = search_prev_fast_tree_outward_32(&(fast_tree -> outward_root), ind_32 - 1, ret_search_result);
-		// this should never happen
-		if (unlikely(ret)){
-			fprintf(stderr, "Error: search_next_fast_tree_outward_32 returned error\n");
-			ret_search_result -> key = search_key;
-			return -1;
+		if (cur_search_vec == 0){
+			// only possible when racing with the writer
+			if (cur_vec_ind == 0){
+				break;
+			}
+			cur_val -= 64;
+			cur_vec_ind -= 1;
+			cur_search_vec = bit_vector[cur_vec_ind];
+			continue;
 		}
 
-		uint32_t prev_ind_32 = ret_search_result -> key;
+		// get highest order set bit position
+		found_element_pos = 63 - __builtin_clzll(cur_search_vec);
 
-		// now we should be guarenteed that there will be a tree with the next index
-		find_fast_table(&(fast_tree -> inward), &prev_ind_32, false, (void **) &inward_tree_32_ref);
+		return cur_val + found_element_pos;
+	}
 
-		// this should never happen
-		if (unlikely(!inward_tree_32_ref)){
-			fprintf(stderr, "Error: expected to find ind_32 tree after outward search, but not found\n");
-			ret_search_result -> key = search_key;
-			return -1;
-		}
+	// should never get here
+	SEARCH_ERROR_FAST_TREE("Error: no position found in lookup_bitvector_prev\n");
+	return 0xFF;
+}
 
-		// now reset the result to be correct
-		ret_search_result -> key = ((uint64_t) prev_ind_32 << 32) + (uint64_t) inward_tree_32_ref -> max;
-	}
-	else{
 
-		// this will temporarily populate the ret_search_result with 32-bit value represent next off_32
-		ret = search_prev_fast_tree_32(inward_tree_32_ref, off_32, ret_search_result);
+uint8_t lookup_bitvector_next(uint64_t * bit_vector, uint8_t key){
 
-		// this should never happen
-		if (unlikely(ret)){
-			fprintf(stderr, "Error: search_next_fast_tree_outward_32 returned error\n");
-			ret_search_result -> key = search_key;
-			return -1;
+
+	// upper 2 bits
+	uint8_t vec_ind = (key & LEAF_VEC_IND_MASK) >> 6;
+	// lower 6 bits
+	uint8_t bit_ind = (key & LEAF_BIT_POS_MASK);
+
+	uint64_t orig_vec = bit_vector[vec_ind];
+
+	// need to clear the lower bits before looing for
+	// highest set bit
+	uint64_t cur_search_vec = orig_vec & (ALL_ONES_64 << bit_ind);
+
+	uint8_t cur_val = 64 * vec_ind;
+	uint8_t cur_vec_ind = vec_ind;
+	int found_element_pos;
+	while (cur_vec_ind >= 0){
+
+		if (cur_search_vec == 0){
+			// only possible when racing with the writer
+			if (cur_vec_ind == 3){
+				break;
+			}
+			cur_val += 64;
+			cur_vec_ind += 1;
+			cur_search_vec = bit_vector[cur_vec_ind];
+			continue;
 		}
 
-		uint32_t prev_off_32 = ret_search_result -> key;
+		// get lowest order set bit position
+		found_element_pos = __builtin_ctzll(cur_search_vec);
 
-		// now reset the result to be correct
-		ret_search_result -> key = ((uint64_t) ind_32 << 32) + (uint64_t) prev_off_32;
+		return cur_val + found_element_pos;
 	}
 
+	// should never get here
+	SEARCH_ERROR_FAST_TREE("Error: no position found in lookup_bitvector_next\n");
 	return 0;
+
+
 }
 
 
-int search_next_fast_tree_16(Fast_Tree_16 * fast_tree, uint16_t search_key, Fast_Tree_Result * ret_search_result){
+// Because all values in the table are pointers, we can 
+// get a reference within the table and deference it
+// to get a staic pointer value that is returned
+
+// The value table might get resized so we don't want to to return a pointer
+// to something within the table!
+void * get_value_from_leaf(Fast_Tree_Leaf * fast_tree_leaf, uint8_t key){
+	// if there isn't a table for this leaf
+	if (fast_tree_leaf -> values.items == NULL){
+		return NULL;
+	}
+	// otherwise lookup key within table
+	uint8_t value_key = key;
+	void * table_value_ptr = NULL;
+
+	
+	find_fast_table(&(fast_tree_leaf -> values), &value_key, false, (void **) &table_value_ptr);
+	if ((!table_value_ptr) || !((void **) table_value_ptr)){
+		return NULL;
+	}
+
+	void * value = *((void **) table_value_ptr);
+	return value;
+}
+
+
+
+
+
+
+
+// SEARCH PREV and SEARCH NEXT RETURN <= and >= key's relative to search key respectively!
+// Rely on passing -1/+1 to achieve strict predecessor/successor
+
+int search_prev_fast_tree_16(Fast_Tree_16 * fast_tree, uint16_t search_key, Fast_Tree_Result * ret_search_result){
 
 	uint8_t ind_8 = (search_key & IND_8_MASK) >> 8;
 	uint8_t off_8 = (search_key & OFF_8_MASK);
@@ -1422,16 +1703,16 @@ int search_next_fast_tree_16(Fast_Tree_16 * fast_tree, uint16_t search_key, Fast
 
 	// this index did not exist so now our search will be looking for the
 	// the successor of index and returing the minimum value from this 32_tree
-	if ((!leaf_ref) || (off_8 > (*leaf_ref) -> max)){
+	if ((!leaf_ref) || (!(*leaf_ref)) || (off_8 < (*leaf_ref) -> min)){
 
-		uint8_t next_leaf_ind = lookup_bitvector_next(fast_tree -> outward_leaf.bit_vector, ind_8 + 1);
+		uint8_t prev_leaf_ind = lookup_bitvector_prev(fast_tree -> outward_leaf.bit_vector, ind_8 - 1);
 
 		// now we should be guarenteed that there will be a tree with the next index
-		find_fast_table(&(fast_tree -> inward_leaves), &next_leaf_ind, false, (void **) &leaf_ref);
+		find_fast_table(&(fast_tree -> inward_leaves), &prev_leaf_ind, false, (void **) &leaf_ref);
 
 		// this should never happen
-		if (unlikely(!leaf_ref)){
-			fprintf(stderr, "Error: expected to find ind_16 tree after outward search, but not found\n");
+		if (unlikely((!leaf_ref) || (!(*leaf_ref)))){
+			SEARCH_ERROR_FAST_TREE("Error: expected to find ind_16 tree after outward search, but not found\n");
 			ret_search_result -> key = search_key;
 			return -1;
 		}
@@ -1439,31 +1720,31 @@ int search_next_fast_tree_16(Fast_Tree_16 * fast_tree, uint16_t search_key, Fast
 		main_leaf = *leaf_ref;
 
 		// set the bottom result
-		ret_search_result -> key = ((uint16_t) next_leaf_ind << 8) + (uint16_t) main_leaf -> min;
+		ret_search_result -> key = ((uint16_t) prev_leaf_ind << 8) + (uint16_t) main_leaf -> max;
 
 		// we are in the leaf of main tree, so can accelerate by populing the values here
 		ret_search_result -> fast_tree_leaf = main_leaf;
-		ret_search_result -> value = get_value_from_leaf(main_leaf, main_leaf -> min);
+		ret_search_result -> value = get_value_from_leaf(main_leaf, main_leaf -> max);
 	}
 	else{
 
 		main_leaf = *leaf_ref;
 
 		// this will temporarily populate the ret_search_result with 32-bit value represent next off_32
-		uint8_t next_leaf_off = lookup_bitvector_next(main_leaf -> bit_vector, off_8);
+		uint8_t prev_leaf_off = lookup_bitvector_prev(main_leaf -> bit_vector, off_8);
 
 		// set the bottom result
-		ret_search_result -> key = ((uint16_t) ind_8 << 8) + (uint16_t) next_leaf_off;
+		ret_search_result -> key = ((uint16_t) ind_8 << 8) + (uint16_t) prev_leaf_off;
 
 		ret_search_result -> fast_tree_leaf = main_leaf;
-		ret_search_result -> value = get_value_from_leaf(main_leaf, next_leaf_off);
+		ret_search_result -> value = get_value_from_leaf(main_leaf, prev_leaf_off);
 	}
 
 	return 0;
 
 }
 
-int search_next_fast_tree_nonmain_16(Fast_Tree_16 * fast_tree, uint16_t search_key, Fast_Tree_Result * ret_search_result){
+int search_prev_fast_tree_nonmain_16(Fast_Tree_16 * fast_tree, uint16_t search_key, Fast_Tree_Result * ret_search_result){
 
 	uint8_t ind_8 = (search_key & IND_8_MASK) >> 8;
 	uint8_t off_8 = (search_key & OFF_8_MASK);
@@ -1475,36 +1756,36 @@ int search_next_fast_tree_nonmain_16(Fast_Tree_16 * fast_tree, uint16_t search_k
 
 	// this index did not exist so now our search will be looking for the
 	// the successor of index and returing the minimum value from this 32_tree
-	if ((!leaf_ref) || (off_8 > leaf_ref -> max)){
+	if ((!leaf_ref) || (off_8 < leaf_ref -> min)){
 
-		uint8_t next_leaf_ind = lookup_bitvector_next(fast_tree -> outward_leaf.bit_vector, ind_8 + 1);
+		uint8_t prev_leaf_ind = lookup_bitvector_prev(fast_tree -> outward_leaf.bit_vector, ind_8 - 1);
 
 		// now we should be guarenteed that there will be a tree with the next index
-		find_fast_table(&(fast_tree -> inward_leaves), &next_leaf_ind, false, (void **) &leaf_ref);
+		find_fast_table(&(fast_tree -> inward_leaves), &prev_leaf_ind, false, (void **) &leaf_ref);
 
 		// this should never happen
 		if (unlikely(!leaf_ref)){
-			fprintf(stderr, "Error: expected to find ind_16 tree after outward search, but not found\n");
+			SEARCH_ERROR_FAST_TREE("Error: expected to find ind_16 tree after outward search, but not found\n");
 			ret_search_result -> key = search_key;
 			return -1;
 		}
 
 		// set the bottom result
-		ret_search_result -> key = ((uint16_t) next_leaf_ind << 8) + (uint16_t) leaf_ref -> min;
+		ret_search_result -> key = ((uint16_t) prev_leaf_ind << 8) + (uint16_t) leaf_ref -> max;
 	}
 	else{
 
 		// this will temporarily populate the ret_search_result with 32-bit value represent next off_32
-		uint8_t next_leaf_off = lookup_bitvector_next(leaf_ref -> bit_vector, off_8);
+		uint8_t prev_leaf_off = lookup_bitvector_prev(leaf_ref -> bit_vector, off_8);
 
 		// set the bottom result
-		ret_search_result -> key = ((uint16_t) ind_8 << 8) + (uint16_t) next_leaf_off;
+		ret_search_result -> key = ((uint16_t) ind_8 << 8) + (uint16_t) prev_leaf_off;
 	}
 
 	return 0;
 }
 
-int search_next_fast_tree_outward_16(Fast_Tree_Outward_Root_16 * fast_tree, uint16_t search_key, Fast_Tree_Result * ret_search_result){
+int search_prev_fast_tree_outward_16(Fast_Tree_Outward_Root_16 * fast_tree, uint16_t search_key, Fast_Tree_Result * ret_search_result){
 
 	uint8_t ind_8 = (search_key & IND_8_MASK) >> 8;
 	uint8_t off_8 = (search_key & OFF_8_MASK);
@@ -1516,37 +1797,37 @@ int search_next_fast_tree_outward_16(Fast_Tree_Outward_Root_16 * fast_tree, uint
 
 	// this index did not exist so now our search will be looking for the
 	// the successor of index and returing the minimum value from this 32_tree
-	if ((!leaf_ref) || (off_8 > leaf_ref -> max)){
+	if ((!leaf_ref) || (off_8 < leaf_ref -> min)){
 
-		uint8_t next_leaf_ind = lookup_bitvector_next(fast_tree -> outward_leaf.bit_vector, ind_8 + 1);
+		uint8_t prev_leaf_ind = lookup_bitvector_prev(fast_tree -> outward_leaf.bit_vector, ind_8 - 1);
 
 		// now we should be guarenteed that there will be a tree with the next index
-		find_fast_table(&(fast_tree -> inward_leaves), &next_leaf_ind, false, (void **) &leaf_ref);
+		find_fast_table(&(fast_tree -> inward_leaves), &prev_leaf_ind, false, (void **) &leaf_ref);
 
 		// this should never happen
 		if (unlikely(!leaf_ref)){
-			fprintf(stderr, "Error: expected to find ind_16 tree after outward search, but not found\n");
+			SEARCH_ERROR_FAST_TREE("Error: expected to find ind_16 tree after outward search, but not found\n");
 			ret_search_result -> key = search_key;
 			return -1;
 		}
 
 		// set the bottom result
-		ret_search_result -> key = ((uint16_t) next_leaf_ind << 8) + (uint16_t) leaf_ref -> min;
+		ret_search_result -> key = ((uint16_t) prev_leaf_ind << 8) + (uint16_t) leaf_ref -> max;
 	}
 	else{
 
 		// this will temporarily populate the ret_search_result with 32-bit value represent next off_32
-		uint8_t next_leaf_off = lookup_bitvector_next(leaf_ref -> bit_vector, off_8);
+		uint8_t prev_leaf_off = lookup_bitvector_prev(leaf_ref -> bit_vector, off_8);
 
 		// set the bottom result
-		ret_search_result -> key = ((uint16_t) ind_8 << 8) + (uint16_t) next_leaf_off;
+		ret_search_result -> key = ((uint16_t) ind_8 << 8) + (uint16_t) prev_leaf_off;
 	}
 
 	return 0;
 }
 
 
-int search_next_fast_tree_32(Fast_Tree_32 * fast_tree, uint32_t search_key, Fast_Tree_Result * ret_search_result){
+int search_prev_fast_tree_32(Fast_Tree_32 * fast_tree, uint32_t search_key, Fast_Tree_Result * ret_search_result){
 
 	uint16_t ind_16 = (search_key & IND_16_MASK) >> 16;
 	uint16_t off_16 = (search_key & OFF_16_MASK);
@@ -1559,55 +1840,55 @@ int search_next_fast_tree_32(Fast_Tree_32 * fast_tree, uint32_t search_key, Fast
 
 	// this index did not exist so now our search will be looking for the
 	// the successor of index and returing the minimum value from this 32_tree
-	if ((!inward_tree_16_ref) || (off_16 > inward_tree_16_ref -> max)){
+	if ((!inward_tree_16_ref) || (off_16 < inward_tree_16_ref -> min)){
 
 		// this will temporarily populate the ret_search_result with 32-bit value represent next ind_32
-		ret = search_next_fast_tree_outward_16(&(fast_tree -> outward_root), ind_16 + 1, ret_search_result);
+		ret = search_prev_fast_tree_outward_16(&(fast_tree -> outward_root), ind_16 - 1, ret_search_result);
 		// this should never happen
 		if (unlikely(ret)){
-			fprintf(stderr, "Error: search_next_fast_tree_outward_32 returned error\n");
+			SEARCH_ERROR_FAST_TREE("Error: search_next_fast_tree_outward_32 returned error\n");
 			ret_search_result -> key = search_key;
 			return -1;
 		}
 
-		uint32_t next_ind_16 = ret_search_result -> key;
+		uint32_t prev_ind_16 = ret_search_result -> key;
 
 		// now we should be guarenteed that there will be a tree with the next index
-		find_fast_table(&(fast_tree -> inward), &next_ind_16, false, (void **) &inward_tree_16_ref);
+		find_fast_table(&(fast_tree -> inward), &prev_ind_16, false, (void **) &inward_tree_16_ref);
 
 		// this should never happen
 		if (unlikely(!inward_tree_16_ref)){
-			fprintf(stderr, "Error: expected to find ind_16 tree after outward search, but not found\n");
+			SEARCH_ERROR_FAST_TREE("Error: expected to find ind_16 tree after outward search, but not found\n");
 			ret_search_result -> key = search_key;
 			return -1;
 		}
 
 		// now reset the result to be correct
-		ret_search_result -> key = ((uint32_t) next_ind_16 << 16) + (uint32_t) inward_tree_16_ref -> min;
+		ret_search_result -> key = ((uint32_t) prev_ind_16 << 16) + (uint32_t) inward_tree_16_ref -> max;
 	}
 	else{
 
 		// this will temporarily populate the ret_search_result with 32-bit value represent next off_32
-		ret = search_next_fast_tree_16(inward_tree_16_ref, off_16, ret_search_result);
+		ret = search_prev_fast_tree_16(inward_tree_16_ref, off_16, ret_search_result);
 
 		// this should never happen
 		if (unlikely(ret)){
-			fprintf(stderr, "Error: search_next_fast_tree_outward_16 returned error\n");
+			SEARCH_ERROR_FAST_TREE("Error: search_next_fast_tree_outward_16 returned error\n");
 			ret_search_result -> key = search_key;
 			return -1;
 		}
 
-		uint16_t next_off_16 = ret_search_result -> key;
+		uint16_t prev_off_16 = ret_search_result -> key;
 
 		// now reset the result to be correct
-		ret_search_result -> key = ((uint32_t) ind_16 << 16) + (uint32_t) next_off_16;
+		ret_search_result -> key = ((uint32_t) ind_16 << 16) + (uint32_t) prev_off_16;
 	}
 
 	return 0;
 	
 }
 
-int search_next_fast_tree_outward_32(Fast_Tree_Outward_Root_32 * fast_tree, uint32_t search_key, Fast_Tree_Result * ret_search_result){
+int search_prev_fast_tree_outward_32(Fast_Tree_Outward_Root_32 * fast_tree, uint32_t search_key, Fast_Tree_Result * ret_search_result){
 
 	uint16_t ind_16 = (search_key & IND_16_MASK) >> 16;
 	uint16_t off_16 = (search_key & OFF_16_MASK);
@@ -1621,236 +1902,1048 @@ int search_next_fast_tree_outward_32(Fast_Tree_Outward_Root_32 * fast_tree, uint
 
 	// this index did not exist so now our search will be looking for the
 	// the successor of index and returing the minimum value from this 32_tree
-	if ((!inward_tree_16_ref) || (off_16 > inward_tree_16_ref -> max)){
+	if ((!inward_tree_16_ref) || (off_16 < inward_tree_16_ref -> min)){
 
 		// this will temporarily populate the ret_search_result with 32-bit value represent next ind_32
-		ret = search_next_fast_tree_outward_16(&(fast_tree -> outward_root), ind_16 + 1, ret_search_result);
+		ret = search_prev_fast_tree_outward_16(&(fast_tree -> outward_root), ind_16 - 1, ret_search_result);
 		// this should never happen
 		if (unlikely(ret)){
-			fprintf(stderr, "Error: search_next_fast_tree_outward_32 returned error\n");
+			SEARCH_ERROR_FAST_TREE("Error: search_next_fast_tree_outward_32 returned error\n");
 			ret_search_result -> key = search_key;
 			return -1;
 		}
 
-		uint32_t next_ind_16 = ret_search_result -> key;
+		uint32_t prev_ind_16 = ret_search_result -> key;
 
 		// now we should be guarenteed that there will be a tree with the next index
-		find_fast_table(&(fast_tree -> inward), &next_ind_16, false, (void **) &inward_tree_16_ref);
+		find_fast_table(&(fast_tree -> inward), &prev_ind_16, false, (void **) &inward_tree_16_ref);
 
 		// this should never happen
 		if (unlikely(!inward_tree_16_ref)){
-			fprintf(stderr, "Error: expected to find ind_16 tree after outward search, but not found\n");
+			SEARCH_ERROR_FAST_TREE("Error: expected to find ind_16 tree after outward search, but not found\n");
+			ret_search_result -> key = search_key;
+			return -1;
+		}
+
+		// now reset the result to be correct
+		ret_search_result -> key = ((uint32_t) prev_ind_16 << 16) + (uint32_t) inward_tree_16_ref -> max;
+	}
+	else{
+
+		// this will temporarily populate the ret_search_result with 32-bit value represent next off_32
+		ret = search_prev_fast_tree_nonmain_16(inward_tree_16_ref, off_16, ret_search_result);
+
+		// this should never happen
+		if (unlikely(ret)){
+			SEARCH_ERROR_FAST_TREE("Error: search_next_fast_tree_outward_16 returned error\n");
 			ret_search_result -> key = search_key;
 			return -1;
 		}
 
-		// now reset the result to be correct
-		ret_search_result -> key = ((uint32_t) next_ind_16 << 16) + (uint32_t) inward_tree_16_ref -> min;
-	}
-	else{
+		uint16_t prev_off_16 = ret_search_result -> key;
+
+		// now reset the result to be correct
+		ret_search_result -> key = ((uint32_t) ind_16 << 16) + (uint32_t) prev_off_16;
+	}
+
+	return 0;
+
+}
+
+// Same as the 64-bit searches except the key is passed directly to the top level tree.
+// The root's min/max were already checked so there is a satisfying key
+static int search_prev_narrow_fast_tree(Fast_Tree * fast_tree, uint64_t search_key, Fast_Tree_Result * ret_search_result){
+
+	// otherwise the key would be truncated
+	if (search_key > fast_tree -> max){
+		search_key = fast_tree -> max;
+	}
+
+	if (fast_tree -> key_bits == FAST_TREE_KEY_BITS_32){
+		return search_prev_fast_tree_32(&(fast_tree -> narrow_root.tree_32), (uint32_t) search_key, ret_search_result);
+	}
+
+	return search_prev_fast_tree_16(&(fast_tree -> narrow_root.tree_16), (uint16_t) search_key, ret_search_result);
+}
+
+int search_prev_fast_tree(Fast_Tree * fast_tree, uint64_t search_key, Fast_Tree_Result * ret_search_result){
+
+	// initally set search result
+	ret_search_result -> fast_tree_leaf = NULL;
+	ret_search_result -> key = search_key;
+	ret_search_result -> value = NULL;
+
+	// Can immediately return because we know there will not be a next within the tree
+	if (search_key < fast_tree -> min){
+		return -1; 
+	}
+
+	if (fast_tree -> key_bits != FAST_TREE_KEY_BITS_64){
+		return search_prev_narrow_fast_tree(fast_tree, search_key, ret_search_result);
+	}
+
+
+	uint32_t ind_32 = (search_key & IND_32_MASK) >> 32;
+	uint32_t off_32 = (search_key & OFF_32_MASK);
+
+
+	Fast_Tree_32 * inward_tree_32_ref = NULL;
+
+	find_fast_table(&(fast_tree -> inward), &ind_32, false, (void **) &inward_tree_32_ref);
+
+	int ret;
+
+	// this index did not exist so now our search will be looking for the
+	// the successor of index and returing the minimum value from this 32_tree
+	if ((!inward_tree_32_ref) || (off_32 < inward_tree_32_ref -> min)){
+
+		// this will temporarily populate the ret_search_result with 32-bit value represent next ind_32
+		ret = search_prev_fast_tree_outward_32(&(fast_tree -> outward_root), ind_32 - 1, ret_search_result);
+		// this should never happen
+		if (unlikely(ret)){
+			SEARCH_ERROR_FAST_TREE("Error: search_next_fast_tree_outward_32 returned error\n");
+			ret_search_result -> key = search_key;
+			return -1;
+		}
+
+		uint32_t prev_ind_32 = ret_search_result -> key;
+
+		// now we should be guarenteed that there will be a tree with the next index
+		find_fast_table(&(fast_tree -> inward), &prev_ind_32, false, (void **) &inward_tree_32_ref);
+
+		// this should never happen
+		if (unlikely(!inward_tree_32_ref)){
+			SEARCH_ERROR_FAST_TREE("Error: expected to find ind_32 tree after outward search, but not found\n");
+			ret_search_result -> key = search_key;
+			return -1;
+		}
+
+		// now reset the result to be correct
+		ret_search_result -> key = ((uint64_t) prev_ind_32 << 32) + (uint64_t) inward_tree_32_ref -> max;
+	}
+	else{
+
+		// this will temporarily populate the ret_search_result with 32-bit value represent next off_32
+		ret = search_prev_fast_tree_32(inward_tree_32_ref, off_32, ret_search_result);
+
+		// this should never happen
+		if (unlikely(ret)){
+			SEARCH_ERROR_FAST_TREE("Error: search_next_fast_tree_outward_32 returned error\n");
+			ret_search_result -> key = search_key;
+			return -1;
+		}
+
+		uint32_t prev_off_32 = ret_search_result -> key;
+
+		// now reset the result to be correct
+		ret_search_result -> key = ((uint64_t) ind_32 << 32) + (uint64_t) prev_off_32;
+	}
+
+	return 0;
+}
+
+
+int search_next_fast_tree_16(Fast_Tree_16 * fast_tree, uint16_t search_key, Fast_Tree_Result * ret_search_result){
+
+	uint8_t ind_8 = (search_key & IND_8_MASK) >> 8;
+	uint8_t off_8 = (search_key & OFF_8_MASK);
+
+
+	Fast_Tree_Leaf ** leaf_ref = NULL;
+
+	Fast_Tree_Leaf * main_leaf = NULL;
+
+	find_fast_table(&(fast_tree -> inward_leaves), &ind_8, false, (void **) &leaf_ref);
+
+	// this index did not exist so now our search will be looking for the
+	// the successor of index and returing the minimum value from this 32_tree
+	if ((!leaf_ref) || (!(*leaf_ref)) || (off_8 > (*leaf_ref) -> max)){
+
+		uint8_t next_leaf_ind = lookup_bitvector_next(fast_tree -> outward_leaf.bit_vector, ind_8 + 1);
+
+		// now we should be guarenteed that there will be a tree with the next index
+		find_fast_table(&(fast_tree -> inward_leaves), &next_leaf_ind, false, (void **) &leaf_ref);
+
+		// this should never happen
+		if (unlikely((!leaf_ref) || (!(*leaf_ref)))){
+			SEARCH_ERROR_FAST_TREE("Error: expected to find ind_16 tree after outward search, but not found\n");
+			ret_search_result -> key = search_key;
+			return -1;
+		}
+
+		main_leaf = *leaf_ref;
+
+		// set the bottom result
+		ret_search_result -> key = ((uint16_t) next_leaf_ind << 8) + (uint16_t) main_leaf -> min;
+
+		// we are in the leaf of main tree, so can accelerate by populing the values here
+		ret_search_result -> fast_tree_leaf = main_leaf;
+		ret_search_result -> value = get_value_from_leaf(main_leaf, main_leaf -> min);
+	}
+	else{
+
+		main_leaf = *leaf_ref;
+
+		// this will temporarily populate the ret_search_result with 32-bit value represent next off_32
+		uint8_t next_leaf_off = lookup_bitvector_next(main_leaf -> bit_vector, off_8);
+
+		// set the bottom result
+		ret_search_result -> key = ((uint16_t) ind_8 << 8) + (uint16_t) next_leaf_off;
+
+		ret_search_result -> fast_tree_leaf = main_leaf;
+		ret_search_result -> value = get_value_from_leaf(main_leaf, next_leaf_off);
+	}
+
+	return 0;
+
+}
+
+int search_next_fast_tree_nonmain_16(Fast_Tree_16 * fast_tree, uint16_t search_key, Fast_Tree_Result * ret_search_result){
+
+	uint8_t ind_8 = (search_key & IND_8_MASK) >> 8;
+	uint8_t off_8 = (search_key & OFF_8_MASK);
+
+
+	Fast_Tree_Outward_Leaf * leaf_ref = NULL;
+
+	find_fast_table(&(fast_tree -> inward_leaves), &ind_8, false, (void **) &leaf_ref);
+
+	// this index did not exist so now our search will be looking for the
+	// the successor of index and returing the minimum value from this 32_tree
+	if ((!leaf_ref) || (off_8 > leaf_ref -> max)){
+
+		uint8_t next_leaf_ind = lookup_bitvector_next(fast_tree -> outward_leaf.bit_vector, ind_8 + 1);
+
+		// now we should be guarenteed that there will be a tree with the next index
+		find_fast_table(&(fast_tree -> inward_leaves), &next_leaf_ind, false, (void **) &leaf_ref);
+
+		// this should never happen
+		if (unlikely(!leaf_ref)){
+			SEARCH_ERROR_FAST_TREE("Error: expected to find ind_16 tree after outward search, but not found\n");
+			ret_search_result -> key = search_key;
+			return -1;
+		}
+
+		// set the bottom result
+		ret_search_result -> key = ((uint16_t) next_leaf_ind << 8) + (uint16_t) leaf_ref -> min;
+	}
+	else{
+
+		// this will temporarily populate the ret_search_result with 32-bit value represent next off_32
+		uint8_t next_leaf_off = lookup_bitvector_next(leaf_ref -> bit_vector, off_8);
+
+		// set the bottom result
+		ret_search_result -> key = ((uint16_t) ind_8 << 8) + (uint16_t) next_leaf_off;
+	}
+
+	return 0;
+}
+
+int search_next_fast_tree_outward_16(Fast_Tree_Outward_Root_16 * fast_tree, uint16_t search_key, Fast_Tree_Result * ret_search_result){
+
+	uint8_t ind_8 = (search_key & IND_8_MASK) >> 8;
+	uint8_t off_8 = (search_key & OFF_8_MASK);
+
+
+	Fast_Tree_Outward_Leaf * leaf_ref = NULL;
+
+	find_fast_table(&(fast_tree -> inward_leaves), &ind_8, false, (void **) &leaf_ref);
+
+	// this index did not exist so now our search will be looking for the
+	// the successor of index and returing the minimum value from this 32_tree
+	if ((!leaf_ref) || (off_8 > leaf_ref -> max)){
+
+		uint8_t next_leaf_ind = lookup_bitvector_next(fast_tree -> outward_leaf.bit_vector, ind_8 + 1);
+
+		// now we should be guarenteed that there will be a tree with the next index
+		find_fast_table(&(fast_tree -> inward_leaves), &next_leaf_ind, false, (void **) &leaf_ref);
+
+		// this should never happen
+		if (unlikely(!leaf_ref)){
+			SEARCH_ERROR_FAST_TREE("Error: expected to find ind_16 tree after outward search, but not found\n");
+			ret_search_result -> key = search_key;
+			return -1;
+		}
+
+		// set the bottom result
+		ret_search_result -> key = ((uint16_t) next_leaf_ind << 8) + (uint16_t) leaf_ref -> min;
+	}
+	else{
+
+		// this will temporarily populate the ret_search_result with 32-bit value represent next off_32
+		uint8_t next_leaf_off = lookup_bitvector_next(leaf_ref -> bit_vector, off_8);
+
+		// set the bottom result
+		ret_search_result -> key = ((uint16_t) ind_8 << 8) + (uint16_t) next_leaf_off;
+	}
+
+	return 0;
+}
+
+
+int search_next_fast_tree_32(Fast_Tree_32 * fast_tree, uint32_t search_key, Fast_Tree_Result * ret_search_result){
+
+	uint16_t ind_16 = (search_key & IND_16_MASK) >> 16;
+	uint16_t off_16 = (search_key & OFF_16_MASK);
+
+	Fast_Tree_16 * inward_tree_16_ref = NULL;
+
+	find_fast_table(&(fast_tree -> inward), &ind_16, false, (void **) &inward_tree_16_ref);
+
+	int ret;
+
+	// this index did not exist so now our search will be looking for the
+	// the successor of index and returing the minimum value from this 32_tree
+	if ((!inward_tree_16_ref) || (off_16 > inward_tree_16_ref -> max)){
+
+		// this will temporarily populate the ret_search_result with 32-bit value represent next ind_32
+		ret = search_next_fast_tree_outward_16(&(fast_tree -> outward_root), ind_16 + 1, ret_search_result);
+		// this should never happen
+		if (unlikely(ret)){
+			SEARCH_ERROR_FAST_TREE("Error: search_next_fast_tree_outward_32 returned error\n");
+			ret_search_result -> key = search_key;
+			return -1;
+		}
+
+		uint32_t next_ind_16 = ret_search_result -> key;
+
+		// now we should be guarenteed that there will be a tree with the next index
+		find_fast_table(&(fast_tree -> inward), &next_ind_16, false, (void **) &inward_tree_16_ref);
+
+		// this should never happen
+		if (unlikely(!inward_tree_16_ref)){
+			SEARCH_ERROR_FAST_TREE("Error: expected to find ind_16 tree after outward search, but not found\n");
+			ret_search_result -> key = search_key;
+			return -1;
+		}
+
+		// now reset the result to be correct
+		ret_search_result -> key = ((uint32_t) next_ind_16 << 16) + (uint32_t) inward_tree_16_ref -> min;
+	}
+	else{
+
+		// this will temporarily populate the ret_search_result with 32-bit value represent next off_32
+		ret = search_next_fast_tree_16(inward_tree_16_ref, off_16, ret_search_result);
+
+		// this should never happen
+		if (unlikely(ret)){
+			SEARCH_ERROR_FAST_TREE("Error: search_next_fast_tree_outward_16 returned error\n");
+			ret_search_result -> key = search_key;
+			return -1;
+		}
+
+		uint16_t next_off_16 = ret_search_result -> key;
+
+		// now reset the result to be correct
+		ret_search_result -> key = ((uint32_t) ind_16 << 16) + (uint32_t) next_off_16;
+	}
+
+	return 0;
+	
+}
+
+int search_next_fast_tree_outward_32(Fast_Tree_Outward_Root_32 * fast_tree, uint32_t search_key, Fast_Tree_Result * ret_search_result){
+
+	uint16_t ind_16 = (search_key & IND_16_MASK) >> 16;
+	uint16_t off_16 = (search_key & OFF_16_MASK);
+
+
+	Fast_Tree_16 * inward_tree_16_ref = NULL;
+
+	find_fast_table(&(fast_tree -> inward), &ind_16, false, (void **) &inward_tree_16_ref);
+
+	int ret;
+
+	// this index did not exist so now our search will be looking for the
+	// the successor of index and returing the minimum value from this 32_tree
+	if ((!inward_tree_16_ref) || (off_16 > inward_tree_16_ref -> max)){
+
+		// this will temporarily populate the ret_search_result with 32-bit value represent next ind_32
+		ret = search_next_fast_tree_outward_16(&(fast_tree -> outward_root), ind_16 + 1, ret_search_result);
+		// this should never happen
+		if (unlikely(ret)){
+			SEARCH_ERROR_FAST_TREE("Error: search_next_fast_tree_outward_32 returned error\n");
+			ret_search_result -> key = search_key;
+			return -1;
+		}
+
+		uint32_t next_ind_16 = ret_search_result -> key;
+
+		// now we should be guarenteed that there will be a tree with the next index
+		find_fast_table(&(fast_tree -> inward), &next_ind_16, false, (void **) &inward_tree_16_ref);
+
+		// this should never happen
+		if (unlikely(!inward_tree_16_ref)){
+			SEARCH_ERROR_FAST_TREE("Error: expected to find ind_16 tree after outward search, but not found\n");
+			ret_search_result -> key = search_key;
+			return -1;
+		}
+
+		// now reset the result to be correct
+		ret_search_result -> key = ((uint32_t) next_ind_16 << 16) + (uint32_t) inward_tree_16_ref -> min;
+	}
+	else{
+
+		// this will temporarily populate the ret_search_result with 32-bit value represent next off_32
+		ret = search_next_fast_tree_nonmain_16(inward_tree_16_ref, off_16, ret_search_result);
+
+		// this should never happen
+		if (unlikely(ret)){
+			SEARCH_ERROR_FAST_TREE("Error: search_next_fast_tree_outward_16 returned error\n");
+			ret_search_result -> key = search_key;
+			return -1;
+		}
+
+		uint16_t next_off_16 = ret_search_result -> key;
+
+		// now reset the result to be correct
+		ret_search_result -> key = ((uint32_t) ind_16 << 16) + (uint32_t) next_off_16;
+	}
+
+	return 0;
+
+}
+
+static int search_next_narrow_fast_tree(Fast_Tree * fast_tree, uint64_t search_key, Fast_Tree_Result * ret_search_result){
+
+	// search_key <= max, so it fits within the tree's width
+	if (fast_tree -> key_bits == FAST_TREE_KEY_BITS_32){
+		return search_next_fast_tree_32(&(fast_tree -> narrow_root.tree_32), (uint32_t) search_key, ret_search_result);
+	}
+
+	return search_next_fast_tree_16(&(fast_tree -> narrow_root.tree_16), (uint16_t) search_key, ret_search_result);
+}
+
+int search_next_fast_tree(Fast_Tree * fast_tree, uint64_t search_key, Fast_Tree_Result * ret_search_result){
+
+	// initally set search result
+	ret_search_result -> fast_tree_leaf = NULL;
+	ret_search_result -> key = search_key;
+	ret_search_result -> value = NULL;
+
+
+	// Can immediately return because we know there will not be a next within the tree
+	if (search_key > fast_tree -> max){
+		return -1; 
+	}
+
+	if (fast_tree -> key_bits != FAST_TREE_KEY_BITS_64){
+		return search_next_narrow_fast_tree(fast_tree, search_key, ret_search_result);
+	}
+
+
+	uint32_t ind_32 = (search_key & IND_32_MASK) >> 32;
+	uint32_t off_32 = (search_key & OFF_32_MASK);
+
+
+	Fast_Tree_32 * inward_tree_32_ref = NULL;
+
+	find_fast_table(&(fast_tree -> inward), &ind_32, false, (void **) &inward_tree_32_ref);
+
+	int ret;
+
+	// this index did not exist so now our search will be looking for the
+	// the successor of index and returing the minimum value from this 32_tree
+	if ((!inward_tree_32_ref) || (off_32 > inward_tree_32_ref -> max)){
+
+		// this will temporarily populate the ret_search_result with 32-bit value represent next ind_32
+		ret = search_next_fast_tree_outward_32(&(fast_tree -> outward_root), ind_32 + 1, ret_search_result);
+		// this should never happen
+		if (unlikely(ret)){
+			SEARCH_ERROR_FAST_TREE("Error: search_next_fast_tree_outward_32 returned error\n");
+			ret_search_result -> key = search_key;
+			return -1;
+		}
+
+		uint32_t next_ind_32 = ret_search_result -> key;
+
+		// now we should be guarenteed that there will be a tree with the next index
+		find_fast_table(&(fast_tree -> inward), &next_ind_32, false, (void **) &inward_tree_32_ref);
+
+		// this should never happen
+		if (unlikely(!inward_tree_32_ref)){
+			SEARCH_ERROR_FAST_TREE("Error: expected to find ind_32 tree after outward search, but not found\n");
+			ret_search_result -> key = search_key;
+			return -1;
+		}
+
+		// now reset the result to be correct
+		ret_search_result -> key = ((uint64_t) next_ind_32 << 32) + (uint64_t) inward_tree_32_ref -> min;
+	}
+	else{
+
+		// this will temporarily populate the ret_search_result with 32-bit value represent next off_32
+		ret = search_next_fast_tree_32(inward_tree_32_ref, off_32, ret_search_result);
+
+		// this should never happen
+		if (unlikely(ret)){
+			SEARCH_ERROR_FAST_TREE("Error: search_next_fast_tree_outward_32 returned error\n");
+			ret_search_result -> key = search_key;
+			return -1;
+		}
+
+		uint32_t next_off_32 = ret_search_result -> key;
+
+		// now reset the result to be correct
+		ret_search_result -> key = ((uint64_t) ind_32 << 32) + (uint64_t) next_off_32;
+	}
+
+	return 0;
+}
+
+
+
+
+
+// reutnrs 0 on success -1 if no satisfying search result
+// sets the search result
+
+// Used directly by the writer, readers go through search_fast_tree
+static int search_nosync_fast_tree(Fast_Tree * fast_tree, uint64_t search_key, FastTreeSearchModifier search_type, Fast_Tree_Result * ret_search_result) {
+	
+	// initally set search result
+	ret_search_result -> fast_tree_leaf = NULL;
+	ret_search_result -> key = search_key;
+	ret_search_result -> value = NULL;
+
+	if (fast_tree -> cnt == 0){
+		return -1;
+	}
+
+	int ret;
+
+	uint64_t found_key;
+	void * value;
+	Fast_Tree_Leaf * fast_tree_leaf;
+
+	switch(search_type){
+		case FAST_TREE_MIN:
+			// only possible when racing with the writer
+			if (unlikely(!(fast_tree -> min_leaf))){
+				return -1;
+			}
+			ret_search_result -> fast_tree_leaf = fast_tree -> min_leaf;
+			ret_search_result -> key = fast_tree -> min;			
+			ret_search_result -> value = get_value_from_leaf(fast_tree -> min_leaf, fast_tree -> min & LEAF_KEY_MASK);
+			ret = 0;
+			break;
+		case FAST_TREE_MAX:
+			if (unlikely(!(fast_tree -> max_leaf))){
+				return -1;
+			}
+			ret_search_result -> fast_tree_leaf = fast_tree -> max_leaf;
+			ret_search_result -> key = fast_tree -> max;			
+			ret_search_result -> value = get_value_from_leaf(fast_tree -> max_leaf, fast_tree -> max & LEAF_KEY_MASK);
+			ret = 0;
+			break;
+		case FAST_TREE_PREV:
+			// trying to search prev on 0 will underflow so immediately return none
+			if (search_key == 0){
+				return -1;
+			}
+			ret = search_prev_fast_tree(fast_tree, search_key - 1, ret_search_result);
+			break;
+		case FAST_TREE_NEXT:
+			// trying to search next on the maximum value will overflow so immediately return none
+			if (search_key == TREE_MAX){
+				return -1;
+			}
+			// not equal so just call next on search key + 1
+			ret = search_next_fast_tree(fast_tree, search_key + 1, ret_search_result);
+			break;
+		// For the just equal case we can directly walk down the main tree
+		case FAST_TREE_EQUAL:
+			fast_tree_leaf = get_leaf(fast_tree, search_key);
+			if (!fast_tree_leaf){
+				return -1;
+			}
+			// we know the leaf exists
+			// now we lookup the value based on lower 8 bits
+			value = get_value_from_leaf(fast_tree_leaf, search_key & LEAF_KEY_MASK);
+			ret_search_result -> fast_tree_leaf = fast_tree_leaf;
+			ret_search_result -> key = search_key;			
+			ret_search_result -> value = value;
+			ret = 0;
+			break;
+		
+		case FAST_TREE_EQUAL_OR_NEXT:
+			ret = search_next_fast_tree(fast_tree, search_key, ret_search_result);
+			break;
+		
+		case FAST_TREE_EQUAL_OR_PREV:
+			ret = search_prev_fast_tree(fast_tree, search_key, ret_search_result);
+			break;
+		default:
+			SEARCH_ERROR_FAST_TREE("Error: unknown search type\n");
+			return -1;
+	}
+
+	// THIS MEANS THAT ret_search_result -> key has been properly set
+	
+	if (ret == 0){
+
+		found_key = ret_search_result -> key;
+		// in the case of finding the appropriate key through
+		// an outward root
+		if (!(ret_search_result -> fast_tree_leaf)){
+			fast_tree_leaf = get_leaf(fast_tree, found_key);
+			// this should never happen
+			if (unlikely(!fast_tree_leaf)){
+				SEARCH_ERROR_FAST_TREE("Error: search was supposed to find key, but no leaf found\n");
+				ret_search_result -> fast_tree_leaf = NULL;
+				ret_search_result -> value = NULL;
+				return -1;
+			}
+			ret_search_result -> fast_tree_leaf = fast_tree_leaf;
+			ret_search_result -> value = get_value_from_leaf(fast_tree_leaf, found_key & LEAF_KEY_MASK);
+		}
+		// if we got the correct leaf, but wrong key then value would be empty
+		else if (search_key != found_key){
+			ret_search_result -> value = get_value_from_leaf(ret_search_result -> fast_tree_leaf, found_key & LEAF_KEY_MASK);
+		}
+		// otherwise we found the key through main tree and then fast_tree_leaf and value
+		// have already been set
+
+		return 0;
+	}
+
+	return ret;
+
+}
+
+
+// Without an epoch domain this is just the search. Otherwise readers
+// retry until no insert or remove overlapped with their search (the
+// same sequence counters as table.c) and the epoch keeps everything
+// they traverse from being freed underneath them
+int search_fast_tree(Fast_Tree * fast_tree, uint64_t search_key, FastTreeSearchModifier search_type, Fast_Tree_Result * ret_search_result) {
+
+	Epoch_Domain * epoch_domain = fast_tree -> epoch_domain;
+
+	if (!epoch_domain){
+		return search_nosync_fast_tree(fast_tree, search_key, search_type, ret_search_result);
+	}
+
+	int ret;
+	uint64_t seq;
+
+	enter_epoch(epoch_domain);
+	is_speculative_search = true;
+
+	while (1){
+
+		seq = __atomic_load_n(&(fast_tree -> write_seq_end), __ATOMIC_ACQUIRE);
+		if (__atomic_load_n(&(fast_tree -> write_seq_start), __ATOMIC_ACQUIRE) != seq){
+			_mm_pause();
+			continue;
+		}
+
+		ret = search_nosync_fast_tree(fast_tree, search_key, search_type, ret_search_result);
+
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		if (likely(__atomic_load_n(&(fast_tree -> write_seq_start), __ATOMIC_RELAXED) == seq)){
+			break;
+		}
+	}
+
+	is_speculative_search = false;
+	exit_epoch(epoch_domain);
+
+	return ret;
+}
+
+// BATCHED SEARCH
+
+// Every level of the main tree is a dependent cache miss. Walking down
+// one level at a time for the whole batch lets all of the keys' misses
+// at that level be outstanding together, and then the regular searches
+// find their path already in the cache.
+
+// Only the main tree path is prefetched (the outward roots are only
+// needed when the key isn't within its leaf).
+
+// The partially resolved tree for each key is kept within its result
+static void prefetch_batch_fast_tree(Fast_Tree * fast_tree, uint64_t * search_keys, uint64_t n, FastTreeSearchModifier search_type, Fast_Tree_Result * ret_search_results){
+
+	uint64_t i;
+	uint64_t key;
+
+	uint32_t ind_32;
+	uint16_t ind_16;
+	uint8_t ind_8;
+	uint8_t off_8;
+
+	Fast_Tree_32 * inward_tree_32_ref;
+	Fast_Tree_16 * inward_tree_16_ref;
+	Fast_Tree_Leaf ** fast_tree_leaf_ref;
+	Fast_Tree_Leaf * fast_tree_leaf;
+
+	Fast_Tree_Key_Bits key_bits = fast_tree -> key_bits;
+
+	// 1.) The root's table of 32-bit trees
+
+	// the key that the search will actually descend with (wrapping around
+	// at the ends only wastes the prefetch)
+	for (i = 0; i < n; i++){
+		key = search_keys[i];
+		if (search_type == FAST_TREE_PREV){
+			key -= 1;
+		}
+		else if (search_type == FAST_TREE_NEXT){
+			key += 1;
+		}
+		ret_search_results[i].key = key;
+		ret_search_results[i].fast_tree_leaf = NULL;
+		ret_search_results[i].value = NULL;
+
+		if (key_bits == FAST_TREE_KEY_BITS_64){
+			ind_32 = (key & IND_32_MASK) >> 32;
+			prefetch_fast_table(&(fast_tree -> inward), &ind_32);
+		}
+	}
+
+	// 2.) The 32-bit trees' tables of 16-bit trees
+	if (key_bits != FAST_TREE_KEY_BITS_16){
+		for (i = 0; i < n; i++){
+			key = ret_search_results[i].key;
+			if (key_bits == FAST_TREE_KEY_BITS_64){
+				ind_32 = (key & IND_32_MASK) >> 32;
+				find_fast_table(&(fast_tree -> inward), &ind_32, false, (void **) &inward_tree_32_ref);
+			}
+			else{
+				inward_tree_32_ref = &(fast_tree -> narrow_root.tree_32);
+			}
+			ret_search_results[i].value = inward_tree_32_ref;
+			if (inward_tree_32_ref){
+				ind_16 = (key & IND_16_MASK) >> 16;
+				prefetch_fast_table(&(inward_tree_32_ref -> inward), &ind_16);
+			}
+		}
+	}
+
+	// 3.) The 16-bit trees' tables of leaves
+	for (i = 0; i < n; i++){
+		key = ret_search_results[i].key;
+		if (key_bits == FAST_TREE_KEY_BITS_16){
+			inward_tree_16_ref = &(fast_tree -> narrow_root.tree_16);
+		}
+		else{
+			inward_tree_16_ref = NULL;
+			inward_tree_32_ref = ret_search_results[i].value;
+			if (inward_tree_32_ref){
+				ind_16 = (key & IND_16_MASK) >> 16;
+				find_fast_table(&(inward_tree_32_ref -> inward), &ind_16, false, (void **) &inward_tree_16_ref);
+			}
+		}
+		ret_search_results[i].value = inward_tree_16_ref;
+		if (inward_tree_16_ref){
+			ind_8 = (key & IND_8_MASK) >> 8;
+			prefetch_fast_table(&(inward_tree_16_ref -> inward_leaves), &ind_8);
+		}
+	}
+
+	// 4.) The leaves
+	for (i = 0; i < n; i++){
+		inward_tree_16_ref = ret_search_results[i].value;
+		if (inward_tree_16_ref){
+			ind_8 = (ret_search_results[i].key & IND_8_MASK) >> 8;
+			find_fast_table(&(inward_tree_16_ref -> inward_leaves), &ind_8, false, (void **) &fast_tree_leaf_ref);
+			if (fast_tree_leaf_ref){
+				ret_search_results[i].fast_tree_leaf = *fast_tree_leaf_ref;
+				__builtin_prefetch(*fast_tree_leaf_ref, 0, 3);
+			}
+		}
+	}
+
+	// 5.) The leaves' value tables
+	for (i = 0; i < n; i++){
+		fast_tree_leaf = ret_search_results[i].fast_tree_leaf;
+		if (fast_tree_leaf){
+			off_8 = ret_search_results[i].key & LEAF_KEY_MASK;
+			prefetch_fast_table(&(fast_tree_leaf -> values), &off_8);
+		}
+	}
+}
+
+uint64_t search_batch_fast_tree(Fast_Tree * fast_tree, uint64_t * search_keys, uint64_t n, FastTreeSearchModifier search_type, Fast_Tree_Result * ret_search_results){
+
+	Epoch_Domain * epoch_domain = fast_tree -> epoch_domain;
+
+	// these don't descend the tree
+	bool to_prefetch = (search_type != FAST_TREE_MIN) && (search_type != FAST_TREE_MAX);
+
+	uint64_t num_found = 0;
+
+	uint64_t num_chunk_keys;
+	for (uint64_t start = 0; start < n; start += FAST_TREE_BATCH_PREFETCH_KEYS){
+		num_chunk_keys = n - start;
+		if (num_chunk_keys > FAST_TREE_BATCH_PREFETCH_KEYS){
+			num_chunk_keys = FAST_TREE_BATCH_PREFETCH_KEYS;
+		}
+
+		// the prefetching doesn't need to be consistent with the writer,
+		// but the trees it goes through must not be freed
+		if (to_prefetch){
+			if (epoch_domain){
+				enter_epoch(epoch_domain);
+			}
+			prefetch_batch_fast_tree(fast_tree, &(search_keys[start]), num_chunk_keys, search_type, &(ret_search_results[start]));
+			if (epoch_domain){
+				exit_epoch(epoch_domain);
+			}
+		}
+
+		for (uint64_t i = start; i < start + num_chunk_keys; i++){
+			if (search_fast_tree(fast_tree, search_keys[i], search_type, &(ret_search_results[i])) == 0){
+				num_found += 1;
+			}
+		}
+	}
+
+	return num_found;
+}
+
+
+void set_epoch_domain_fast_tree(Fast_Tree * fast_tree, Epoch_Domain * epoch_domain){
+
+	set_epoch_domain_fast_table_config(fast_tree -> table_config_32, epoch_domain);
+	set_epoch_domain_fast_table_config(fast_tree -> table_config_16, epoch_domain);
+	set_epoch_domain_fast_table_config(fast_tree -> table_config_outward_leaf, epoch_domain);
+	set_epoch_domain_fast_table_config(fast_tree -> table_config_main_leaf, epoch_domain);
+	set_epoch_domain_fast_table_config(fast_tree -> table_config_value, epoch_domain);
+
+	fast_tree -> epoch_domain = epoch_domain;
+}
+
+
+// MEMORY ACCOUNTING AND COMPACTION
+
+// Every table is visited after the tables within its items, so compacting
+// a table never moves the trees whose tables are still being visited
 
-		// this will temporarily populate the ret_search_result with 32-bit value represent next off_32
-		ret = search_next_fast_tree_nonmain_16(inward_tree_16_ref, off_16, ret_search_result);
+static int visit_table_fast_tree(Fast_Table * fast_table, bool to_compact, Fast_Tree_Level_Stats * level_stats){
 
-		// this should never happen
+	if (!(fast_table -> is_empty_bit_vector)){
+		return 0;
+	}
+
+	if (to_compact){
+		int ret = compact_fast_table(fast_table);
 		if (unlikely(ret)){
-			fprintf(stderr, "Error: search_next_fast_tree_outward_16 returned error\n");
-			ret_search_result -> key = search_key;
+			fprintf(stderr, "Error: failure to compact fast tree table\n");
 			return -1;
 		}
+	}
 
-		uint16_t next_off_16 = ret_search_result -> key;
-
-		// now reset the result to be correct
-		ret_search_result -> key = ((uint32_t) ind_16 << 16) + (uint32_t) next_off_16;
+	if (level_stats){
+		level_stats -> num_tables += 1;
+		level_stats -> num_slots += fast_table -> size;
+		level_stats -> num_items += fast_table -> cnt;
+		level_stats -> bytes += get_bytes_fast_table(fast_table);
 	}
 
 	return 0;
-
 }
 
-int search_next_fast_tree(Fast_Tree * fast_tree, uint64_t search_key, Fast_Tree_Result * ret_search_result){
+static int visit_outward_32_fast_tree(Fast_Tree_Outward_Root_32 * outward_root, bool to_compact, Fast_Tree_Memory_Stats * stats){
 
-	// initally set search result
-	ret_search_result -> fast_tree_leaf = NULL;
-	ret_search_result -> key = search_key;
-	ret_search_result -> value = NULL;
+	Fast_Tree_Level_Stats * outward_stats = stats ? &(stats -> levels[FAST_TREE_LEVEL_OUTWARD]) : NULL;
 
+	int ret;
 
-	// Can immediately return because we know there will not be a next within the tree
-	if (search_key > fast_tree -> max){
-		return -1; 
+	uint64_t ind = 0;
+	Fast_Tree_16 * nonmain_tree_16;
+	while (next_item_fast_table(&(outward_root -> inward), &ind, NULL, (void **) &nonmain_tree_16) == 0){
+		ret = visit_table_fast_tree(&(nonmain_tree_16 -> inward_leaves), to_compact, outward_stats);
+		if (unlikely(ret)){
+			return -1;
+		}
 	}
 
+	ret = visit_table_fast_tree(&(outward_root -> outward_root.inward_leaves), to_compact, outward_stats);
+	if (unlikely(ret)){
+		return -1;
+	}
 
-	uint32_t ind_32 = (search_key & IND_32_MASK) >> 32;
-	uint32_t off_32 = (search_key & OFF_32_MASK);
-
-
-	Fast_Tree_32 * inward_tree_32_ref = NULL;
+	return visit_table_fast_tree(&(outward_root -> inward), to_compact, outward_stats);
+}
 
-	find_fast_table(&(fast_tree -> inward), &ind_32, false, (void **) &inward_tree_32_ref);
+static int visit_32_fast_tree(Fast_Tree_32 * fast_tree, bool to_compact, Fast_Tree_Memory_Stats * stats){
 
 	int ret;
 
-	// this index did not exist so now our search will be looking for the
-	// the successor of index and returing the minimum value from this 32_tree
-	if ((!inward_tree_32_ref) || (off_32 > inward_tree_32_ref -> max)){
-
-		// this will temporarily populate the ret_search_result with 32-bit value represent next ind_32
-		ret = search_next_fast_tree_outward_32(&(fast_tree -> outward_root), ind_32 + 1, ret_search_result);
-		// this should never happen
+	uint64_t ind = 0;
+	Fast_Tree_16 * inward_tree_16;
+	while (next_item_fast_table(&(fast_tree -> inward), &ind, NULL, (void **) &inward_tree_16) == 0){
+		ret = visit_table_fast_tree(&(inward_tree_16 -> inward_leaves), to_compact, stats ? &(stats -> levels[FAST_TREE_LEVEL_LEAF]) : NULL);
 		if (unlikely(ret)){
-			fprintf(stderr, "Error: search_next_fast_tree_outward_32 returned error\n");
-			ret_search_result -> key = search_key;
 			return -1;
 		}
+	}
 
-		uint32_t next_ind_32 = ret_search_result -> key;
+	ret = visit_table_fast_tree(&(fast_tree -> outward_root.inward_leaves), to_compact, stats ? &(stats -> levels[FAST_TREE_LEVEL_OUTWARD]) : NULL);
+	if (unlikely(ret)){
+		return -1;
+	}
 
-		// now we should be guarenteed that there will be a tree with the next index
-		find_fast_table(&(fast_tree -> inward), &next_ind_32, false, (void **) &inward_tree_32_ref);
+	return visit_table_fast_tree(&(fast_tree -> inward), to_compact, stats ? &(stats -> levels[FAST_TREE_LEVEL_16]) : NULL);
+}
 
-		// this should never happen
-		if (unlikely(!inward_tree_32_ref)){
-			fprintf(stderr, "Error: expected to find ind_32 tree after outward search, but not found\n");
-			ret_search_result -> key = search_key;
+static int visit_fast_tree(Fast_Tree * fast_tree, bool to_compact, Fast_Tree_Memory_Stats * stats){
+
+	int ret;
+
+	// 1.) The leaves' value tables (the leaves themselves only move if they are removed)
+	Fast_Tree_Leaf * fast_tree_leaf = fast_tree -> min_leaf;
+	while (fast_tree_leaf){
+		ret = visit_table_fast_tree(&(fast_tree_leaf -> values), to_compact, stats ? &(stats -> levels[FAST_TREE_LEVEL_VALUE]) : NULL);
+		if (unlikely(ret)){
 			return -1;
 		}
-
-		// now reset the result to be correct
-		ret_search_result -> key = ((uint64_t) next_ind_32 << 32) + (uint64_t) inward_tree_32_ref -> min;
+		if (stats){
+			stats -> leaf_bytes += sizeof(Fast_Tree_Leaf);
+		}
+		fast_tree_leaf = fast_tree_leaf -> next;
 	}
-	else{
 
-		// this will temporarily populate the ret_search_result with 32-bit value represent next off_32
-		ret = search_next_fast_tree_32(inward_tree_32_ref, off_32, ret_search_result);
+	// 2.) All of the levels above
+	switch (fast_tree -> key_bits){
+		case FAST_TREE_KEY_BITS_16:
+			return visit_table_fast_tree(&(fast_tree -> narrow_root.tree_16.inward_leaves), to_compact, stats ? &(stats -> levels[FAST_TREE_LEVEL_LEAF]) : NULL);
+		case FAST_TREE_KEY_BITS_32:
+			return visit_32_fast_tree(&(fast_tree -> narrow_root.tree_32), to_compact, stats);
+		default:
+			break;
+	}
 
-		// this should never happen
+	uint64_t ind = 0;
+	Fast_Tree_32 * inward_tree_32;
+	while (next_item_fast_table(&(fast_tree -> inward), &ind, NULL, (void **) &inward_tree_32) == 0){
+		ret = visit_32_fast_tree(inward_tree_32, to_compact, stats);
 		if (unlikely(ret)){
-			fprintf(stderr, "Error: search_next_fast_tree_outward_32 returned error\n");
-			ret_search_result -> key = search_key;
 			return -1;
 		}
+	}
 
-		uint32_t next_off_32 = ret_search_result -> key;
+	ret = visit_outward_32_fast_tree(&(fast_tree -> outward_root), to_compact, stats);
+	if (unlikely(ret)){
+		return -1;
+	}
 
-		// now reset the result to be correct
-		ret_search_result -> key = ((uint64_t) ind_32 << 32) + (uint64_t) next_off_32;
+	return visit_table_fast_tree(&(fast_tree -> inward), to_compact, stats ? &(stats -> levels[FAST_TREE_LEVEL_32]) : NULL);
+}
+
+
+void fast_tree_stats(Fast_Tree * fast_tree, Fast_Tree_Memory_Stats * ret_stats){
+
+	memset(ret_stats, 0, sizeof(Fast_Tree_Memory_Stats));
+
+	// without compacting this can't fail
+	visit_fast_tree(fast_tree, false, ret_stats);
+
+	Fast_Tree_Level_Stats * level_stats;
+
+	ret_stats -> total_bytes = sizeof(Fast_Tree) + ret_stats -> leaf_bytes;
+	for (int i = 0; i < FAST_TREE_NUM_LEVELS; i++){
+		level_stats = &(ret_stats -> levels[i]);
+		if (level_stats -> num_slots > 0){
+			level_stats -> load = (float) level_stats -> num_items / (float) level_stats -> num_slots;
+		}
+		ret_stats -> total_bytes += level_stats -> bytes;
 	}
+}
 
-	return 0;
+
+int compact_fast_tree(Fast_Tree * fast_tree){
+
+	if (!(fast_tree -> epoch_domain)){
+		return visit_fast_tree(fast_tree, true, NULL);
+	}
+
+	// the tables are moving, so concurrent searches should retry
+	__atomic_fetch_add(&(fast_tree -> write_seq_start), 1, __ATOMIC_SEQ_CST);
+	int ret = visit_fast_tree(fast_tree, true, NULL);
+	__atomic_fetch_add(&(fast_tree -> write_seq_end), 1, __ATOMIC_RELEASE);
+
+	return ret;
 }
 
 
+// ORDERED ITERATION
 
+int init_fast_tree_cursor(Fast_Tree * fast_tree, uint64_t search_key, FastTreeSearchModifier search_type, Fast_Tree_Cursor * cursor){
 
+	Fast_Tree_Result search_result;
 
-// reutnrs 0 on success -1 if no satisfying search result
-// sets the search result
-int search_fast_tree(Fast_Tree * fast_tree, uint64_t search_key, FastTreeSearchModifier search_type, Fast_Tree_Result * ret_search_result) {
-	
-	// initally set search result
-	ret_search_result -> fast_tree_leaf = NULL;
-	ret_search_result -> key = search_key;
-	ret_search_result -> value = NULL;
+	int ret = search_fast_tree(fast_tree, search_key, search_type, &search_result);
+	if (ret){
+		return -1;
+	}
 
-	if (fast_tree -> cnt == 0){
+	// an equal search succeeds when only the leaf exists
+	if (!check_bitvector(search_result.fast_tree_leaf -> bit_vector, search_result.key & LEAF_KEY_MASK)){
 		return -1;
 	}
 
-	int ret;
+	cursor -> fast_tree = fast_tree;
+	cursor -> fast_tree_leaf = search_result.fast_tree_leaf;
+	cursor -> key = search_result.key;
+	cursor -> value = search_result.value;
 
-	uint64_t found_key;
-	void * value;
-	Fast_Tree_Leaf * fast_tree_leaf;
+	return 0;
+}
 
-	switch(search_type){
-		case FAST_TREE_MIN:
-			ret_search_result -> fast_tree_leaf = fast_tree -> min_leaf;
-			ret_search_result -> key = fast_tree -> min;			
-			ret_search_result -> value = get_value_from_leaf(fast_tree -> min_leaf, fast_tree -> min & LEAF_KEY_MASK);
-			ret = 0;
-			break;
-		case FAST_TREE_MAX:
-			ret_search_result -> fast_tree_leaf = fast_tree -> max_leaf;
-			ret_search_result -> key = fast_tree -> max;			
-			ret_search_result -> value = get_value_from_leaf(fast_tree -> max_leaf, fast_tree -> max & LEAF_KEY_MASK);
-			ret = 0;
-			break;
-		case FAST_TREE_PREV:
-			// trying to search prev on 0 will underflow so immediately return none
-			if (search_key == 0){
-				return -1;
-			}
-			ret = search_prev_fast_tree(fast_tree, search_key - 1, ret_search_result);
-			break;
-		case FAST_TREE_NEXT:
-			// trying to search next on the maximum value will overflow so immediately return none
-			if (search_key == TREE_MAX){
-				return -1;
-			}
-			// not equal so just call next on search key + 1
-			ret = search_next_fast_tree(fast_tree, search_key + 1, ret_search_result);
-			break;
-		// For the just equal case we can directly walk down the main tree
-		case FAST_TREE_EQUAL:
-			fast_tree_leaf = get_leaf(fast_tree, search_key);
-			if (!fast_tree_leaf){
-				return -1;
-			}
-			// we know the leaf exists
-			// now we lookup the value based on lower 8 bits
-			value = get_value_from_leaf(fast_tree_leaf, search_key & LEAF_KEY_MASK);
-			ret_search_result -> fast_tree_leaf = fast_tree_leaf;
-			ret_search_result -> key = search_key;			
-			ret_search_result -> value = value;
-			ret = 0;
-			break;
-		
-		case FAST_TREE_EQUAL_OR_NEXT:
-			ret = search_next_fast_tree(fast_tree, search_key, ret_search_result);
-			break;
-		
-		case FAST_TREE_EQUAL_OR_PREV:
-			ret = search_prev_fast_tree(fast_tree, search_key, ret_search_result);
-			break;
-		default:
-			fprintf(stderr, "Error: unknown search type\n");
+
+int next_fast_tree_cursor(Fast_Tree_Cursor * cursor){
+
+	Fast_Tree_Leaf * fast_tree_leaf = cursor -> fast_tree_leaf;
+	uint8_t off_8 = cursor -> key & LEAF_KEY_MASK;
+
+	uint8_t next_off_8;
+
+	// still within the same leaf
+	if (off_8 < fast_tree_leaf -> max){
+		next_off_8 = lookup_bitvector_next(fast_tree_leaf -> bit_vector, off_8 + 1);
+	}
+	else{
+		fast_tree_leaf = fast_tree_leaf -> next;
+		if (!fast_tree_leaf){
 			return -1;
+		}
+		next_off_8 = fast_tree_leaf -> min;
 	}
 
-	// THIS MEANS THAT ret_search_result -> key has been properly set
-	
-	if (ret == 0){
+	cursor -> fast_tree_leaf = fast_tree_leaf;
+	cursor -> key = fast_tree_leaf -> base + next_off_8;
+	cursor -> value = get_value_from_leaf(fast_tree_leaf, next_off_8);
 
-		found_key = ret_search_result -> key;
-		// in the case of finding the appropriate key through
-		// an outward root
-		if (!(ret_search_result -> fast_tree_leaf)){
-			fast_tree_leaf = get_leaf(fast_tree, found_key);
-			// this should never happen
-			if (unlikely(!fast_tree_leaf)){
-				fprintf(stderr, "Error: search was supposed to find key, but no leaf found\n");
-				ret_search_result -> fast_tree_leaf = NULL;
-				ret_search_result -> value = NULL;
-				return -1;
-			}
-			ret_search_result -> fast_tree_leaf = fast_tree_leaf;
-			ret_search_result -> value = get_value_from_leaf(fast_tree_leaf, found_key & LEAF_KEY_MASK);
-		}
-		// if we got the correct leaf, but wrong key then value would be empty
-		else if (search_key != found_key){
-			ret_search_result -> value = get_value_from_leaf(ret_search_result -> fast_tree_leaf, found_key & LEAF_KEY_MASK);
-		}
-		// otherwise we found the key through main tree and then fast_tree_leaf and value
-		// have already been set
+	return 0;
+}
 
-		return 0;
+
+int prev_fast_tree_cursor(Fast_Tree_Cursor * cursor){
+
+	Fast_Tree_Leaf * fast_tree_leaf = cursor -> fast_tree_leaf;
+	uint8_t off_8 = cursor -> key & LEAF_KEY_MASK;
+
+	uint8_t prev_off_8;
+
+	if (off_8 > fast_tree_leaf -> min){
+		prev_off_8 = lookup_bitvector_prev(fast_tree_leaf -> bit_vector, off_8 - 1);
+	}
+	else{
+		fast_tree_leaf = fast_tree_leaf -> prev;
+		if (!fast_tree_leaf){
+			return -1;
+		}
+		prev_off_8 = fast_tree_leaf -> max;
 	}
 
-	return ret;
+	cursor -> fast_tree_leaf = fast_tree_leaf;
+	cursor -> key = fast_tree_leaf -> base + prev_off_8;
+	cursor -> value = get_value_from_leaf(fast_tree_leaf, prev_off_8);
 
+	return 0;
 }
 
 
@@ -1884,6 +2977,12 @@ void destroy_and_unlink_fast_tree_leaf(Fast_Tree * root, Fast_Tree_Leaf * fast_t
 		root -> max_leaf = NULL;
 	}
 
+	// concurrent searches might still be within the leaf
+	if (root -> epoch_domain){
+		retire_epoch(root -> epoch_domain, fast_tree_leaf, &free);
+		return;
+	}
+
 	free(fast_tree_leaf);
 
 	return;
@@ -2139,7 +3238,7 @@ void remove_fast_tree_32(Fast_Tree * root, Fast_Tree_32 * fast_tree, uint32_t ke
 	bool child_tree_removed = false;
 	remove_fast_tree_16(root, inward_tree_16_ref, off_16, triggered_new_min_key, triggered_new_max_key, element_removed, &child_tree_removed, prev_value);
 
-	if (!element_removed){
+	if (!(*element_removed)){
 		return;
 	}
 
@@ -2213,15 +3312,59 @@ void remove_fast_tree_outward_32(Fast_Tree * root, Fast_Tree_Outward_Root_32 * f
 
 }
 
+// The caller already checked that key is within [min, max]
+static int remove_narrow_fast_tree(Fast_Tree * fast_tree, uint64_t key, void * prev_value) {
+
+	bool child_tree_removed = false;
+	bool element_removed = false;
+
+	uint64_t triggered_new_min_key = key;
+	uint64_t triggered_new_max_key = key;
+
+	// If the top level tree becomes empty its tables are destroyed
+	// and get re-initialized by the next insert
+	if (fast_tree -> key_bits == FAST_TREE_KEY_BITS_32){
+		remove_fast_tree_32(fast_tree, &(fast_tree -> narrow_root.tree_32), (uint32_t) key, &triggered_new_min_key, &triggered_new_max_key, &element_removed, &child_tree_removed, prev_value);
+	}
+	else{
+		remove_fast_tree_16(fast_tree, &(fast_tree -> narrow_root.tree_16), (uint16_t) key, &triggered_new_min_key, &triggered_new_max_key, &element_removed, &child_tree_removed, prev_value);
+	}
+
+	if (!element_removed){
+		return -1;
+	}
+
+	fast_tree -> cnt -= 1;
+
+	if (fast_tree -> cnt == 0){
+		fast_tree -> min = TREE_MAX;
+		fast_tree -> max = 0;
+		return 0;
+	}
+
+	if (fast_tree -> min == key){
+		fast_tree -> min = triggered_new_min_key;
+	}
+	else if (fast_tree -> max == key){
+		fast_tree -> max = triggered_new_max_key;
+	}
+
+	return 0;
+}
+
 // returns 0 on success -1 on error
 // fails is key is already in the tree and overwrite set to false
 // if key was already in the tree and had a non-null value, then copies the previous value into prev_value
-int remove_fast_tree(Fast_Tree * fast_tree, uint64_t key, void * prev_value) {
+static int remove_nosync_fast_tree(Fast_Tree * fast_tree, uint64_t key, void * prev_value) {
 
 	if ((fast_tree -> cnt == 0) || ((key < fast_tree -> min) || (key > fast_tree -> max))){	
 		return -1;
 	}	
 
+	if (fast_tree -> key_bits != FAST_TREE_KEY_BITS_64){
+		return remove_narrow_fast_tree(fast_tree, key, prev_value);
+	}
+
 	uint32_t ind_32 = (key & IND_32_MASK) >> 32;
 	uint32_t off_32 = (key & OFF_32_MASK);
 
@@ -2270,6 +3413,19 @@ int remove_fast_tree(Fast_Tree * fast_tree, uint64_t key, void * prev_value) {
 	return 0;
 }
 
+int remove_fast_tree(Fast_Tree * fast_tree, uint64_t key, void * prev_value) {
+
+	if (!(fast_tree -> epoch_domain)){
+		return remove_nosync_fast_tree(fast_tree, key, prev_value);
+	}
+
+	__atomic_fetch_add(&(fast_tree -> write_seq_start), 1, __ATOMIC_SEQ_CST);
+	int ret = remove_nosync_fast_tree(fast_tree, key, prev_value);
+	__atomic_fetch_add(&(fast_tree -> write_seq_end), 1, __ATOMIC_RELEASE);
+
+	return ret;
+}
+
 
 // This provides a single function interface for a very large set of possible behaviors
 // See FastTreeUpdateOpType enum definition in fast_tree.h for a description of 
@@ -283,6 +283,33 @@ struct fast_tree_16 {
  };
 
 
+// Position of an ordered iteration over the tree.
+
+// Moves along the doubly linked list of main leaves, so each
+// step is within a leaf's bit vector or to the adjacent leaf
+typedef struct fast_tree_cursor {
+	Fast_Tree * fast_tree;
+	// the leaf containing key
+	Fast_Tree_Leaf * fast_tree_leaf;
+	// the key the cursor is currently at and
+	// its value (NULL if there is none)
+	uint64_t key;
+	void * value;
+} Fast_Tree_Cursor;
+
+
+// The width of the keys that will be inserted into a tree.
+
+// Narrow trees only have the levels below their width (i.e. a 32-bit tree
+// is a single Fast_Tree_32 and a 16-bit tree a single Fast_Tree_16), so every
+// operation skips the upper tables and outward roots
+typedef enum fast_tree_key_bits {
+	FAST_TREE_KEY_BITS_64,
+	FAST_TREE_KEY_BITS_32,
+	FAST_TREE_KEY_BITS_16
+} Fast_Tree_Key_Bits;
+
+
 typedef struct fast_tree_stats {
 	uint32_t num_trees_32;
 	uint32_t num_trees_16;
@@ -292,6 +319,40 @@ typedef struct fast_tree_stats {
 } Fast_Tree_Stats;
 
 
+// The tables of a tree grouped by what they contain
+typedef enum fast_tree_level {
+	// the root's table of 32-bit trees
+	FAST_TREE_LEVEL_32,
+	// the 32-bit trees' tables of 16-bit trees
+	FAST_TREE_LEVEL_16,
+	// the 16-bit trees' tables of main leaves
+	FAST_TREE_LEVEL_LEAF,
+	// the tables of values within main leaves
+	FAST_TREE_LEVEL_VALUE,
+	// every table within the outward roots
+	FAST_TREE_LEVEL_OUTWARD,
+	FAST_TREE_NUM_LEVELS
+} Fast_Tree_Level;
+
+typedef struct fast_tree_level_stats {
+	uint64_t num_tables;
+	// sum of the table sizes and counts
+	uint64_t num_slots;
+	uint64_t num_items;
+	// num_items / num_slots
+	float load;
+	uint64_t bytes;
+} Fast_Tree_Level_Stats;
+
+typedef struct fast_tree_memory_stats {
+	Fast_Tree_Level_Stats levels[FAST_TREE_NUM_LEVELS];
+	// the Fast_Tree_Leaf structs themselves
+	uint64_t leaf_bytes;
+	// all of the levels + leaves + root
+	uint64_t total_bytes;
+} Fast_Tree_Memory_Stats;
+
+
 
 struct fast_tree {
 	// configurations for all the tables
@@ -321,6 +382,14 @@ struct fast_tree {
 	// This represents a Fast_Tree_32 seraching
 	// for the uint32_t index of the original elmeent
 	Fast_Tree_Outward_Root_32 outward_root;
+
+	// inward and outward_root are only used by 64-bit trees. 
+	// Narrow trees store their top level tree here instead
+	Fast_Tree_Key_Bits key_bits;
+	union {
+		Fast_Tree_32 tree_32;
+		Fast_Tree_16 tree_16;
+	} narrow_root;
 	
 	// if this fast tree will be containing
 	// entries within the leaves of the tree.
@@ -339,6 +408,13 @@ struct fast_tree {
 	// a contiguous range
 	Fast_Tree_Leaf * min_leaf;
 	Fast_Tree_Leaf * max_leaf;
+	// NULL unless set_epoch_domain_fast_tree() was called
+	Epoch_Domain * epoch_domain;
+	// When there is an epoch domain, inserts and removes increment
+	// write_seq_start before modifying and write_seq_end once finished.
+	// Searches retry if an insert/remove started while they were searching
+	uint64_t write_seq_start;
+	uint64_t write_seq_end;
 };
 
 
@@ -371,6 +447,33 @@ uint64_t hash_func_modulus_8(void * key_ref, uint64_t table_size);
 
 Fast_Tree * init_fast_tree();
 
+// Same as init_fast_tree, but all keys inserted must be within key_bits
+// (inserting a larger key fails, searches for larger keys are bounded by the max)
+Fast_Tree * init_fast_tree_with_key_bits(Fast_Tree_Key_Bits key_bits);
+
+
+// Builds a tree containing keys[0, n) where keys are sorted and unique,
+// values is either NULL (no values) or has a value (possibly NULL) for each key.
+
+// Equivalent to inserting every key, but constructs each level bottom-up
+// with all the tables presized, so there are no resizes or repeated searches
+Fast_Tree * build_fast_tree_sorted(uint64_t * keys, void ** values, uint64_t n);
+
+// Same as build_fast_tree_sorted, but for a tree from init_fast_tree_with_key_bits
+// (fails if the largest key doesn't fit within key_bits)
+Fast_Tree * build_fast_tree_sorted_with_key_bits(Fast_Tree_Key_Bits key_bits, uint64_t * keys, void ** values, uint64_t n);
+
+
+// Allows searches to run concurrently with a single writer (inserts and removes
+// still need to be serialized by the caller). Must be called before any other thread
+// uses the tree.
+
+// Every leaf and table block that gets released is retired to the epoch
+// domain and searches take place within a critical section. The Fast_Tree_Leaf
+// within a search result is only safe to dereference by the writer, a concurrent
+// reader should only use the key and value
+void set_epoch_domain_fast_tree(Fast_Tree * fast_tree, Epoch_Domain * epoch_domain);
+
 
 // ONLY TEMPORARILY EXPOSING THIS FUNCTION!
 Fast_Tree_Leaf * get_leaf(Fast_Tree * fast_tree, uint64_t key);
@@ -386,6 +489,18 @@ Fast_Tree_Leaf * get_leaf(Fast_Tree * fast_tree, uint64_t key);
 int search_fast_tree(Fast_Tree * fast_tree, uint64_t search_key, FastTreeSearchModifier search_type, Fast_Tree_Result * ret_search_result);
 
 
+// The batch search descends this many keys at a time
+#define FAST_TREE_BATCH_PREFETCH_KEYS 32
+
+// Equivalent to calling search_fast_tree for each of search_keys[0, n) with the same
+// search_type, but the keys go down the tree one level at a time and each level's
+// tables are prefetched for all of them before any are looked up.
+
+// Returns the number of keys that had a satisfying result. ret_search_results[i]
+// is set as the search would, so fast_tree_leaf is NULL if nothing satisfied search_keys[i]
+uint64_t search_batch_fast_tree(Fast_Tree * fast_tree, uint64_t * search_keys, uint64_t n, FastTreeSearchModifier search_type, Fast_Tree_Result * ret_search_results);
+
+
 // returns 0 on success -1 on error
 // fails is key is already in the tree and overwrite set to false
 // if key was already in the tree and had a non-null value, then copies the previous value into prev_value
@@ -399,6 +514,43 @@ int remove_fast_tree(Fast_Tree * fast_tree, uint64_t key, void * prev_value);
 
 
 
+// MEMORY ACCOUNTING
+
+// Both of these walk every table within the tree, so they are meant
+// to be called occasionally (and only by the writer)
+
+// Sets the current size and occupancy of the tables at each level
+void fast_tree_stats(Fast_Tree * fast_tree, Fast_Tree_Memory_Stats * ret_stats);
+
+// Shrinks every table to the size it would have grown to for its count.
+// returns 0 on success, -1 on error
+int compact_fast_tree(Fast_Tree * fast_tree);
+
+
+
+// ORDERED ITERATION
+
+// The cursor holds a reference to a leaf, so it is only valid until the next
+// insert or remove (and should only be used by the writer if there are concurrent searches).
+
+// To iterate over [lo, hi]:
+//	ret = init_fast_tree_cursor(fast_tree, lo, FAST_TREE_EQUAL_OR_NEXT, &cursor);
+//	while ((ret == 0) && (cursor.key <= hi)) { ...; ret = next_fast_tree_cursor(&cursor); }
+
+
+// Positions the cursor at the key satisfying the search query
+// returns 0 on success, -1 if no key satisfied the query
+int init_fast_tree_cursor(Fast_Tree * fast_tree, uint64_t search_key, FastTreeSearchModifier search_type, Fast_Tree_Cursor * cursor);
+
+// Moves the cursor to the next larger (or smaller for prev) key
+// returns 0 on success, -1 if the cursor was already at the last (or first) key
+// in which case the cursor is not modified
+int next_fast_tree_cursor(Fast_Tree_Cursor * cursor);
+int prev_fast_tree_cursor(Fast_Tree_Cursor * cursor);
+
+
+
+
 // This provides a single API for a very large set of possible behaviors
 
 // It always conducts a search and then performs an action conditional on the
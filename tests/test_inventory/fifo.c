@@ -1,17 +1,28 @@
 #include "fifo.h"
 
+#include <immintrin.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
 
 // Initializes fifo struct and allocates memory for buffer
 Fifo * init_fifo(uint64_t max_items, uint64_t item_size_bytes) {
+	return init_fifo_with_engine(max_items, item_size_bytes, FIFO_ENGINE_LOCKED);
+}
+
+Fifo * init_fifo_with_engine(uint64_t max_items, uint64_t item_size_bytes, Fifo_Engine engine) {
 
 	int ret;
 
-	Fifo * fifo = (Fifo *) malloc(sizeof(Fifo));
-	if (fifo == NULL){
-		fprintf(stderr, "Error: malloc failed to allocate fifo container\n");
+	Fifo * fifo;
+	// aligned so the lock free positions are on seperate cache lines
+	ret = posix_memalign((void **) &fifo, 64, sizeof(Fifo));
+	if (ret != 0){
+		fprintf(stderr, "Error: could not allocate fifo container\n");
 		return NULL;
 	}
 
+	fifo -> engine = engine;
 	fifo -> max_items = max_items;
 	fifo -> item_size_bytes = item_size_bytes;
 	fifo -> produce_ind = 0;
@@ -46,9 +57,39 @@ Fifo * init_fifo(uint64_t max_items, uint64_t item_size_bytes) {
 		return NULL;
 	}
 
+	fifo -> slot_seqs = NULL;
+	fifo -> num_parked_consumers = 0;
+	fifo -> num_parked_producers = 0;
+	fifo -> enqueue_pos = 0;
+	fifo -> dequeue_pos = 0;
+
+	if (engine == FIFO_ENGINE_LOCK_FREE){
+		fifo -> wait_policy = FIFO_WAIT_SPIN_THEN_PARK;
+	}
+	else{
+		fifo -> wait_policy = FIFO_WAIT_PARK;
+	}
+	fifo -> spin_iters = FIFO_DEFAULT_SPIN_ITERS;
+
+	if (engine == FIFO_ENGINE_LOCK_FREE){
+		fifo -> slot_seqs = (uint64_t *) malloc(max_items * sizeof(uint64_t));
+		if (fifo -> slot_seqs == NULL){
+			fprintf(stderr, "Error: malloc failed to allocate fifo slot sequences\n");
+			return NULL;
+		}
+		for (uint64_t i = 0; i < max_items; i++){
+			(fifo -> slot_seqs)[i] = i;
+		}
+	}
+
 	return fifo;
 }
 
+void set_wait_policy_fifo(Fifo * fifo, Fifo_Wait_Policy wait_policy, uint64_t spin_iters) {
+	fifo -> wait_policy = wait_policy;
+	fifo -> spin_iters = spin_iters;
+}
+
 void * get_buffer_addr(Fifo * fifo, uint64_t ind) {
 	uint64_t buffer_addr = (uint64_t) fifo -> buffer;
 	uint64_t offset = ind * (fifo -> item_size_bytes);
@@ -56,6 +97,320 @@ void * get_buffer_addr(Fifo * fifo, uint64_t ind) {
 }
 
 
+// WAITING
+
+// pauses for *num_pauses and doubles it (up to FIFO_MAX_BACKOFF_PAUSES) for the next call
+static inline void backoff_fifo(uint64_t * num_pauses) {
+	for (uint64_t i = 0; i < *num_pauses; i++){
+		_mm_pause();
+	}
+	if (*num_pauses < FIFO_MAX_BACKOFF_PAUSES){
+		*num_pauses <<= 1;
+	}
+}
+
+// if the caller should keep spinning after num_spins iterations, based on the wait policy
+static inline bool to_spin_fifo(Fifo_Wait_Policy wait_policy, uint64_t spin_iters, uint64_t num_spins) {
+	return (wait_policy == FIFO_WAIT_SPIN) || ((wait_policy == FIFO_WAIT_SPIN_THEN_PARK) && (num_spins < spin_iters));
+}
+
+// LOCKED engine consumers call this before acquiring update_lock
+//	- returns once there are at least num_items or the policy says to stop spinning
+//	- available_items is read without the lock, it is only a hint to stop spinning
+//		(the caller re-checks it under the lock)
+static void spin_produced_fifo(Fifo * fifo, uint64_t num_items) {
+	uint64_t num_spins = 0;
+	uint64_t num_pauses = 1;
+	while (to_spin_fifo(fifo -> wait_policy, fifo -> spin_iters, num_spins)){
+		if (__atomic_load_n(&(fifo -> available_items), __ATOMIC_RELAXED) >= num_items){
+			return;
+		}
+		backoff_fifo(&num_pauses);
+		num_spins++;
+	}
+}
+
+// LOCKED engine consumers call this while holding update_lock and there are not enough items
+//	- returns holding update_lock
+static void wait_produced_fifo(Fifo * fifo, uint64_t num_items) {
+	if (fifo -> wait_policy == FIFO_WAIT_SPIN){
+		pthread_mutex_unlock(&(fifo -> update_lock));
+		spin_produced_fifo(fifo, num_items);
+		pthread_mutex_lock(&(fifo -> update_lock));
+		return;
+	}
+	pthread_cond_wait(&(fifo -> produced_cv), &(fifo -> update_lock));
+}
+
+
+
+// LOCK FREE ENGINE
+
+// Each attempt either claims a slot with a CAS on the position, or
+// fails if the fifo was full/empty at the time
+
+// Claiming only reserves the slot at *ret_pos (% max_items) for this producer,
+// consumers won't see it until it is published
+static bool try_claim_lock_free_fifo(Fifo * fifo, uint64_t * ret_pos) {
+
+	uint64_t max_items = fifo -> max_items;
+	uint64_t * slot_seqs = fifo -> slot_seqs;
+
+	uint64_t pos = __atomic_load_n(&(fifo -> enqueue_pos), __ATOMIC_RELAXED);
+	uint64_t seq;
+	int64_t diff;
+
+	while (1){
+		seq = __atomic_load_n(&(slot_seqs[pos % max_items]), __ATOMIC_ACQUIRE);
+		diff = (int64_t) seq - (int64_t) pos;
+		// the slot is free for this position, try to claim it
+		if (diff == 0){
+			if (__atomic_compare_exchange_n(&(fifo -> enqueue_pos), &pos, pos + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)){
+				break;
+			}
+			// failed CAS updated pos
+		}
+		// the item from the previous lap hasn't been consumed yet => full
+		else if (diff < 0){
+			return false;
+		}
+		// another producer claimed pos
+		else {
+			pos = __atomic_load_n(&(fifo -> enqueue_pos), __ATOMIC_RELAXED);
+		}
+	}
+
+	*ret_pos = pos;
+	return true;
+}
+
+// copies the item (if non-null) into the claimed slot
+static void fill_lock_free_fifo(Fifo * fifo, uint64_t pos, void * item) {
+	if (item != NULL){
+		memcpy(get_buffer_addr(fifo, pos % (fifo -> max_items)), item, fifo -> item_size_bytes);
+	}
+}
+
+// makes the claimed slot's item visible to consumers
+static void publish_lock_free_fifo(Fifo * fifo, uint64_t pos) {
+	__atomic_store_n(&((fifo -> slot_seqs)[pos % (fifo -> max_items)]), pos + 1, __ATOMIC_RELEASE);
+}
+
+// Claims all of the consecutive ready items (up to max_ret_items) with a single CAS
+// Returns the number consumed, 0 if the fifo was empty at the time
+static uint64_t try_consume_lock_free_fifo(Fifo * fifo, uint64_t max_ret_items, void * ret_items) {
+
+	uint64_t max_items = fifo -> max_items;
+	uint64_t item_size_bytes = fifo -> item_size_bytes;
+	uint64_t * slot_seqs = fifo -> slot_seqs;
+
+	uint64_t pos = __atomic_load_n(&(fifo -> dequeue_pos), __ATOMIC_RELAXED);
+	uint64_t num_ready, seq;
+
+	while (1){
+
+		// count the ready slots starting at pos. The items after the 
+		// first non-ready slot can't be taken without reordering
+		num_ready = 0;
+		while (num_ready < max_ret_items){
+			seq = __atomic_load_n(&(slot_seqs[(pos + num_ready) % max_items]), __ATOMIC_ACQUIRE);
+			if (seq != pos + num_ready + 1){
+				break;
+			}
+			num_ready++;
+		}
+
+		if (num_ready == 0){
+			// either empty or another consumer took pos
+			seq = __atomic_load_n(&(slot_seqs[pos % max_items]), __ATOMIC_ACQUIRE);
+			if ((int64_t) seq - (int64_t) (pos + 1) < 0){
+				return 0;
+			}
+			pos = __atomic_load_n(&(fifo -> dequeue_pos), __ATOMIC_RELAXED);
+			continue;
+		}
+
+		// producers cannot overwrite ready slots, so if dequeue_pos is unchanged all of them are ours
+		if (__atomic_compare_exchange_n(&(fifo -> dequeue_pos), &pos, pos + num_ready, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED)){
+			break;
+		}
+	}
+
+	uint64_t ind;
+	for (uint64_t i = 0; i < num_ready; i++){
+		ind = (pos + i) % max_items;
+		memcpy((void *) ((uint64_t) ret_items + i * item_size_bytes), get_buffer_addr(fifo, ind), item_size_bytes);
+		// hand the slot back to the producer of the next lap
+		__atomic_store_n(&(slot_seqs[ind]), pos + i + max_items, __ATOMIC_RELEASE);
+	}
+
+	return num_ready;
+}
+
+// Parking:
+//	- a parking thread increments its counter (under update_lock), then re-tries before sleeping
+//	- the other side, after publishing slot sequences, checks the counter and only then takes the lock to wake
+// The seq_cst fences on both sides mean either the re-try sees the published slot, or the 
+// waker sees the counter (and the wakeup can't be lost because the sleeper held the lock until waiting)
+static void wake_parked_lock_free_fifo(Fifo * fifo, uint64_t * num_parked, pthread_cond_t * cv) {
+
+	// nobody ever parks
+	if (fifo -> wait_policy == FIFO_WAIT_SPIN){
+		return;
+	}
+
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	if (likely(__atomic_load_n(num_parked, __ATOMIC_RELAXED) == 0)){
+		return;
+	}
+
+	pthread_mutex_lock(&(fifo -> update_lock));
+	pthread_cond_broadcast(cv);
+	pthread_mutex_unlock(&(fifo -> update_lock));
+}
+
+static uint64_t park_claim_lock_free_fifo(Fifo * fifo) {
+
+	uint64_t pos;
+
+	pthread_mutex_lock(&(fifo -> update_lock));
+	__atomic_fetch_add(&(fifo -> num_parked_producers), 1, __ATOMIC_RELAXED);
+	while (1){
+		__atomic_thread_fence(__ATOMIC_SEQ_CST);
+		if (try_claim_lock_free_fifo(fifo, &pos)){
+			break;
+		}
+		pthread_cond_wait(&(fifo -> consumed_cv), &(fifo -> update_lock));
+	}
+	__atomic_fetch_sub(&(fifo -> num_parked_producers), 1, __ATOMIC_RELAXED);
+	pthread_mutex_unlock(&(fifo -> update_lock));
+
+	return pos;
+}
+
+static uint64_t park_consume_lock_free_fifo(Fifo * fifo, uint64_t max_ret_items, void * ret_items) {
+
+	uint64_t num_consumed;
+
+	pthread_mutex_lock(&(fifo -> update_lock));
+	__atomic_fetch_add(&(fifo -> num_parked_consumers), 1, __ATOMIC_RELAXED);
+	while (1){
+		__atomic_thread_fence(__ATOMIC_SEQ_CST);
+		num_consumed = try_consume_lock_free_fifo(fifo, max_ret_items, ret_items);
+		if (num_consumed > 0){
+			break;
+		}
+		pthread_cond_wait(&(fifo -> produced_cv), &(fifo -> update_lock));
+	}
+	__atomic_fetch_sub(&(fifo -> num_parked_consumers), 1, __ATOMIC_RELAXED);
+	pthread_mutex_unlock(&(fifo -> update_lock));
+
+	return num_consumed;
+}
+
+static int produce_nonblock_lock_free_fifo(Fifo * fifo, void * item) {
+
+	uint64_t pos;
+
+	if (!try_claim_lock_free_fifo(fifo, &pos)){
+		return -1;
+	}
+
+	fill_lock_free_fifo(fifo, pos, item);
+	publish_lock_free_fifo(fifo, pos);
+
+	wake_parked_lock_free_fifo(fifo, &(fifo -> num_parked_consumers), &(fifo -> produced_cv));
+
+	return 0;
+}
+
+static uint64_t consume_nonblock_lock_free_fifo(Fifo * fifo, uint64_t max_ret_items, void * ret_items) {
+
+	uint64_t num_consumed = try_consume_lock_free_fifo(fifo, max_ret_items, ret_items);
+
+	if (num_consumed > 0){
+		wake_parked_lock_free_fifo(fifo, &(fifo -> num_parked_producers), &(fifo -> consumed_cv));
+	}
+
+	return num_consumed;
+}
+
+// BLOCKING until a slot is claimed
+static uint64_t claim_lock_free_fifo(Fifo * fifo) {
+
+	uint64_t pos;
+	uint64_t num_spins = 0;
+	uint64_t num_pauses = 1;
+
+	while (!try_claim_lock_free_fifo(fifo, &pos)){
+		if (!to_spin_fifo(fifo -> wait_policy, fifo -> spin_iters, num_spins)){
+			return park_claim_lock_free_fifo(fifo);
+		}
+		backoff_fifo(&num_pauses);
+		num_spins++;
+	}
+
+	return pos;
+}
+
+static uint64_t produce_lock_free_fifo(Fifo * fifo, void * item) {
+
+	uint64_t pos = claim_lock_free_fifo(fifo);
+
+	fill_lock_free_fifo(fifo, pos, item);
+	publish_lock_free_fifo(fifo, pos);
+
+	wake_parked_lock_free_fifo(fifo, &(fifo -> num_parked_consumers), &(fifo -> produced_cv));
+
+	return pos % (fifo -> max_items);
+}
+
+static uint64_t consume_lock_free_fifo(Fifo * fifo, uint64_t max_ret_items, void * ret_items) {
+
+	uint64_t num_consumed;
+	uint64_t num_spins = 0;
+	uint64_t num_pauses = 1;
+
+	while ((num_consumed = try_consume_lock_free_fifo(fifo, max_ret_items, ret_items)) == 0){
+		if (!to_spin_fifo(fifo -> wait_policy, fifo -> spin_iters, num_spins)){
+			num_consumed = park_consume_lock_free_fifo(fifo, max_ret_items, ret_items);
+			break;
+		}
+		backoff_fifo(&num_pauses);
+		num_spins++;
+	}
+
+	wake_parked_lock_free_fifo(fifo, &(fifo -> num_parked_producers), &(fifo -> consumed_cv));
+
+	return num_consumed;
+}
+
+
+uint64_t reserve_fifo(Fifo * fifo) {
+
+	if (unlikely(fifo -> engine != FIFO_ENGINE_LOCK_FREE)){
+		fprintf(stderr, "Error: reserve_fifo is only supported by lock free fifos\n");
+		return FIFO_RESERVE_ERROR;
+	}
+
+	return claim_lock_free_fifo(fifo);
+}
+
+int commit_fifo(Fifo * fifo, uint64_t reserve_pos) {
+
+	if (unlikely(fifo -> engine != FIFO_ENGINE_LOCK_FREE)){
+		fprintf(stderr, "Error: commit_fifo is only supported by lock free fifos\n");
+		return -1;
+	}
+	
+	publish_lock_free_fifo(fifo, reserve_pos);
+
+	wake_parked_lock_free_fifo(fifo, &(fifo -> num_parked_consumers), &(fifo -> produced_cv));
+
+	return 0;
+}
+
+
 // Returns the index of insertion
 //	- Needed for receive channels to proply post IB receive work requests
 
@@ -63,6 +418,10 @@ void * get_buffer_addr(Fifo * fifo, uint64_t ind) {
 // BLOCKING!
 uint64_t produce_fifo(Fifo * fifo, void * item) {
 
+	if (fifo -> engine == FIFO_ENGINE_LOCK_FREE){
+		return produce_lock_free_fifo(fifo, item);
+	}
+
 	// Error Check if we want
 
 	/*
@@ -120,6 +479,11 @@ uint64_t produce_fifo(Fifo * fifo, void * item) {
 // ASSUME MEMORY FOR RET_ITEM ALREADY ALLOCATED
 void consume_fifo(Fifo * fifo, void * ret_item) {
 
+	if (fifo -> engine == FIFO_ENGINE_LOCK_FREE){
+		consume_lock_free_fifo(fifo, 1, ret_item);
+		return;
+	}
+
 	// Error Check (if we want)
 
 	/*
@@ -130,12 +494,14 @@ void consume_fifo(Fifo * fifo, void * ret_item) {
 	*/
 
 	// 1.) Optimisitically acquire the update lock
+	//		- (depending on the wait policy first spin until there is an item)
+	spin_produced_fifo(fifo, 1);
 	pthread_mutex_lock(&(fifo -> update_lock));
 
 	// 2.) Wait until there are items to consume
 
 	while (fifo -> available_items == 0){
-		pthread_cond_wait(&(fifo -> produced_cv), &(fifo -> update_lock));
+		wait_produced_fifo(fifo, 1);
 	}
 
 	// 3.) Actually consume item
@@ -241,11 +607,13 @@ void consume_batch_fifo(Fifo * fifo, uint64_t num_items, void * ret_items) {
 	uint64_t max_items = fifo -> max_items;
 
 	// 1.) Optimisitically acquire update lock
+	//		- (depending on the wait policy first spin until there are enough items)
+	spin_produced_fifo(fifo, num_items);
 	pthread_mutex_lock(&(fifo -> update_lock));
 
 	// 2.) Wait until there are enough items that we want to consume
 	while (fifo -> available_items < num_items){
-		pthread_cond_wait(&(fifo -> produced_cv), &(fifo -> update_lock));
+		wait_produced_fifo(fifo, num_items);
 	}
 
 	// 3.) Actually consume items
@@ -413,15 +781,21 @@ uint64_t consume_and_reproduce_batch_fifo(Fifo * fifo, uint64_t num_items, void
 // Returns the number of items consumed
 uint64_t consume_all_fifo(Fifo * fifo, void * ret_items) {
 
+	if (fifo -> engine == FIFO_ENGINE_LOCK_FREE){
+		return consume_lock_free_fifo(fifo, fifo -> max_items, ret_items);
+	}
+
 
 	uint64_t max_items = fifo -> max_items;
 
 	// 1.) Optimisitically acquire update lock
+	//		- (depending on the wait policy first spin until there is an item)
+	spin_produced_fifo(fifo, 1);
 	pthread_mutex_lock(&(fifo -> update_lock));
 
 	// 2.) Wait until there are any items to consume
 	while (fifo -> available_items == 0){
-		pthread_cond_wait(&(fifo -> produced_cv), &(fifo -> update_lock));
+		wait_produced_fifo(fifo, 1);
 	}
 
 	// 3.) Actually consume items
@@ -486,6 +860,10 @@ uint64_t consume_all_fifo(Fifo * fifo, void * ret_items) {
 // Returns the number of items consumed
 uint64_t consume_all_nonblock_fifo(Fifo * fifo, void * ret_items) {
 
+	if (fifo -> engine == FIFO_ENGINE_LOCK_FREE){
+		return consume_nonblock_lock_free_fifo(fifo, fifo -> max_items, ret_items);
+	}
+
 
 	uint64_t max_items = fifo -> max_items;
 
@@ -559,6 +937,10 @@ uint64_t consume_all_nonblock_fifo(Fifo * fifo, void * ret_items) {
 
 int produce_nonblock_fifo(Fifo * fifo, void * item, bool to_signal_produced) {
 
+	if (fifo -> engine == FIFO_ENGINE_LOCK_FREE){
+		return produce_nonblock_lock_free_fifo(fifo, item);
+	}
+
 	uint64_t insert_ind;
 
 	// 1.) Optimisitically acquire update lock
@@ -605,6 +987,10 @@ int produce_nonblock_fifo(Fifo * fifo, void * item, bool to_signal_produced) {
 
 int consume_nonblock_fifo(Fifo * fifo, void * ret_item, bool to_signal_consumed) {
 
+	if (fifo -> engine == FIFO_ENGINE_LOCK_FREE){
+		return (consume_nonblock_lock_free_fifo(fifo, 1, ret_item) == 0) ? -1 : 0;
+	}
+
 	// Error Check (if we want)
 
 	/*
@@ -645,3 +1031,54 @@ int consume_nonblock_fifo(Fifo * fifo, void * ret_item, bool to_signal_consumed)
 
 }
 
+
+
+// COMPLETION
+
+static long futex_completion(uint32_t * addr, int op, uint32_t val) {
+	return syscall(SYS_futex, addr, op, val, NULL, NULL, 0);
+}
+
+void init_completion(Completion * completion, Fifo_Wait_Policy wait_policy, uint64_t spin_iters) {
+	completion -> wait_policy = wait_policy;
+	completion -> spin_iters = spin_iters;
+	completion -> state = COMPLETION_PENDING;
+}
+
+void signal_completion(Completion * completion) {
+
+	// after this exchange the waiter is free to return, so the only use
+	// of the completion afterwards is its address for the wakeup
+	uint32_t prev_state = __atomic_exchange_n(&(completion -> state), COMPLETION_DONE, __ATOMIC_RELEASE);
+
+	if (prev_state == COMPLETION_PARKED){
+		futex_completion(&(completion -> state), FUTEX_WAKE_PRIVATE, 1);
+	}
+}
+
+void wait_completion(Completion * completion) {
+
+	uint32_t * state = &(completion -> state);
+
+	// 1.) Spin
+	uint64_t num_spins = 0;
+	uint64_t num_pauses = 1;
+	while (to_spin_fifo(completion -> wait_policy, completion -> spin_iters, num_spins)){
+		if (__atomic_load_n(state, __ATOMIC_ACQUIRE) == COMPLETION_DONE){
+			return;
+		}
+		backoff_fifo(&num_pauses);
+		num_spins++;
+	}
+
+	// 2.) Park
+	//	- announce that we are parked so the signaler knows to wake us. If it was 
+	//		signaled in the meantime the CAS fails and we are done
+	uint32_t expected = COMPLETION_PENDING;
+	__atomic_compare_exchange_n(state, &expected, COMPLETION_PARKED, false, __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE);
+
+	// the futex only sleeps if state is still PARKED (and spurious wakeups re-check)
+	while (__atomic_load_n(state, __ATOMIC_ACQUIRE) != COMPLETION_DONE){
+		futex_completion(state, FUTEX_WAIT_PRIVATE, COMPLETION_PARKED);
+	}
+}
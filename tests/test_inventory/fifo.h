@@ -3,7 +3,43 @@
 
 #include "common.h"
 
+// The engine is chosen at init and every function below dispatches on it
+//	- LOCKED: a mutex protects the indicies, and blocked producers/consumers sleep
+//		on the condition variables
+//	- LOCK_FREE: bounded multi-producer/multi-consumer queue where each slot has a 
+//		sequence number (Vyukov style). A producer claims a slot by CAS'ing enqueue_pos and
+//		marks it ready by publishing the slot's sequence, a consumer does the same with 
+//		dequeue_pos. Producers into the same fifo only contend on a single cache line instead of a
+//		mutex convoy. The lock and condition variables are only used by waiters that park
+typedef enum fifo_engine {
+	FIFO_ENGINE_LOCKED,
+	FIFO_ENGINE_LOCK_FREE
+} Fifo_Engine;
+
+
+// How a blocked caller waits for items (consume_fifo, consume_batch_fifo, consume_all_fifo) 
+// or for room (LOCK_FREE produce_fifo). Locked producers always park
+//	- PARK: sleep on the condition variable right away (a futex syscall + scheduler latency per wakeup)
+//	- SPIN_THEN_PARK: re-check up to spin_iters times with _mm_pause backoff before sleeping
+//	- SPIN: never sleep (burns the core, lowest latency)
+typedef enum fifo_wait_policy {
+	FIFO_WAIT_PARK,
+	FIFO_WAIT_SPIN_THEN_PARK,
+	FIFO_WAIT_SPIN
+} Fifo_Wait_Policy;
+
+// Each spin iteration pauses twice as long as the previous one, up to this many _mm_pause's
+#define FIFO_MAX_BACKOFF_PAUSES 64
+
+// LOCKED fifos default to FIFO_WAIT_PARK (the original behavior) and
+// LOCK_FREE fifos to FIFO_WAIT_SPIN_THEN_PARK with this many iterations
+#define FIFO_DEFAULT_SPIN_ITERS 1024
+
 typedef struct fifo {
+	Fifo_Engine engine;
+	Fifo_Wait_Policy wait_policy;
+	// only used for FIFO_WAIT_SPIN_THEN_PARK
+	uint64_t spin_iters;
 	uint64_t max_items;
 	uint64_t item_size_bytes;
 	// the index at which to place the next item produced
@@ -22,12 +58,30 @@ typedef struct fifo {
 	uint64_t available_items;
 	// actually contains the items
 	void * buffer;
+	// LOCK_FREE only (the fields above besides max_items, item_size_bytes and buffer are unused):
+	// slot_seqs[i] == pos => slot is free for the producer claiming pos
+	// slot_seqs[i] == pos + 1 => slot holds the item produced at pos
+	// (where i = pos % max_items), after consuming it is set to pos + max_items
+	uint64_t * slot_seqs;
+	// the number of consumers/producers sleeping on produced_cv/consumed_cv
+	//	- (incremented under update_lock), the other side only takes the lock to wake them when non-zero
+	uint64_t num_parked_consumers;
+	uint64_t num_parked_producers;
+	// free running positions of the next produce/consume, on their own cache lines
+	uint64_t enqueue_pos __attribute__((aligned(64)));
+	uint64_t dequeue_pos __attribute__((aligned(64)));
 } Fifo;
 
 
 // Initializes fifo struct and allocates memory for buffer
+// (uses FIFO_ENGINE_LOCKED)
 Fifo * init_fifo(uint64_t max_items, uint64_t item_size_bytes);
 
+Fifo * init_fifo_with_engine(uint64_t max_items, uint64_t item_size_bytes, Fifo_Engine engine);
+
+// Should be called before the fifo is shared with other threads
+void set_wait_policy_fifo(Fifo * fifo, Fifo_Wait_Policy wait_policy, uint64_t spin_iters);
+
 // places the item at the back
 // returns the index as which the item was inserted
 // BLOCKING!
@@ -45,6 +99,24 @@ void consume_fifo(Fifo * fifo, void * ret_item);
 void * get_buffer_addr(Fifo * fifo, uint64_t ind);
 
 
+// Producing in place (FIFO_ENGINE_LOCK_FREE only):
+//	- reserve_fifo claims the next slot and returns its position
+//		(the slot's index is reserve_pos % max_items, see get_buffer_addr)
+//	- the caller builds the item directly within the buffer
+//	- commit_fifo makes it visible to consumers
+// Consumers that reach a reserved slot wait for it to be committed, so every reserve needs a commit
+// (a producer that reserves again before committing can block forever once the fifo fills up behind its uncommitted slot)
+
+// A FIFO_ENGINE_LOCKED fifo has no slot sequences to claim or publish, so there reserve_fifo
+// returns FIFO_RESERVE_ERROR and commit_fifo returns -1 without touching the fifo
+// BLOCKING (reserve)!
+#define FIFO_RESERVE_ERROR UINT64_MAX
+uint64_t reserve_fifo(Fifo * fifo);
+int commit_fifo(Fifo * fifo, uint64_t reserve_pos);
+
+
+// The batch functions rely on the items occupying contiguous indicies (the ctrl channels
+// post work requests based on them), so they are only available with FIFO_ENGINE_LOCKED
 uint64_t produce_batch_fifo(Fifo * fifo, uint64_t num_items, void * items);
 void consume_batch_fifo(Fifo * fifo, uint64_t num_items, void * ret_items);
 
@@ -74,4 +146,33 @@ int consume_nonblock_fifo(Fifo * fifo, void * ret_item, bool to_signal_consumed)
 
 
 
-#endif
\ No newline at end of file
+
+// COMPLETION
+
+// One-shot event that a single thread waits on and another thread signals
+// (i.e. a memory op submitted to the memory server), using the same wait policies
+
+// The waiter parks with a futex on state, and signal_completion never touches the completion
+// after changing state. So the waiter can return (and the completion can go out of scope, i.e. on
+// its stack) as soon as it observes COMPLETION_DONE
+
+#define COMPLETION_PENDING 0
+#define COMPLETION_PARKED 1
+#define COMPLETION_DONE 2
+
+typedef struct completion {
+	Fifo_Wait_Policy wait_policy;
+	uint64_t spin_iters;
+	uint32_t state;
+} Completion;
+
+void init_completion(Completion * completion, Fifo_Wait_Policy wait_policy, uint64_t spin_iters);
+
+// Can only be called once per init
+void signal_completion(Completion * completion);
+
+// BLOCKING!
+void wait_completion(Completion * completion);
+
+
+#endif
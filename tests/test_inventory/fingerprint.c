@@ -16,16 +16,6 @@ void print_sha256(uint8_t * fingerprint){
 	printf("\n");
 }
 
-uint64_t fingerprint_to_least_sig64(uint8_t * fingerprint, int fingerprint_num_bytes){
-	uint8_t * least_sig_start = fingerprint + fingerprint_num_bytes - sizeof(uint64_t);
-	uint64_t result = 0;
-    for(int i = 0; i < 8; i++){
-        result <<= 8;
-        result |= (uint64_t)least_sig_start[i];
-    }
-    return result;
-}
-
 uint8_t get_fingerprint_num_bytes(FingerprintType fingerprint_type){
 	switch(fingerprint_type){
 		case SHA256_HASH:
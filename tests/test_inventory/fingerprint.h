@@ -16,9 +16,37 @@ typedef enum fingerprint_type{
 } FingerprintType;
 
 
+// These are called by every table hash/tag/shard function, so they are inlined
+// and load the bytes as a single big-endian word instead of one byte at a time
+
+static inline uint64_t load_big_endian64(uint8_t * bytes){
+	uint64_t result;
+	memcpy(&result, bytes, sizeof(uint64_t));
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+	result = __builtin_bswap64(result);
+#endif
+	return result;
+}
+
+static inline uint64_t fingerprint_to_least_sig64(uint8_t * fingerprint, int fingerprint_num_bytes){
+	return load_big_endian64(fingerprint + fingerprint_num_bytes - sizeof(uint64_t));
+}
+
+// The table index comes from the least significant bytes, so take the
+// tag from the most significant bytes to keep them independent
+static inline uint16_t fingerprint_to_most_sig16(uint8_t * fingerprint){
+	return ((uint16_t) fingerprint[0] << 8) | (uint16_t) fingerprint[1];
+}
+
+// The most significant 64 bits after the ones used for tags, so a shard's
+// items still have uniformly distributed tags
+static inline uint64_t fingerprint_to_shard64(uint8_t * fingerprint){
+	return load_big_endian64(fingerprint + 2);
+}
+
+
 void print_hex(uint8_t * fingerprint, int num_bytes);
 void print_sha256(uint8_t * fingerprint);
-uint64_t fingerprint_to_least_sig64(uint8_t * fingerprint, int fingerprint_num_bytes);
 uint8_t get_fingerprint_num_bytes(FingerprintType fingerprint_type);
 char * get_fingerprint_type_name(FingerprintType fingerprint_type);
 void do_fingerprinting(void * data, uint64_t num_bytes, uint8_t * ret_fingerprint, FingerprintType fingerprint_type);
@@ -15,6 +15,28 @@ uint64_t inventory_hash_func(void * inventory_item, uint64_t table_size) {
 	return least_sig_64bits % table_size;
 }
 
+uint16_t inventory_hash_tag_func(void * inventory_item) {
+	Object * item_casted = (Object *) inventory_item;
+	return fingerprint_to_most_sig16(item_casted -> fingerprint);
+}
+
+uint64_t inventory_shard_func(void * inventory_item) {
+	Object * item_casted = (Object *) inventory_item;
+	return fingerprint_to_shard64(item_casted -> fingerprint);
+}
+
+// Object lookups, inserts and removals use their own instantiation of the table's probing paths,
+// with the functions above (and the fingerprint compare) inlined
+#define TABLE_T_FN(name) name##_object_table
+#define TABLE_T_SHARDED_FN(name) name##_object_sharded_table
+#define TABLE_T_ITEM_TYPE Object
+#define TABLE_T_KEY_FIELD fingerprint
+#define TABLE_T_KEY_SIZE FINGERPRINT_NUM_BYTES
+#define TABLE_T_HASH(table, item, size) inventory_hash_func((item), (size))
+#define TABLE_T_TAG(table, item) inventory_hash_tag_func(item)
+#define TABLE_T_SHARD(item) inventory_shard_func(item)
+#include "table_template.h"
+
 int outstanding_bids_item_cmp(void * outstanding_bid_item, void * other_item) {
 	uint8_t * item_fingerprint = ((Outstanding_Bid *) outstanding_bid_item) -> fingerprint;
 	uint8_t * other_fingerprint = ((Outstanding_Bid *) other_item) -> fingerprint;
@@ -30,6 +52,11 @@ uint64_t outstanding_bids_hash_func(void * outstanding_bid_item, uint64_t table_
 	return least_sig_64bits % table_size;
 }
 
+uint16_t outstanding_bids_hash_tag_func(void * outstanding_bid_item) {
+	Outstanding_Bid * item_casted = (Outstanding_Bid *) outstanding_bid_item;
+	return fingerprint_to_most_sig16(item_casted -> fingerprint);
+}
+
 
 Inventory * init_inventory(Memory * memory) {
 
@@ -44,26 +71,37 @@ Inventory * init_inventory(Memory * memory) {
 
 	Hash_Func hash_func = &inventory_hash_func;
 	Item_Cmp item_cmp = &inventory_item_cmp;
+	Hash_Tag_Func tag_func = &inventory_hash_tag_func;
 
-	inventory -> object_table = init_table(INVENTORY_MIN_FINGERPRINTS_TABLE_ITEMS, INVENTORY_MAX_FINGERPRINTS_TABLE_ITEMS, 
-											INVENTORY_TABLES_LOAD_FACTOR, INVENTORY_TABLES_SHRINK_FACTOR, hash_func, item_cmp);
+	inventory -> object_table = init_sharded_table(INVENTORY_TABLES_SHARD_BITS, &inventory_shard_func, INVENTORY_MIN_FINGERPRINTS_TABLE_ITEMS, INVENTORY_MAX_FINGERPRINTS_TABLE_ITEMS, 
+											INVENTORY_TABLES_LOAD_FACTOR, INVENTORY_TABLES_SHRINK_FACTOR, INVENTORY_TABLES_SLOT_LOCK_RATIO, hash_func, item_cmp, tag_func, INVENTORY_TABLES_ENGINE);
 
 	if (!(inventory -> object_table)){
-		fprintf(stderr, "Error: init_table failed for inventory object table\n");
+		fprintf(stderr, "Error: init_sharded_table failed for inventory object table\n");
 		return NULL;
 	}
 
 	hash_func = &outstanding_bids_hash_func;
 	item_cmp =  &outstanding_bids_item_cmp;
+	tag_func = &outstanding_bids_hash_tag_func;
 
 	inventory -> outstanding_bids = init_table(OUTSTANDING_BIDS_TABLE_MIN_ITEMS, OUTSTANDING_BIDS_TABLE_MAX_ITEMS, 
-											OUTSTANDING_BIDS_TABLE_LOAD_FACTOR, OUTSTANDING_BIDS_TABLE_SHRINK_FACTOR, hash_func, item_cmp);
+											OUTSTANDING_BIDS_TABLE_LOAD_FACTOR, OUTSTANDING_BIDS_TABLE_SHRINK_FACTOR, OUTSTANDING_BIDS_TABLE_SLOT_LOCK_RATIO, hash_func, item_cmp, tag_func, OUTSTANDING_BIDS_TABLE_ENGINE);
 
 	if (!(inventory -> outstanding_bids)){
 		fprintf(stderr, "Error: init_table failed for inventory outstanding_bids table\n");
 		return NULL;
 	}
 
+	inventory -> epoch_domain = init_epoch_domain();
+	if (!(inventory -> epoch_domain)){
+		fprintf(stderr, "Error: init_epoch_domain failed for inventory\n");
+		return NULL;
+	}
+
+	set_epoch_domain_sharded_table(inventory -> object_table, inventory -> epoch_domain);
+	set_epoch_domain_table(inventory -> outstanding_bids, inventory -> epoch_domain);
+
 	return inventory;
 }
 
@@ -98,8 +136,8 @@ int handle_fingerprint_match(Inventory * inventory, WorkerType worker_type, int
 	uint64_t content_size = outstanding_bid -> content_size;
 	int preferred_pool_id = outstanding_bid -> preferred_pool_id;
 
-	// done with the bid so can free it
-	free(outstanding_bid);
+	// done with the bid, but another worker might have found it before it was removed
+	retire_epoch(inventory -> epoch_domain, outstanding_bid, &free);
 
 	// 2.) Reserve object now that we have a match
 
@@ -145,6 +183,8 @@ int do_inventory_function(Inventory * inventory, WorkerType worker_type, int thr
 
 	InventoryMessageType inventory_message_type = inventory_message -> message_type;
 
+	enter_epoch(inventory -> epoch_domain);
+
 	switch(inventory_message_type){
 		case FINGERPRINT_MATCH: ;
 			Fingerprint_Match * match_message = (Fingerprint_Match *) (inventory_message -> message);
@@ -164,9 +204,12 @@ int do_inventory_function(Inventory * inventory, WorkerType worker_type, int thr
 			break;
 		default:
 			fprintf(stderr, "Error: unknown inventory message type: %d\n", inventory_message_type);
-			return -1;
+			ret = -1;
+			break;
 	}
 
+	exit_epoch(inventory -> epoch_domain);
+
 	return ret;
 }	
 
@@ -174,6 +217,13 @@ int do_inventory_function(Inventory * inventory, WorkerType worker_type, int thr
 
 // THE FUNCTIONS THAT DO THE CORE WORK
 
+// Retire function for objects removed from the object table
+void retire_object(void * _obj){
+	Object * obj = (Object *) _obj;
+	free(obj -> locations);
+	free(obj);
+}
+
 // returns 0 upon success, otherwise error
 
 // Responsible for first checking if fingerprint is in inventory -> fingerprints. If not, allocate object and insert
@@ -184,7 +234,7 @@ int reserve_object(Inventory * inventory, uint8_t * fingerprint, int pool_id, ui
 
 	Object target_obj;
 	memcpy(target_obj.fingerprint, fingerprint, FINGERPRINT_NUM_BYTES);
-	Object * obj = find_item_table(inventory -> object_table, &target_obj);
+	Object * obj = find_item_object_sharded_table(inventory -> object_table, &target_obj);
 
 	Obj_Location * locations;
 
@@ -227,7 +277,7 @@ int reserve_object(Inventory * inventory, uint8_t * fingerprint, int pool_id, ui
 
 		// insert the object we just created
 
-		int ins_ret = insert_item_table(inventory -> object_table, obj);
+		int ins_ret = insert_item_object_sharded_table(inventory -> object_table, obj);
 
 		if (ins_ret < 0){
 			fprintf(stderr, "Error: unable to insert object into inventory table\n");
@@ -325,7 +375,7 @@ int release_object(Inventory * inventory, uint8_t * fingerprint, Obj_Location *
 
 	Object target_obj;
 	memcpy(target_obj.fingerprint, fingerprint, FINGERPRINT_NUM_BYTES);
-	Object * table_obj = find_item_table(inventory -> object_table, &target_obj);
+	Object * table_obj = find_item_object_sharded_table(inventory -> object_table, &target_obj);
 
 	if (!table_obj){
 		fprintf(stderr, "Error: unable to find object in table with specified fingerprint upon release_object\n");
@@ -350,10 +400,9 @@ int release_object(Inventory * inventory, uint8_t * fingerprint, Obj_Location *
 	table_obj -> num_reserved_locations -= 1;
 
 	if (table_obj -> num_reserved_locations == 0){
-		// remove from table and free object
-		remove_item_table(inventory -> object_table, table_obj);
-		free(table_obj -> locations);
-		free(table_obj);
+		// remove from table and retire object
+		remove_item_object_sharded_table(inventory -> object_table, table_obj);
+		retire_epoch(inventory -> epoch_domain, table_obj, &retire_object);
 	}
 
 	return 0;
@@ -366,7 +415,7 @@ int destroy_object(Inventory * inventory, uint8_t * fingerprint, int mem_client_
 
 	Object target_obj;
 	memcpy(target_obj.fingerprint, fingerprint, FINGERPRINT_NUM_BYTES);
-	Object * table_obj = find_item_table(inventory -> object_table, &target_obj);
+	Object * table_obj = find_item_object_sharded_table(inventory -> object_table, &target_obj);
 
 	if (!table_obj){
 		return 0;
@@ -389,10 +438,9 @@ int destroy_object(Inventory * inventory, uint8_t * fingerprint, int mem_client_
 	}
 
 	// assert table_obj -> num_reserved_locations == 0
-	// remove from table and free object
-	remove_item_table(inventory -> object_table, table_obj);
-	free(table_obj -> locations);
-	free(table_obj);
+	// remove from table and retire object
+	remove_item_object_sharded_table(inventory -> object_table, table_obj);
+	retire_epoch(inventory -> epoch_domain, table_obj, &retire_object);
 
 	return 0;
 }
@@ -404,7 +452,7 @@ int lookup_object(Inventory * inventory, uint8_t * fingerprint, Object ** ret_ob
 
 	Object target_obj;
 	memcpy(target_obj.fingerprint, fingerprint, FINGERPRINT_NUM_BYTES);
-	Object * table_obj = find_item_table(inventory -> object_table, &target_obj);
+	Object * table_obj = find_item_object_sharded_table(inventory -> object_table, &target_obj);
 
 	*ret_object = table_obj;
 
@@ -3,8 +3,10 @@
 
 #include "common.h"
 #include "table.h"
+#include "sharded_table.h"
 #include "fifo.h"
 #include "deque.h"
+#include "epoch.h"
 #include "fingerprint.h"
 #include "inventory_messages.h"
 #include "work_pool.h"
@@ -52,7 +54,7 @@ typedef struct inventory {
 	// convenient to just have even though embedded within memory struct
 	int num_pools;
 	// mapping from fingerprint -> obj
-	Table * object_table;
+	Sharded_Table * object_table;
 	// TODO: think about "where" outstanding bids fit it? In inventory? In exchange client? In schedule? On its own?
 	// FOR NOW...
 	// mapping from fingerprint -> outstanding bid
@@ -60,6 +62,10 @@ typedef struct inventory {
 	//	- upon figerprint match we will remove the outstanding bid and create
 	//		an object with backing memory reservation
 	Table * outstanding_bids;
+	// Objects and outstanding bids found within the tables are only referenced
+	// within a critical section of this domain (every do_inventory_function call is one)
+	// and are retired here once removed
+	Epoch_Domain * epoch_domain;
 } Inventory;
 
 Inventory * init_inventory(Memory * memory);
@@ -70,6 +76,9 @@ void print_inventory_message(uint32_t node_id, WorkerType worker_type, int threa
 
 // These FUNCTIONS SHOULDN'T BE EXPOSED....
 
+// They must be called within a critical section of inventory -> epoch_domain 
+// (do_inventory_function is one), because the tables have an epoch domain
+
 // returns 0 upon success, otherwise error
 
 // Responsible for first checking if fingerprint is in inventory -> fingerprints. If not, allocate object and insert
@@ -88,6 +97,7 @@ int release_object(Inventory * inventory, uint8_t * fingerprint, Obj_Location *
 int destroy_object(Inventory * inventory, uint8_t * fingerprint, int mem_client_id);
 
 // returns the object within fingerprint table
+//	- the object is only guaranteed to stay valid while the caller is within a critical section of inventory -> epoch_domain
 int lookup_object(Inventory * inventory, uint8_t * fingerprint, Object ** ret_object);
 
 
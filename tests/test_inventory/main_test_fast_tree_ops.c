@@ -0,0 +1,749 @@
+#include "fast_tree.h"
+
+// Every value within these tests is derived from its key
+// so any (key, value) pair returned can be checked
+#define TEST_VALUE(key) ((void *) ((key) + 1))
+
+
+// CONCURRENT SEARCHES
+
+// The writer keeps every even key in [0, TEST_CONCURRENT_NUM_KEYS) in the
+// tree the whole time and repeatedly inserts/removes the odd keys, so readers
+// always know at least one valid answer to their searches
+#define TEST_CONCURRENT_NUM_KEYS (1UL << 16)
+#define TEST_CONCURRENT_KEY_SHIFT 20
+#define TEST_CONCURRENT_NUM_WRITER_ROUNDS 8
+#define TEST_CONCURRENT_NUM_READERS 4
+
+typedef struct test_concurrent_reader {
+	Fast_Tree * fast_tree;
+	volatile bool * is_writer_done;
+	uint64_t num_searches;
+	uint64_t num_errors;
+} Test_Concurrent_Reader;
+
+// spread the keys out so the writer is creating and destroying leaves/tables at every level
+static uint64_t get_concurrent_key(uint64_t ind){
+	return (ind << TEST_CONCURRENT_KEY_SHIFT) | (ind & 0xFF);
+}
+
+static void * run_concurrent_reader(void * _reader){
+
+	Test_Concurrent_Reader * reader = (Test_Concurrent_Reader *) _reader;
+
+	uint64_t ind = 0;
+	uint64_t odd_ind;
+	uint64_t search_key;
+
+	int ret;
+	Fast_Tree_Result search_result;
+
+	while (!(*(reader -> is_writer_done))){
+
+		ind = (ind + 7919) & (TEST_CONCURRENT_NUM_KEYS - 1);
+
+		// the even keys are always present
+		search_key = get_concurrent_key(ind & ~1UL);
+		ret = search_fast_tree(reader -> fast_tree, search_key, FAST_TREE_EQUAL, &search_result);
+		if ((ret != 0) || (search_result.key != search_key) || (search_result.value != TEST_VALUE(search_key))){
+			reader -> num_errors += 1;
+		}
+
+		// the next key after an odd key is either the odd key
+		// itself or the following even key
+		odd_ind = ind | 1UL;
+		search_key = get_concurrent_key(odd_ind);
+		ret = search_fast_tree(reader -> fast_tree, search_key, FAST_TREE_EQUAL_OR_NEXT, &search_result);
+		if (odd_ind != (TEST_CONCURRENT_NUM_KEYS - 1)){
+			if ((ret != 0) || ((search_result.key != search_key) && (search_result.key != get_concurrent_key(odd_ind + 1)))
+							|| (search_result.value != TEST_VALUE(search_result.key))){
+				reader -> num_errors += 1;
+			}
+		}
+
+		reader -> num_searches += 2;
+	}
+
+	return NULL;
+}
+
+static int test_concurrent_searches(){
+
+	int ret;
+
+	printf("Concurrent searches with a single writer...\n");
+
+	Fast_Tree * fast_tree = init_fast_tree();
+	if (!fast_tree){
+		fprintf(stderr, "Error: init fast tree failed\n");
+		return -1;
+	}
+
+	Epoch_Domain * epoch_domain = init_epoch_domain();
+	if (!epoch_domain){
+		fprintf(stderr, "Error: init epoch domain failed\n");
+		return -1;
+	}
+
+	set_epoch_domain_fast_tree(fast_tree, epoch_domain);
+
+	uint64_t key;
+	for (uint64_t i = 0; i < TEST_CONCURRENT_NUM_KEYS; i += 2){
+		key = get_concurrent_key(i);
+		ret = insert_fast_tree(fast_tree, key, TEST_VALUE(key), false, NULL);
+		if (ret){
+			fprintf(stderr, "Error: insert_fast_tree failed for key %lu\n", key);
+			return -1;
+		}
+	}
+
+	volatile bool is_writer_done = false;
+
+	Test_Concurrent_Reader readers[TEST_CONCURRENT_NUM_READERS];
+	pthread_t reader_threads[TEST_CONCURRENT_NUM_READERS];
+
+	for (int i = 0; i < TEST_CONCURRENT_NUM_READERS; i++){
+		readers[i].fast_tree = fast_tree;
+		readers[i].is_writer_done = &is_writer_done;
+		readers[i].num_searches = 0;
+		readers[i].num_errors = 0;
+		ret = pthread_create(&(reader_threads[i]), NULL, run_concurrent_reader, &(readers[i]));
+		if (ret){
+			fprintf(stderr, "Error: pthread_create failed for reader %d\n", i);
+			return -1;
+		}
+	}
+
+	for (int round = 0; round < TEST_CONCURRENT_NUM_WRITER_ROUNDS; round++){
+		for (uint64_t i = 1; i < TEST_CONCURRENT_NUM_KEYS; i += 2){
+			key = get_concurrent_key(i);
+			ret = insert_fast_tree(fast_tree, key, TEST_VALUE(key), false, NULL);
+			if (ret){
+				fprintf(stderr, "Error: insert_fast_tree failed for key %lu\n", key);
+				return -1;
+			}
+		}
+		for (uint64_t i = 1; i < TEST_CONCURRENT_NUM_KEYS; i += 2){
+			key = get_concurrent_key(i);
+			ret = remove_fast_tree(fast_tree, key, NULL);
+			if (ret){
+				fprintf(stderr, "Error: remove_fast_tree failed for key %lu\n", key);
+				return -1;
+			}
+		}
+	}
+
+	is_writer_done = true;
+
+	uint64_t total_searches = 0;
+	uint64_t total_errors = 0;
+	for (int i = 0; i < TEST_CONCURRENT_NUM_READERS; i++){
+		pthread_join(reader_threads[i], NULL);
+		total_searches += readers[i].num_searches;
+		total_errors += readers[i].num_errors;
+	}
+
+	if (total_errors > 0){
+		fprintf(stderr, "Error: %lu of %lu concurrent searches returned an invalid result\n", total_errors, total_searches);
+		return -1;
+	}
+
+	printf("\tSuccess! %lu concurrent searches during %d writer rounds\n\n", total_searches, TEST_CONCURRENT_NUM_WRITER_ROUNDS);
+
+	return 0;
+}
+
+
+// SHARED KEYS AND REFERENCE CHECKS
+
+#define TEST_MAX_NUM_KEYS 20000
+
+typedef struct test_keys {
+	Fast_Tree_Key_Bits key_bits;
+	uint64_t max_key;
+	// sorted and unique, values[i] = TEST_VALUE(keys[i])
+	uint64_t * keys;
+	void ** values;
+	uint64_t n;
+	unsigned int seed;
+} Test_Keys;
+
+typedef int (*Test_Keys_Func)(Test_Keys * test_keys);
+
+// Sorted unique keys within max_key, mixing dense runs (full leaves) and sparse jumps (new upper level trees)
+static int init_test_keys(Fast_Tree_Key_Bits key_bits, uint64_t max_key, unsigned int seed, Test_Keys * test_keys){
+
+	test_keys -> key_bits = key_bits;
+	test_keys -> max_key = max_key;
+	test_keys -> seed = seed;
+
+	test_keys -> keys = (uint64_t *) malloc(TEST_MAX_NUM_KEYS * sizeof(uint64_t));
+	test_keys -> values = (void **) malloc(TEST_MAX_NUM_KEYS * sizeof(void *));
+	if (!(test_keys -> keys) || !(test_keys -> values)){
+		fprintf(stderr, "Error: malloc failed for test keys\n");
+		return -1;
+	}
+
+	uint64_t n = 0;
+	uint64_t key = rand_r(&(test_keys -> seed)) & 0xFF;
+	uint64_t step;
+
+	while ((n < TEST_MAX_NUM_KEYS) && (key <= max_key)){
+		test_keys -> keys[n] = key;
+		test_keys -> values[n] = TEST_VALUE(key);
+		n++;
+		if (rand_r(&(test_keys -> seed)) % 64 == 0){
+			step = ((uint64_t) rand_r(&(test_keys -> seed)) << 16) % (max_key >> 10) + 1;
+		}
+		else{
+			step = rand_r(&(test_keys -> seed)) % 4 + 1;
+		}
+		if (step > max_key - key){
+			break;
+		}
+		key += step;
+	}
+
+	test_keys -> n = n;
+
+	return 0;
+}
+
+static void destroy_test_keys(Test_Keys * test_keys){
+	free(test_keys -> keys);
+	free(test_keys -> values);
+}
+
+// Inserts the keys one at a time in a scrambled order so the leaves aren't linked in order of creation
+static Fast_Tree * insert_test_tree(Test_Keys * test_keys){
+
+	int ret;
+
+	Fast_Tree * fast_tree = init_fast_tree_with_key_bits(test_keys -> key_bits);
+	if (!fast_tree){
+		fprintf(stderr, "Error: init fast tree failed\n");
+		return NULL;
+	}
+
+	uint64_t n = test_keys -> n;
+	uint64_t ind;
+	for (uint64_t i = 0; i < n; i++){
+		ind = (i * 7919) % n;
+		ret = insert_fast_tree(fast_tree, test_keys -> keys[ind], test_keys -> values[ind], false, NULL);
+		if (ret){
+			fprintf(stderr, "Error: insert_fast_tree failed for key %lu\n", test_keys -> keys[ind]);
+			return NULL;
+		}
+	}
+
+	return fast_tree;
+}
+
+static Fast_Tree * build_test_tree(Test_Keys * test_keys){
+
+	Fast_Tree * fast_tree = build_fast_tree_sorted_with_key_bits(test_keys -> key_bits, test_keys -> keys, test_keys -> values, test_keys -> n);
+	if (!fast_tree){
+		fprintf(stderr, "Error: build_fast_tree_sorted_with_key_bits failed\n");
+		return NULL;
+	}
+
+	return fast_tree;
+}
+
+// Removes all but 1 out of every keep_every keys from the tree, and then
+// from the test keys once every tree built from them has been updated
+static int remove_test_tree(Fast_Tree * fast_tree, Test_Keys * test_keys, uint64_t keep_every){
+
+	int ret;
+
+	for (uint64_t i = 0; i < test_keys -> n; i++){
+		if ((i % keep_every) != 0){
+			ret = remove_fast_tree(fast_tree, test_keys -> keys[i], NULL);
+			if (ret){
+				fprintf(stderr, "Error: remove_fast_tree failed for key %lu\n", test_keys -> keys[i]);
+				return -1;
+			}
+		}
+	}
+
+	return 0;
+}
+
+static void remove_test_keys(Test_Keys * test_keys, uint64_t keep_every){
+
+	uint64_t num_kept = 0;
+	for (uint64_t i = 0; i < test_keys -> n; i += keep_every){
+		test_keys -> keys[num_kept] = test_keys -> keys[i];
+		test_keys -> values[num_kept] = test_keys -> values[i];
+		num_kept++;
+	}
+
+	test_keys -> n = num_kept;
+}
+
+static int check_search(Fast_Tree * fast_tree, uint64_t search_key, FastTreeSearchModifier search_type, bool is_expected, uint64_t expected_key){
+
+	Fast_Tree_Result search_result;
+
+	int ret = search_fast_tree(fast_tree, search_key, search_type, &search_result);
+
+	if (!is_expected){
+		if (ret == 0){
+			fprintf(stderr, "Error: search type %d for key %lu found %lu, expected nothing\n", search_type, search_key, search_result.key);
+			return -1;
+		}
+		return 0;
+	}
+
+	if ((ret != 0) || (search_result.key != expected_key) || (search_result.value != TEST_VALUE(expected_key))){
+		fprintf(stderr, "Error: search type %d for key %lu returned (%d, %lu), expected %lu\n", search_type, search_key, ret, search_result.key, expected_key);
+		return -1;
+	}
+
+	return 0;
+}
+
+// Every search type at and around each key returns what the sorted keys say it should
+static int check_test_tree(Fast_Tree * fast_tree, Test_Keys * test_keys){
+
+	int ret = 0;
+
+	uint64_t * keys = test_keys -> keys;
+	uint64_t n = test_keys -> n;
+
+	if ((fast_tree -> cnt != n) || ((n > 0) && ((fast_tree -> min != keys[0]) || (fast_tree -> max != keys[n - 1])))){
+		fprintf(stderr, "Error: tree has (cnt, min, max) = (%lu, %lu, %lu), expected %lu keys\n", fast_tree -> cnt, fast_tree -> min, fast_tree -> max, n);
+		return -1;
+	}
+
+	if (n == 0){
+		return 0;
+	}
+
+	ret |= check_search(fast_tree, 0, FAST_TREE_MIN, true, keys[0]);
+	ret |= check_search(fast_tree, 0, FAST_TREE_MAX, true, keys[n - 1]);
+
+	if (keys[0] > 0){
+		ret |= check_search(fast_tree, keys[0] - 1, FAST_TREE_EQUAL_OR_PREV, false, 0);
+		ret |= check_search(fast_tree, keys[0] - 1, FAST_TREE_EQUAL_OR_NEXT, true, keys[0]);
+	}
+
+	bool has_next, has_gap;
+	for (uint64_t i = 0; (i < n) && !ret; i++){
+
+		has_next = (i < n - 1);
+
+		ret |= check_search(fast_tree, keys[i], FAST_TREE_EQUAL, true, keys[i]);
+		ret |= check_search(fast_tree, keys[i], FAST_TREE_EQUAL_OR_PREV, true, keys[i]);
+		ret |= check_search(fast_tree, keys[i], FAST_TREE_EQUAL_OR_NEXT, true, keys[i]);
+		ret |= check_search(fast_tree, keys[i], FAST_TREE_PREV, i > 0, (i > 0) ? keys[i - 1] : 0);
+		ret |= check_search(fast_tree, keys[i], FAST_TREE_NEXT, has_next, has_next ? keys[i + 1] : 0);
+
+		// the key right after this one, if it isn't also within the tree
+		has_gap = (keys[i] < test_keys -> max_key) && (!has_next || (keys[i + 1] > keys[i] + 1));
+		if (has_gap){
+			ret |= check_search(fast_tree, keys[i] + 1, FAST_TREE_EQUAL_OR_PREV, true, keys[i]);
+			ret |= check_search(fast_tree, keys[i] + 1, FAST_TREE_EQUAL_OR_NEXT, has_next, has_next ? keys[i + 1] : 0);
+			ret |= check_search(fast_tree, keys[i] + 1, FAST_TREE_PREV, true, keys[i]);
+			ret |= check_search(fast_tree, keys[i] + 1, FAST_TREE_NEXT, has_next, has_next ? keys[i + 1] : 0);
+		}
+	}
+
+	return ret;
+}
+
+// Runs the test once per key width, each with its own sorted keys
+static int run_keys_test(char * description, Test_Keys_Func test_func, unsigned int seed){
+
+	int ret;
+
+	Fast_Tree_Key_Bits key_bits[3] = {FAST_TREE_KEY_BITS_64, FAST_TREE_KEY_BITS_32, FAST_TREE_KEY_BITS_16};
+	uint64_t max_keys[3] = {UINT64_MAX, UINT32_MAX, UINT16_MAX};
+
+	printf("%s...\n", description);
+
+	Test_Keys test_keys;
+	uint64_t num_keys;
+
+	for (int i = 0; i < 3; i++){
+
+		ret = init_test_keys(key_bits[i], max_keys[i], seed + i, &test_keys);
+		if (ret){
+			return -1;
+		}
+
+		num_keys = test_keys.n;
+
+		ret = test_func(&test_keys);
+		if (ret){
+			return -1;
+		}
+
+		printf("\tSuccess! %lu keys with key bits type %d\n", num_keys, key_bits[i]);
+
+		destroy_test_keys(&test_keys);
+	}
+
+	printf("\n");
+
+	return 0;
+}
+
+
+// BULK BUILD
+
+static int test_bulk_build(Test_Keys * test_keys){
+
+	int ret;
+
+	Fast_Tree * inserted_tree = insert_test_tree(test_keys);
+	if (!inserted_tree){
+		return -1;
+	}
+
+	Fast_Tree * built_tree = build_test_tree(test_keys);
+	if (!built_tree){
+		return -1;
+	}
+
+	ret = check_test_tree(built_tree, test_keys);
+	if (ret){
+		return -1;
+	}
+
+	Fast_Tree_Stats * built_tree_stats = &(built_tree -> tree_stats);
+	Fast_Tree_Stats * inserted_tree_stats = &(inserted_tree -> tree_stats);
+	if ((built_tree_stats -> num_trees_32 != inserted_tree_stats -> num_trees_32) || (built_tree_stats -> num_trees_16 != inserted_tree_stats -> num_trees_16) ||
+			(built_tree_stats -> num_leaves != inserted_tree_stats -> num_leaves) || (built_tree_stats -> num_nonmain_trees_16 != inserted_tree_stats -> num_nonmain_trees_16) ||
+			(built_tree_stats -> num_outward_leaves != inserted_tree_stats -> num_outward_leaves)){
+		fprintf(stderr, "Error: built tree has a different number of subtrees/leaves than the inserted tree\n");
+		return -1;
+	}
+
+	// only the table sizes can differ (the built tables are presized)
+	Fast_Tree_Memory_Stats built_stats, inserted_stats;
+	fast_tree_stats(built_tree, &built_stats);
+	fast_tree_stats(inserted_tree, &inserted_stats);
+	for (int level = 0; level < FAST_TREE_NUM_LEVELS; level++){
+		if ((built_stats.levels[level].num_tables != inserted_stats.levels[level].num_tables) ||
+				(built_stats.levels[level].num_items != inserted_stats.levels[level].num_items)){
+			fprintf(stderr, "Error: built tree has different tables/items at level %d than the inserted tree\n", level);
+			return -1;
+		}
+	}
+
+	// and the built tree can still be modified like any other
+	ret = remove_test_tree(built_tree, test_keys, 2);
+	if (ret){
+		return -1;
+	}
+
+	remove_test_keys(test_keys, 2);
+
+	return check_test_tree(built_tree, test_keys);
+}
+
+
+// ORDERED ITERATION
+
+static int test_cursor(Test_Keys * test_keys){
+
+	int ret;
+
+	uint64_t * keys = test_keys -> keys;
+	uint64_t n = test_keys -> n;
+	uint64_t max_key = test_keys -> max_key;
+
+	Fast_Tree * fast_tree = insert_test_tree(test_keys);
+	if (!fast_tree){
+		return -1;
+	}
+
+	Fast_Tree_Cursor cursor;
+
+	// forwards over everything
+	uint64_t num_visited = 0;
+	ret = init_fast_tree_cursor(fast_tree, 0, FAST_TREE_EQUAL_OR_NEXT, &cursor);
+	while (ret == 0){
+		if ((num_visited >= n) || (cursor.key != keys[num_visited]) || (cursor.value != TEST_VALUE(cursor.key))){
+			fprintf(stderr, "Error: forward cursor at position %lu has key %lu\n", num_visited, cursor.key);
+			return -1;
+		}
+		num_visited++;
+		ret = next_fast_tree_cursor(&cursor);
+	}
+
+	if (num_visited != n){
+		fprintf(stderr, "Error: forward cursor visited %lu of %lu keys\n", num_visited, n);
+		return -1;
+	}
+
+	// at the end the cursor stays at the last key
+	if (cursor.key != keys[n - 1]){
+		fprintf(stderr, "Error: cursor moved past the last key\n");
+		return -1;
+	}
+
+	// backwards over everything
+	num_visited = 0;
+	ret = init_fast_tree_cursor(fast_tree, max_key, FAST_TREE_EQUAL_OR_PREV, &cursor);
+	while (ret == 0){
+		if ((num_visited >= n) || (cursor.key != keys[n - 1 - num_visited]) || (cursor.value != TEST_VALUE(cursor.key))){
+			fprintf(stderr, "Error: backward cursor at position %lu has key %lu\n", num_visited, cursor.key);
+			return -1;
+		}
+		num_visited++;
+		ret = prev_fast_tree_cursor(&cursor);
+	}
+
+	if (num_visited != n){
+		fprintf(stderr, "Error: backward cursor visited %lu of %lu keys\n", num_visited, n);
+		return -1;
+	}
+
+	// ranges starting and ending between keys
+	uint64_t lo_ind, hi_ind, lo, hi;
+	for (int i = 0; i < 100; i++){
+
+		lo_ind = rand_r(&(test_keys -> seed)) % n;
+		hi_ind = lo_ind + rand_r(&(test_keys -> seed)) % (n - lo_ind);
+		lo = (lo_ind > 0) ? keys[lo_ind - 1] + 1 : 0;
+		hi = (hi_ind < n - 1) ? keys[hi_ind + 1] - 1 : max_key;
+
+		num_visited = 0;
+		ret = init_fast_tree_cursor(fast_tree, lo, FAST_TREE_EQUAL_OR_NEXT, &cursor);
+		while ((ret == 0) && (cursor.key <= hi)){
+			if (cursor.key != keys[lo_ind + num_visited]){
+				fprintf(stderr, "Error: range [%lu, %lu] cursor at position %lu has key %lu\n", lo, hi, num_visited, cursor.key);
+				return -1;
+			}
+			num_visited++;
+			ret = next_fast_tree_cursor(&cursor);
+		}
+
+		if (num_visited != hi_ind - lo_ind + 1){
+			fprintf(stderr, "Error: range [%lu, %lu] visited %lu of %lu keys\n", lo, hi, num_visited, hi_ind - lo_ind + 1);
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+
+// BATCH SEARCH
+
+// not a multiple of FAST_TREE_BATCH_PREFETCH_KEYS so the last batch is partial
+#define TEST_BATCH_NUM_SEARCH_KEYS 3001
+
+static int test_batch_search(Test_Keys * test_keys){
+
+	int ret;
+
+	uint64_t * keys = test_keys -> keys;
+	uint64_t n = test_keys -> n;
+	uint64_t max_key = test_keys -> max_key;
+
+	uint64_t * search_keys = (uint64_t *) malloc(TEST_BATCH_NUM_SEARCH_KEYS * sizeof(uint64_t));
+	Fast_Tree_Result * batch_results = (Fast_Tree_Result *) malloc(TEST_BATCH_NUM_SEARCH_KEYS * sizeof(Fast_Tree_Result));
+	if (!search_keys || !batch_results){
+		fprintf(stderr, "Error: malloc failed for batch search keys\n");
+		return -1;
+	}
+
+	Fast_Tree * fast_tree = build_test_tree(test_keys);
+	if (!fast_tree){
+		return -1;
+	}
+
+	// unsorted, with repeats, and including keys past both ends of the tree
+	unsigned int * seed = &(test_keys -> seed);
+	uint64_t key;
+	for (uint64_t i = 0; i < TEST_BATCH_NUM_SEARCH_KEYS; i++){
+		key = keys[rand_r(seed) % n];
+		switch (rand_r(seed) % 4){
+			case 0:
+				search_keys[i] = key;
+				break;
+			case 1:
+				search_keys[i] = (key > 0) ? key - 1 : key;
+				break;
+			case 2:
+				search_keys[i] = (key < max_key) ? key + 1 : key;
+				break;
+			default:
+				search_keys[i] = (((uint64_t) rand_r(seed) << 33) ^ ((uint64_t) rand_r(seed) << 2)) & max_key;
+				break;
+		}
+	}
+	search_keys[0] = 0;
+	search_keys[1] = max_key;
+
+	uint64_t num_found, num_expected;
+	Fast_Tree_Result search_result;
+
+	for (FastTreeSearchModifier search_type = FAST_TREE_MIN; search_type <= FAST_TREE_EQUAL_OR_NEXT; search_type++){
+
+		num_found = search_batch_fast_tree(fast_tree, search_keys, TEST_BATCH_NUM_SEARCH_KEYS, search_type, batch_results);
+
+		num_expected = 0;
+		for (uint64_t i = 0; i < TEST_BATCH_NUM_SEARCH_KEYS; i++){
+			ret = search_fast_tree(fast_tree, search_keys[i], search_type, &search_result);
+			if (ret == 0){
+				num_expected++;
+				if ((batch_results[i].fast_tree_leaf != search_result.fast_tree_leaf) || (batch_results[i].key != search_result.key) ||
+						(batch_results[i].value != search_result.value)){
+					fprintf(stderr, "Error: batch search type %d for key %lu found %lu, individual search found %lu\n",
+									search_type, search_keys[i], batch_results[i].key, search_result.key);
+					return -1;
+				}
+			}
+			else if (batch_results[i].fast_tree_leaf != NULL){
+				fprintf(stderr, "Error: batch search type %d for key %lu found %lu, individual search found nothing\n",
+									search_type, search_keys[i], batch_results[i].key);
+				return -1;
+			}
+		}
+
+		if (num_found != num_expected){
+			fprintf(stderr, "Error: batch search type %d reported %lu results, expected %lu\n", search_type, num_found, num_expected);
+			return -1;
+		}
+	}
+
+	free(search_keys);
+	free(batch_results);
+
+	return 0;
+}
+
+
+// COMPACTION
+
+// every key within [0, TEST_COMPACT_NUM_KEYS) gets inserted so every table grows to
+// its largest layout, then all but 1 out of every TEST_COMPACT_KEEP_EVERY keys are removed
+#define TEST_COMPACT_NUM_KEYS (1UL << 18)
+#define TEST_COMPACT_KEEP_EVERY 20
+
+static int test_compact(){
+
+	int ret;
+
+	printf("Compaction shrinks the tables after mass removal...\n");
+
+	Test_Keys test_keys;
+	test_keys.key_bits = FAST_TREE_KEY_BITS_64;
+	test_keys.max_key = UINT64_MAX;
+	test_keys.n = TEST_COMPACT_NUM_KEYS;
+	test_keys.keys = (uint64_t *) malloc(TEST_COMPACT_NUM_KEYS * sizeof(uint64_t));
+	test_keys.values = (void **) malloc(TEST_COMPACT_NUM_KEYS * sizeof(void *));
+	if (!test_keys.keys || !test_keys.values){
+		fprintf(stderr, "Error: malloc failed for compaction keys\n");
+		return -1;
+	}
+
+	// spread the dense run over multiple 32-bit trees
+	for (uint64_t i = 0; i < TEST_COMPACT_NUM_KEYS; i++){
+		test_keys.keys[i] = ((i >> 16) << 32) | (i & 0xFFFF);
+		test_keys.values[i] = TEST_VALUE(test_keys.keys[i]);
+	}
+
+	Fast_Tree * fast_tree = insert_test_tree(&test_keys);
+	if (!fast_tree){
+		return -1;
+	}
+
+	ret = remove_test_tree(fast_tree, &test_keys, TEST_COMPACT_KEEP_EVERY);
+	if (ret){
+		return -1;
+	}
+
+	remove_test_keys(&test_keys, TEST_COMPACT_KEEP_EVERY);
+
+	Fast_Tree_Memory_Stats removed_stats, compacted_stats;
+	fast_tree_stats(fast_tree, &removed_stats);
+
+	ret = compact_fast_tree(fast_tree);
+	if (ret){
+		fprintf(stderr, "Error: compact_fast_tree failed\n");
+		return -1;
+	}
+
+	fast_tree_stats(fast_tree, &compacted_stats);
+
+	if (compacted_stats.total_bytes >= removed_stats.total_bytes){
+		fprintf(stderr, "Error: compaction did not shrink the tree. Bytes before: %lu, after: %lu\n", removed_stats.total_bytes, compacted_stats.total_bytes);
+		return -1;
+	}
+
+	for (int level = 0; level < FAST_TREE_NUM_LEVELS; level++){
+		if ((compacted_stats.levels[level].num_tables != removed_stats.levels[level].num_tables) ||
+				(compacted_stats.levels[level].num_items != removed_stats.levels[level].num_items) ||
+				(compacted_stats.levels[level].num_slots > removed_stats.levels[level].num_slots)){
+			fprintf(stderr, "Error: compaction changed the contents or grew the tables at level %d\n", level);
+			return -1;
+		}
+	}
+
+	// everything that remains is still there, and nothing else
+	ret = check_test_tree(fast_tree, &test_keys);
+	if (ret){
+		return -1;
+	}
+
+	// the tables are already at their compact size
+	ret = compact_fast_tree(fast_tree);
+	if (ret){
+		fprintf(stderr, "Error: compact_fast_tree failed\n");
+		return -1;
+	}
+
+	Fast_Tree_Memory_Stats recompacted_stats;
+	fast_tree_stats(fast_tree, &recompacted_stats);
+
+	if (recompacted_stats.total_bytes != compacted_stats.total_bytes){
+		fprintf(stderr, "Error: compacting twice changed the size. Bytes before: %lu, after: %lu\n", compacted_stats.total_bytes, recompacted_stats.total_bytes);
+		return -1;
+	}
+
+	printf("\tSuccess! %lu keys remaining, bytes: %lu => %lu\n\n", test_keys.n, removed_stats.total_bytes, compacted_stats.total_bytes);
+
+	destroy_test_keys(&test_keys);
+
+	return 0;
+}
+
+
+int main(int argc, char * argv[]){
+
+	int ret;
+
+	ret = test_concurrent_searches();
+	if (ret){
+		return -1;
+	}
+
+	ret = run_keys_test("Bulk build matches inserting one by one", test_bulk_build, 1);
+	if (ret){
+		return -1;
+	}
+
+	ret = run_keys_test("Cursor iterates in key order across leaves", test_cursor, 11);
+	if (ret){
+		return -1;
+	}
+
+	ret = run_keys_test("Batch search matches individual searches", test_batch_search, 21);
+	if (ret){
+		return -1;
+	}
+
+	ret = test_compact();
+	if (ret){
+		return -1;
+	}
+
+	printf("All fast tree tests passed!\n");
+
+	return 0;
+}
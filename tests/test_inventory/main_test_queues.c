@@ -0,0 +1,764 @@
+#include "spsc_ring.h"
+#include "fifo.h"
+
+#include <immintrin.h>
+
+// Every item within these tests is a uint64_t whose value says exactly which item
+// it is, so the consumers can check that each one arrives exactly once (and in order)
+
+
+// SPSC RING
+
+// requested capacity (gets rounded up to TEST_SPSC_ROUNDED_MAX_ITEMS)
+#define TEST_SPSC_MAX_ITEMS 50
+#define TEST_SPSC_ROUNDED_MAX_ITEMS 64
+#define TEST_SPSC_NUM_LAPS 200
+#define TEST_SPSC_NUM_ITEMS (1UL << 20)
+// batches go up to 3x the capacity, so the producer has to publish them in parts
+#define TEST_SPSC_MAX_BATCH_ITEMS (3 * TEST_SPSC_ROUNDED_MAX_ITEMS)
+// the producer sleeps after this many batches so the consumer runs out of items and parks
+#define TEST_SPSC_SLEEP_BATCHES 256
+#define TEST_SPSC_SLEEP_US 200
+
+typedef struct test_spsc_consumer {
+	Spsc_Ring * ring;
+	uint64_t num_consumes;
+	uint64_t num_errors;
+} Test_Spsc_Consumer;
+
+// Single threaded, every batch size from 1 up to the capacity so the
+// slots wrap around the end of the buffer at every offset
+static int test_spsc_wraparound(){
+
+	printf("SPSC ring wraps around at every offset...\n");
+
+	Spsc_Ring * ring = init_spsc_ring(TEST_SPSC_MAX_ITEMS, sizeof(uint64_t), 0);
+	if (!ring){
+		fprintf(stderr, "Error: init spsc ring failed\n");
+		return -1;
+	}
+
+	if (ring -> max_items != TEST_SPSC_ROUNDED_MAX_ITEMS){
+		fprintf(stderr, "Error: spsc ring capacity of %d was rounded to %lu, expected %d\n", TEST_SPSC_MAX_ITEMS, ring -> max_items, TEST_SPSC_ROUNDED_MAX_ITEMS);
+		return -1;
+	}
+
+	uint64_t items[TEST_SPSC_ROUNDED_MAX_ITEMS];
+	uint64_t ret_items[TEST_SPSC_ROUNDED_MAX_ITEMS];
+
+	uint64_t num_consumed = consume_all_nonblock_spsc_ring(ring, ret_items);
+	if (num_consumed != 0){
+		fprintf(stderr, "Error: consumed %lu items from an empty spsc ring\n", num_consumed);
+		return -1;
+	}
+
+	uint64_t next_item = 0;
+	uint64_t num_items;
+	for (uint64_t lap = 0; lap < TEST_SPSC_NUM_LAPS; lap++){
+		num_items = 1 + ((lap * 7) % TEST_SPSC_ROUNDED_MAX_ITEMS);
+		for (uint64_t i = 0; i < num_items; i++){
+			items[i] = next_item + i;
+		}
+
+		produce_batch_spsc_ring(ring, num_items, items);
+
+		num_consumed = consume_all_nonblock_spsc_ring(ring, ret_items);
+		if (num_consumed != num_items){
+			fprintf(stderr, "Error: lap %lu consumed %lu items from the spsc ring, expected %lu\n", lap, num_consumed, num_items);
+			return -1;
+		}
+		for (uint64_t i = 0; i < num_items; i++){
+			if (ret_items[i] != next_item + i){
+				fprintf(stderr, "Error: lap %lu consumed item %lu at position %lu, expected %lu\n", lap, ret_items[i], i, next_item + i);
+				return -1;
+			}
+		}
+		next_item += num_items;
+	}
+
+	destroy_spsc_ring(ring);
+
+	printf("\tSuccess! %lu items over %d laps\n\n", next_item, TEST_SPSC_NUM_LAPS);
+
+	return 0;
+}
+
+static void * run_spsc_consumer(void * _consumer){
+
+	Test_Spsc_Consumer * consumer = (Test_Spsc_Consumer *) _consumer;
+
+	uint64_t * ret_items = (uint64_t *) malloc(consumer -> ring -> max_items * sizeof(uint64_t));
+	if (!ret_items){
+		fprintf(stderr, "Error: malloc failed for spsc consumer items\n");
+		consumer -> num_errors += 1;
+		return NULL;
+	}
+
+	uint64_t next_item = 0;
+	uint64_t num_consumed;
+	while (next_item < TEST_SPSC_NUM_ITEMS){
+		num_consumed = consume_all_spsc_ring(consumer -> ring, ret_items);
+		consumer -> num_consumes += 1;
+		for (uint64_t i = 0; i < num_consumed; i++){
+			// a skipped, repeated or reordered item shows up as a mismatch
+			if (ret_items[i] != next_item){
+				consumer -> num_errors += 1;
+			}
+			next_item = ret_items[i] + 1;
+		}
+	}
+
+	free(ret_items);
+
+	return NULL;
+}
+
+// One producer thread with batches that are up to 3x the capacity and one consumer thread
+// that parks whenever the ring is empty (after spinning for spin_iters)
+static int test_spsc_concurrent(uint64_t spin_iters){
+
+	int ret;
+
+	printf("SPSC ring delivers every item exactly once with spin_iters = %lu...\n", spin_iters);
+
+	Spsc_Ring * ring = init_spsc_ring(TEST_SPSC_MAX_ITEMS, sizeof(uint64_t), spin_iters);
+	if (!ring){
+		fprintf(stderr, "Error: init spsc ring failed\n");
+		return -1;
+	}
+
+	uint64_t * items = (uint64_t *) malloc(TEST_SPSC_MAX_BATCH_ITEMS * sizeof(uint64_t));
+	if (!items){
+		fprintf(stderr, "Error: malloc failed for spsc producer items\n");
+		return -1;
+	}
+
+	Test_Spsc_Consumer consumer;
+	consumer.ring = ring;
+	consumer.num_consumes = 0;
+	consumer.num_errors = 0;
+
+	pthread_t consumer_thread;
+	ret = pthread_create(&consumer_thread, NULL, run_spsc_consumer, &consumer);
+	if (ret){
+		fprintf(stderr, "Error: pthread_create failed for spsc consumer\n");
+		return -1;
+	}
+
+	uint64_t next_item = 0;
+	uint64_t num_items;
+	uint64_t num_batches = 0;
+	while (next_item < TEST_SPSC_NUM_ITEMS){
+		num_items = 1 + ((num_batches * 37) % TEST_SPSC_MAX_BATCH_ITEMS);
+		if (num_items > TEST_SPSC_NUM_ITEMS - next_item){
+			num_items = TEST_SPSC_NUM_ITEMS - next_item;
+		}
+		for (uint64_t i = 0; i < num_items; i++){
+			items[i] = next_item + i;
+		}
+
+		produce_batch_spsc_ring(ring, num_items, items);
+
+		next_item += num_items;
+		num_batches++;
+		if ((num_batches % TEST_SPSC_SLEEP_BATCHES) == 0){
+			usleep(TEST_SPSC_SLEEP_US);
+		}
+	}
+
+	pthread_join(consumer_thread, NULL);
+
+	if (consumer.num_errors > 0){
+		fprintf(stderr, "Error: spsc consumer saw %lu items out of sequence\n", consumer.num_errors);
+		return -1;
+	}
+
+	free(items);
+	destroy_spsc_ring(ring);
+
+	printf("\tSuccess! %lu items in %lu batches, consumed in %lu calls\n\n", (uint64_t) TEST_SPSC_NUM_ITEMS, num_batches, consumer.num_consumes);
+
+	return 0;
+}
+
+
+// LOCK FREE FIFO
+
+#define TEST_FIFO_MAX_ITEMS 8
+#define TEST_FIFO_NUM_LAPS 100
+#define TEST_FIFO_NUM_PRODUCERS 4
+#define TEST_FIFO_NUM_CONSUMERS 3
+#define TEST_FIFO_ITEMS_PER_PRODUCER 50000
+// producers sleep after this many items so the consumers run out of items and park
+#define TEST_FIFO_SLEEP_ITEMS 1024
+#define TEST_FIFO_SLEEP_US 200
+// reserving producers yield between reserve and commit after this many items, so
+// slots are often committed out of order
+#define TEST_FIFO_YIELD_ITEMS 4
+// FIFO_WAIT_SPIN_THEN_PARK iterations, low enough that blocked callers park often
+#define TEST_FIFO_SPIN_ITERS 16
+
+// consumers stop upon this item, which is only produced after all of the producers finished
+#define TEST_FIFO_STOP_ITEM UINT64_MAX
+
+#define TEST_FIFO_ITEM(producer_id, seq) (((uint64_t) (producer_id) << 32) | (seq))
+#define TEST_FIFO_ITEM_PRODUCER(item) ((item) >> 32)
+#define TEST_FIFO_ITEM_SEQ(item) ((item) & 0xFFFFFFFF)
+
+typedef struct test_fifo_producer {
+	Fifo * fifo;
+	uint64_t producer_id;
+	// reserve/commit instead of produce_fifo
+	bool is_reserve;
+	uint64_t num_errors;
+} Test_Fifo_Producer;
+
+typedef struct test_fifo_consumer {
+	Fifo * fifo;
+	// consume_all_fifo (multi-slot claims) instead of consume_fifo
+	bool is_consume_all;
+	// number of times each item was consumed (shared by all consumers)
+	uint64_t * consume_cnts;
+	uint64_t max_consumed;
+	uint64_t num_errors;
+} Test_Fifo_Consumer;
+
+// consumes everything within the fifo and checks it is exactly expected_items
+static int check_consume_all_fifo(Fifo * fifo, uint64_t num_expected_items, uint64_t * expected_items, const char * description){
+
+	uint64_t ret_items[TEST_FIFO_MAX_ITEMS];
+
+	uint64_t num_consumed = consume_all_nonblock_fifo(fifo, ret_items);
+	if (num_consumed != num_expected_items){
+		fprintf(stderr, "Error: %s consumed %lu items, expected %lu\n", description, num_consumed, num_expected_items);
+		return -1;
+	}
+
+	for (uint64_t i = 0; i < num_consumed; i++){
+		if (ret_items[i] != expected_items[i]){
+			fprintf(stderr, "Error: %s consumed item %lu at position %lu, expected %lu\n", description, ret_items[i], i, expected_items[i]);
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+// Single threaded
+//	- consume_all claims every ready slot at once (wrapping around the end of the buffer)
+//	- a full fifo rejects non-blocking produces
+//	- committed slots are only consumed once every slot before them was committed as well
+static int test_fifo_claims(){
+
+	int ret;
+
+	printf("Lock free fifo claims and out of order commits...\n");
+
+	Fifo * fifo = init_fifo_with_engine(TEST_FIFO_MAX_ITEMS, sizeof(uint64_t), FIFO_ENGINE_LOCK_FREE);
+	if (!fifo){
+		fprintf(stderr, "Error: init fifo failed\n");
+		return -1;
+	}
+
+	uint64_t items[TEST_FIFO_MAX_ITEMS];
+
+	uint64_t next_item = 0;
+	uint64_t num_items;
+	for (uint64_t lap = 0; lap < TEST_FIFO_NUM_LAPS; lap++){
+		num_items = 1 + ((lap * 3) % TEST_FIFO_MAX_ITEMS);
+		for (uint64_t i = 0; i < num_items; i++){
+			items[i] = next_item + i;
+			ret = produce_nonblock_fifo(fifo, &(items[i]), true);
+			if (ret){
+				fprintf(stderr, "Error: lap %lu could not produce item %lu of %lu\n", lap, i, num_items);
+				return -1;
+			}
+		}
+		ret = check_consume_all_fifo(fifo, num_items, items, "consume all");
+		if (ret){
+			return -1;
+		}
+		next_item += num_items;
+	}
+
+	// fill it up
+	for (uint64_t i = 0; i < TEST_FIFO_MAX_ITEMS; i++){
+		items[i] = next_item + i;
+		produce_fifo(fifo, &(items[i]));
+	}
+	ret = produce_nonblock_fifo(fifo, &next_item, true);
+	if (ret == 0){
+		fprintf(stderr, "Error: produced into a full fifo\n");
+		return -1;
+	}
+	ret = check_consume_all_fifo(fifo, TEST_FIFO_MAX_ITEMS, items, "full fifo");
+	if (ret){
+		return -1;
+	}
+	next_item += TEST_FIFO_MAX_ITEMS;
+
+	// reserve 3 slots and commit them as 1, 0, 2
+	uint64_t reserve_pos[3];
+	for (int i = 0; i < 3; i++){
+		reserve_pos[i] = reserve_fifo(fifo);
+		if (reserve_pos[i] == FIFO_RESERVE_ERROR){
+			fprintf(stderr, "Error: reserve fifo failed\n");
+			return -1;
+		}
+		items[i] = next_item + i;
+		*((uint64_t *) get_buffer_addr(fifo, reserve_pos[i] % (fifo -> max_items))) = items[i];
+	}
+
+	commit_fifo(fifo, reserve_pos[1]);
+	ret = check_consume_all_fifo(fifo, 0, NULL, "uncommitted first slot");
+	if (ret){
+		return -1;
+	}
+
+	commit_fifo(fifo, reserve_pos[0]);
+	ret = check_consume_all_fifo(fifo, 2, items, "first two commits");
+	if (ret){
+		return -1;
+	}
+
+	commit_fifo(fifo, reserve_pos[2]);
+	ret = check_consume_all_fifo(fifo, 1, &(items[2]), "last commit");
+	if (ret){
+		return -1;
+	}
+
+	printf("\tSuccess! %d laps of consume all and out of order commits\n\n", TEST_FIFO_NUM_LAPS);
+
+	return 0;
+}
+
+static void * run_fifo_producer(void * _producer){
+
+	Test_Fifo_Producer * producer = (Test_Fifo_Producer *) _producer;
+	Fifo * fifo = producer -> fifo;
+
+	uint64_t item;
+	uint64_t reserve_pos;
+
+	for (uint64_t seq = 0; seq < TEST_FIFO_ITEMS_PER_PRODUCER; seq++){
+		item = TEST_FIFO_ITEM(producer -> producer_id, seq);
+		if (producer -> is_reserve){
+			reserve_pos = reserve_fifo(fifo);
+			if (reserve_pos == FIFO_RESERVE_ERROR){
+				producer -> num_errors += 1;
+				return NULL;
+			}
+			*((uint64_t *) get_buffer_addr(fifo, reserve_pos % (fifo -> max_items))) = item;
+			// let the other producers claim and commit the following slots first
+			if ((seq % TEST_FIFO_YIELD_ITEMS) == 0){
+				sched_yield();
+			}
+			commit_fifo(fifo, reserve_pos);
+		}
+		else{
+			produce_fifo(fifo, &item);
+		}
+		if (((seq + 1) % TEST_FIFO_SLEEP_ITEMS) == 0){
+			usleep(TEST_FIFO_SLEEP_US);
+		}
+	}
+
+	return NULL;
+}
+
+static void * run_fifo_consumer(void * _consumer){
+
+	Test_Fifo_Consumer * consumer = (Test_Fifo_Consumer *) _consumer;
+	Fifo * fifo = consumer -> fifo;
+
+	uint64_t ret_items[TEST_FIFO_MAX_ITEMS];
+
+	// Items of the same producer are consumed in the order they were produced,
+	// even when split among consumers (each claim takes the oldest ready slots)
+	uint64_t next_seqs[TEST_FIFO_NUM_PRODUCERS] = {0};
+
+	uint64_t num_consumed;
+	uint64_t num_stops;
+	uint64_t item, producer_id;
+	while (1){
+		if (consumer -> is_consume_all){
+			num_consumed = consume_all_fifo(fifo, ret_items);
+		}
+		else{
+			consume_fifo(fifo, ret_items);
+			num_consumed = 1;
+		}
+		if (num_consumed > consumer -> max_consumed){
+			consumer -> max_consumed = num_consumed;
+		}
+
+		num_stops = 0;
+		for (uint64_t i = 0; i < num_consumed; i++){
+			item = ret_items[i];
+			if (item == TEST_FIFO_STOP_ITEM){
+				num_stops++;
+				continue;
+			}
+			producer_id = TEST_FIFO_ITEM_PRODUCER(item);
+			if ((producer_id >= TEST_FIFO_NUM_PRODUCERS) || (TEST_FIFO_ITEM_SEQ(item) >= TEST_FIFO_ITEMS_PER_PRODUCER)){
+				consumer -> num_errors += 1;
+				continue;
+			}
+			if (TEST_FIFO_ITEM_SEQ(item) < next_seqs[producer_id]){
+				consumer -> num_errors += 1;
+			}
+			next_seqs[producer_id] = TEST_FIFO_ITEM_SEQ(item) + 1;
+			__atomic_fetch_add(&((consumer -> consume_cnts)[producer_id * TEST_FIFO_ITEMS_PER_PRODUCER + TEST_FIFO_ITEM_SEQ(item)]), 1, __ATOMIC_RELAXED);
+		}
+
+		// the stops are the last items produced, so nothing else can follow them within this claim.
+		// Hand the extra ones back for the other consumers
+		if (num_stops > 0){
+			item = TEST_FIFO_STOP_ITEM;
+			for (uint64_t i = 1; i < num_stops; i++){
+				produce_fifo(fifo, &item);
+			}
+			return NULL;
+		}
+	}
+}
+
+// N producers (half of them reserving/committing, out of order with the others) and M consumers (one consuming single
+// items, the others with consume_all_fifo) through a small fifo, so both sides block and park constantly
+static int test_fifo_concurrent(Fifo_Wait_Policy wait_policy, const char * wait_policy_name){
+
+	int ret;
+
+	printf("Lock free fifo delivers every item exactly once with %d producers, %d consumers and %s...\n", TEST_FIFO_NUM_PRODUCERS, TEST_FIFO_NUM_CONSUMERS, wait_policy_name);
+
+	Fifo * fifo = init_fifo_with_engine(TEST_FIFO_MAX_ITEMS, sizeof(uint64_t), FIFO_ENGINE_LOCK_FREE);
+	if (!fifo){
+		fprintf(stderr, "Error: init fifo failed\n");
+		return -1;
+	}
+
+	set_wait_policy_fifo(fifo, wait_policy, TEST_FIFO_SPIN_ITERS);
+
+	uint64_t num_items = TEST_FIFO_NUM_PRODUCERS * TEST_FIFO_ITEMS_PER_PRODUCER;
+	uint64_t * consume_cnts = (uint64_t *) calloc(num_items, sizeof(uint64_t));
+	if (!consume_cnts){
+		fprintf(stderr, "Error: calloc failed for consume counts\n");
+		return -1;
+	}
+
+	Test_Fifo_Consumer consumers[TEST_FIFO_NUM_CONSUMERS];
+	pthread_t consumer_threads[TEST_FIFO_NUM_CONSUMERS];
+
+	for (int i = 0; i < TEST_FIFO_NUM_CONSUMERS; i++){
+		consumers[i].fifo = fifo;
+		consumers[i].is_consume_all = (i > 0);
+		consumers[i].consume_cnts = consume_cnts;
+		consumers[i].max_consumed = 0;
+		consumers[i].num_errors = 0;
+		ret = pthread_create(&(consumer_threads[i]), NULL, run_fifo_consumer, &(consumers[i]));
+		if (ret){
+			fprintf(stderr, "Error: pthread_create failed for consumer %d\n", i);
+			return -1;
+		}
+	}
+
+	Test_Fifo_Producer producers[TEST_FIFO_NUM_PRODUCERS];
+	pthread_t producer_threads[TEST_FIFO_NUM_PRODUCERS];
+
+	for (int i = 0; i < TEST_FIFO_NUM_PRODUCERS; i++){
+		producers[i].fifo = fifo;
+		producers[i].producer_id = i;
+		producers[i].is_reserve = ((i % 2) == 1);
+		producers[i].num_errors = 0;
+		ret = pthread_create(&(producer_threads[i]), NULL, run_fifo_producer, &(producers[i]));
+		if (ret){
+			fprintf(stderr, "Error: pthread_create failed for producer %d\n", i);
+			return -1;
+		}
+	}
+
+	uint64_t total_errors = 0;
+	for (int i = 0; i < TEST_FIFO_NUM_PRODUCERS; i++){
+		pthread_join(producer_threads[i], NULL);
+		total_errors += producers[i].num_errors;
+	}
+
+	uint64_t stop_item = TEST_FIFO_STOP_ITEM;
+	for (int i = 0; i < TEST_FIFO_NUM_CONSUMERS; i++){
+		produce_fifo(fifo, &stop_item);
+	}
+
+	uint64_t max_consumed = 0;
+	for (int i = 0; i < TEST_FIFO_NUM_CONSUMERS; i++){
+		pthread_join(consumer_threads[i], NULL);
+		total_errors += consumers[i].num_errors;
+		if (consumers[i].max_consumed > max_consumed){
+			max_consumed = consumers[i].max_consumed;
+		}
+	}
+
+	if (total_errors > 0){
+		fprintf(stderr, "Error: %lu items were invalid or consumed out of order\n", total_errors);
+		return -1;
+	}
+
+	for (uint64_t i = 0; i < num_items; i++){
+		if (consume_cnts[i] != 1){
+			fprintf(stderr, "Error: item %lu of producer %lu was consumed %lu times\n", i % TEST_FIFO_ITEMS_PER_PRODUCER, i / TEST_FIFO_ITEMS_PER_PRODUCER, consume_cnts[i]);
+			return -1;
+		}
+	}
+
+	free(consume_cnts);
+
+	printf("\tSuccess! %lu items, at most %lu within one claim\n\n", num_items, max_consumed);
+
+	return 0;
+}
+
+
+// COMPLETIONS
+
+#define TEST_COMPLETION_NUM_WAITERS 4
+#define TEST_COMPLETION_NUM_ROUNDS 1000
+#define TEST_COMPLETION_NUM_DELAYED_ROUNDS 50
+#define TEST_COMPLETION_DELAY_US 100
+// FIFO_WAIT_SPIN_THEN_PARK waiters spin for 1 up to this many iterations (varying by round)
+#define TEST_COMPLETION_MAX_SPIN_ITERS 8
+// the race rounds delay signals by up to this many pauses, which covers the whole spin phase
+// of the waiters (the backoff of TEST_COMPLETION_MAX_SPIN_ITERS iterations is ~255 pauses)
+#define TEST_COMPLETION_MAX_RACE_PAUSES 512
+// a lost wakeup leaves a waiter sleeping forever, so give up on them after this long
+#define TEST_COMPLETION_TIMEOUT_SEC 60
+
+typedef enum test_completion_signal {
+	// signal as soon as the waiter publishes its completion (usually before it even starts waiting)
+	TEST_COMPLETION_SIGNAL_IMMEDIATE,
+	// sleep before signaling, so the waiters have parked (unless they spin forever)
+	TEST_COMPLETION_SIGNAL_DELAYED,
+	// pause a varying amount before signaling, so signals land within the spin phase, right
+	// after it (between the CAS to COMPLETION_PARKED and the futex wait) and within the futex wait
+	TEST_COMPLETION_SIGNAL_RACE
+} Test_Completion_Signal;
+
+typedef struct test_completion_op {
+	Completion completion;
+	bool is_signaled;
+} Test_Completion_Op;
+
+typedef struct test_completion {
+	Fifo_Wait_Policy wait_policy;
+	Test_Completion_Signal signal_mode;
+	uint64_t num_rounds;
+	// each waiter publishes the op it is about to wait on (which lives on its stack)
+	Test_Completion_Op * pending_ops[TEST_COMPLETION_NUM_WAITERS];
+	uint64_t num_done;
+	uint64_t num_errors;
+} Test_Completion;
+
+typedef struct test_completion_waiter {
+	Test_Completion * test;
+	int waiter_id;
+} Test_Completion_Waiter;
+
+static void * run_completion_waiter(void * _waiter){
+
+	Test_Completion_Waiter * waiter = (Test_Completion_Waiter *) _waiter;
+	Test_Completion * test = waiter -> test;
+
+	Test_Completion_Op op;
+
+	for (uint64_t round = 0; round < test -> num_rounds; round++){
+		init_completion(&(op.completion), test -> wait_policy, 1 + (round % TEST_COMPLETION_MAX_SPIN_ITERS));
+		op.is_signaled = false;
+
+		__atomic_store_n(&((test -> pending_ops)[waiter -> waiter_id]), &op, __ATOMIC_RELEASE);
+
+		wait_completion(&(op.completion));
+
+		// the signaler sets this before signaling
+		if (!__atomic_load_n(&(op.is_signaled), __ATOMIC_RELAXED)){
+			__atomic_fetch_add(&(test -> num_errors), 1, __ATOMIC_RELAXED);
+		}
+
+		// the next round re-initializes the same memory, which is only safe
+		// because the signaler never touches the op after signaling it
+		__atomic_fetch_add(&(test -> num_done), 1, __ATOMIC_RELEASE);
+	}
+
+	return NULL;
+}
+
+static void * run_completion_signaler(void * _test){
+
+	Test_Completion * test = (Test_Completion *) _test;
+
+	uint64_t num_signals = TEST_COMPLETION_NUM_WAITERS * test -> num_rounds;
+	uint64_t num_signaled = 0;
+	uint64_t num_pauses;
+	Test_Completion_Op * op;
+
+	while (num_signaled < num_signals){
+		for (int i = 0; i < TEST_COMPLETION_NUM_WAITERS; i++){
+			op = __atomic_exchange_n(&((test -> pending_ops)[i]), NULL, __ATOMIC_ACQUIRE);
+			if (!op){
+				continue;
+			}
+
+			if (test -> signal_mode == TEST_COMPLETION_SIGNAL_DELAYED){
+				usleep(TEST_COMPLETION_DELAY_US);
+			}
+			else if (test -> signal_mode == TEST_COMPLETION_SIGNAL_RACE){
+				num_pauses = (num_signaled * 37) % TEST_COMPLETION_MAX_RACE_PAUSES;
+				for (uint64_t j = 0; j < num_pauses; j++){
+					_mm_pause();
+				}
+			}
+
+			__atomic_store_n(&(op -> is_signaled), true, __ATOMIC_RELAXED);
+			signal_completion(&(op -> completion));
+			num_signaled++;
+		}
+		// nothing to signal, let the waiters run
+		sched_yield();
+	}
+
+	return NULL;
+}
+
+// TEST_COMPLETION_NUM_WAITERS threads each wait on their own completion for num_rounds, all signaled by one thread
+static int test_completion(Fifo_Wait_Policy wait_policy, const char * wait_policy_name, Test_Completion_Signal signal_mode, const char * signal_mode_name, uint64_t num_rounds){
+
+	int ret;
+
+	printf("Completions with %d waiters, %s and %s signals...\n", TEST_COMPLETION_NUM_WAITERS, wait_policy_name, signal_mode_name);
+
+	Test_Completion test;
+	test.wait_policy = wait_policy;
+	test.signal_mode = signal_mode;
+	test.num_rounds = num_rounds;
+	for (int i = 0; i < TEST_COMPLETION_NUM_WAITERS; i++){
+		test.pending_ops[i] = NULL;
+	}
+	test.num_done = 0;
+	test.num_errors = 0;
+
+	Test_Completion_Waiter waiters[TEST_COMPLETION_NUM_WAITERS];
+	pthread_t waiter_threads[TEST_COMPLETION_NUM_WAITERS];
+
+	for (int i = 0; i < TEST_COMPLETION_NUM_WAITERS; i++){
+		waiters[i].test = &test;
+		waiters[i].waiter_id = i;
+		ret = pthread_create(&(waiter_threads[i]), NULL, run_completion_waiter, &(waiters[i]));
+		if (ret){
+			fprintf(stderr, "Error: pthread_create failed for waiter %d\n", i);
+			return -1;
+		}
+	}
+
+	pthread_t signaler_thread;
+	ret = pthread_create(&signaler_thread, NULL, run_completion_signaler, &test);
+	if (ret){
+		fprintf(stderr, "Error: pthread_create failed for signaler\n");
+		return -1;
+	}
+
+	// joining a waiter that missed its wakeup would hang, so poll instead
+	uint64_t num_waits = TEST_COMPLETION_NUM_WAITERS * num_rounds;
+	time_t start_time = time(NULL);
+	while (__atomic_load_n(&(test.num_done), __ATOMIC_ACQUIRE) < num_waits){
+		if (time(NULL) - start_time > TEST_COMPLETION_TIMEOUT_SEC){
+			fprintf(stderr, "Error: only %lu of %lu waits returned within %d seconds (lost wakeup)\n", 
+								__atomic_load_n(&(test.num_done), __ATOMIC_ACQUIRE), num_waits, TEST_COMPLETION_TIMEOUT_SEC);
+			return -1;
+		}
+		usleep(1000);
+	}
+
+	for (int i = 0; i < TEST_COMPLETION_NUM_WAITERS; i++){
+		pthread_join(waiter_threads[i], NULL);
+	}
+	pthread_join(signaler_thread, NULL);
+
+	if (test.num_errors > 0){
+		fprintf(stderr, "Error: %lu waits returned before being signaled\n", test.num_errors);
+		return -1;
+	}
+
+	printf("\tSuccess! %lu waits\n\n", num_waits);
+
+	return 0;
+}
+
+static int test_completion_policies(){
+
+	int ret;
+
+	Fifo_Wait_Policy wait_policies[3] = {FIFO_WAIT_PARK, FIFO_WAIT_SPIN_THEN_PARK, FIFO_WAIT_SPIN};
+	const char * wait_policy_names[3] = {"FIFO_WAIT_PARK", "FIFO_WAIT_SPIN_THEN_PARK", "FIFO_WAIT_SPIN"};
+
+	for (int i = 0; i < 3; i++){
+		ret = test_completion(wait_policies[i], wait_policy_names[i], TEST_COMPLETION_SIGNAL_IMMEDIATE, "immediate", TEST_COMPLETION_NUM_ROUNDS);
+		if (ret){
+			return -1;
+		}
+
+		ret = test_completion(wait_policies[i], wait_policy_names[i], TEST_COMPLETION_SIGNAL_DELAYED, "delayed", TEST_COMPLETION_NUM_DELAYED_ROUNDS);
+		if (ret){
+			return -1;
+		}
+
+		ret = test_completion(wait_policies[i], wait_policy_names[i], TEST_COMPLETION_SIGNAL_RACE, "racing", TEST_COMPLETION_NUM_ROUNDS);
+		if (ret){
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+
+int main(int argc, char * argv[]){
+
+	int ret;
+
+	ret = test_spsc_wraparound();
+	if (ret){
+		return -1;
+	}
+
+	// always park
+	ret = test_spsc_concurrent(0);
+	if (ret){
+		return -1;
+	}
+
+	ret = test_spsc_concurrent(64);
+	if (ret){
+		return -1;
+	}
+
+	ret = test_fifo_claims();
+	if (ret){
+		return -1;
+	}
+
+	ret = test_fifo_concurrent(FIFO_WAIT_PARK, "FIFO_WAIT_PARK");
+	if (ret){
+		return -1;
+	}
+
+	ret = test_fifo_concurrent(FIFO_WAIT_SPIN_THEN_PARK, "FIFO_WAIT_SPIN_THEN_PARK");
+	if (ret){
+		return -1;
+	}
+
+	ret = test_completion_policies();
+	if (ret){
+		return -1;
+	}
+
+	printf("All queue tests passed!\n");
+
+	return 0;
+}
@@ -40,6 +40,62 @@ int node_config_cmp(void * node_config, void * other_node_config){
 }
 
 
+// qsort passes references to the array elements (Node_Config *)
+static int node_config_ref_cmp(const void * node_config_ref, const void * other_node_config_ref){
+	return node_config_cmp(*((void **) node_config_ref), *((void **) other_node_config_ref));
+}
+
+// Returns the count and populates ret_all_node_config with a view of all the node configs, sorted by node id
+//	- like get_all_items_table the caller frees the returned array (NULL if there are no nodes), but not the items
+// Walks the table with a weak cursor so nothing is locked out. The node configs are only inserted by
+// process_join_net_request while holding id_to_assign_lock (and never removed), so a caller holding
+// that lock sees exactly the nodes within the table
+
+// returns 0 on success, -1 on error
+static int get_all_node_configs(Master * master, uint32_t * ret_node_cnt, Node_Config *** ret_all_node_config){
+
+	int ret;
+
+	*ret_node_cnt = 0;
+	*ret_all_node_config = NULL;
+
+	Table * node_configs = master -> node_configs;
+
+	uint64_t max_node_cnt = get_count_table(node_configs, false);
+	if (max_node_cnt == 0){
+		return 0;
+	}
+
+	Node_Config ** all_node_config = (Node_Config **) malloc(max_node_cnt * sizeof(Node_Config *));
+	if (all_node_config == NULL){
+		fprintf(stderr, "[Master Server] Error: malloc failed to allocate array for %lu node configs\n", max_node_cnt);
+		return -1;
+	}
+
+	Table_Cursor cursor;
+	ret = open_cursor_table(node_configs, false, &cursor);
+	if (ret != 0){
+		fprintf(stderr, "[Master Server] Error: could not open cursor on node configs table\n");
+		free(all_node_config);
+		return -1;
+	}
+
+	uint64_t node_cnt = 0;
+	while ((!cursor.is_done) && (node_cnt < max_node_cnt)){
+		node_cnt += next_cursor_table(&cursor, max_node_cnt - node_cnt, (void **) &(all_node_config[node_cnt]));
+	}
+
+	close_cursor_table(&cursor);
+
+	qsort(all_node_config, node_cnt, sizeof(Node_Config *), &node_config_ref_cmp);
+
+	*ret_node_cnt = (uint32_t) node_cnt;
+	*ret_all_node_config = all_node_config;
+
+	return 0;
+}
+
+
 Master * init_master(char * ip_addr, uint32_t max_nodes, uint32_t min_init_nodes) {
 
 	int ret;
@@ -79,13 +135,14 @@ Master * init_master(char * ip_addr, uint32_t max_nodes, uint32_t min_init_nodes
 	// Keeping it this way for now, for flexiblity
 	float load_factor = 0.5f;
 	float shrink_factor = 0.1f;
+	uint64_t slot_lock_ratio = 1;
 
 	// setting min_nodes == max_nodes
 	uint32_t min_nodes = max_nodes;
 
 	Hash_Func hash_func_node_config = &node_config_hash_func;
 	Item_Cmp item_cmp_node_config = &node_config_cmp;
-	Table * node_configs = init_table(min_nodes, max_nodes, load_factor, shrink_factor, hash_func_node_config, item_cmp_node_config);
+	Table * node_configs = init_table(min_nodes, max_nodes, load_factor, shrink_factor, slot_lock_ratio, hash_func_node_config, item_cmp_node_config, NULL, TABLE_LINEAR_PROBE);
 	if (node_configs == NULL){
 		fprintf(stderr, "[Master] Error: could not initialize master node_config table\n");
 		return NULL;
@@ -191,18 +248,16 @@ int process_join_net_request(Worker_Connection * worker_connection, bool * ret_i
 	uint32_t id_to_assign = master -> id_to_assign;
 
 	// 2.) Obtain all of the exisiting nodes in the table
-	//		- Calling this function completely locks table for duration (no inserts/removals can occur during)
-	//		- However there still may be race condition between a node leaving after this get_all_items_call and before client receives response
+	//		- Walks the table without locking it out (see get_all_node_configs). Holding id_to_assign_lock means no other joiner is being added
+	//		- However there still may be race condition between a node leaving after this and before client receives response
 	//			- This is OK. No issues will occur except that the client's attempted TCP connection to the node that left will timeout => no worries
 	//				- Probably expect a timeout like this to trigger a message to the master to confirm that the node did indeed leave
 
 	Node_Config ** all_node_config;
-	bool to_start_rand = false;
-	bool to_sort = true;
 	uint32_t node_cnt;
-	ret = (uint32_t) get_all_items_table(master -> node_configs, to_start_rand, to_sort, (uint64_t *) &node_cnt, (void *) &all_node_config);
+	ret = get_all_node_configs(master, &node_cnt, &all_node_config);
 	if (ret != 0){
-		fprintf(stderr, "[Master Server] Error: failure in get_all_items_table()\n");
+		fprintf(stderr, "[Master Server] Error: failure in get_all_node_configs()\n");
 		pthread_mutex_unlock(&(master -> id_to_assign_lock));
 		close(sockfd);
 		*ret_is_join_successful = false;
@@ -227,7 +282,7 @@ int process_join_net_request(Worker_Connection * worker_connection, bool * ret_i
 			fprintf(stderr, "[Master Server] Error: malloc failed to allocate node_config array\n");
 			pthread_mutex_unlock(&(master -> id_to_assign_lock));
 			close(sockfd);
-			// ensure to free the array returned from get_all_items table
+			// ensure to free the array returned from get_all_node_configs
 			free(all_node_config);
 			*ret_is_join_successful = false;
 			return -1;
@@ -236,7 +291,7 @@ int process_join_net_request(Worker_Connection * worker_connection, bool * ret_i
 		for (uint32_t i = 0; i < node_cnt; i++){
 			memcpy(&(join_response.node_config_arr[i]), all_node_config[i], sizeof(Node_Config));
 		}
-		// ensure to free the array returned from get_all_items table
+		// ensure to free the array returned from get_all_node_configs
 		free(all_node_config);
 	}	
 	else{
@@ -77,7 +77,34 @@ int init_mempool(Mempool * mempool, int pool_id, void * backing_memory, uint64_t
 
 	mempool -> range_lists_table = range_lists_table;
 
-	mempool -> free_mem_ranges = init_fast_tree();
+	// The keys of this tree are range sizes (at most num_chunks), so
+	// smaller pools can use a narrow tree that skips the upper levels
+	Fast_Tree_Key_Bits free_mem_ranges_key_bits = FAST_TREE_KEY_BITS_64;
+	if (num_chunks <= UINT16_MAX){
+		free_mem_ranges_key_bits = FAST_TREE_KEY_BITS_16;
+	}
+	else if (num_chunks <= UINT32_MAX){
+		free_mem_ranges_key_bits = FAST_TREE_KEY_BITS_32;
+	}
+
+	// Initially there is a single free range (covering the entire pool), so
+	// its range list is created here and the tree is built already containing it.
+	// insert_free_mem_range() below then finds the list and only needs to add to it
+	uint64_t initial_range_size = num_chunks;
+
+	Fast_List * initial_range_list = init_fast_list(MEMORY_RANGE_LIST_DEFAULT_BUFFER_CAPACITY);
+	if (!initial_range_list){
+		fprintf(stderr, "Error: failure to initialize the initial range list\n");
+		return -1;
+	}
+
+	ret = insert_fast_table(range_lists_table, &initial_range_size, &initial_range_list);
+	if (ret){
+		fprintf(stderr, "Error: failure to insert the initial range list into range list table\n");
+		return -1;
+	}
+
+	mempool -> free_mem_ranges = build_fast_tree_sorted_with_key_bits(free_mem_ranges_key_bits, &initial_range_size, (void **) &initial_range_list, 1);
 
 	if (!(mempool -> free_mem_ranges)){
 		fprintf(stderr, "Error: failure to initialize memory fast tree for system mempool\n");
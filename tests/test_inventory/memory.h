@@ -148,7 +148,7 @@ typedef struct mem_op_timestamps {
 	// When the server starts processing sets this
 	uint64_t start_op;
 	// When the server finishes processing sets this
-	// (right before setting is_complete)
+	// (right before signaling completion)
 	uint64_t finish_op;
 } Mem_Op_Timestamps;
 
@@ -161,11 +161,9 @@ typedef struct mem_op {
 	MemOpStatus status;
 	// If we want to track statistics and benchmark...
 	Mem_Op_Timestamps timestamps;
-	// The client will spin on this value
-	// If we wanted we could make this a semaphore
-	// to conserve wasted cycles, but probably perfer 
-	// lowest latency possible
-	bool is_complete;
+	// The client waits on this and the server signals it once the op is processed
+	//	- the client spins and then parks based on MEMORY_OP_WAIT_POLICY
+	Completion completion;
 } Mem_Op;
 
 
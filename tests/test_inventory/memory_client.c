@@ -49,7 +49,7 @@ MemOpStatus submit_memory_op(Memory * memory, MemOpType op_type, Mem_Reservation
 
 	new_mem_op.type = op_type;
 	new_mem_op.mem_reservation = mem_reservation;
-	new_mem_op.is_complete = false;
+	init_completion(&(new_mem_op.completion), MEMORY_OP_WAIT_POLICY, MEMORY_OP_SPIN_ITERS);
 
 	new_mem_op.timestamps.submitted = timestamp_submitted;
 
@@ -89,12 +89,7 @@ MemOpStatus submit_memory_op(Memory * memory, MemOpType op_type, Mem_Reservation
 
 
 	// wait until the server marks this as completed
-
-	// not sure if we need to mark as volatile for compiler to 
-	// not optimize away the loop waiting for completition...
-	volatile bool * is_complete_ptr = &(new_mem_op.is_complete);
-
-	while (!(*is_complete_ptr)) {}
+	wait_completion(&(new_mem_op.completion));
 
 
 	// COULD POPULATE DATASET FOR ANALYZING THE MEM_OP_TIMESTAMPS HERE!!!!
@@ -222,9 +222,10 @@ void * run_memory_server(void * _memory){
 				}
 
 
-				// now set the is_complete flag so client knows
+				// now signal the completion so client knows
 				// it can continue
-				cur_op -> is_complete = true;
+				//	- cur_op is on the client's stack, so can't touch it after this
+				signal_completion(&(cur_op -> completion));
 
 				// decrement the remaining ops for this pool and total number of ops
 				num_queued_per_pool[i] -= 1;
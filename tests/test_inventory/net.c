@@ -46,6 +46,23 @@ int net_node_cmp(void * net_node, void * other_net_node) {
 	}
 }
 
+// the table is in tagged mode, so most probes of slots holding other nodes
+// are rejected without touching the node
+uint16_t net_node_hash_tag_func(void * net_node) {
+	uint32_t key = ((Net_Node *) net_node) -> node_id;
+	return (uint16_t) ((key * 0x9E3779B1U) >> 16);
+}
+
+// Node lookups happen on every outgoing message, so they use their own
+// instantiation of the table's probing paths with the hash, compare and tag inlined
+#define TABLE_T_FN(name) name##_net_node_table
+#define TABLE_T_ITEM_TYPE Net_Node
+#define TABLE_T_KEY_FIELD node_id
+#define TABLE_T_KEY_SIZE sizeof(uint32_t)
+#define TABLE_T_HASH(table, item, size) net_node_hash_func((item), (size))
+#define TABLE_T_TAG(table, item) net_node_hash_tag_func(item)
+#include "table_template.h"
+
 
 // after successful join request from master, but before connecting to any other workers
 // happens during processing of join request
@@ -105,10 +122,13 @@ Net_World * init_net_world(Self_Net * self_net, uint32_t node_id, uint32_t max_n
 	uint32_t min_nodes = max_nodes;
 	float load_factor = 1.0f;
 	float shrink_factor = 0.0f;
+	// small table, so every slot can have its own lock
+	uint64_t slot_lock_ratio = 1;
 
 	Hash_Func hash_func_net_node = &net_node_hash_func;
 	Item_Cmp item_cmp_net_node = &net_node_cmp;
-	Table * nodes = init_table(min_nodes, max_nodes, load_factor, shrink_factor, hash_func_net_node, item_cmp_net_node);
+	Hash_Tag_Func tag_func_net_node = &net_node_hash_tag_func;
+	Table * nodes = init_table(min_nodes, max_nodes, load_factor, shrink_factor, slot_lock_ratio, hash_func_net_node, item_cmp_net_node, tag_func_net_node, TABLE_LINEAR_PROBE);
 	if (nodes == NULL){
 		fprintf(stderr, "Error: could not initialize net_world nodes table\n");
 		return NULL;
@@ -419,7 +439,7 @@ Net_Node * net_add_node(Net_World * net_world, Rdma_Init_Info * remote_rdma_init
 
 	// 5.) Add this node to the table
 
-	ret = insert_item_table(net_world -> nodes, node);
+	ret = insert_item_net_node_table(net_world -> nodes, node);
 	if (ret != 0){
 		fprintf(stderr, "Error: could not add node id: %u to the table during rdma_init processing\n", node -> node_id);
 		for (uint32_t k = 0; k < node -> num_ports; k++){
@@ -464,7 +484,7 @@ void destroy_remote_node(Net_World * net_world, Net_Node * node){
 	free(endpoints);
 	
 	// 4.) Remove node from net_world table
-	remove_item_table(net_world -> nodes, node);
+	remove_item_net_node_table(net_world -> nodes, node);
 
 	// 5.) free node container
 	free(node);
@@ -484,40 +504,64 @@ int post_send_ctrl_net(Net_World * net_world, Ctrl_Message * ctrl_message) {
 
 	int ret;
 
+	// 1.) Reserve a slot on the default channel to the destination
+	Ctrl_Send_Reservation reservation;
+	ret = reserve_send_ctrl_net(net_world, ctrl_message -> header.dest_node_id, &reservation);
+	if (ret != 0){
+		fprintf(stderr, "Error: post_send_ctrl_net failed because couldn't reserve send slot\n");
+		return -1;
+	}
+
+	// 2.) Copy the message into the registered slot
+	memcpy(reservation.ctrl_message, ctrl_message, sizeof(Ctrl_Message));
+
+	// 3.) Actually post send
+	ret = commit_send_ctrl_channel(&reservation);
+	if (ret != 0){
+		fprintf(stderr, "Error: failure to post to control channel within default_post_send_ctrl_net\n");
+		return -1;
+	}
+
+	return 0;
+}
+
+
+int reserve_send_ctrl_net(Net_World * net_world, uint32_t remote_node_id, Ctrl_Send_Reservation * ret_reservation) {
+
+	int ret;
+
 	// 1.) Lookup node in table
-	uint32_t remote_node_id = ctrl_message -> header.dest_node_id;
 	Net_Node target_node;
 	target_node.node_id = remote_node_id;
 
-	Net_Node * remote_node = find_item_table(net_world -> nodes, &target_node);
+	Net_Node * remote_node = find_item_net_node_table(net_world -> nodes, &target_node);
 	if (remote_node == NULL){
-		fprintf(stderr, "Error: post_send_ctrl_net failed because couldn't find remote node with id %u in net_world -> nodes table\n", remote_node_id);
+		fprintf(stderr, "Error: reserve_send_ctrl_net failed because couldn't find remote node with id %u in net_world -> nodes table\n", remote_node_id);
 		return -1;
 	}
 
 	// 2.) Obtain the appropriate sending channel
 	Ctrl_Channel * default_send_ctrl_channel = remote_node -> default_send_ctrl_channel;
 	if (default_send_ctrl_channel == NULL){
-		fprintf(stderr, "Error: post_send_ctrl_net failed becaues it appears this node as no control endpoints available\n");
+		fprintf(stderr, "Error: reserve_send_ctrl_net failed becaues it appears this node as no control endpoints available\n");
 		return -1;
 	}
 
 	// 3.) Obtain default destination from node
 	Net_Dest default_ctrl_dest = remote_node -> default_ctrl_dest;
 	if (default_ctrl_dest.ah == NULL){
-		fprintf(stderr, "Error: post_send_ctrl_net failed because it appears the destination node %u, has no control endpoints available\n", remote_node_id);
+		fprintf(stderr, "Error: reserve_send_ctrl_net failed because it appears the destination node %u, has no control endpoints available\n", remote_node_id);
 		return -1;
 	}
 
-	// 4.) Actually post send
-	ret = post_send_ctrl_channel(default_send_ctrl_channel, ctrl_message, default_ctrl_dest.ah, default_ctrl_dest.remote_qp_num, default_ctrl_dest.remote_qkey);
+	// 4.) Reserve the slot within the channel
+	ret = reserve_send_ctrl_channel(default_send_ctrl_channel, default_ctrl_dest.ah, default_ctrl_dest.remote_qp_num, default_ctrl_dest.remote_qkey, ret_reservation);
 	if (ret != 0){
-		fprintf(stderr, "Error: failure to post to control channel within default_post_send_ctrl_net\n");
+		fprintf(stderr, "Error: reserve_send_ctrl_net failed to reserve a slot within the send channel to node %u\n", remote_node_id);
 		return -1;
 	}
 
 	return 0;
-
 }
 
 
@@ -541,7 +585,7 @@ int policy_post_send_ctrl_net(Net_World * net_world, Ctrl_Message * ctrl_message
 	Net_Node target_node;
 	target_node.node_id = remote_node_id;
 
-	Net_Node * remote_node = find_item_table(net_world -> nodes, &target_node);
+	Net_Node * remote_node = find_item_net_node_table(net_world -> nodes, &target_node);
 	if (remote_node == NULL){
 		fprintf(stderr, "Error: policy_post_send_ctrl_net failed because couldn't find remote node with id %u in net_world -> nodes table\n", remote_node_id);
 		return -1;
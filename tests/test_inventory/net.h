@@ -160,6 +160,12 @@ typedef struct send_dest {
 // with extra overhead of determining address handle
 int post_send_ctrl_net(Net_World * net_world, Ctrl_Message * ctrl_message);
 
+// Reserves a slot on the same default send channel post_send_ctrl_net would use, so the message
+// can be built directly within the registered buffer (see reserve_send_ctrl_channel).
+// Send it with commit_send_ctrl_channel(ret_reservation)
+// returns 0 on success, -1 on error (nothing was reserved)
+int reserve_send_ctrl_net(Net_World * net_world, uint32_t remote_node_id, Ctrl_Send_Reservation * ret_reservation);
+
 
 // Within this function there is a policy to choose the sending / receiving endpoints 
 //	- based on active ctrl endpoint deques within self_node and net_node
@@ -0,0 +1,224 @@
+#include "sharded_table.h"
+
+Sharded_Table * init_sharded_table(uint32_t shard_bits, Shard_Func shard_func, uint64_t min_size, uint64_t max_size, float load_factor, float shrink_factor, 
+									uint64_t slot_lock_ratio, Hash_Func hash_func, Item_Cmp item_cmp, Hash_Tag_Func tag_func, Table_Engine engine) {
+
+	if (shard_bits >= 32){
+		fprintf(stderr, "Error: sharded table cannot have 2^%u shards\n", shard_bits);
+		return NULL;
+	}
+
+	Sharded_Table * sharded_table = (Sharded_Table *) malloc(sizeof(Sharded_Table));
+	if (sharded_table == NULL){
+		fprintf(stderr, "Error: malloc failed to allocate sharded table\n");
+		return NULL;
+	}
+
+	uint64_t num_shards = 1UL << shard_bits;
+
+	sharded_table -> shard_bits = shard_bits;
+	sharded_table -> num_shards = num_shards;
+	sharded_table -> shard_func = shard_func;
+	sharded_table -> item_cmp = item_cmp;
+
+	sharded_table -> shards = (Table **) malloc(num_shards * sizeof(Table *));
+	if (sharded_table -> shards == NULL){
+		fprintf(stderr, "Error: malloc failed to allocate %lu shards\n", num_shards);
+		free(sharded_table);
+		return NULL;
+	}
+
+	uint64_t shard_min_size = MY_CEIL(min_size, num_shards);
+	uint64_t shard_max_size = MY_CEIL(max_size, num_shards);
+
+	for (uint64_t i = 0; i < num_shards; i++){
+		(sharded_table -> shards)[i] = init_table(shard_min_size, shard_max_size, load_factor, shrink_factor, slot_lock_ratio, hash_func, item_cmp, tag_func, engine);
+		if ((sharded_table -> shards)[i] == NULL){
+			fprintf(stderr, "Error: could not initialize shard #%lu of sharded table\n", i);
+			return NULL;
+		}
+	}
+
+	return sharded_table;
+}
+
+void destroy_sharded_table(Sharded_Table * sharded_table){
+	for (uint64_t i = 0; i < sharded_table -> num_shards; i++){
+		destroy_table((sharded_table -> shards)[i]);
+	}
+	free(sharded_table -> shards);
+	free(sharded_table);
+}
+
+
+static inline Table * get_shard_table(Sharded_Table * sharded_table, void * item){
+	// shifting by 64 is undefined
+	if (sharded_table -> shard_bits == 0){
+		return (sharded_table -> shards)[0];
+	}
+	uint64_t shard_ind = (sharded_table -> shard_func)(item) >> (64 - sharded_table -> shard_bits);
+	return (sharded_table -> shards)[shard_ind];
+}
+
+int insert_item_sharded_table(Sharded_Table * sharded_table, void * item){
+	return insert_item_table(get_shard_table(sharded_table, item), item);
+}
+
+void * find_item_sharded_table(Sharded_Table * sharded_table, void * item){
+	return find_item_table(get_shard_table(sharded_table, item), item);
+}
+
+void * remove_item_sharded_table(Sharded_Table * sharded_table, void * item){
+	return remove_item_table(get_shard_table(sharded_table, item), item);
+}
+
+void set_epoch_domain_sharded_table(Sharded_Table * sharded_table, Epoch_Domain * epoch_domain){
+	for (uint64_t i = 0; i < sharded_table -> num_shards; i++){
+		set_epoch_domain_table((sharded_table -> shards)[i], epoch_domain);
+	}
+}
+
+
+uint64_t get_count_sharded_table(Sharded_Table * sharded_table, bool to_wait_pending){
+
+	uint64_t count = 0;
+	for (uint64_t i = 0; i < sharded_table -> num_shards; i++){
+		count += get_count_table((sharded_table -> shards)[i], to_wait_pending);
+	}
+	return count;
+}
+
+
+int get_all_items_sharded_table(Sharded_Table * sharded_table, bool to_start_rand, bool to_sort, uint64_t * ret_cnt, void *** ret_all_items){
+
+	int ret;
+
+	uint64_t num_shards = sharded_table -> num_shards;
+
+	uint64_t * shard_cnts = (uint64_t *) malloc(num_shards * sizeof(uint64_t));
+	void *** shard_items = (void ***) malloc(num_shards * sizeof(void **));
+	if ((shard_cnts == NULL) || (shard_items == NULL)){
+		fprintf(stderr, "Error: malloc failed to allocate containers for shard items\n");
+		free(shard_cnts);
+		free(shard_items);
+		return -1;
+	}
+
+	// 1.) Collect each shard's items, the sorting is done after combining
+
+	uint64_t cnt = 0;
+	for (uint64_t i = 0; i < num_shards; i++){
+		ret = get_all_items_table((sharded_table -> shards)[i], to_start_rand, false, &(shard_cnts[i]), &(shard_items[i]));
+		if (ret != 0){
+			fprintf(stderr, "Error: could not get all items from shard #%lu\n", i);
+			for (uint64_t j = 0; j < i; j++){
+				free(shard_items[j]);
+			}
+			free(shard_cnts);
+			free(shard_items);
+			return -1;
+		}
+		cnt += shard_cnts[i];
+	}
+
+	// 2.) Combine into one container
+
+	void ** all_items = (void **) malloc(cnt * sizeof(void *));
+	if (all_items == NULL){
+		fprintf(stderr, "Error: malloc failed to allocate all_items container\n");
+		for (uint64_t i = 0; i < num_shards; i++){
+			free(shard_items[i]);
+		}
+		free(shard_cnts);
+		free(shard_items);
+		return -1;
+	}
+
+	// if the to_start_rand bool is set, also start at a random shard
+	uint64_t shard_ind_start = 0;
+	if (to_start_rand){
+		shard_ind_start = rand() % num_shards;
+	}
+
+	uint64_t shard_ind;
+	uint64_t num_added = 0;
+	for (uint64_t i = shard_ind_start; i < shard_ind_start + num_shards; i++){
+		shard_ind = i % num_shards;
+		memcpy(&(all_items[num_added]), shard_items[shard_ind], shard_cnts[shard_ind] * sizeof(void *));
+		num_added += shard_cnts[shard_ind];
+		free(shard_items[shard_ind]);
+	}
+
+	free(shard_cnts);
+	free(shard_items);
+
+	// 3.) Same as within get_all_items_table
+	if (to_sort){
+		qsort(all_items, cnt, sizeof(void *), (int (*)(const void *, const void *)) sharded_table -> item_cmp);
+	}
+
+	*ret_cnt = cnt;
+	*ret_all_items = all_items;
+
+	return 0;
+}
+
+
+int open_cursor_sharded_table(Sharded_Table * sharded_table, bool is_snapshot, Sharded_Table_Cursor * ret_cursor){
+
+	ret_cursor -> sharded_table = sharded_table;
+	ret_cursor -> is_snapshot = is_snapshot;
+	ret_cursor -> is_done = false;
+	ret_cursor -> is_failed = false;
+	ret_cursor -> shard_ind = 0;
+
+	int ret = open_cursor_table((sharded_table -> shards)[0], is_snapshot, &(ret_cursor -> shard_cursor));
+	if (ret != 0){
+		fprintf(stderr, "Error: could not open cursor on the first shard\n");
+		// nothing to close
+		ret_cursor -> is_done = true;
+		ret_cursor -> is_failed = true;
+		return -1;
+	}
+
+	return 0;
+}
+
+uint64_t next_cursor_sharded_table(Sharded_Table_Cursor * cursor, uint64_t max_items, void ** ret_items){
+
+	int ret;
+
+	if (cursor -> is_done){
+		return 0;
+	}
+
+	uint64_t num_items = next_cursor_table(&(cursor -> shard_cursor), max_items, ret_items);
+
+	// move on to the next shard
+	if (cursor -> shard_cursor.is_done){
+		close_cursor_table(&(cursor -> shard_cursor));
+		cursor -> shard_ind += 1;
+		if (cursor -> shard_ind == cursor -> sharded_table -> num_shards){
+			cursor -> is_done = true;
+		}
+		else{
+			ret = open_cursor_table((cursor -> sharded_table -> shards)[cursor -> shard_ind], cursor -> is_snapshot, &(cursor -> shard_cursor));
+			if (ret != 0){
+				fprintf(stderr, "Error: could not open cursor on shard %lu, ending the iteration early\n", cursor -> shard_ind);
+				// the shard's cursor was never opened, so close must skip it
+				cursor -> is_done = true;
+				cursor -> is_failed = true;
+			}
+		}
+	}
+
+	return num_items;
+}
+
+void close_cursor_sharded_table(Sharded_Table_Cursor * cursor){
+	// the last shard's cursor was already closed (or, after a failure, never opened)
+	if (cursor -> is_done){
+		return;
+	}
+	close_cursor_table(&(cursor -> shard_cursor));
+}
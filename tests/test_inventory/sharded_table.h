@@ -0,0 +1,64 @@
+#ifndef SHARDED_TABLE_H
+#define SHARDED_TABLE_H
+
+#include "common.h"
+#include "table.h"
+
+// Splits the keyspace across 2^shard_bits independent tables
+//	- each shard has its own locks, counts and resize state, so a resize (or a burst
+//	  of removals) only stalls the operations that route to that shard
+//	- routing uses the most significant shard_bits bits of shard_func(item)
+
+typedef struct sharded_table {
+	uint32_t shard_bits;
+	uint64_t num_shards;
+	Shard_Func shard_func;
+	Item_Cmp item_cmp;
+	Table ** shards;
+} Sharded_Table;
+
+
+// min_size and max_size are for the whole table, every shard gets an even share of both
+// (the other arguments are passed to init_table for every shard)
+Sharded_Table * init_sharded_table(uint32_t shard_bits, Shard_Func shard_func, uint64_t min_size, uint64_t max_size, float load_factor, float shrink_factor, 
+									uint64_t slot_lock_ratio, Hash_Func hash_func, Item_Cmp item_cmp, Hash_Tag_Func tag_func, Table_Engine engine);
+void destroy_sharded_table(Sharded_Table * sharded_table);
+
+// Same semantics as the corresponding Table functions
+int insert_item_sharded_table(Sharded_Table * sharded_table, void * item);
+void * find_item_sharded_table(Sharded_Table * sharded_table, void * item);
+void * remove_item_sharded_table(Sharded_Table * sharded_table, void * item);
+
+// sets the epoch domain of every shard
+// (same requirements as set_epoch_domain_table)
+void set_epoch_domain_sharded_table(Sharded_Table * sharded_table, Epoch_Domain * epoch_domain);
+
+// Aggregates over all shards
+//	- each shard is only locked out while its own items are being counted/collected, 
+//	  so this is not a consistent snapshot of the whole table if there are concurrent operations
+uint64_t get_count_sharded_table(Sharded_Table * sharded_table, bool to_wait_pending);
+int get_all_items_sharded_table(Sharded_Table * sharded_table, bool to_start_rand, bool to_sort, uint64_t * ret_cnt, void *** ret_all_items);
+
+
+// Walks the shards one after another with a Table_Cursor (same semantics per shard)
+//	- in snapshot mode each shard is copied out once the cursor reaches it, so every shard is
+//	  taken at a different time. With concurrent operations the result is NOT exactly the items 
+//	  within the table at any single point (an item moved between shards' snapshots, or inserted
+//	  into an already copied shard, is missed)
+//	- if opening the cursor on a later shard fails, the cursor is marked done with is_failed set,
+//	  so once is_done check is_failed before trusting that every shard was walked
+//	- close is still required (and safe) after a failure
+typedef struct sharded_table_cursor {
+	Sharded_Table * sharded_table;
+	bool is_snapshot;
+	bool is_done;
+	bool is_failed;
+	uint64_t shard_ind;
+	Table_Cursor shard_cursor;
+} Sharded_Table_Cursor;
+
+int open_cursor_sharded_table(Sharded_Table * sharded_table, bool is_snapshot, Sharded_Table_Cursor * ret_cursor);
+uint64_t next_cursor_sharded_table(Sharded_Table_Cursor * cursor, uint64_t max_items, void ** ret_items);
+void close_cursor_sharded_table(Sharded_Table_Cursor * cursor);
+
+#endif
@@ -0,0 +1,257 @@
+#include "spsc_ring.h"
+
+#include <immintrin.h>
+#include <sched.h>
+
+
+Spsc_Ring * init_spsc_ring(uint64_t max_items, uint64_t item_size_bytes, uint64_t spin_iters) {
+
+	int ret;
+
+	if (max_items == 0){
+		fprintf(stderr, "Error: cannot create spsc ring with 0 items\n");
+		return NULL;
+	}
+
+	Spsc_Ring * ring;
+	// the head/tail cache line separation relies on the container being aligned
+	ret = posix_memalign((void **) &ring, 64, sizeof(Spsc_Ring));
+	if (ret != 0){
+		fprintf(stderr, "Error: could not allocate spsc ring container\n");
+		return NULL;
+	}
+
+	// round up to power of two so slots are a mask of the free running indicies
+	uint64_t rounded_max_items = 1;
+	while (rounded_max_items < max_items){
+		rounded_max_items <<= 1;
+	}
+
+	ring -> max_items = rounded_max_items;
+	ring -> item_size_bytes = item_size_bytes;
+	ring -> spin_iters = spin_iters;
+	ring -> tail = 0;
+	ring -> cached_head = 0;
+	ring -> head = 0;
+	ring -> cached_tail = 0;
+	ring -> consumer_parked = false;
+
+	ret = pthread_mutex_init(&(ring -> park_lock), NULL);
+	if (ret != 0){
+		fprintf(stderr, "Error: could not init spsc ring park lock\n");
+		free(ring);
+		return NULL;
+	}
+
+	ret = pthread_cond_init(&(ring -> produced_cv), NULL);
+	if (ret != 0){
+		fprintf(stderr, "Error: could not init spsc ring condition variable\n");
+		pthread_mutex_destroy(&(ring -> park_lock));
+		free(ring);
+		return NULL;
+	}
+
+	uint64_t buffer_size = rounded_max_items * item_size_bytes;
+	ring -> buffer = malloc(buffer_size);
+	if (ring -> buffer == NULL){
+		fprintf(stderr, "Error: malloc failed to allocate spsc ring buffer of size: %lu\n", buffer_size);
+		pthread_cond_destroy(&(ring -> produced_cv));
+		pthread_mutex_destroy(&(ring -> park_lock));
+		free(ring);
+		return NULL;
+	}
+
+	return ring;
+}
+
+
+void destroy_spsc_ring(Spsc_Ring * ring) {
+	pthread_cond_destroy(&(ring -> produced_cv));
+	pthread_mutex_destroy(&(ring -> park_lock));
+	free(ring -> buffer);
+	free(ring);
+}
+
+
+// copies num_items starting at free running index ind into the ring, looping around at the end of the buffer
+static void copy_in_spsc_ring(Spsc_Ring * ring, uint64_t ind, uint64_t num_items, void * items) {
+
+	uint64_t item_size_bytes = ring -> item_size_bytes;
+	uint64_t start_slot = ind & (ring -> max_items - 1);
+
+	uint64_t items_til_end = num_items;
+	if (start_slot + num_items > ring -> max_items){
+		items_til_end = ring -> max_items - start_slot;
+	}
+
+	uint64_t bytes_til_end = items_til_end * item_size_bytes;
+	memcpy((void *) ((uint64_t) ring -> buffer + start_slot * item_size_bytes), items, bytes_til_end);
+
+	if (items_til_end < num_items){
+		memcpy(ring -> buffer, (void *) ((uint64_t) items + bytes_til_end), (num_items - items_til_end) * item_size_bytes);
+	}
+}
+
+static void copy_out_spsc_ring(Spsc_Ring * ring, uint64_t ind, uint64_t num_items, void * ret_items) {
+
+	uint64_t item_size_bytes = ring -> item_size_bytes;
+	uint64_t start_slot = ind & (ring -> max_items - 1);
+
+	uint64_t items_til_end = num_items;
+	if (start_slot + num_items > ring -> max_items){
+		items_til_end = ring -> max_items - start_slot;
+	}
+
+	uint64_t bytes_til_end = items_til_end * item_size_bytes;
+	memcpy(ret_items, (void *) ((uint64_t) ring -> buffer + start_slot * item_size_bytes), bytes_til_end);
+
+	if (items_til_end < num_items){
+		memcpy((void *) ((uint64_t) ret_items + bytes_til_end), ring -> buffer, (num_items - items_til_end) * item_size_bytes);
+	}
+}
+
+
+// Called by the producer after publishing tail
+
+// The seq_cst fence pairs with the consumer's fence between setting consumer_parked
+// and re-reading tail: either the consumer sees the new tail and doesn't sleep, or
+// we see it parked and signal it (under park_lock so the signal cannot be lost)
+static void wake_consumer_spsc_ring(Spsc_Ring * ring) {
+
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+	if (likely(!__atomic_load_n(&(ring -> consumer_parked), __ATOMIC_RELAXED))){
+		return;
+	}
+
+	pthread_mutex_lock(&(ring -> park_lock));
+	__atomic_store_n(&(ring -> consumer_parked), false, __ATOMIC_RELAXED);
+	pthread_cond_signal(&(ring -> produced_cv));
+	pthread_mutex_unlock(&(ring -> park_lock));
+}
+
+
+void produce_batch_spsc_ring(Spsc_Ring * ring, uint64_t num_items, void * items) {
+
+	uint64_t max_items = ring -> max_items;
+	uint64_t tail = ring -> tail;
+
+	uint64_t num_free, num_to_produce;
+	uint64_t spins = 0;
+
+	while (num_items > 0){
+
+		// 1.) Determine how much room there is, only looking at the consumer's
+		//		index when our cached copy says we are full
+		num_free = max_items - (tail - ring -> cached_head);
+		if (num_free == 0){
+			ring -> cached_head = __atomic_load_n(&(ring -> head), __ATOMIC_ACQUIRE);
+			num_free = max_items - (tail - ring -> cached_head);
+			if (num_free == 0){
+				spins++;
+				if (spins < SPSC_RING_PRODUCER_SPIN_ITERS){
+					_mm_pause();
+				}
+				else {
+					sched_yield();
+				}
+				continue;
+			}
+		}
+
+		spins = 0;
+
+		num_to_produce = num_items;
+		if (num_to_produce > num_free){
+			num_to_produce = num_free;
+		}
+
+		// 2.) Copy the items and publish all of them at once
+		copy_in_spsc_ring(ring, tail, num_to_produce, items);
+
+		tail += num_to_produce;
+		__atomic_store_n(&(ring -> tail), tail, __ATOMIC_RELEASE);
+
+		wake_consumer_spsc_ring(ring);
+
+		items = (void *) ((uint64_t) items + num_to_produce * ring -> item_size_bytes);
+		num_items -= num_to_produce;
+	}
+}
+
+
+// returns the number of items available to the consumer, refreshing cached_tail if needed
+static inline uint64_t get_available_spsc_ring(Spsc_Ring * ring, uint64_t head) {
+	if (ring -> cached_tail == head){
+		ring -> cached_tail = __atomic_load_n(&(ring -> tail), __ATOMIC_ACQUIRE);
+	}
+	return ring -> cached_tail - head;
+}
+
+static uint64_t wait_available_spsc_ring(Spsc_Ring * ring, uint64_t head) {
+
+	uint64_t num_available = get_available_spsc_ring(ring, head);
+
+	// 1.) Spin
+	uint64_t spin_iters = ring -> spin_iters;
+	for (uint64_t i = 0; (num_available == 0) && (i < spin_iters); i++){
+		_mm_pause();
+		num_available = get_available_spsc_ring(ring, head);
+	}
+
+	if (num_available > 0){
+		return num_available;
+	}
+
+	// 2.) Park
+	//	- the producer clears consumer_parked when it signals, so
+	//		re-announce before every wait
+	pthread_mutex_lock(&(ring -> park_lock));
+	while (1){
+		__atomic_store_n(&(ring -> consumer_parked), true, __ATOMIC_RELAXED);
+		__atomic_thread_fence(__ATOMIC_SEQ_CST);
+		num_available = get_available_spsc_ring(ring, head);
+		if (num_available > 0){
+			break;
+		}
+		pthread_cond_wait(&(ring -> produced_cv), &(ring -> park_lock));
+	}
+	__atomic_store_n(&(ring -> consumer_parked), false, __ATOMIC_RELAXED);
+	pthread_mutex_unlock(&(ring -> park_lock));
+
+	return num_available;
+}
+
+
+static uint64_t consume_available_spsc_ring(Spsc_Ring * ring, uint64_t head, uint64_t num_available, void * ret_items) {
+
+	copy_out_spsc_ring(ring, head, num_available, ret_items);
+
+	// release the slots back to the producer at once
+	__atomic_store_n(&(ring -> head), head + num_available, __ATOMIC_RELEASE);
+
+	return num_available;
+}
+
+
+uint64_t consume_all_spsc_ring(Spsc_Ring * ring, void * ret_items) {
+
+	uint64_t head = ring -> head;
+
+	uint64_t num_available = wait_available_spsc_ring(ring, head);
+
+	return consume_available_spsc_ring(ring, head, num_available, ret_items);
+}
+
+
+uint64_t consume_all_nonblock_spsc_ring(Spsc_Ring * ring, void * ret_items) {
+
+	uint64_t head = ring -> head;
+
+	uint64_t num_available = get_available_spsc_ring(ring, head);
+	if (num_available == 0){
+		return 0;
+	}
+
+	return consume_available_spsc_ring(ring, head, num_available, ret_items);
+}
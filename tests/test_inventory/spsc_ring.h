@@ -0,0 +1,80 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include "common.h"
+
+// Lock-free ring for exactly one producer thread and one consumer thread
+//	- used between the receive control completion handler and the receive dispatcher
+
+// The producer only writes tail and the consumer only writes head, so
+// neither side needs a lock. Each side keeps a cached copy of the other's index
+// on its own cache line and only re-reads the shared index once the cached copy
+// says the ring is full/empty.
+
+// Items are copied in/out as a whole batch and the index is published once per batch
+// (not once per item), so the other side sees the entire batch with a single cache line transfer
+
+// The indicies are free running (never wrap) and the capacity is rounded up to a power of two,
+// so the slot is (ind & (max_items - 1)) and the count is (tail - head)
+
+// Waiting:
+//	- the consumer spins (with pause) for up to spin_iters checks before parking on
+//		a condition variable. The producer only touches the lock/cv if it sees the consumer parked
+//	- spin_iters = 0 => always park immediately, SPSC_RING_SPIN_FOREVER => never park
+//	- the producer (a cq thread that is already busy-polling) never parks, it spins and yields while full
+#define SPSC_RING_SPIN_FOREVER UINT64_MAX
+
+// number of pauses before a full producer yields its cpu
+#define SPSC_RING_PRODUCER_SPIN_ITERS 1024
+
+
+typedef struct spsc_ring {
+	// read-only after init
+	uint64_t max_items;
+	uint64_t item_size_bytes;
+	uint64_t spin_iters;
+	void * buffer;
+	// only written by the producer
+	uint64_t tail __attribute__((aligned(64)));
+	// producer's copy of head, refreshed when the ring looks full
+	uint64_t cached_head;
+	// only written by the consumer
+	uint64_t head __attribute__((aligned(64)));
+	// consumer's copy of tail, refreshed when the ring looks empty
+	uint64_t cached_tail;
+	// set by the consumer (under park_lock) right before sleeping on produced_cv
+	bool consumer_parked __attribute__((aligned(64)));
+	pthread_mutex_t park_lock;
+	pthread_cond_t produced_cv;
+} Spsc_Ring;
+
+
+// max_items is rounded up to the next power of two
+Spsc_Ring * init_spsc_ring(uint64_t max_items, uint64_t item_size_bytes, uint64_t spin_iters);
+
+// Assumes neither side is using the ring anymore
+void destroy_spsc_ring(Spsc_Ring * ring);
+
+
+// ONLY THE PRODUCER THREAD
+
+// copies num_items from items to the back of the ring
+// If there is not enough room publishes as much as fits and waits for the rest
+// (so num_items can exceed max_items)
+// BLOCKING!
+void produce_batch_spsc_ring(Spsc_Ring * ring, uint64_t num_items, void * items);
+
+
+// ONLY THE CONSUMER THREAD
+
+// ret_items must have room for max_items (after rounding)
+// Returns the number of items consumed
+
+// Blocks until there is at least 1 item
+uint64_t consume_all_spsc_ring(Spsc_Ring * ring, void * ret_items);
+
+// if there are 0 items, immediately returns
+uint64_t consume_all_nonblock_spsc_ring(Spsc_Ring * ring, void * ret_items);
+
+
+#endif
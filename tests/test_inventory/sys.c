@@ -301,8 +301,10 @@ int start_memory(System * system){
 		return -1;
 	}
 
+	// All memory clients produce into these concurrently and the memory server
+	// is already busy-polling them with consume_all_nonblock_fifo, so use the lock free engine
 	for (int i = 0; i < num_mempools; i++){
-		mem_op_fifos[i] = init_fifo(MEMORY_OPS_BUFFER_MAX_REQUESTS_PER_MEMPOOL, sizeof(Mem_Op *));
+		mem_op_fifos[i] = init_fifo_with_engine(MEMORY_OPS_BUFFER_MAX_REQUESTS_PER_MEMPOOL, sizeof(Mem_Op *), FIFO_ENGINE_LOCK_FREE);
 		if (!mem_op_fifos[i]){
 			fprintf(stderr, "Error: failure to initialize memory ops fifo for mempool %d\n", i);
 			return -1;
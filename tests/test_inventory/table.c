@@ -1,12 +1,121 @@
 #include "table.h"
 
+#include <immintrin.h>
+
 // Simple HashTable implementation
 // Using LinearProbing for simplicity / performance
 
-Table * init_table(uint64_t min_size, uint64_t max_size, float load_factor, float shrink_factor, Hash_Func hash_func, Item_Cmp item_cmp) {
+// MEMORY HELPERS
+
+// Large slot arrays and lock stripes are allocated directly with mmap so they can be
+// backed by huge pages (fewer TLB misses when probing randomly across a big table).
+// The memory from mmap is already zeroed, so all slots start out as NULL.
+// Small arrays just use calloc
+static void * alloc_table_mem(uint64_t num_bytes){
+
+	if (num_bytes < TABLE_HUGE_PAGE_SIZE){
+		return calloc(1, num_bytes);
+	}
+
+	uint64_t alloc_bytes = MY_CEIL(num_bytes, TABLE_HUGE_PAGE_SIZE) * TABLE_HUGE_PAGE_SIZE;
+
+	// first try explicitly reserved huge pages
+	void * mem = mmap(NULL, alloc_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+	if (mem != MAP_FAILED){
+		return mem;
+	}
+
+	// otherwise fallback to regular pages and ask for transparent huge pages
+	mem = mmap(NULL, alloc_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (mem == MAP_FAILED){
+		return NULL;
+	}
+
+	madvise(mem, alloc_bytes, MADV_HUGEPAGE);
+
+	return mem;
+}
+
+// num_bytes must match the amount originally requested from alloc_table_mem
+static void free_table_mem(void * mem, uint64_t num_bytes){
+
+	if (mem == NULL){
+		return;
+	}
+
+	if (num_bytes < TABLE_HUGE_PAGE_SIZE){
+		free(mem);
+		return;
+	}
+
+	uint64_t alloc_bytes = MY_CEIL(num_bytes, TABLE_HUGE_PAGE_SIZE) * TABLE_HUGE_PAGE_SIZE;
+	munmap(mem, alloc_bytes);
+}
+
+
+// Control bytes for the group probing engine start out as all empty
+static uint8_t * init_ctrl_table(uint64_t size){
+	uint8_t * ctrl = (uint8_t *) alloc_table_mem(size);
+	if (ctrl == NULL){
+		return NULL;
+	}
+	memset(ctrl, TABLE_CTRL_EMPTY, size);
+	return ctrl;
+}
+
+// LOCK STRIPE HELPERS
+
+// Every slot_lock_ratio consecutive slots share one lock
+static inline uint64_t get_num_slot_locks_table(Table * table, uint64_t size){
+	return (size >> table -> slot_lock_shift) + ((size & (table -> slot_lock_ratio - 1)) != 0);
+}
+
+static pthread_mutex_t * init_slot_locks_table(uint64_t num_slot_locks){
+
+	pthread_mutex_t * slot_locks = (pthread_mutex_t *) alloc_table_mem(num_slot_locks * sizeof(pthread_mutex_t));
+	if (slot_locks == NULL){
+		return NULL;
+	}
+
+	int ret;
+	for (uint64_t i = 0; i < num_slot_locks; i++){
+		ret = pthread_mutex_init(&(slot_locks[i]), NULL);
+		if (ret != 0){
+			fprintf(stderr, "Error: could not init slot lock\n");
+			free_table_mem(slot_locks, num_slot_locks * sizeof(pthread_mutex_t));
+			return NULL;
+		}
+	}
+
+	return slot_locks;
+}
+
+// assumes all the locks are unlocked
+static void destroy_slot_locks_table(pthread_mutex_t * slot_locks, uint64_t num_slot_locks){
+	for (uint64_t i = 0; i < num_slot_locks; i++){
+		// Practice to hold lock before destorying
+		pthread_mutex_lock(&(slot_locks[i]));
+		pthread_mutex_destroy(&(slot_locks[i]));
+	}
+	free_table_mem(slot_locks, num_slot_locks * sizeof(pthread_mutex_t));
+}
+
+
+Table * init_table(uint64_t min_size, uint64_t max_size, float load_factor, float shrink_factor, uint64_t slot_lock_ratio, Hash_Func hash_func, Item_Cmp item_cmp, Hash_Tag_Func tag_func, Table_Engine engine) {
 
 	int ret;
 
+	if ((engine == TABLE_GROUP_PROBE) && (tag_func == NULL)){
+		fprintf(stderr, "Error: group probing table requires a tag function\n");
+		return NULL;
+	}
+
+	// group probing works on whole groups of slots
+	if (engine == TABLE_GROUP_PROBE){
+		min_size = MY_CEIL(min_size, TABLE_GROUP_SIZE) * TABLE_GROUP_SIZE;
+		max_size = MY_CEIL(max_size, TABLE_GROUP_SIZE) * TABLE_GROUP_SIZE;
+	}
+
 	Table * tab = (Table *) malloc(sizeof(Table));
 
 	// set number of elements to size passed in
@@ -24,12 +133,48 @@ Table * init_table(uint64_t min_size, uint64_t max_size, float load_factor, floa
 	tab -> cnt = 0;
 
 	// init table with no references to items (all Null)
-	void ** table = (void **) malloc(min_size * sizeof(void *));
-	for (uint64_t i = 0; i < min_size; i++){
-		table[i] = NULL;
+	void ** table = (void **) alloc_table_mem(min_size * sizeof(void *));
+	if (table == NULL){
+		fprintf(stderr, "Error: could not allocate table of size %lu\n", min_size);
+		return NULL;
 	}
 	tab -> table = table;
 
+	tab -> engine = engine;
+	tab -> ctrl = NULL;
+	tab -> old_ctrl = NULL;
+	tab -> num_tombstones = 0;
+
+	tab -> tag_func = tag_func;
+	tab -> tags = NULL;
+	tab -> old_tags = NULL;
+	if (engine == TABLE_GROUP_PROBE){
+		// the control bytes take the place of the tags array
+		tab -> ctrl = init_ctrl_table(min_size);
+		if (tab -> ctrl == NULL){
+			fprintf(stderr, "Error: could not allocate table control bytes of size %lu\n", min_size);
+			return NULL;
+		}
+	}
+	else if (tag_func != NULL){
+		// zeroed memory, so all tags start as TABLE_EMPTY_TAG
+		tab -> tags = (uint16_t *) alloc_table_mem(min_size * sizeof(uint16_t));
+		if (tab -> tags == NULL){
+			fprintf(stderr, "Error: could not allocate table tags of size %lu\n", min_size);
+			return NULL;
+		}
+	}
+
+	// round the stripe ratio up to a power of two so the lock index is just a shift
+	if (slot_lock_ratio == 0){
+		slot_lock_ratio = 1;
+	}
+	tab -> slot_lock_shift = 0;
+	while ((1UL << tab -> slot_lock_shift) < slot_lock_ratio){
+		tab -> slot_lock_shift += 1;
+	}
+	tab -> slot_lock_ratio = 1UL << tab -> slot_lock_shift;
+
 
 	// TODO: ADD SYNC VARIABLE TO ENSURE O(1) REMOVALS/FIND (when missing) (instead of current O(N))
 
@@ -51,26 +196,48 @@ Table * init_table(uint64_t min_size, uint64_t max_size, float load_factor, floa
 		return NULL;
 	}
 	tab -> num_inserts = 0;
-	tab -> num_finds = 0;
 
-	// TODO: ADD LOCK RATIO SO NOT EVERY SLOT NEEDS A LOCK!
 
-	pthread_mutex_t * slot_locks = (pthread_mutex_t *) malloc(min_size * sizeof(pthread_mutex_t));
-	for (uint64_t i = 0; i < min_size; i++){
-		ret = pthread_mutex_init(&(slot_locks[i]), NULL);
-		if (ret != 0){
-			fprintf(stderr, "Error: could not slock lock\n");
-			return NULL;
-		}
+	tab -> old_table = NULL;
+	tab -> old_size = 0;
+	tab -> migrate_ind = 0;
+	ret = pthread_mutex_init(&(tab -> migrate_lock), NULL);
+	if (ret != 0){
+		fprintf(stderr, "Error: could not init table migrate lock\n");
+		return NULL;
+	}
+
+	tab -> write_seq_start = 0;
+	tab -> write_seq_end = 0;
+
+	tab -> reader_phase = 0;
+	tab -> reader_cnts[0] = 0;
+	tab -> reader_cnts[1] = 0;
+	ret = pthread_mutex_init(&(tab -> reader_sync_lock), NULL);
+	if (ret != 0){
+		fprintf(stderr, "Error: could not init table reader sync lock\n");
+		return NULL;
+	}
+
+	pthread_mutex_t * slot_locks = init_slot_locks_table(get_num_slot_locks_table(tab, min_size));
+	if (slot_locks == NULL){
+		fprintf(stderr, "Error: could not init slot locks\n");
+		return NULL;
 	}
 
 	tab -> slot_locks = slot_locks;
 	tab -> hash_func = hash_func;
 	tab -> item_cmp = item_cmp;
 
+	tab -> epoch_domain = NULL;
+
 	return tab;
 }
 
+void set_epoch_domain_table(Table * table, Epoch_Domain * epoch_domain){
+	table -> epoch_domain = epoch_domain;
+}
+
 void destroy_table(Table * table){
 	fprintf(stderr, "Destroy Table: Unimplemented Error\n");
 }
@@ -106,6 +273,34 @@ uint64_t get_count_table(Table * table, bool to_wait_pending){
 }
 
 
+// OPTIMISTIC LOOKUPS, INSERTS AND REMOVALS
+
+// The lock-free lookup path and the probing parts of inserts/removals (and the helpers they need) live
+// within table_template.h, so that modules with a fixed item type can instantiate a copy with the 
+// hash/compare inlined. This is the generic instantiation that goes through the table's function pointers
+#define TABLE_T_FN(name) name##_table
+#define TABLE_T_HASH(table, item, size) ((table) -> hash_func)((item), (size))
+#define TABLE_T_CMP(table, item, other_item) ((table) -> item_cmp)((item), (other_item))
+#define TABLE_T_TAG(table, item) ((table) -> tag_func)(item)
+#define TABLE_T_API
+#include "table_template.h"
+
+
+// WRITER HELPERS
+
+// Wait until every find that started before this call has finished
+//	- called by writers after unlinking memory (old slot arrays, removed items)
+// 	  and before freeing/returning it
+static void synchronize_readers_table(Table * table){
+	pthread_mutex_lock(&(table -> reader_sync_lock));
+	uint64_t prev_phase = __atomic_fetch_add(&(table -> reader_phase), 1, __ATOMIC_SEQ_CST) & 1;
+	while (__atomic_load_n(&((table -> reader_cnts)[prev_phase]), __ATOMIC_ACQUIRE) != 0){
+		_mm_pause();
+	}
+	pthread_mutex_unlock(&(table -> reader_sync_lock));
+}
+
+
 /* USING A PASSED IN HASH FUNCTION INSTEAD */
 
 // with prototype uint64_t hash_func(void * item, uint64_t table_size)
@@ -125,9 +320,155 @@ uint64_t get_count_table(Table * table, bool to_wait_pending){
 // }
 
 
-// assert(holding op_lock), 
-// everyone else (insert/remove/find) is locked out so don't need to care about locks
-// However, we will 
+// assert(holding migrate_lock)
+// Migrates up to max_slots old slots into the current array.
+// If this finishes the migration then the old array is unpublished and freed
+//	- must not be called while registered as a reader (it might wait for readers)
+void migrate_slots_table(Table * table, uint64_t max_slots){
+
+	void ** old_tab = table -> old_table;
+	if (old_tab == NULL){
+		return;
+	}
+
+	uint16_t * old_tags = table -> old_tags;
+	uint8_t * old_ctrl = table -> old_ctrl;
+
+	uint64_t old_size = table -> old_size;
+	uint64_t start_ind = table -> migrate_ind;
+	uint64_t end_ind = start_ind + max_slots;
+	if (end_ind > old_size){
+		end_ind = old_size;
+	}
+
+	// the current array can't be swapped out while a migration is ongoing
+	void ** tab = table -> table;
+	uint16_t * tags = table -> tags;
+	uint8_t * ctrl = table -> ctrl;
+	pthread_mutex_t * slot_locks = table -> slot_locks;
+	uint64_t size = table -> size;
+
+	void * cur_item;
+	uint16_t cur_tag;
+	bool is_duplicate;
+	bool is_tombstone_reused;
+	for (uint64_t i = start_ind; i < end_ind; i++){
+		if (old_ctrl){
+			// empty, deleted and claimed control bytes all have the high bit set
+			//	- nothing can be claiming old slots, new items only go into the current array
+			if (old_ctrl[i] & TABLE_CTRL_EMPTY){
+				continue;
+			}
+			// Never reuses tombstones of the current array, they are only accounted for
+			// under the op_lock (by the removals/inserts that create/reuse them)
+			if (unlikely(!claim_slot_group_table(table, ctrl, tab, size, get_home_group_table(table, old_tab[i], size), old_tab[i], old_ctrl[i], false, &is_tombstone_reused))){
+				fprintf(stderr, "Error: could not migrate item into resized table of size %lu\n", size);
+			}
+			continue;
+		}
+		cur_item = old_tab[i];
+		if ((cur_item == NULL) || (cur_item == TABLE_TOMBSTONE)){
+			continue;
+		}
+		// the tag only depends on the item, so no need to recompute it
+		cur_tag = 0;
+		if (old_tags){
+			cur_tag = old_tags[i];
+		}
+		// live items in the old array can't be within the current array because
+		// inserts check the old array first, so never a duplicate
+		if (unlikely(!insert_slot_table(table, tab, tags, slot_locks, size, cur_item, cur_tag, &is_duplicate))){
+			fprintf(stderr, "Error: could not migrate item into resized table of size %lu\n", size);
+		}
+	}
+
+	// after this point the items are only considered live within the current array
+	__atomic_store_n(&(table -> migrate_ind), end_ind, __ATOMIC_RELEASE);
+
+	if (end_ind < old_size){
+		return;
+	}
+
+	// Finished the migration, unpublish the old array and wait for finds & inserts
+	// that might still be looking through it
+	begin_write_table(table);
+	__atomic_store_n(&(table -> old_table), NULL, __ATOMIC_RELEASE);
+	__atomic_store_n(&(table -> old_tags), NULL, __ATOMIC_RELEASE);
+	__atomic_store_n(&(table -> old_ctrl), NULL, __ATOMIC_RELEASE);
+	table -> old_size = 0;
+	table -> migrate_ind = 0;
+	end_write_table(table);
+
+	synchronize_readers_table(table);
+
+	free_table_mem(old_tab, old_size * sizeof(void *));
+	if (old_tags){
+		free_table_mem(old_tags, old_size * sizeof(uint16_t));
+	}
+	if (old_ctrl){
+		free_table_mem(old_ctrl, old_size);
+	}
+}
+
+
+// Called at the start of every insert/removal to make progress on a pending migration.
+// Don't want to convoy behind another thread that is already migrating, so just skip in that case
+void migrate_step_table(Table * table){
+
+	if (__atomic_load_n(&(table -> old_table), __ATOMIC_ACQUIRE) == NULL){
+		return;
+	}
+
+	if (pthread_mutex_trylock(&(table -> migrate_lock)) != 0){
+		return;
+	}
+
+	migrate_slots_table(table, TABLE_MIGRATE_SLOTS_PER_OP);
+
+	pthread_mutex_unlock(&(table -> migrate_lock));
+}
+
+
+// assert(holding op_lock and no other inserts/removals are in-flight)
+// Only the case when a new resize is triggered before the previous migration
+// finished (or if someone needs a view of the whole table) 
+static void finish_migration_table(Table * table){
+
+	if (table -> old_table == NULL){
+		return;
+	}
+
+	pthread_mutex_lock(&(table -> migrate_lock));
+	migrate_slots_table(table, table -> old_size);
+	pthread_mutex_unlock(&(table -> migrate_lock));
+}
+
+
+// GROUP PROBING ENGINE
+
+// Slots are split into aligned groups of TABLE_GROUP_SIZE, each with one control byte per slot (ctrl).
+// A full slot's control byte holds the low 7 bits of the item's tag (H2), the hash function picks
+// the home group (H1) and groups are probed linearly from there. A whole group's control
+// bytes are matched against H2 with a single SSE2 compare, so only slots with matching control bytes
+// are ever dereferenced, and a probe ends at the first group that has an empty control byte.
+
+// Removals never shift items. They either mark the slot as empty (if its group already has
+// an empty slot, so no probe sequence could continue past the group) or leave a tombstone
+// that inserts can reuse. So within this engine only a resize can move items past a concurrent find
+
+// Inserts/removals of the same item are serialized by the lock stripe of the item's home group.
+// Inserts of different items (and migrations) can race for the same free slot, so slots are claimed 
+// by CAS on the control byte before writing the item
+
+// Resizes use the same incremental migration as the linear probing engine (old_ctrl/old_table
+// next to the new arrays, see migrate_slots_table). Tombstones are dropped while migrating
+
+
+// assert(holding op_lock and no other inserts/removals are in-flight), 
+// However, finds may still be probing the current array
+
+// Allocates the new array and publishes it alongside the current one (which becomes the old array).
+// The actual rehashing happens incrementally within subsequent inserts/removals (see migrate_step_table)
 int resize_table(Table * table, uint64_t new_size) {
 
 	if (table == NULL){
@@ -135,62 +476,99 @@ int resize_table(Table * table, uint64_t new_size) {
 		return -1;
 	}
 
+	if (table -> engine == TABLE_GROUP_PROBE){
+		new_size = MY_CEIL(new_size, TABLE_GROUP_SIZE) * TABLE_GROUP_SIZE;
+	}
+
+	// only one migration at a time
+	finish_migration_table(table);
+
 	void ** old_table = table -> table;
+	uint16_t * old_tags = table -> tags;
+	uint8_t * old_ctrl = table -> ctrl;
 	pthread_mutex_t * old_slot_locks = table -> slot_locks;
 	uint64_t old_size = table -> size;
+	uint64_t old_num_slot_locks = get_num_slot_locks_table(table, old_size);
 
 	// create new table that will replace old one
 	// ensure new table is initialized to all null, otherwise placement errors
-	void ** new_table = (void **) calloc(new_size, sizeof(void *));
-	pthread_mutex_t * new_slot_locks = malloc(new_size * sizeof(pthread_mutex_t));
-	for (uint64_t i = 0; i < new_size; i++){
-		pthread_mutex_init(&(new_slot_locks[i]), NULL);
+	void ** new_table = (void **) alloc_table_mem(new_size * sizeof(void *));
+	if (new_table == NULL){
+		fprintf(stderr, "Error: could not allocate resized table of size %lu\n", new_size);
+		return -1;
 	}
 
+	uint16_t * new_tags = NULL;
+	if ((table -> tag_func) && (table -> engine == TABLE_LINEAR_PROBE)){
+		new_tags = (uint16_t *) alloc_table_mem(new_size * sizeof(uint16_t));
+		if (new_tags == NULL){
+			fprintf(stderr, "Error: could not allocate tags for resized table of size %lu\n", new_size);
+			free_table_mem(new_table, new_size * sizeof(void *));
+			return -1;
+		}
+	}
 
-	// re-hash all the items into new table
-	uint64_t hash_ind, table_ind;
-	for (uint64_t i = 0; i < old_size; i++){
-		if (old_table[i] == NULL){
-			continue;
+	// the group probing engine has control bytes instead of tags
+	uint8_t * new_ctrl = NULL;
+	if (table -> engine == TABLE_GROUP_PROBE){
+		new_ctrl = init_ctrl_table(new_size);
+		if (new_ctrl == NULL){
+			fprintf(stderr, "Error: could not allocate control bytes for resized table of size %lu\n", new_size);
+			free_table_mem(new_table, new_size * sizeof(void *));
+			return -1;
 		}
-		hash_ind = (table -> hash_func)(old_table[i], new_size);
-		// do open addressing insert
-		for (uint64_t j = hash_ind; j < hash_ind + new_size; j++){
-			table_ind = j % new_size;
-			// found empty slot to insert
-			if (new_table[table_ind] == NULL) {
-				new_table[table_ind] = old_table[i];
-				break;
-			}
-			else{
-			}
+	}
+
+	uint64_t new_num_slot_locks = get_num_slot_locks_table(table, new_size);
+	pthread_mutex_t * new_slot_locks = init_slot_locks_table(new_num_slot_locks);
+	if (new_slot_locks == NULL){
+		fprintf(stderr, "Error: could not allocate slot locks for resized table of size %lu\n", new_size);
+		free_table_mem(new_table, new_size * sizeof(void *));
+		if (new_tags){
+			free_table_mem(new_tags, new_size * sizeof(uint16_t));
 		}
+		if (new_ctrl){
+			free_table_mem(new_ctrl, new_size);
+		}
+		return -1;
 	}
 
-	// only need to modify the table field and size field
-	table -> table = new_table;
+	// publish the new array and keep the current one around as the old array
+	//	- finds snapshot all of these under the write sequence so they never see
+	//	  a size/array pair from different generations
+	begin_write_table(table);
+	__atomic_store_n(&(table -> old_table), old_table, __ATOMIC_RELEASE);
+	__atomic_store_n(&(table -> old_tags), old_tags, __ATOMIC_RELEASE);
+	__atomic_store_n(&(table -> old_ctrl), old_ctrl, __ATOMIC_RELEASE);
+	table -> old_size = old_size;
+	table -> migrate_ind = 0;
+	__atomic_store_n(&(table -> table), new_table, __ATOMIC_RELEASE);
+	__atomic_store_n(&(table -> tags), new_tags, __ATOMIC_RELEASE);
+	__atomic_store_n(&(table -> ctrl), new_ctrl, __ATOMIC_RELEASE);
 	table -> slot_locks = new_slot_locks;
-	table -> size = new_size;
-
-	// we know these are unlocked
-	for (uint64_t i = 0; i < old_size; i++){
-		// Practice to hold lock before destorying
-		pthread_mutex_lock(&(old_slot_locks[i]));
-		pthread_mutex_destroy(&(old_slot_locks[i]));
-	}
+	__atomic_store_n(&(table -> size), new_size, __ATOMIC_RELEASE);
+	end_write_table(table);
 
-	free(old_slot_locks);
+	// tombstones are never migrated, so the new array starts without any
+	table -> num_tombstones = 0;
 
-	// free the old table and reset to new one
-	free(old_table);
+	// The old array is only modified under the migrate_lock from now on (no slot locks needed)
+	// and we know these are unlocked
+	destroy_slot_locks_table(old_slot_locks, old_num_slot_locks);
 
 	return 0;
 }
 
 
-// return -1 upon error
-int insert_item_table(Table * table, void * item) {
+// INSERT/REMOVAL PROTOCOL
+
+// The probing parts of inserts and removals live within table_template.h (so typed instantiations
+// can inline them), but they all go through these functions before and after touching the slots
+
+// Waits until inserts are allowed, registers the insert and grows (or purges tombstones) if needed
+//	- sets ret_size to the size observed while holding op_lock
+// return -1 upon error (the insert must not go any further)
+int begin_insert_table(Table * table, uint64_t * ret_size) {
 
 
 	int ret;
@@ -211,7 +589,9 @@ int insert_item_table(Table * table, void * item) {
 	// we now know there are no pending removals, so we can obtain the count
 	// and (worst-case) assume all inserts are new
 	uint64_t current_cnt = table -> cnt;
-	uint64_t total_cnt = current_cnt + table -> num_inserts;
+	// tombstones (group probing engine only) occupy slots just like items, so they count
+	// towards the load
+	uint64_t total_cnt = current_cnt + table -> num_inserts + table -> num_tombstones;
 	uint64_t max_size = table -> max_size;
 
 	// before releasing op lock we need to determine if the table will need to
@@ -229,10 +609,12 @@ int insert_item_table(Table * table, void * item) {
 
 			// Can have multiple concurrent inserts reach this point,
 			//	- because we release the op_lock within the cond_wait below
-			// but they all must have unique total_cnts. 
-			// Only one of these inserts will have total_cnt == cap
+			// but only one evaluates this check before resizing is set (new inserts wait above),
 			//		- this one will wait for the others to finish before resizing
-			if ((cur_size < max_size) && (total_cnt == load_cap)){
+			// total_cnt can already be past the cap when the check becomes relevant (e.g. at max_size the load
+			// grows past the cap without resizing and only later do removals leave tombstones), so it is an inequality
+			// Even at max_size we still need to rehash if the load is partially from tombstones
+			if (((cur_size < max_size) || (table -> num_tombstones > 0)) && (total_cnt >= load_cap)){
 
 
 				uint64_t new_size = (uint64_t) ((double) cur_size * (1.0f / load_factor));
@@ -240,14 +622,20 @@ int insert_item_table(Table * table, void * item) {
 					new_size = max_size;
 				}
 
+				// If most of the load is tombstones then just purge them without growing
+				if ((table -> num_tombstones > 0) && ((current_cnt + table -> num_inserts) <= (load_cap / 2))){
+					new_size = cur_size;
+				}
+
 				// Set this variable before releasing lock
 				table -> resizing = true;
 				
-				// wait for all previous inserts & finds to finish
+				// wait for all previous inserts to finish
 				//	because we incremented num inserts at the beginning
 				// (to prevent simulateneous removals) we should wait 
 				// until there is 1 insert left (which is this thread's function)
-				while((table -> num_inserts > 1) || (table -> num_finds > 0)){
+				//	- finds don't need to be waited for, resize_table handles them
+				while(table -> num_inserts > 1){
 					pthread_cond_wait(&(table -> insert_cv), &(table -> op_lock));
 				}
 
@@ -274,45 +662,18 @@ int insert_item_table(Table * table, void * item) {
 
 
 	// ensure size is checked while holding lock
-	uint64_t size = table -> size;
+	*ret_size = table -> size;
 
 	// we can release the op lock now, but will acquire it again when finished to decrement
 	// the inserts
 	pthread_mutex_unlock(&(table -> op_lock));
 
-	
-	uint64_t hash_ind = (table -> hash_func)(item, size);
-	uint64_t table_ind;
-	// doing the Linear Probing
-	// worst case O(size) insert time
-	void ** tab = table -> table;
-	pthread_mutex_t * slot_locks = table -> slot_locks;
-	bool is_duplicate = false;
-	bool is_inserted = false;
-	
-	// can shortcut the insertion
-
+	return 0;
+}
 
-	for (uint64_t i = hash_ind; i < hash_ind + size; i++){
-		table_ind = i % size;
-		pthread_mutex_lock(&(slot_locks[table_ind]));
-		// if item was already in table
-		if ((tab[table_ind] != NULL) && ((table -> item_cmp)(item, tab[table_ind]) == 0)){
-			pthread_mutex_unlock(&(slot_locks[table_ind]));
-			is_duplicate = true;
-			is_inserted = true;
-			break;
-		}
-		else if (tab[table_ind] == NULL) {
-			tab[table_ind] = item;
-			pthread_mutex_unlock(&(slot_locks[table_ind]));
-			is_inserted = true;
-			break;
-		}
-		else{
-			pthread_mutex_unlock(&(slot_locks[table_ind]));
-		}
-	}
+// Unregisters the insert and updates the counts based on its outcome
+// returns what insert_item_table returns
+int end_insert_table(Table * table, uint64_t size, bool is_inserted, bool is_duplicate, bool is_tombstone_reused) {
 
 	if (!is_inserted){
 		fprintf(stderr, "Error: item was not inserted into table. Table size was %lu and count value was %lu\n", size, table -> cnt);
@@ -325,6 +686,9 @@ int insert_item_table(Table * table, void * item) {
 	if (is_inserted && !is_duplicate){
 		table -> cnt += 1;
 	}
+	if (is_tombstone_reused){
+		table -> num_tombstones -= 1;
+	}
 	// The reason for num_inserts == 1 is because when the table is growing
 	// there will be a pending insert waiting on this insert to finish
 	bool is_insert_notify = ((table -> num_inserts == 0) || (table -> num_inserts == 1));
@@ -342,80 +706,17 @@ int insert_item_table(Table * table, void * item) {
 }
 
 
-// For "correctness" find_item needs to wait for just pending removals
-void * find_item_table(Table * table, void * item){
-
-
-	// Cannot do find during pending removals
-	pthread_mutex_lock(&(table -> op_lock));
-	while (table -> num_removals > 0 || table -> resizing){
-		pthread_cond_wait(&(table -> removal_cv), &(table -> op_lock));
-	}
-
-	// Now incdicate we are doing a find
-	// to prevent removals from occurring
-	table -> num_finds += 1;
-
-	// ensure size is checked while holding lock
-	uint64_t size = table -> size;
-
-	// we can release the op lock now, but will acquire it again when finished to decrement
-	// the inserts
-	pthread_mutex_unlock(&(table -> op_lock));
-
-
-	
-	uint64_t hash_ind = (table -> hash_func)(item, size);
-	void ** tab = table -> table;
-	void * found_item = NULL;
-	pthread_mutex_t * slot_locks = table -> slot_locks;
-	uint64_t table_ind;
-	
-	
-	// do linear scan
-	for (uint64_t i = hash_ind; i < hash_ind + size; i++){
-		table_ind = i % size;
-		pthread_mutex_lock(&(slot_locks[table_ind]));
-		if ((tab[table_ind] != NULL) && ((table -> item_cmp)(item, tab[table_ind]) == 0)){
-			pthread_mutex_unlock(&(slot_locks[table_ind]));
-			found_item = tab[table_ind];
-			break;
-		}
-		// There was an empty slot, so we know item doesn't exist
-		else if (tab[table_ind] == NULL){
-			pthread_mutex_unlock(&(slot_locks[table_ind]));
-			found_item = NULL;
-			break;
-		}
-		else{
-			// continue searching
-			pthread_mutex_unlock(&(slot_locks[table_ind]));
-		}
-	}
-
-
-	pthread_mutex_lock(&(table -> op_lock));
-	table -> num_finds -= 1;
-	// The reason for table inserts == 1 is because when table is growing there will be a pending insert waiting 
-	// on this find to finish
-	bool is_find_notify = (table -> num_finds == 0) && ((table -> num_inserts == 0) || (table -> num_inserts == 1));
-	// Indicate to pending removals that they might be able to go
-	if (is_find_notify){
-		pthread_cond_broadcast(&(table -> insert_cv));
-	}
-	pthread_mutex_unlock(&(table -> op_lock));
-
-	return found_item;
-}
-
-// remove from table and return pointer to item (can be used later for destroying)
-void * remove_item_table(Table * table, void * item) {
+// Waits until removals are allowed, registers the removal and shrinks if needed
+//	- sets ret_size and ret_is_migrating to what was observed while holding op_lock
+//	- ret_is_resized is passed back to end_remove_table
+// return -1 upon error (the removal must not go any further)
+int begin_remove_table(Table * table, uint64_t * ret_size, bool * ret_is_migrating, bool * ret_is_resized) {
 	
 	int ret;
 
-	// Cannot remove during pending insert/find
+	// Cannot remove during pending insert
 	pthread_mutex_lock(&(table -> op_lock));
-	while (((table -> num_inserts > 0) || (table -> num_finds > 0)) || (table -> resizing)){
+	while ((table -> num_inserts > 0) || (table -> resizing)){
 		pthread_cond_wait(&(table -> insert_cv), &(table -> op_lock));
 	}
 
@@ -483,7 +784,7 @@ void * remove_item_table(Table * table, void * item) {
 				fprintf(stderr, "Error: resize table failed when shrinking from %lu to %lu. Was triggered when current count was %lu and total cnt was %lu\n", 
 										cur_size, new_size, current_cnt, total_cnt);
 				pthread_mutex_unlock(&(table -> op_lock));
-				return NULL;
+				return -1;
 			}
 
 
@@ -501,97 +802,23 @@ void * remove_item_table(Table * table, void * item) {
 
 
 	// ensure to get size while still holding lock
-	uint64_t size = table -> size;
+	*ret_size = table -> size;
 
-	pthread_mutex_unlock(&(table -> op_lock));
-		
-	uint64_t hash_ind = (table -> hash_func)(item, size);
+	// a migration can't start while this removal is in-flight (only finish)
+	*ret_is_migrating = (table -> old_table != NULL);
 
-	// orig set to null in case item not in table 
-	// in which case we want to return NULL
-	void * ret_item = NULL;
-	uint64_t table_ind;
-	// do linear scan
-	void ** tab = table -> table;
-	pthread_mutex_t * slot_locks = table -> slot_locks;
+	*ret_is_resized = resized;
 
-	bool is_exists = false;
+	pthread_mutex_unlock(&(table -> op_lock));
 
-	for (uint64_t i = hash_ind; i < hash_ind + size; i++){
-		table_ind = i % size;
-		// check if we found item, remember its contents and make room in table
-		// use function pointer to check for item key
-		pthread_mutex_lock(&(slot_locks[table_ind]));
-		if ((tab[table_ind] != NULL) && ((table -> item_cmp)(item, tab[table_ind]) == 0)){
-			// set item to be the item removed so we can return it
-			ret_item = tab[table_ind];
-			// Now need to find a replacement for this NULL to maintain invariant for insert/finds
-			uint64_t replacement_ind;
-			uint64_t empty_ind = table_ind;
-			
-		
+	return 0;
+}
 
-			// Advance to the next non-null. Find first item that could
-			// be found again by swapping it to the table_ind 
-
-			// If none of items were able to be found again before non-null
-			// that means we can just set table_ind to null and everything will be ok
-
-			// Because j started at 1, we know maximum value for replacement_ind will be table_ind - 1
-			//	(and won't run into double locking problems)
-
-			// Start at next index
-			uint64_t j = 1;
-			uint64_t rehash_ind;
-
-			while (j < size){
-				replacement_ind = (table_ind + j) % size;
-				pthread_mutex_lock(&(slot_locks[replacement_ind]));
-				if (tab[replacement_ind] != NULL){
-					rehash_ind = (table -> hash_func)(tab[replacement_ind], size);
-					// Now check conditions to ensure a valid replacement (need to still be able to find
-					//	the replacement item after swapping)
-
-					// Ref: https://stackoverflow.com/questions/9127207/hash-table-why-deletion-is-difficult-in-open-addressing-scheme
-
-					if (((replacement_ind > empty_ind) && (rehash_ind <= empty_ind || rehash_ind > replacement_ind)) 
-						|| ((replacement_ind < empty_ind) && (rehash_ind <= empty_ind) && rehash_ind > replacement_ind)){
-						tab[empty_ind] = tab[replacement_ind];
-						pthread_mutex_unlock(&(slot_locks[empty_ind]));
-						empty_ind = replacement_ind;
-					}
-					else{
-						// This element wouldn't be able to be found again at table_ind spot
-						// so keep it where it is and try the next element
-						pthread_mutex_unlock(&(slot_locks[replacement_ind]));
-					}
-					
-				}
-				else{
-					pthread_mutex_unlock(&(slot_locks[replacement_ind]));
-					break;
-				}
-				j++;
-			}
+// Unregisters the removal, updates the counts and (without an epoch domain)
+// waits for finds that might still reference the removed item
+void end_remove_table(Table * table, void * ret_item, bool is_tombstone_created, bool resized) {
 
-			tab[empty_ind] = NULL;
-			// found item so break
-			pthread_mutex_unlock(&(slot_locks[empty_ind]));
-			is_exists = true;
-			break;
-		}
-		// There was an empty slot, so we know item doesn't exist
-		else if (tab[table_ind] == NULL){
-			pthread_mutex_unlock(&(slot_locks[table_ind]));
-			ret_item = NULL;
-			break;
-		}
-		else{
-			// continue searching
-			pthread_mutex_unlock(&(slot_locks[table_ind]));
-		}
-		
-	}
+	bool is_exists = (ret_item != NULL);
 
 	// Indicate to pending inserts/finds that they might be able to go
 	pthread_mutex_lock(&(table -> op_lock));
@@ -600,6 +827,9 @@ void * remove_item_table(Table * table, void * item) {
 	if (is_exists){
 		table -> cnt -= 1;
 	}
+	if (is_tombstone_created){
+		table -> num_tombstones += 1;
+	}
 
 	// When shrinking final removal is actually when there is 1 left
 	// if we resized then we need to notify pending "finds" that they can go through
@@ -608,9 +838,13 @@ void * remove_item_table(Table * table, void * item) {
 		pthread_cond_broadcast(&(table -> removal_cv));
 	}
 	pthread_mutex_unlock(&(table -> op_lock));
-	
-	// if found is pointer to item, otherwise null
-	return ret_item;
+
+	// a concurrent find may have loaded this item before it was unlinked
+	// and the caller is likely going to free it upon return
+	//	- with an epoch domain the caller retires it instead
+	if ((is_exists) && (table -> epoch_domain == NULL)){
+		synchronize_readers_table(table);
+	}
 }
 
 
@@ -623,19 +857,24 @@ int get_all_items_table(Table * table, bool to_start_rand, bool to_sort, uint64_
 
 	pthread_mutex_lock(&(table -> op_lock));
 	
-	// Sleep while there are ongoing removals
+	// Sleep while there are ongoing removals or inserts
 	//	- need to wait because a concurrent removal might swap item to a location that we already swept through
-	while (table -> num_removals > 0){
-		pthread_cond_wait(&(table -> removal_cv), &(table -> op_lock));
-	}
-
-	// Sleep while there are ongoing inserts
-	while (table -> num_inserts > 0){
-		pthread_cond_wait(&(table -> insert_cv), &(table -> op_lock));
+	//	- both are checked within the same loop, because new removals can start while waiting
+	//	  for the inserts to finish (and vice versa)
+	while ((table -> num_removals > 0) || (table -> num_inserts > 0) || (table -> resizing)){
+		if (table -> num_removals > 0){
+			pthread_cond_wait(&(table -> removal_cv), &(table -> op_lock));
+		}
+		else{
+			pthread_cond_wait(&(table -> insert_cv), &(table -> op_lock));
+		}
 	}
 
 	// Don't release this mutex until completely finished
-	// 	(i.e. don't allow inserts/finds/removals to occur during this)
+	// 	(i.e. don't allow inserts/removals to occur during this)
+
+	// Simpler to only have to look through one array
+	finish_migration_table(table);
 
 
 	// 1.) Acquire size & cnt 
@@ -671,13 +910,13 @@ int get_all_items_table(Table * table, bool to_start_rand, bool to_sort, uint64_
 	uint64_t table_ind;
 	for (uint64_t i = table_ind_start; i < table_ind_start + size; i++){
 		table_ind = i % size;
-		pthread_mutex_lock(&(slot_locks[table_ind]));
+		pthread_mutex_lock(get_slot_lock_table(table, slot_locks, table_ind));
 		// there was an item at this location
 		if (tab[table_ind] != NULL){
 			all_items[num_added] = tab[table_ind];
 			num_added++;
 		}
-		pthread_mutex_unlock(&(slot_locks[table_ind]));
+		pthread_mutex_unlock(get_slot_lock_table(table, slot_locks, table_ind));
 
 		// can break early if we've already seen everything
 		if (num_added == cnt){
@@ -705,3 +944,176 @@ int get_all_items_table(Table * table, bool to_start_rand, bool to_sort, uint64_
 
 	return 0;
 }
+
+
+// CURSORS
+
+int open_cursor_table(Table * table, bool is_snapshot, Table_Cursor * ret_cursor){
+
+	if (table == NULL){
+		fprintf(stderr, "Error: cannot open cursor on null table\n");
+		return -1;
+	}
+
+	ret_cursor -> table = table;
+	ret_cursor -> is_snapshot = is_snapshot;
+	ret_cursor -> is_done = false;
+	ret_cursor -> slot_ind = 0;
+
+	ret_cursor -> snapshot_items = NULL;
+	ret_cursor -> num_snapshot_items = 0;
+
+	if (!is_snapshot){
+		// the arrays are looked up again (as a reader) within every step
+		ret_cursor -> is_old = true;
+		ret_cursor -> tab = NULL;
+		ret_cursor -> size = 0;
+		return 0;
+	}
+
+	ret_cursor -> is_old = false;
+	ret_cursor -> tab = NULL;
+	ret_cursor -> size = 0;
+
+	// blocks all inserts/removals for the whole O(n) copy (see table.h)
+	int ret = get_all_items_table(table, false, false, &(ret_cursor -> num_snapshot_items), &(ret_cursor -> snapshot_items));
+	if (ret != 0){
+		fprintf(stderr, "Error: could not copy out the items for a snapshot cursor\n");
+		return -1;
+	}
+
+	return 0;
+}
+
+// Copies the next max_items (at most) of the items that were copied out on open
+static uint64_t next_snapshot_cursor_table(Table_Cursor * cursor, uint64_t max_items, void ** ret_items){
+
+	uint64_t num_items = cursor -> num_snapshot_items - cursor -> slot_ind;
+	if (num_items > max_items){
+		num_items = max_items;
+	}
+
+	memcpy(ret_items, &((cursor -> snapshot_items)[cursor -> slot_ind]), num_items * sizeof(void *));
+	cursor -> slot_ind += num_items;
+
+	if (cursor -> slot_ind == cursor -> num_snapshot_items){
+		cursor -> is_done = true;
+	}
+
+	return num_items;
+}
+
+// Copies the items within the next TABLE_CURSOR_SLOTS_PER_STEP slots (at most)
+// using the same optimistic read protocol as finds
+static uint64_t next_weak_cursor_table(Table_Cursor * cursor, uint64_t max_items, void ** ret_items){
+
+	Table * table = cursor -> table;
+
+	uint64_t phase = enter_reader_table(table);
+
+	uint64_t seq;
+	void ** tab;
+	uint64_t size;
+	void ** old_tab;
+	uint64_t old_size;
+	uint64_t migrate_ind;
+
+	while (1){
+		seq = read_begin_table(table);
+		tab = __atomic_load_n(&(table -> table), __ATOMIC_ACQUIRE);
+		size = __atomic_load_n(&(table -> size), __ATOMIC_ACQUIRE);
+		old_tab = __atomic_load_n(&(table -> old_table), __ATOMIC_ACQUIRE);
+		old_size = table -> old_size;
+		migrate_ind = __atomic_load_n(&(table -> migrate_ind), __ATOMIC_ACQUIRE);
+		if (likely(read_validate_table(table, seq))){
+			break;
+		}
+	}
+
+	// Start by walking the live part of the old array (if there is a migration). Once it has
+	// been migrated, or if the array being walked was swapped out, just continue at the
+	// same relative position within the current array
+
+	// The array from the previous step might have been freed and its address reused by a new array,
+	// so always compare the size as well (if both match the layout is the same, so it doesn't matter)
+	if (cursor -> is_old){
+		if ((old_tab == NULL) || ((cursor -> tab != NULL) && ((cursor -> tab != old_tab) || (cursor -> size != old_size)))){
+			cursor -> is_old = false;
+			cursor -> tab = NULL;
+			cursor -> slot_ind = 0;
+		}
+		else{
+			if (cursor -> tab == NULL){
+				cursor -> tab = old_tab;
+				cursor -> size = old_size;
+			}
+			if (cursor -> slot_ind < migrate_ind){
+				cursor -> slot_ind = migrate_ind;
+			}
+		}
+	}
+
+	if (!(cursor -> is_old)){
+		if (cursor -> tab == NULL){
+			cursor -> tab = tab;
+			cursor -> size = size;
+		}
+		else if ((cursor -> tab != tab) || (cursor -> size != size)){
+			cursor -> slot_ind = (uint64_t) (((double) cursor -> slot_ind / (double) cursor -> size) * (double) size);
+			cursor -> tab = tab;
+			cursor -> size = size;
+		}
+	}
+
+	void * cur_item;
+	uint64_t num_items = 0;
+	uint64_t end_ind = cursor -> slot_ind + TABLE_CURSOR_SLOTS_PER_STEP;
+	if (end_ind > cursor -> size){
+		end_ind = cursor -> size;
+	}
+
+	while ((num_items < max_items) && (cursor -> slot_ind < end_ind)){
+		cur_item = __atomic_load_n(&((cursor -> tab)[cursor -> slot_ind]), __ATOMIC_ACQUIRE);
+		if ((cur_item != NULL) && (cur_item != TABLE_TOMBSTONE)){
+			ret_items[num_items] = cur_item;
+			num_items++;
+		}
+		cursor -> slot_ind += 1;
+	}
+
+	if (cursor -> slot_ind == cursor -> size){
+		if (cursor -> is_old){
+			cursor -> is_old = false;
+			cursor -> tab = NULL;
+			cursor -> slot_ind = 0;
+		}
+		else{
+			cursor -> is_done = true;
+		}
+	}
+
+	exit_reader_table(table, phase);
+
+	return num_items;
+}
+
+uint64_t next_cursor_table(Table_Cursor * cursor, uint64_t max_items, void ** ret_items){
+
+	if (cursor -> is_done){
+		return 0;
+	}
+
+	if (cursor -> is_snapshot){
+		return next_snapshot_cursor_table(cursor, max_items, ret_items);
+	}
+
+	return next_weak_cursor_table(cursor, max_items, ret_items);
+}
+
+void close_cursor_table(Table_Cursor * cursor){
+
+	if (cursor -> is_snapshot){
+		free(cursor -> snapshot_items);
+		cursor -> snapshot_items = NULL;
+	}
+}
@@ -2,6 +2,45 @@
 #define TABLE_H
 
 #include "common.h"
+#include "epoch.h"
+
+// When a resize is triggered the items are not rehashed all at once.
+// Instead every insert/removal migrates this many slots of the previous
+// array into the new one before doing its own work
+#define TABLE_MIGRATE_SLOTS_PER_OP 64
+
+// Slot arrays and lock stripes at least this large are allocated
+// with mmap and backed by huge pages when possible
+#define TABLE_HUGE_PAGE_SIZE (1UL << 21)
+
+// The batch functions prefetch this many items' home slots at a time
+#define TABLE_BATCH_PREFETCH_ITEMS 32
+
+// Upper bound on the number of slots a cursor examines within one step
+#define TABLE_CURSOR_SLOTS_PER_STEP 4096
+
+// Within the tags array, indicates the slot is empty
+// (a tag function returning this value gets remapped)
+#define TABLE_EMPTY_TAG 0
+
+// Group probing engine:
+
+// number of slots (control bytes) matched at once
+#define TABLE_GROUP_SIZE 16
+
+// Special control bytes all have the high bit set,
+// a full slot holds the low 7 bits of its item's tag
+#define TABLE_CTRL_EMPTY 0x80
+#define TABLE_CTRL_DELETED 0xFE
+// an insert is in the middle of writing the slot
+#define TABLE_CTRL_CLAIMED 0xFF
+
+typedef enum table_engine {
+	// linear probing (optionally with a parallel tags array), incremental resizing
+	TABLE_LINEAR_PROBE = 0,
+	// SIMD probing of control byte groups with tombstones (requires a tag_func), incremental resizing
+	TABLE_GROUP_PROBE = 1
+} Table_Engine;
 
 typedef struct table {
 	// number of objects in table
@@ -25,8 +64,14 @@ typedef struct table {
 	// set new size to be size * (1 - shrink_factor) and shrink table 
 	float shrink_factor;
 
-	// lock to read/write each slot
+	// locks to read/write slots
+	//	- every slot_lock_ratio consecutive slots share one lock (a stripe)
+	//		- linear probing touches consecutive slots, so most probes stay within one stripe
+	//	- there are ceil(size / slot_lock_ratio) locks
+	//	- slot_lock_ratio is always a power of two (slot_lock_ratio == 1 << slot_lock_shift)
 	pthread_mutex_t * slot_locks;
+	uint64_t slot_lock_ratio;
+	uint64_t slot_lock_shift;
 
 	// Not allowed to do INSERT or FIND while a removal is taking place!
 	// Because upon successful removal, the function needs to maintain
@@ -37,44 +82,137 @@ typedef struct table {
 	// swapped at the same time of find thread and the find thread 
 	// already passed over that index
 
+	// NOTE: finds no longer participate in this protocol (see the optimistic
+	//			read path below), it is only used to order inserts/removals/resizes
+
 	pthread_mutex_t op_lock;
 	pthread_cond_t removal_cv;
 	// the number of concurrent removals
 	uint64_t num_removals;
-	// For same reason, cannot do a removal while an insert/find is occurring
+	// For same reason, cannot do a removal while an insert is occurring
 	pthread_cond_t insert_cv;
 	// the number of concurrent inserts
 	uint64_t num_inserts;
-	// the number of concurrent finds
-	// 	- could have just incremented num_inserts instead of having num_finds,
-	//		but better for readability
-	uint64_t num_finds;
+
+	// Optimistic (lock-free) finds:
+
+	// Writers that might move an item past a concurrent find (a removal
+	// shifting items backwards or a resize swapping the slot array) increment
+	// write_seq_start before modifying and write_seq_end once finished.
+	// A find snapshots write_seq_end, waits until no writer is active
+	// (write_seq_start == write_seq_end), probes without acquiring any locks
+	// and then retries if write_seq_start changed in the meantime
+	uint64_t write_seq_start;
+	uint64_t write_seq_end;
+
+	// Finds announce themselves within one of two reader counters. Before
+	// freeing an old slot array (resize) or handing a removed item back to the caller
+	// (who will likely free it), the writer flips reader_phase and waits until
+	// the previous phase's counter drains. After that point no find can still be
+	// holding a reference obtained before the modification
+	uint64_t reader_phase;
+	uint64_t reader_cnts[2];
+	// serializes writers waiting for readers to drain
+	pthread_mutex_t reader_sync_lock;
 
 	// set this bool when a resize is triggered to prevent
 	// new functions from attempting to start
+	//	- only held while waiting for in-flight inserts/removals to drain and
+	//	  swapping in the new array, the rehashing itself is incremental
 	bool resizing;
 	pthread_cond_t resizing_cv;
 
-	// TODO: ADD LOCK RATIO SO NOT EVERY SLOT NEEDS A LOCK!
-	
+	// Incremental resizing:
+
+	// While a migration is in progress the previous array is kept as old_table
+	// (non-NULL) next to the new array in table. All old slots at index < migrate_ind
+	// have already been copied into the new array, so only items found at index >= migrate_ind
+	// within the old array are still live there. New items are only ever inserted into the new array.
+	// Removing an item that is still live within the old array replaces it with a
+	// tombstone (never shifts), so old probe sequences stay intact until migration finishes
+	//	- both engines migrate this way, the group probing engine keeps its old control bytes in old_ctrl
+	void ** old_table;
+	uint64_t old_size;
+	uint64_t migrate_ind;
+	// held while moving old slots or modifying the old array
+	//	- also held by removals for their whole duration while a migration is in progress
+	pthread_mutex_t migrate_lock;
+
 	// Function pointer to retrieve the key of objects inserted into table
 	//	- which is then passed the hash function
 	Hash_Func hash_func;
 	// Function to compare item, returns 0 if equal
 	Item_Cmp item_cmp;
 	void ** table;
+
+	// Tagged mode (if tag_func != NULL):
+
+	// A parallel array of 16-bit tags (from tag_func) for every slot in table (and old_table).
+	// Probes scan the tags and only dereference the slot's item and call item_cmp when the tags match.
+	// A tag of TABLE_EMPTY_TAG means the slot is empty, so misses never have to touch the slot array.
+	// 	- 32 tags fit in a cache line vs. 8 slot pointers
+	//	- writers still treat the slot pointers as the source of truth
+	//	- a tag is always written after its slot, so it is what publishes the item to finds
+	Hash_Tag_Func tag_func;
+	uint16_t * tags;
+	uint16_t * old_tags;
+
+	// Which probing scheme the table uses
+	Table_Engine engine;
+
+	// Group probing engine only:
+
+	// one control byte per slot (see TABLE_CTRL_*)
+	uint8_t * ctrl;
+	uint8_t * old_ctrl;
+	// number of TABLE_CTRL_DELETED slots, they count towards the load (reset upon resize)
+	uint64_t num_tombstones;
+
+	// Epoch-based reclamation (if epoch_domain != NULL):
+
+	// Callers only dereference found items within a critical section of this domain
+	// and retire removed items to it (instead of destroying them directly).
+	// Removals then no longer wait for concurrent finds to drain (the grace period
+	// of the domain takes care of that), the reader counters above only protect the slot arrays
+	Epoch_Domain * epoch_domain;
 } Table;
 
 // Functions to export:
-Table * init_table(uint64_t min_size, uint64_t max_size, float load_factor, float shrink_factor, Hash_Func hash_func, Item_Cmp item_cmp);
+// slot_lock_ratio is the number of slots that share a lock (rounded up to a power of two)
+// if tag_func is non-null the table runs in tagged mode
+// the group probing engine rounds min_size and max_size up to a multiple of TABLE_GROUP_SIZE (and needs a tag_func)
+Table * init_table(uint64_t min_size, uint64_t max_size, float load_factor, float shrink_factor, uint64_t slot_lock_ratio, Hash_Func hash_func, Item_Cmp item_cmp, Hash_Tag_Func tag_func, Table_Engine engine);
 void destroy_table(Table * table);
 
 
 // enforce the caller supplied item_key because don't want to defrence void * 
 int insert_item_table(Table * table, void * item);
+
+// Never blocks on op_lock or slot locks. Safe to call concurrently with inserts,
+// removals and resizes. The returned pointer is valid until the caller (or another thread)
+// removes it from the table
 void * find_item_table(Table * table, void * item);
+
+// Upon returning the removed item no concurrent find can still be referencing it,
+// so the caller is free to destroy it
+//	- if the table has an epoch domain, finds might still be referencing it
+//	  and the caller must retire it with retire_epoch instead
 void * remove_item_table(Table * table, void * item);
 
+// Must be set before the table is shared with other threads
+//	- removals then no longer wait for concurrent finds to drain, so EVERY access to the table 
+//	  (including inserts, which compare against the items already within it) must be 
+//	  within a critical section of the domain
+void set_epoch_domain_table(Table * table, Epoch_Domain * epoch_domain);
+
+// Batched versions of find/insert, used when a worker has many items to process at once
+// (the home slots of the items are prefetched up-front to overlap the cache misses)
+// 	- ret_items[i] is set to what find_item_table(table, items[i]) would return
+void find_batch_table(Table * table, uint64_t num_items, void ** items, void ** ret_items);
+//	- ret_vals[i] is set to what insert_item_table(table, items[i]) would return
+// returns -1 if any of the inserts failed
+int insert_batch_table(Table * table, uint64_t num_items, void ** items, int * ret_vals);
+
 
 // Notes: 
 //	- Returns the count and populated the 2nd argument with a view of all the items
@@ -89,4 +227,54 @@ int get_all_items_table(Table * table, bool to_start_rand, bool to_sort, uint64_
 
 uint64_t get_count_table(Table * table, bool to_wait_pending);
 
+
+// Cursors walk the table in bounded steps without holding off inserts, removals or finds in between
+
+// Weak (is_snapshot == false):
+//	- never blocks anything, every step is an optimistic read like a find
+//	- every returned item was within the table at some point during the iteration, but items
+//	  moved by concurrent removals/resizes (and migrations) might be missed or returned twice
+// Snapshot (is_snapshot == true):
+//	- NOT a versioned snapshot: opening the cursor is a blocking O(n) copy of the item pointers with
+//	  get_all_items_table, which locks out all inserts and removals until every slot has been copied
+//	- the steps then walk that copy, so exactly the items within the table at that point are 
+//	  returned, once each, and nothing is held off after open returns
+//	- (like get_all_items_table the items themselves are not copied)
+// Prefer weak cursors on any path where stalling writers for the whole copy matters
+
+typedef struct table_cursor {
+	Table * table;
+	bool is_snapshot;
+	// set once all slots have been walked
+	bool is_done;
+	// walking the old array of a migration (before the current array)
+	bool is_old;
+	// the array being walked
+	void ** tab;
+	uint64_t size;
+	uint64_t slot_ind;
+	// snapshot only: the copied items (walked with slot_ind), freed on close
+	void ** snapshot_items;
+	uint64_t num_snapshot_items;
+} Table_Cursor;
+
+// ret_cursor is caller allocated
+int open_cursor_table(Table * table, bool is_snapshot, Table_Cursor * ret_cursor);
+// Copies up to max_items items into ret_items and returns the number copied.
+// Examines at most TABLE_CURSOR_SLOTS_PER_STEP slots, so a return of 0 doesn't mean 
+// the iteration is finished. Loop until cursor -> is_done
+uint64_t next_cursor_table(Table_Cursor * cursor, uint64_t max_items, void ** ret_items);
+// Must be called for every opened cursor (even if is_done)
+void close_cursor_table(Table_Cursor * cursor);
+
+
+// INTERNAL: used by the insert/remove paths within table_template.h (not meant to be called directly)
+int begin_insert_table(Table * table, uint64_t * ret_size);
+int end_insert_table(Table * table, uint64_t size, bool is_inserted, bool is_duplicate, bool is_tombstone_reused);
+int begin_remove_table(Table * table, uint64_t * ret_size, bool * ret_is_migrating, bool * ret_is_resized);
+void end_remove_table(Table * table, void * ret_item, bool is_tombstone_created, bool resized);
+void migrate_slots_table(Table * table, uint64_t max_slots);
+void migrate_step_table(Table * table);
+
+
 #endif
\ No newline at end of file
@@ -0,0 +1,1089 @@
+// Probing paths of Table (optimistic finds, inserts, removals and their batched versions)
+
+// Instantiated by defining the parameters below and then including this file.
+// table.c instantiates it once with the function pointers stored in the Table (the generic API).
+// A module whose tables only ever hold one item type can instantiate its own copy, where the
+// hash/compare/tag are direct calls (or expressions) the compiler can inline, so the probe loops make
+// no indirect calls. The op_lock protocol around inserts/removals, resizes and migration steps 
+// always go through table.c (and its generic function pointers), and typed and generic calls can be 
+// mixed on the same table, so a typed instantiation must compute exactly what the Table's 
+// hash_func/item_cmp/tag_func would
+
+// Parameters:
+//	- TABLE_T_FN(name): name of the instantiated function (e.g. name##_table)
+//	- TABLE_T_HASH(table, item, size): same as hash_func(item, size)
+//	- TABLE_T_CMP(table, item, other_item): 0 if equal (only ever checked for equality)
+//		- can instead be derived from the key (a fixed size memcmp) by defining TABLE_T_ITEM_TYPE,
+//		  TABLE_T_KEY_FIELD and TABLE_T_KEY_SIZE
+//	- TABLE_T_TAG(table, item): same as tag_func(item), defaults to calling tag_func
+//	- TABLE_T_API: storage class of the exported functions, defaults to static inline
+//	- TABLE_T_SHARDED_FN(name) & TABLE_T_SHARD(item): optionally also instantiate the
+//	  functions for Sharded_Tables of this type that route with TABLE_T_SHARD instead of shard_func
+
+// Exported (for TABLE_T_FN(name)), same semantics as the generic functions within table.h:
+//	void * TABLE_T_FN(find_item)(Table * table, void * item);
+//	void TABLE_T_FN(find_batch)(Table * table, uint64_t num_items, void ** items, void ** ret_items);
+//	int TABLE_T_FN(insert_item)(Table * table, void * item);
+//	int TABLE_T_FN(insert_batch)(Table * table, uint64_t num_items, void ** items, int * ret_vals);
+//	void * TABLE_T_FN(remove_item)(Table * table, void * item);
+//	(and optionally) void * TABLE_T_SHARDED_FN(find_item)(Sharded_Table * sharded_table, void * item);
+//					 int TABLE_T_SHARDED_FN(insert_item)(Sharded_Table * sharded_table, void * item);
+//					 void * TABLE_T_SHARDED_FN(remove_item)(Sharded_Table * sharded_table, void * item);
+//					 void TABLE_T_SHARDED_FN(prefetch_batch)(Sharded_Table * sharded_table, uint64_t num_items, void ** items);
+
+// All parameters are undefined at the end, so it can be included multiple times within the same file
+
+
+#ifndef TABLE_TEMPLATE_HELPERS_H
+#define TABLE_TEMPLATE_HELPERS_H
+
+#include "table.h"
+
+#include <immintrin.h>
+
+// OPTIMISTIC READ HELPERS
+
+// Register as a reader within the current phase. Need to re-check the phase after incrementing
+// because a writer might have flipped it (and already seen our old counter at 0) in between
+static inline uint64_t enter_reader_table(Table * table){
+	uint64_t phase;
+	while (1){
+		phase = __atomic_load_n(&(table -> reader_phase), __ATOMIC_SEQ_CST) & 1;
+		__atomic_fetch_add(&((table -> reader_cnts)[phase]), 1, __ATOMIC_SEQ_CST);
+		if ((__atomic_load_n(&(table -> reader_phase), __ATOMIC_SEQ_CST) & 1) == phase){
+			return phase;
+		}
+		__atomic_fetch_sub(&((table -> reader_cnts)[phase]), 1, __ATOMIC_SEQ_CST);
+	}
+}
+
+static inline void exit_reader_table(Table * table, uint64_t phase){
+	__atomic_fetch_sub(&((table -> reader_cnts)[phase]), 1, __ATOMIC_RELEASE);
+}
+
+// Returns a sequence snapshot taken while no writers were active
+static inline uint64_t read_begin_table(Table * table){
+	uint64_t seq;
+	while (1){
+		seq = __atomic_load_n(&(table -> write_seq_end), __ATOMIC_ACQUIRE);
+		if (__atomic_load_n(&(table -> write_seq_start), __ATOMIC_ACQUIRE) == seq){
+			return seq;
+		}
+		_mm_pause();
+	}
+}
+
+// Returns true if no writer started since read_begin_table returned seq
+static inline bool read_validate_table(Table * table, uint64_t seq){
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	return __atomic_load_n(&(table -> write_seq_start), __ATOMIC_RELAXED) == seq;
+}
+
+
+// Marks an item removed from the old array during a migration. Never stored
+// within the current array
+#define TABLE_TOMBSTONE ((void *) 1)
+
+
+// WRITER HELPERS
+
+static inline pthread_mutex_t * get_slot_lock_table(Table * table, pthread_mutex_t * slot_locks, uint64_t table_ind){
+	return &(slot_locks[table_ind >> table -> slot_lock_shift]);
+}
+
+// Called by writers before they start moving items that concurrent finds might be probing
+static inline void begin_write_table(Table * table){
+	__atomic_fetch_add(&(table -> write_seq_start), 1, __ATOMIC_SEQ_CST);
+}
+
+static inline void end_write_table(Table * table){
+	__atomic_fetch_add(&(table -> write_seq_end), 1, __ATOMIC_RELEASE);
+}
+
+
+// GROUP PROBING HELPERS
+
+// The control bytes of a full slot are always published after the slot (release), so acquiring
+// after the load means the slots of all full control bytes seen are visible
+static inline __m128i load_group_table(uint8_t * ctrl, uint64_t group){
+	__m128i ctrl_group = _mm_loadu_si128((__m128i *) &(ctrl[group * TABLE_GROUP_SIZE]));
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	return ctrl_group;
+}
+
+// bit i is set if control byte i of the group is equal to val
+static inline uint32_t match_group_table(__m128i ctrl_group, uint8_t val){
+	return (uint32_t) _mm_movemask_epi8(_mm_cmpeq_epi8(ctrl_group, _mm_set1_epi8((char) val)));
+}
+
+#endif
+
+
+#ifndef TABLE_T_FN
+#error "table_template.h requires TABLE_T_FN"
+#endif
+
+#ifndef TABLE_T_HASH
+#error "table_template.h requires TABLE_T_HASH"
+#endif
+
+#ifndef TABLE_T_CMP
+#if defined(TABLE_T_ITEM_TYPE) && defined(TABLE_T_KEY_FIELD) && defined(TABLE_T_KEY_SIZE)
+#define TABLE_T_CMP(table, item, other_item) memcmp(&(((TABLE_T_ITEM_TYPE *) (item)) -> TABLE_T_KEY_FIELD), &(((TABLE_T_ITEM_TYPE *) (other_item)) -> TABLE_T_KEY_FIELD), TABLE_T_KEY_SIZE)
+#else
+#error "table_template.h requires TABLE_T_CMP (or TABLE_T_ITEM_TYPE, TABLE_T_KEY_FIELD and TABLE_T_KEY_SIZE)"
+#endif
+#endif
+
+#ifndef TABLE_T_TAG
+#define TABLE_T_TAG(table, item) ((table) -> tag_func)(item)
+#endif
+
+#ifndef TABLE_T_API
+#define TABLE_T_API static inline
+#endif
+
+
+// Only called in tagged mode
+static inline uint16_t TABLE_T_FN(get_tag)(Table * table, void * item){
+	(void) table;
+	uint16_t tag = TABLE_T_TAG(table, item);
+	if (unlikely(tag == TABLE_EMPTY_TAG)){
+		tag = TABLE_EMPTY_TAG + 1;
+	}
+	return tag;
+}
+
+
+// Linear probe without acquiring any locks (used by optimistic readers and by writers
+// for the old array). The caller is responsible for validating the write sequence afterwards
+//	- returns the matching item (and sets ret_ind), or NULL once an empty slot is reached
+//	- tombstones are skipped over because they might be in the middle of a probe sequence
+//	- tags is NULL if not in tagged mode (and tag is ignored)
+static inline void * TABLE_T_FN(probe_slots)(Table * table, void ** tab, uint16_t * tags, uint64_t size, void * item, uint16_t tag, uint64_t * ret_ind){
+
+	(void) table;
+
+	uint64_t hash_ind = TABLE_T_HASH(table, item, size);
+	uint64_t table_ind;
+	uint16_t cur_tag;
+	void * cur_item;
+
+	for (uint64_t i = hash_ind; i < hash_ind + size; i++){
+		table_ind = i % size;
+		if (tags){
+			// the tag is published after the slot, so acquiring it
+			// means the slot is visible
+			cur_tag = __atomic_load_n(&(tags[table_ind]), __ATOMIC_ACQUIRE);
+			// There was an empty slot, so we know item doesn't exist
+			if (cur_tag == TABLE_EMPTY_TAG){
+				return NULL;
+			}
+			// most mismatches are rejected here without touching the item
+			if (cur_tag != tag){
+				continue;
+			}
+			cur_item = __atomic_load_n(&(tab[table_ind]), __ATOMIC_RELAXED);
+			// a concurrent removal clears the slot before the tag,
+			// the caller's validation will catch this
+			if (cur_item == NULL){
+				continue;
+			}
+		}
+		else{
+			cur_item = __atomic_load_n(&(tab[table_ind]), __ATOMIC_ACQUIRE);
+			// There was an empty slot, so we know item doesn't exist
+			if (cur_item == NULL){
+				return NULL;
+			}
+		}
+		if ((cur_item != TABLE_TOMBSTONE) && (TABLE_T_CMP(table, item, cur_item) == 0)){
+			if (ret_ind){
+				*ret_ind = table_ind;
+			}
+			return cur_item;
+		}
+	}
+
+	return NULL;
+}
+
+
+// Lookup within the old array during a migration
+//	- returns the item only if it is still live within the old array (found at index >= migrate_ind)
+//	- if it was found at a lower index it has already been copied into the current array
+static inline void * TABLE_T_FN(find_old)(Table * table, void ** old_tab, uint16_t * old_tags, uint64_t old_size, uint64_t migrate_ind, void * item, uint16_t tag, uint64_t * ret_ind){
+
+	uint64_t found_ind;
+	void * found_item = TABLE_T_FN(probe_slots)(table, old_tab, old_tags, old_size, item, tag, &found_ind);
+	if ((found_item == NULL) || (found_ind < migrate_ind)){
+		return NULL;
+	}
+
+	if (ret_ind){
+		*ret_ind = found_ind;
+	}
+
+	return found_item;
+}
+
+
+// Group probing engine (see table.c)
+
+static inline uint8_t TABLE_T_FN(get_h2)(Table * table, void * item){
+	(void) table;
+	return (uint8_t) (TABLE_T_TAG(table, item) & 0x7F);
+}
+
+static inline uint64_t TABLE_T_FN(get_home_group)(Table * table, void * item, uint64_t size){
+	(void) table;
+	return TABLE_T_HASH(table, item, size / TABLE_GROUP_SIZE);
+}
+
+// Probe without acquiring any locks
+//	- returns the matching item (and sets ret_ind), or NULL once a group with an empty slot is reached
+static inline void * TABLE_T_FN(probe_group)(Table * table, uint8_t * ctrl, void ** tab, uint64_t size, void * item, uint8_t h2, uint64_t * ret_ind){
+
+	uint64_t num_groups = size / TABLE_GROUP_SIZE;
+	uint64_t group = TABLE_T_FN(get_home_group)(table, item, size);
+
+	__m128i ctrl_group;
+	uint32_t matches;
+	uint64_t table_ind;
+	void * cur_item;
+
+	for (uint64_t i = 0; i < num_groups; i++){
+		ctrl_group = load_group_table(ctrl, group);
+		matches = match_group_table(ctrl_group, h2);
+		while (matches){
+			table_ind = group * TABLE_GROUP_SIZE + __builtin_ctz(matches);
+			cur_item = __atomic_load_n(&(tab[table_ind]), __ATOMIC_RELAXED);
+			// a concurrent removal might have cleared the slot after we loaded the control bytes
+			if ((cur_item != NULL) && (TABLE_T_CMP(table, item, cur_item) == 0)){
+				if (ret_ind){
+					*ret_ind = table_ind;
+				}
+				return cur_item;
+			}
+			matches &= matches - 1;
+		}
+		// There was an empty slot, so we know item doesn't exist
+		if (match_group_table(ctrl_group, TABLE_CTRL_EMPTY)){
+			return NULL;
+		}
+		group += 1;
+		if (group == num_groups){
+			group = 0;
+		}
+	}
+
+	return NULL;
+}
+
+// Same as find_old, but for the group probing engine
+static inline void * TABLE_T_FN(find_old_group)(Table * table, uint8_t * old_ctrl, void ** old_tab, uint64_t old_size, uint64_t migrate_ind, void * item, uint8_t h2, uint64_t * ret_ind){
+
+	uint64_t found_ind;
+	void * found_item = TABLE_T_FN(probe_group)(table, old_ctrl, old_tab, old_size, item, h2, &found_ind);
+	if ((found_item == NULL) || (found_ind < migrate_ind)){
+		return NULL;
+	}
+
+	if (ret_ind){
+		*ret_ind = found_ind;
+	}
+
+	return found_item;
+}
+
+// assert(registered as a reader)
+// Same migration protocol as the linear probing engine (see find_registered)
+static inline void * TABLE_T_FN(find_group)(Table * table, void * item){
+
+	uint8_t h2 = TABLE_T_FN(get_h2)(table, item);
+
+	uint64_t seq;
+	uint64_t size;
+	void ** tab;
+	uint8_t * ctrl;
+	void ** old_tab;
+	uint8_t * old_ctrl;
+	uint64_t old_size;
+	uint64_t migrate_ind;
+	void * found_item;
+
+	while (1){
+		seq = read_begin_table(table);
+
+		size = __atomic_load_n(&(table -> size), __ATOMIC_ACQUIRE);
+		tab = __atomic_load_n(&(table -> table), __ATOMIC_ACQUIRE);
+		ctrl = __atomic_load_n(&(table -> ctrl), __ATOMIC_ACQUIRE);
+		old_tab = __atomic_load_n(&(table -> old_table), __ATOMIC_ACQUIRE);
+		old_ctrl = __atomic_load_n(&(table -> old_ctrl), __ATOMIC_ACQUIRE);
+		old_size = table -> old_size;
+		migrate_ind = __atomic_load_n(&(table -> migrate_ind), __ATOMIC_ACQUIRE);
+
+		// ensure size and arrays were from the same generation before indexing
+		if (unlikely(!read_validate_table(table, seq))){
+			continue;
+		}
+
+		if (old_tab != NULL){
+			found_item = TABLE_T_FN(find_old_group)(table, old_ctrl, old_tab, old_size, migrate_ind, item, h2, NULL);
+			if (found_item != NULL){
+				if (likely(read_validate_table(table, seq))){
+					break;
+				}
+				continue;
+			}
+		}
+
+		found_item = TABLE_T_FN(probe_group)(table, ctrl, tab, size, item, h2, NULL);
+
+		if (likely(read_validate_table(table, seq))){
+			break;
+		}
+	}
+
+	return found_item;
+}
+
+
+// Optimistic find that never acquires op_lock or slot locks
+
+// The only modifications that can make a concurrent probe miss an item are
+// removals (which shift items backwards) and resizes (which swap out the array).
+// Both are bracketed by the write sequence, so if the sequence didn't change
+// while probing the result is correct. Inserts only ever fill empty slots,
+// so a concurrent insert is either seen or linearized after this find
+
+// During a migration the old array is checked first (with the migrate_ind snapshot taken
+// before probing the current array), so an item that is being migrated concurrently
+// is always found in at least one of the arrays
+
+// assert(registered as a reader)
+static inline void * TABLE_T_FN(find_registered)(Table * table, void * item){
+
+	if (table -> engine == TABLE_GROUP_PROBE){
+		return TABLE_T_FN(find_group)(table, item);
+	}
+
+	uint64_t seq;
+	uint64_t size;
+	void ** tab;
+	uint16_t * tags;
+	void ** old_tab;
+	uint16_t * old_tags;
+	uint64_t old_size;
+	uint64_t migrate_ind;
+	void * found_item;
+
+	uint16_t tag = 0;
+	if (table -> tag_func){
+		tag = TABLE_T_FN(get_tag)(table, item);
+	}
+
+	while (1){
+
+		seq = read_begin_table(table);
+
+		size = __atomic_load_n(&(table -> size), __ATOMIC_ACQUIRE);
+		tab = __atomic_load_n(&(table -> table), __ATOMIC_ACQUIRE);
+		tags = __atomic_load_n(&(table -> tags), __ATOMIC_ACQUIRE);
+		old_tab = __atomic_load_n(&(table -> old_table), __ATOMIC_ACQUIRE);
+		old_tags = __atomic_load_n(&(table -> old_tags), __ATOMIC_ACQUIRE);
+		old_size = table -> old_size;
+		migrate_ind = __atomic_load_n(&(table -> migrate_ind), __ATOMIC_ACQUIRE);
+
+		// ensure size and tab were from the same array before indexing
+		if (unlikely(!read_validate_table(table, seq))){
+			continue;
+		}
+
+		found_item = NULL;
+
+		if (old_tab != NULL){
+			found_item = TABLE_T_FN(find_old)(table, old_tab, old_tags, old_size, migrate_ind, item, tag, NULL);
+			if (found_item != NULL){
+				if (likely(read_validate_table(table, seq))){
+					break;
+				}
+				continue;
+			}
+		}
+
+		// do linear scan
+		found_item = TABLE_T_FN(probe_slots)(table, tab, tags, size, item, tag, NULL);
+
+		if (likely(read_validate_table(table, seq))){
+			break;
+		}
+	}
+
+	return found_item;
+}
+
+TABLE_T_API void * TABLE_T_FN(find_item)(Table * table, void * item){
+
+	uint64_t phase = enter_reader_table(table);
+
+	void * found_item = TABLE_T_FN(find_registered)(table, item);
+
+	exit_reader_table(table, phase);
+
+	return found_item;
+}
+
+
+// Issues prefetches for the first slots each item would probe (within the current array)
+//	- nothing is dereferenced besides the items, so it doesn't matter if the snapshot
+//	  is stale by the time the probes actually happen
+static inline void TABLE_T_FN(prefetch_batch)(Table * table, uint64_t num_items, void ** items){
+
+	uint64_t seq;
+	uint64_t size;
+	void ** tab;
+	uint16_t * tags;
+	uint8_t * ctrl;
+
+	do {
+		seq = read_begin_table(table);
+		size = __atomic_load_n(&(table -> size), __ATOMIC_ACQUIRE);
+		tab = __atomic_load_n(&(table -> table), __ATOMIC_ACQUIRE);
+		tags = __atomic_load_n(&(table -> tags), __ATOMIC_ACQUIRE);
+		ctrl = __atomic_load_n(&(table -> ctrl), __ATOMIC_ACQUIRE);
+	} while (unlikely(!read_validate_table(table, seq)));
+
+	uint64_t table_ind;
+	for (uint64_t i = 0; i < num_items; i++){
+		if (table -> engine == TABLE_GROUP_PROBE){
+			table_ind = TABLE_T_FN(get_home_group)(table, items[i], size) * TABLE_GROUP_SIZE;
+			__builtin_prefetch(&(ctrl[table_ind]), 0, 3);
+		}
+		else{
+			table_ind = TABLE_T_HASH(table, items[i], size);
+			if (tags){
+				__builtin_prefetch(&(tags[table_ind]), 0, 3);
+			}
+		}
+		__builtin_prefetch(&(tab[table_ind]), 0, 3);
+	}
+}
+
+
+// Items are processed in chunks of TABLE_BATCH_PREFETCH_ITEMS. All of a chunk's home slots
+// are prefetched before any of its probes start, so the cache misses overlap instead of
+// being paid one after another
+TABLE_T_API void TABLE_T_FN(find_batch)(Table * table, uint64_t num_items, void ** items, void ** ret_items){
+
+	uint64_t phase = enter_reader_table(table);
+
+	uint64_t num_chunk_items;
+	for (uint64_t start = 0; start < num_items; start += TABLE_BATCH_PREFETCH_ITEMS){
+		num_chunk_items = num_items - start;
+		if (num_chunk_items > TABLE_BATCH_PREFETCH_ITEMS){
+			num_chunk_items = TABLE_BATCH_PREFETCH_ITEMS;
+		}
+
+		TABLE_T_FN(prefetch_batch)(table, num_chunk_items, &(items[start]));
+
+		for (uint64_t i = start; i < start + num_chunk_items; i++){
+			ret_items[i] = TABLE_T_FN(find_registered)(table, items[i]);
+		}
+	}
+
+	exit_reader_table(table, phase);
+}
+
+
+// INSERTS/REMOVALS
+
+// Linear probing insert into the current array (not the old array)
+//	- sets is_duplicate if an equal item was already present
+//	- returns false if there was no room
+//	- tags is NULL if not in tagged mode (and tag is ignored)
+static inline bool TABLE_T_FN(insert_slot)(Table * table, void ** tab, uint16_t * tags, pthread_mutex_t * slot_locks, uint64_t size, void * item, uint16_t tag, bool * is_duplicate){
+
+	uint64_t hash_ind = TABLE_T_HASH(table, item, size);
+	uint64_t table_ind;
+
+	*is_duplicate = false;
+
+	// consecutive slots share a lock stripe, so only switch locks
+	// when probing crosses into the next stripe
+	pthread_mutex_t * held_lock = NULL;
+	pthread_mutex_t * cur_lock;
+
+	for (uint64_t i = hash_ind; i < hash_ind + size; i++){
+		table_ind = i % size;
+		cur_lock = get_slot_lock_table(table, slot_locks, table_ind);
+		if (cur_lock != held_lock){
+			if (held_lock != NULL){
+				pthread_mutex_unlock(held_lock);
+			}
+			pthread_mutex_lock(cur_lock);
+			held_lock = cur_lock;
+		}
+		// if item was already in table
+		if ((tab[table_ind] != NULL) && ((!tags) || (tags[table_ind] == tag)) && (TABLE_T_CMP(table, item, tab[table_ind]) == 0)){
+			pthread_mutex_unlock(held_lock);
+			*is_duplicate = true;
+			return true;
+		}
+		else if (tab[table_ind] == NULL) {
+			// publish the item to optimistic finds only after it is fully initialized
+			if (tags){
+				__atomic_store_n(&(tab[table_ind]), item, __ATOMIC_RELAXED);
+				__atomic_store_n(&(tags[table_ind]), tag, __ATOMIC_RELEASE);
+			}
+			else{
+				__atomic_store_n(&(tab[table_ind]), item, __ATOMIC_RELEASE);
+			}
+			pthread_mutex_unlock(held_lock);
+			return true;
+		}
+	}
+
+	if (held_lock != NULL){
+		pthread_mutex_unlock(held_lock);
+	}
+
+	return false;
+}
+
+
+// Optimistic lookup of items that are still live within the old array
+// Used by inserts during a migration to check for duplicates
+//	- for the group probing engine tag is the item's H2
+static inline void * TABLE_T_FN(find_live_old)(Table * table, void * item, uint16_t tag){
+
+	uint64_t phase = enter_reader_table(table);
+
+	uint64_t seq;
+	void ** old_tab;
+	uint16_t * old_tags;
+	uint8_t * old_ctrl;
+	uint64_t old_size;
+	uint64_t migrate_ind;
+	void * found_item;
+
+	while (1){
+		seq = read_begin_table(table);
+
+		old_tab = __atomic_load_n(&(table -> old_table), __ATOMIC_ACQUIRE);
+		old_tags = __atomic_load_n(&(table -> old_tags), __ATOMIC_ACQUIRE);
+		old_ctrl = __atomic_load_n(&(table -> old_ctrl), __ATOMIC_ACQUIRE);
+		old_size = table -> old_size;
+		migrate_ind = __atomic_load_n(&(table -> migrate_ind), __ATOMIC_ACQUIRE);
+
+		if (unlikely(!read_validate_table(table, seq))){
+			continue;
+		}
+
+		found_item = NULL;
+		if (old_tab != NULL){
+			if (table -> engine == TABLE_GROUP_PROBE){
+				found_item = TABLE_T_FN(find_old_group)(table, old_ctrl, old_tab, old_size, migrate_ind, item, (uint8_t) tag, NULL);
+			}
+			else{
+				found_item = TABLE_T_FN(find_old)(table, old_tab, old_tags, old_size, migrate_ind, item, tag, NULL);
+			}
+		}
+
+		if (likely(read_validate_table(table, seq))){
+			break;
+		}
+	}
+
+	exit_reader_table(table, phase);
+
+	return found_item;
+}
+
+
+// Claims the first free slot along the probe sequence starting at group and publishes item within it
+//	- tombstones are only reused if is_tombstone_reusable (sets is_tombstone_reused if one was)
+//	- returns false if there was no room
+// Concurrent inserts of other items can only take free slots away (never add new empty ones), 
+// so if every claim within a group fails the group has no free slots left and it is fine to keep probing
+static inline bool TABLE_T_FN(claim_slot_group)(Table * table, uint8_t * ctrl, void ** tab, uint64_t size, uint64_t group, void * item, uint8_t h2, bool is_tombstone_reusable, bool * is_tombstone_reused){
+
+	(void) table;
+
+	uint64_t num_groups = size / TABLE_GROUP_SIZE;
+
+	__m128i ctrl_group;
+	uint32_t free_slots;
+	uint64_t table_ind;
+	uint8_t expected;
+
+	for (uint64_t i = 0; i < num_groups; i++){
+		ctrl_group = load_group_table(ctrl, group);
+		free_slots = match_group_table(ctrl_group, TABLE_CTRL_EMPTY);
+		if (is_tombstone_reusable){
+			free_slots |= match_group_table(ctrl_group, TABLE_CTRL_DELETED);
+		}
+		while (free_slots){
+			table_ind = group * TABLE_GROUP_SIZE + __builtin_ctz(free_slots);
+			expected = __atomic_load_n(&(ctrl[table_ind]), __ATOMIC_RELAXED);
+			if (((expected == TABLE_CTRL_EMPTY) || ((is_tombstone_reusable) && (expected == TABLE_CTRL_DELETED))) && 
+					__atomic_compare_exchange_n(&(ctrl[table_ind]), &expected, TABLE_CTRL_CLAIMED, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)){
+				__atomic_store_n(&(tab[table_ind]), item, __ATOMIC_RELAXED);
+				// publish to finds
+				__atomic_store_n(&(ctrl[table_ind]), h2, __ATOMIC_RELEASE);
+				*is_tombstone_reused = (expected == TABLE_CTRL_DELETED);
+				return true;
+			}
+			free_slots &= free_slots - 1;
+		}
+		group += 1;
+		if (group == num_groups){
+			group = 0;
+		}
+	}
+
+	return false;
+}
+
+// returns true if the item was inserted or is a duplicate
+static inline bool TABLE_T_FN(insert_group)(Table * table, void * item, bool * is_duplicate, bool * is_tombstone_reused){
+
+	// help out with any pending resize
+	migrate_step_table(table);
+
+	// the arrays can't be swapped out while an insert is in-flight
+	uint8_t * ctrl = table -> ctrl;
+	void ** tab = table -> table;
+	uint64_t size = table -> size;
+
+	uint8_t h2 = TABLE_T_FN(get_h2)(table, item);
+	uint64_t group = TABLE_T_FN(get_home_group)(table, item, size);
+
+	// same as insert_linear, the old array needs to be checked before the current array
+	if (__atomic_load_n(&(table -> old_table), __ATOMIC_ACQUIRE) != NULL){
+		if (TABLE_T_FN(find_live_old)(table, item, h2) != NULL){
+			*is_duplicate = true;
+			return true;
+		}
+	}
+
+	pthread_mutex_t * home_lock = get_slot_lock_table(table, table -> slot_locks, group * TABLE_GROUP_SIZE);
+	pthread_mutex_lock(home_lock);
+
+	if (TABLE_T_FN(probe_group)(table, ctrl, tab, size, item, h2, NULL) != NULL){
+		pthread_mutex_unlock(home_lock);
+		*is_duplicate = true;
+		return true;
+	}
+
+	bool is_inserted = TABLE_T_FN(claim_slot_group)(table, ctrl, tab, size, group, item, h2, true, is_tombstone_reused);
+
+	pthread_mutex_unlock(home_lock);
+	return is_inserted;
+}
+
+// is_migrating was observed while holding op_lock
+static inline void * TABLE_T_FN(remove_group)(Table * table, void * item, bool is_migrating, bool * is_tombstone_created){
+
+	void * ret_item = NULL;
+
+	uint8_t h2 = TABLE_T_FN(get_h2)(table, item);
+
+	// While migrating, removals hold the migrate lock for their whole duration (same as remove_linear).
+	// Besides keeping the old array stable, this keeps migrations from claiming empty slots
+	// of the current array while the group check below decides between empty and tombstone
+	if (is_migrating){
+		pthread_mutex_lock(&(table -> migrate_lock));
+
+		// help out with the pending resize
+		migrate_slots_table(table, TABLE_MIGRATE_SLOTS_PER_OP);
+
+		if (table -> old_table != NULL){
+			uint64_t old_ind;
+			ret_item = TABLE_T_FN(find_old_group)(table, table -> old_ctrl, table -> old_table, table -> old_size, table -> migrate_ind, item, h2, &old_ind);
+			if (ret_item != NULL){
+				// always a tombstone so old probe sequences stay intact (the old array
+				// is dropped after the migration, so it doesn't count towards the load)
+				__atomic_store_n(&((table -> old_ctrl)[old_ind]), TABLE_CTRL_DELETED, __ATOMIC_RELEASE);
+				__atomic_store_n(&((table -> old_table)[old_ind]), NULL, __ATOMIC_RELAXED);
+			}
+		}
+	}
+
+	if (ret_item == NULL){
+
+		uint8_t * ctrl = table -> ctrl;
+		void ** tab = table -> table;
+		uint64_t size = table -> size;
+
+		uint64_t group = TABLE_T_FN(get_home_group)(table, item, size);
+
+		pthread_mutex_t * home_lock = get_slot_lock_table(table, table -> slot_locks, group * TABLE_GROUP_SIZE);
+		pthread_mutex_lock(home_lock);
+
+		uint64_t table_ind;
+		ret_item = TABLE_T_FN(probe_group)(table, ctrl, tab, size, item, h2, &table_ind);
+		if (ret_item != NULL){
+			// Inserts and migrations can't run concurrently with removals, so the empty slots within the group can't change
+			if (match_group_table(load_group_table(ctrl, table_ind / TABLE_GROUP_SIZE), TABLE_CTRL_EMPTY)){
+				__atomic_store_n(&(ctrl[table_ind]), TABLE_CTRL_EMPTY, __ATOMIC_RELEASE);
+			}
+			else{
+				__atomic_store_n(&(ctrl[table_ind]), TABLE_CTRL_DELETED, __ATOMIC_RELEASE);
+				*is_tombstone_created = true;
+			}
+			__atomic_store_n(&(tab[table_ind]), NULL, __ATOMIC_RELAXED);
+		}
+
+		pthread_mutex_unlock(home_lock);
+	}
+
+	if (is_migrating){
+		pthread_mutex_unlock(&(table -> migrate_lock));
+	}
+
+	return ret_item;
+}
+
+
+// Linear probing engine insert (after the caller has gone through the op_lock protocol)
+// size is the table size observed while holding op_lock
+static inline bool TABLE_T_FN(insert_linear)(Table * table, void * item, uint64_t size, bool * is_duplicate){
+
+	// help out with any pending resize
+	migrate_step_table(table);
+
+	// doing the Linear Probing
+	// worst case O(size) insert time
+	void ** tab = table -> table;
+	uint16_t * tags = table -> tags;
+	pthread_mutex_t * slot_locks = table -> slot_locks;
+	bool is_inserted = false;
+
+	uint16_t tag = 0;
+	if (table -> tag_func){
+		tag = TABLE_T_FN(get_tag)(table, item);
+	}
+
+	// If a migration is in progress an equal item might still be live within the old array.
+	// Need to check the old array before the current array, because a concurrent migration copies
+	// items into the current array before advancing migrate_ind
+	if (__atomic_load_n(&(table -> old_table), __ATOMIC_ACQUIRE) != NULL){
+		if (TABLE_T_FN(find_live_old)(table, item, tag) != NULL){
+			*is_duplicate = true;
+			is_inserted = true;
+		}
+	}
+
+	if (!(*is_duplicate)){
+		is_inserted = TABLE_T_FN(insert_slot)(table, tab, tags, slot_locks, size, item, tag, is_duplicate);
+	}
+
+	return is_inserted;
+}
+
+
+// Linear probing engine removal (after the caller has gone through the op_lock protocol)
+// size and is_migrating were observed while holding op_lock
+static inline void * TABLE_T_FN(remove_linear)(Table * table, void * item, uint64_t size, bool is_migrating){
+
+	// orig set to null in case item not in table 
+	// in which case we want to return NULL
+	void * ret_item = NULL;
+
+	bool is_exists = false;
+
+	uint16_t tag = 0;
+	if (table -> tag_func){
+		tag = TABLE_T_FN(get_tag)(table, item);
+	}
+
+	// While migrating, removals hold the migrate lock for their whole duration. 
+	// This prevents a concurrent migration from copying items into the current
+	// array while the shifting below is happening and keeps the old array
+	// stable while we tombstone within it
+	if (is_migrating){
+		pthread_mutex_lock(&(table -> migrate_lock));
+
+		// help out with the pending resize
+		migrate_slots_table(table, TABLE_MIGRATE_SLOTS_PER_OP);
+
+		if (table -> old_table != NULL){
+			uint64_t old_ind;
+			ret_item = TABLE_T_FN(find_old)(table, table -> old_table, table -> old_tags, table -> old_size, table -> migrate_ind, item, tag, &old_ind);
+			if (ret_item != NULL){
+				// nothing gets shifted within the old array, so finds don't need to be notified
+				// through the write sequence (the tag is kept so probes continue past the tombstone)
+				__atomic_store_n(&((table -> old_table)[old_ind]), TABLE_TOMBSTONE, __ATOMIC_RELEASE);
+				is_exists = true;
+			}
+		}
+	}
+		
+	uint64_t hash_ind = TABLE_T_HASH(table, item, size);
+
+	uint64_t table_ind;
+	// do linear scan
+	void ** tab = table -> table;
+	uint16_t * tags = table -> tags;
+	pthread_mutex_t * slot_locks = table -> slot_locks;
+
+	// if it was removed from the old array then we can skip the probing
+	uint64_t num_probes = is_exists ? 0 : size;
+
+	pthread_mutex_t * cur_lock;
+	pthread_mutex_t * empty_lock;
+	pthread_mutex_t * replacement_lock;
+
+	// Concurrent removals can shift an item backwards past this probe (same as
+	// with optimistic finds), so if the item wasn't found and another removal
+	// started shifting in the meantime then need to probe again
+
+	// This retry is independent of the lock striping: probes only hold one stripe
+	// at a time, so even with a lock per slot a removal walking forward could have 
+	// the item it is looking for shifted into a slot it already passed. Such a removal
+	// would return NULL for an item that is in the table
+	uint64_t seq;
+	bool is_retry = true;
+	while (is_retry){
+
+		seq = read_begin_table(table);
+
+		for (uint64_t i = hash_ind; i < hash_ind + num_probes; i++){
+			table_ind = i % size;
+			// check if we found item, remember its contents and make room in table
+			// use function pointer to check for item key
+			cur_lock = get_slot_lock_table(table, slot_locks, table_ind);
+			pthread_mutex_lock(cur_lock);
+			// in tagged mode most mismatches are rejected without dereferencing the slot
+			if ((tab[table_ind] != NULL) && ((tags == NULL) || (tags[table_ind] == tag)) && (TABLE_T_CMP(table, item, tab[table_ind]) == 0)){
+				// set item to be the item removed so we can return it
+				ret_item = tab[table_ind];
+
+				// the shifting below can move items behind concurrent finds
+				begin_write_table(table);
+
+				// Now need to find a replacement for this NULL to maintain invariant for insert/finds
+				uint64_t replacement_ind;
+				uint64_t empty_ind = table_ind;
+				empty_lock = cur_lock;
+		
+
+				// Advance to the next non-null. Find first item that could
+				// be found again by swapping it to the table_ind 
+
+				// If none of items were able to be found again before non-null
+				// that means we can just set table_ind to null and everything will be ok
+
+				// Because j started at 1, we know maximum value for replacement_ind will be table_ind - 1
+				//	(and won't run into double locking problems)
+
+				// Neighboring slots will usually map to the same lock stripe as the empty slot 
+				// which we are already holding, so only lock/unlock when they differ
+
+				// Start at next index
+				uint64_t j = 1;
+				uint64_t rehash_ind;
+
+				while (j < size){
+					replacement_ind = (table_ind + j) % size;
+					replacement_lock = get_slot_lock_table(table, slot_locks, replacement_ind);
+					if (replacement_lock != empty_lock){
+						pthread_mutex_lock(replacement_lock);
+					}
+					if (tab[replacement_ind] != NULL){
+						rehash_ind = TABLE_T_HASH(table, tab[replacement_ind], size);
+						// Now check conditions to ensure a valid replacement (need to still be able to find
+						//	the replacement item after swapping)
+
+						// Ref: https://stackoverflow.com/questions/9127207/hash-table-why-deletion-is-difficult-in-open-addressing-scheme
+
+						if (((replacement_ind > empty_ind) && (rehash_ind <= empty_ind || rehash_ind > replacement_ind)) 
+							|| ((replacement_ind < empty_ind) && (rehash_ind <= empty_ind) && rehash_ind > replacement_ind)){
+							__atomic_store_n(&(tab[empty_ind]), tab[replacement_ind], __ATOMIC_RELAXED);
+							if (tags){
+								__atomic_store_n(&(tags[empty_ind]), tags[replacement_ind], __ATOMIC_RELEASE);
+							}
+							if (replacement_lock != empty_lock){
+								pthread_mutex_unlock(empty_lock);
+							}
+							empty_ind = replacement_ind;
+							empty_lock = replacement_lock;
+						}
+						else{
+							// This element wouldn't be able to be found again at table_ind spot
+							// so keep it where it is and try the next element
+							if (replacement_lock != empty_lock){
+								pthread_mutex_unlock(replacement_lock);
+							}
+						}
+					
+					}
+					else{
+						if (replacement_lock != empty_lock){
+							pthread_mutex_unlock(replacement_lock);
+						}
+						break;
+					}
+					j++;
+				}
+
+				__atomic_store_n(&(tab[empty_ind]), NULL, __ATOMIC_RELAXED);
+				if (tags){
+					__atomic_store_n(&(tags[empty_ind]), TABLE_EMPTY_TAG, __ATOMIC_RELAXED);
+				}
+
+				end_write_table(table);
+
+				// found item so break
+				pthread_mutex_unlock(empty_lock);
+				is_exists = true;
+				break;
+			}
+			// There was an empty slot, so we know item doesn't exist
+			else if (tab[table_ind] == NULL){
+				pthread_mutex_unlock(cur_lock);
+				ret_item = NULL;
+				break;
+			}
+			else{
+				// continue searching
+				pthread_mutex_unlock(cur_lock);
+			}
+		
+		}
+
+		is_retry = (!is_exists) && (num_probes > 0) && (!read_validate_table(table, seq));
+	}
+
+	if (is_migrating){
+		pthread_mutex_unlock(&(table -> migrate_lock));
+	}
+
+	return ret_item;
+}
+
+
+// see insert_item_table
+TABLE_T_API int TABLE_T_FN(insert_item)(Table * table, void * item){
+
+	uint64_t size;
+	if (begin_insert_table(table, &size) != 0){
+		return -1;
+	}
+
+	bool is_duplicate = false;
+	bool is_inserted;
+	bool is_tombstone_reused = false;
+
+	if (table -> engine == TABLE_GROUP_PROBE){
+		is_inserted = TABLE_T_FN(insert_group)(table, item, &is_duplicate, &is_tombstone_reused);
+	}
+	else{
+		is_inserted = TABLE_T_FN(insert_linear)(table, item, size, &is_duplicate);
+	}
+
+	return end_insert_table(table, size, is_inserted, is_duplicate, is_tombstone_reused);
+}
+
+
+TABLE_T_API int TABLE_T_FN(insert_batch)(Table * table, uint64_t num_items, void ** items, int * ret_vals){
+
+	int ret = 0;
+
+	uint64_t num_chunk_items;
+	for (uint64_t start = 0; start < num_items; start += TABLE_BATCH_PREFETCH_ITEMS){
+		num_chunk_items = num_items - start;
+		if (num_chunk_items > TABLE_BATCH_PREFETCH_ITEMS){
+			num_chunk_items = TABLE_BATCH_PREFETCH_ITEMS;
+		}
+
+		// a resize triggered within the chunk just makes some of these prefetches useless
+		//	- inserts probe for duplicates before writing, so a read prefetch is fine
+		TABLE_T_FN(prefetch_batch)(table, num_chunk_items, &(items[start]));
+
+		for (uint64_t i = start; i < start + num_chunk_items; i++){
+			ret_vals[i] = TABLE_T_FN(insert_item)(table, items[i]);
+			if (ret_vals[i] == -1){
+				ret = -1;
+			}
+		}
+	}
+
+	return ret;
+}
+
+
+// see remove_item_table
+TABLE_T_API void * TABLE_T_FN(remove_item)(Table * table, void * item){
+
+	uint64_t size;
+	bool is_migrating;
+	bool is_resized;
+	if (begin_remove_table(table, &size, &is_migrating, &is_resized) != 0){
+		return NULL;
+	}
+
+	void * ret_item;
+	bool is_tombstone_created = false;
+
+	if (table -> engine == TABLE_GROUP_PROBE){
+		ret_item = TABLE_T_FN(remove_group)(table, item, is_migrating, &is_tombstone_created);
+	}
+	else{
+		ret_item = TABLE_T_FN(remove_linear)(table, item, size, is_migrating);
+	}
+
+	end_remove_table(table, ret_item, is_tombstone_created, is_resized);
+
+	// if found is pointer to item, otherwise null
+	return ret_item;
+}
+
+
+#ifdef TABLE_T_SHARDED_FN
+
+#include "sharded_table.h"
+
+static inline Table * TABLE_T_SHARDED_FN(get_shard)(Sharded_Table * sharded_table, void * item){
+	// shifting by 64 is undefined
+	uint64_t shard_ind = 0;
+	if (sharded_table -> shard_bits > 0){
+		shard_ind = TABLE_T_SHARD(item) >> (64 - sharded_table -> shard_bits);
+	}
+	return (sharded_table -> shards)[shard_ind];
+}
+
+TABLE_T_API void * TABLE_T_SHARDED_FN(find_item)(Sharded_Table * sharded_table, void * item){
+	return TABLE_T_FN(find_item)(TABLE_T_SHARDED_FN(get_shard)(sharded_table, item), item);
+}
+
+TABLE_T_API int TABLE_T_SHARDED_FN(insert_item)(Sharded_Table * sharded_table, void * item){
+	return TABLE_T_FN(insert_item)(TABLE_T_SHARDED_FN(get_shard)(sharded_table, item), item);
+}
+
+TABLE_T_API void * TABLE_T_SHARDED_FN(remove_item)(Sharded_Table * sharded_table, void * item){
+	return TABLE_T_FN(remove_item)(TABLE_T_SHARDED_FN(get_shard)(sharded_table, item), item);
+}
+
+// Prefetches the home slots of each item within its shard (see prefetch_batch). For callers that
+// must still do their finds/inserts/removals one at a time (in order), but know the items up front
+TABLE_T_API void TABLE_T_SHARDED_FN(prefetch_batch)(Sharded_Table * sharded_table, uint64_t num_items, void ** items){
+	for (uint64_t i = 0; i < num_items; i++){
+		TABLE_T_FN(prefetch_batch)(TABLE_T_SHARDED_FN(get_shard)(sharded_table, items[i]), 1, &(items[i]));
+	}
+}
+
+#endif
+
+
+#undef TABLE_T_FN
+#undef TABLE_T_HASH
+#undef TABLE_T_CMP
+#undef TABLE_T_TAG
+#undef TABLE_T_API
+#undef TABLE_T_ITEM_TYPE
+#undef TABLE_T_KEY_FIELD
+#undef TABLE_T_KEY_SIZE
+#undef TABLE_T_SHARDED_FN
+#undef TABLE_T_SHARD
@@ -60,6 +60,7 @@ int add_work_class(Work_Pool * work_pool, int work_class_index, int num_workers,
 			fprintf(stderr, "Error: unable to intialize worker task fifo for worker num %d\n", i);
 			return -1;
 		}
+		set_wait_policy_fifo((work_class -> worker_tasks)[i], WORKER_TASKS_WAIT_POLICY, WORKER_TASKS_SPIN_ITERS);
 	}
 
 	